@@ -0,0 +1,89 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "glm/glm.hpp"
+#include "sre/impl/DynamicResolutionController.hpp"
+#include "sre/impl/Export.hpp"
+
+namespace sre {
+    class Framebuffer;
+    class Material;
+    class RenderPass;
+    class Texture;
+
+    /**
+     * Dynamic resolution renders the scene into an offscreen framebuffer at a scale chosen each frame to keep the frame
+     * time within a budget, and upscales the result to the screen using bilinear filtering with sharpening.
+     *
+     * The frame time is the GPU time spent between begin() and end() if timer queries are supported (see
+     * RenderInfo::supportTimerQuery). Timer queries are read a few frames later, so no stall occurs. Otherwise the time
+     * between calls to begin() is used, which is limited by vsync (the budget should then be above the vsync interval).
+     * The scale is chosen by a DynamicResolutionController and is exposed in RenderStats::dynamicResolutionScale.
+     *
+     * The framebuffer has the size of the drawable, and the scale is applied using Framebuffer::setRenderScale(), so
+     * render passes (including Camera::setViewport() and RenderPass::frameSize()) use the scaled size. The render
+     * passes using the framebuffer must be finished before end() is called.
+     *
+     * Example:
+     * DynamicResolution dynamicResolution(14);                             // 14 ms budget (after Renderer::init())
+     * // each frame
+     * auto framebuffer = dynamicResolution.begin();
+     * auto&& builder = RenderPass::create();
+     * builder.withFramebuffer(framebuffer).withCamera(camera).withGUI(false);
+     * auto scenePass = builder.build();
+     * scenePass.draw(mesh, transform, material);
+     * scenePass.finish();
+     * auto screenPass = RenderPass::create().build();
+     * dynamicResolution.end(screenPass);                                  // upscales the scene to the screen
+     */
+    class DllExport DynamicResolution {
+    public:
+        explicit DynamicResolution(float budget = 14);                     // Frame time budget in ms
+        ~DynamicResolution();
+
+        std::shared_ptr<Framebuffer> begin();                               // Updates the scale. Returns the framebuffer to render the scene into
+        void end(RenderPass& renderPass);                                   // Upscales the scene into the render pass (which must not be finished)
+
+        void setBudget(float budget);
+        float getBudget();
+        void setScaleLimits(float minScale, float maxScale = 1.0f);         // Limits of the render scale (0.0 - 1.0]. Default 0.5 - 1.0
+        float getMinScale();
+        float getMaxScale();
+        void setSharpness(float sharpness);                                 // Sharpening when upscaling (0.0 = bilinear, 1.0 = max). Default 0.5
+        float getSharpness();
+        void setEnabled(bool enabled);                                      // When disabled the scene is rendered at the max scale
+        bool isEnabled();
+
+        float getScale();                                                   // Render scale of the current frame
+        float getFrameTime();                                               // Last measured frame time in ms
+        bool isGPUTimed();                                                  // True if the frame time is measured on the GPU
+        std::shared_ptr<Texture> getColorTexture();                         // Texture rendered into (only the lower left part is used when scaled)
+    private:
+        void updateFramebuffer();
+        float readTimerQueries();                                           // Returns the latest available GPU time in ms (or 0)
+
+        DynamicResolutionController controller;
+        std::shared_ptr<Texture> colorTexture;
+        std::shared_ptr<Framebuffer> framebuffer;
+        std::shared_ptr<Material> upscaleMaterial;
+        float sharpness = 0.5f;
+        bool enabled = true;
+        float frameTime = 0;
+        bool gpuTimed;
+        std::vector<unsigned int> timerQueries;                             // ring buffer of GL_TIME_ELAPSED queries
+        std::vector<bool> timerQueryPending;
+        int timerQueryIndex = 0;
+        bool timerQueryActive = false;
+        std::chrono::time_point<std::chrono::high_resolution_clock> lastBegin;
+        bool hasLastBegin = false;
+    };
+}
@@ -25,22 +25,29 @@ namespace sre {
      * materials when rendering to the framebuffer (reading and writing to a texture at the same time is not supported).
      *
      * To use a framebuffer, pass it to RenderPassBuilder when a renderpass is being created.
+     *
+     * A multisampled framebuffer (see FrameBufferBuilder::withSamples()) renders into multisample renderbuffers, which
+     * are resolved into the attached textures when the render pass finishes. After the resolve the multisample
+     * contents are discarded, so a render pass using a multisampled framebuffer should clear color and depth.
+     *
+     * The render scale (see setRenderScale()) restricts render passes to the lower left part of the framebuffer, which
+     * allows changing the resolution each frame without reallocating the textures (see DynamicResolution).
      */
     class Framebuffer {
     public:
         class FrameBufferBuilder {
         public:
             FrameBufferBuilder& withColorTexture(std::shared_ptr<Texture> texture);
-    		FrameBufferBuilder& withColorTexture(unsigned int textureID,
-													int width, int height);
             FrameBufferBuilder& withDepthTexture(std::shared_ptr<Texture> texture);
+            FrameBufferBuilder& withSamples(int samples);           // Multisample anti-aliasing (default 1 = disabled). Clamped to RenderInfo::maxSamples.
+                                                                    // Requires a color or depth texture (resolve target)
             FrameBufferBuilder& withName(std::string name);
             std::shared_ptr<Framebuffer> build();
         private:
             std::vector<std::shared_ptr<Texture>> textures;
-			unsigned int screenTextureId = 0;
             std::shared_ptr<Texture> depthTexture;
             glm::uvec2 size;
+            int samples = 1;
             std::string name;
             FrameBufferBuilder() = default;
             FrameBufferBuilder(const FrameBufferBuilder&) = default;
@@ -58,23 +65,30 @@ namespace sre {
         void setDepthTexture(std::shared_ptr<Texture> tex);
 
         const std::string& getName();
-		// Temporarily provide public access to frameBufferObjectId to provide
-		// direct access to internals to enable direct OpenGL calls to support
-		// multi-sample framebuffers. The desired functionality should be
-		// provided by the FrameBuffer class and then this Id should be moved
-		// back to private status.
-        unsigned int frameBufferObjectId;
+        int getSamples();                                           // Number of samples per pixel (1 if not multisampled)
+
+        void setRenderScale(float scale);                           // Fraction of the width and height used by render passes (0.0 - 1.0]. Default 1
+        float getRenderScale();
+        glm::uvec2 getRenderSize();                                 // Size used by render passes (size scaled by the render scale)
     private:
-        void bind();
+        void bind();                                                // Bind the framebuffer rendered into (the multisample framebuffer if multisampled)
+        void bindResolved();                                        // Bind the framebuffer with the attached textures
+        void resolve();                                             // Resolve the multisample renderbuffers into the attached textures
+        void createMultisampleFramebuffer();
+        void deleteMultisampleFramebuffer();
         bool dirty = true;
         explicit Framebuffer(std::string name);
         std::vector<std::shared_ptr<Texture>> textures;
-		unsigned int screenTextureId = 0;
         std::shared_ptr<Texture> depthTexture;
-        //unsigned int frameBufferObjectId;
-        uint32_t renderbuffer = 0;
+        unsigned int frameBufferObjectId = 0;
+        uint32_t colorRenderbuffer = 0;                             // used when no color texture is attached
+        uint32_t depthRenderbuffer = 0;                             // used when no depth texture is attached
+        int samples = 1;
+        unsigned int multisampleFrameBufferObjectId = 0;
+        std::vector<uint32_t> multisampleRenderbuffers;             // color renderbuffers followed by the depth renderbuffer
         std::string name;
         glm::uvec2 size;
+        float renderScale = 1;
         friend class RenderPass;
         friend class Inspector;
     };
@@ -24,6 +24,7 @@ namespace sre {
     class Camera;
 
     class SpriteAtlas;
+    class RenderGraph;
 
     class SDLRenderer;
 
@@ -51,10 +52,6 @@ namespace sre {
 
     private:
         std::shared_ptr<Texture> getTmpTexture();
-
-        std::vector<std::shared_ptr<Texture>> offscreenTextures;
-        int usedTextures = 0;
-        std::shared_ptr<Framebuffer> framebuffer;
         int frames;
         int frameCount;
         std::weak_ptr<Shader> shaderEdit;
@@ -71,11 +68,12 @@ namespace sre {
         std::chrono::time_point<std::chrono::high_resolution_clock> lastTick;
 
         void showSpriteAtlas(SpriteAtlas *pAtlas);
+        void showRenderGraph(RenderGraph *graph);
         void editShader(Shader* shader);
 
         WorldLights worldLights;
 
-        void initFramebuffer();
+        void initWorldLights();
 
         const float previewSize = 100;
 
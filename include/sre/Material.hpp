@@ -9,6 +9,7 @@
 
 #include "sre/Shader.hpp"
 #include "sre/Texture.hpp"
+#include "sre/Sampler.hpp"
 #include "glm/glm.hpp"
 #include "sre/Color.hpp"
 #include "sre/impl/UniformSet.hpp"
@@ -23,11 +24,16 @@ namespace sre {
     class Shader;
     class Texture;
     class RenderPass;
+    class UniformBufferPool;
 
     /**
      * Material encapsulates a shader and its states. Example using the standard shader (computing the color of the
      * surface using lights in the scene) a material would contain a color (glm::vec4), a texture (sre::Texture) and
      * specularity (float). The specularity determines that shininess of the material.
+     *
+     * If the shader declares a uniform block named material (layout(std140) uniform material { ... };) the non-texture
+     * uniforms of the block are stored in a shared uniform buffer. The material uploads the block when a value has
+     * changed and binds it using a single glBindBufferRange. Not supported on OpenGL ES 2.0 / WebGL 1.0.
      */
     class DllExport Material {
     public:
@@ -77,18 +83,49 @@ namespace sre {
                                                 // are ignored for metallic-roughness calculations.
                                                 // (Source https://github.com/KhronosGroup/glTF/tree/master/specification/2.0#reference-pbrmetallicroughness)
 
-        bool set(std::string uniformName, glm::vec4 value);
-        bool set(std::string uniformName, float value);
-        bool set(std::string uniformName, glm::mat4 value);
-        bool set(std::string uniformName, std::shared_ptr<Texture> value);
-        bool set(std::string uniformName, std::shared_ptr<std::vector<glm::mat3>> value);
-        bool set(std::string uniformName, std::shared_ptr<std::vector<glm::mat4>> value);
-        bool set(std::string uniformName, Color value);
+        bool set(const std::string& uniformName, glm::vec4 value);
+        bool set(const std::string& uniformName, float value);
+        bool set(const std::string& uniformName, glm::mat4 value);
+        bool set(const std::string& uniformName, std::shared_ptr<Texture> value);
+        bool set(const std::string& uniformName, std::shared_ptr<std::vector<glm::mat3>> value);
+        bool set(const std::string& uniformName, std::shared_ptr<std::vector<glm::mat4>> value);
+        bool set(const std::string& uniformName, Color value);
+
+        // Set uniform using handle (see Shader::getUniformHandle() and sre::UniformHandles). Avoids the name lookup.
+        bool set(int uniformHandle, glm::vec4 value);
+        bool set(int uniformHandle, float value);
+        bool set(int uniformHandle, glm::mat4 value);
+        bool set(int uniformHandle, std::shared_ptr<Texture> value);
+        bool set(int uniformHandle, std::shared_ptr<std::vector<glm::mat3>> value);
+        bool set(int uniformHandle, std::shared_ptr<std::vector<glm::mat4>> value);
+        bool set(int uniformHandle, Color value);
+
+        // Override the sampler state (filtering, wrap, anisotropy) used for a texture uniform. By default textures are
+        // sampled using Texture::getSampler(). Requires sampler objects (see RenderInfo::supportSamplerObjects),
+        // otherwise the override is ignored. Returns false if the uniform is not a texture.
+        bool setSampler(const std::string& uniformName, const Sampler& sampler);
+        bool setSampler(int uniformHandle, const Sampler& sampler);
+        bool removeSampler(const std::string& uniformName);                     // Use the sampler of the texture again
+        std::shared_ptr<const Sampler> getSampler(const std::string& uniformName); // Returns nullptr if not overridden
 
         template<typename T>
-        inline T get(std::string uniformName);
+        inline T get(const std::string& uniformName);
+        template<typename T>
+        inline T get(int uniformHandle);
     private:
+        bool setSamplerValue(const Uniform& uniform, std::shared_ptr<const Sampler> sampler);
         void bind();
+        Uniform getUniform(const std::string& name, UniformType type = UniformType::Invalid); // Lookup uniform in shader. Creates a provisional
+                                                                                              // uniform of type if the shader is not yet compiled
+        Uniform getUniform(int uniformHandle, UniformType type = UniformType::Invalid);
+        static UniformType getTextureUniformType(const std::shared_ptr<Texture>& texture);
+
+        template<typename T>
+        inline T getValue(const Uniform& uniform);
+        template<typename T>
+        bool setValue(const Uniform& uniform, T value);
+
+        void updateMaterialBuffer();
 
         explicit Material(std::shared_ptr<sre::Shader> shader);
         std::shared_ptr<std::vector<Uniform>> uniforms;
@@ -97,95 +134,89 @@ namespace sre {
 
         UniformSet uniformMap;
 
+        std::shared_ptr<UniformBufferPool> materialBuffer;    // std140 storage of the shader's "material" uniform block (if any)
+        int materialBufferSlot = -1;
+        bool materialBufferDirty = true;
+        std::vector<char> materialBufferData;
+
         friend class Shader;
         friend class RenderPass;
         friend class Inspector;
     };
 
+    template<typename T>
+    inline T Material::get(const std::string& uniformName) {
+        return getValue<T>(getUniform(uniformName));
+    }
+
+    template<typename T>
+    inline T Material::get(int uniformHandle) {
+        return getValue<T>(getUniform(uniformHandle));
+    }
+
     template<>
-    inline std::shared_ptr<sre::Texture> Material::get(std::string uniformName) {
-        auto t = shader->getUniform(uniformName);
-        if (t.type != UniformType::Texture && t.type != UniformType::TextureCube){
+    inline std::shared_ptr<sre::Texture> Material::getValue(const Uniform& t) {
+        if (t.type != UniformType::Texture && t.type != UniformType::TextureCube && t.type != UniformType::TextureArray){
             return nullptr;
         }
-        for (auto & tv : uniformMap.textureValues){
-            auto res = uniformMap.textureValues.find(t.id);
-            if (res != uniformMap.textureValues.end()){
-                return res->second;
-            }
-        }
-        return nullptr;
+        return uniformMap.get<std::shared_ptr<sre::Texture>>(t.id);
     }
 
     template<>
-    inline glm::vec4 Material::get(std::string uniformName)  {
-        auto t = shader->getUniform(uniformName);
+    inline glm::vec4 Material::getValue(const Uniform& t)  {
         if (t.type == UniformType::Vec4){
-            auto res = uniformMap.vectorValues.find(t.id);
-            if (res != uniformMap.vectorValues.end()){
-                return res->second;
+            if (uniformMap.contains(t.id)){
+                return uniformMap.get<glm::vec4>(t.id);
             }
         }
         return glm::vec4(0,0,0,0);
     }
 
     template<>
-    inline glm::mat4 Material::get(std::string uniformName)  {
-        auto t = shader->getUniform(uniformName);
+    inline glm::mat4 Material::getValue(const Uniform& t)  {
         if (t.type == UniformType::Mat4){
-            auto res = uniformMap.mat4Values.find(t.id);
-            if (res != uniformMap.mat4Values.end()){
-                return res->second;
+            if (uniformMap.contains(t.id)){
+                return uniformMap.get<glm::mat4>(t.id);
             }
         }
         return glm::mat4(1);
     }
 
     template<>
-    inline Color Material::get(std::string uniformName)  {
-        auto t = shader->getUniform(uniformName);
+    inline Color Material::getValue(const Uniform& t)  {
         if (t.type == UniformType::Vec4){
-            auto res = uniformMap.vectorValues.find(t.id);
-            if (res != uniformMap.vectorValues.end()){
-                Color value;
-                value.setFromLinear(res->second);
-                return value;
+            if (uniformMap.contains(t.id)){
+                return uniformMap.get<Color>(t.id);
             }
         }
         return {0,0,0,0};
     }
 
     template<>
-    inline float Material::get(std::string uniformName) {
-        auto t = shader->getUniform(uniformName);
+    inline float Material::getValue(const Uniform& t) {
         if (t.type == UniformType::Float) {
-            auto res = uniformMap.floatValues.find(t.id);
-            if (res != uniformMap.floatValues.end()){
-                return res->second;
+            if (uniformMap.contains(t.id)){
+                return uniformMap.get<float>(t.id);
             }
         }
         return 0.0f;
     }
 
     template<>
-    inline std::shared_ptr<std::vector<glm::mat3>> Material::get(std::string uniformName) {
-        auto t = shader->getUniform(uniformName);
+    inline std::shared_ptr<std::vector<glm::mat3>> Material::getValue(const Uniform& t) {
         if (t.type == UniformType::Mat3Array) {
-            auto res = uniformMap.mat3sValues.find(t.id);
-            if (res != uniformMap.mat3sValues.end()){
-                return res->second;
+            if (uniformMap.contains(t.id)){
+                return uniformMap.get<std::shared_ptr<std::vector<glm::mat3>>>(t.id);
             }
         }
         return {};
     }
 
     template<>
-    inline std::shared_ptr<std::vector<glm::mat4>> Material::get(std::string uniformName) {
-        auto t = shader->getUniform(uniformName);
+    inline std::shared_ptr<std::vector<glm::mat4>> Material::getValue(const Uniform& t) {
         if (t.type == UniformType::Mat4Array) {
-            auto res = uniformMap.mat4sValues.find(t.id);
-            if (res != uniformMap.mat4sValues.end()){
-                return res->second;
+            if (uniformMap.contains(t.id)){
+                return uniformMap.get<std::shared_ptr<std::vector<glm::mat4>>>(t.id);
             }
         }
         return {};
@@ -13,7 +13,9 @@
 #include <string>
 #include <cstdint>
 #include <map>
+#include <unordered_map>
 #include "sre/MeshTopology.hpp"
+#include "sre/MeshBVH.hpp"
 
 #include "sre/impl/Export.hpp"
 #include "Shader.hpp"
@@ -26,6 +28,21 @@ namespace sre {
     class Inspector;
 	class RenderPass;
 
+    /**
+     * Read-only view of a vertex attribute stored in a Mesh (pointer and count - no copy).
+     * The view is invalidated when the mesh is updated or destroyed.
+     */
+    template<typename T>
+    struct AttributeView {
+        const T* data = nullptr;
+        size_t size = 0;
+
+        const T* begin() const { return data; }
+        const T* end() const { return data + size; }
+        const T& operator[](size_t i) const { return data[i]; }
+        bool empty() const { return size == 0; }
+    };
+
     /**
      * Represents a Mesh object.
      * A mesh is composed of a list of named vertex attributes such as
@@ -123,6 +140,14 @@ namespace sre {
         static MeshBuilder create();                                // Create Mesh using the builder pattern. (Must end with build()).
         MeshBuilder update();                                       // Update the mesh using the builder pattern. (Must end with build()).
 
+        bool save(const std::string& path);                         // Save the mesh in the binary .srem format (interleaved vertex data, attribute
+                                                                    // layout, index sets, topology and bounds). Returns false on failure
+        static std::shared_ptr<Mesh> loadMapped(const std::string& path, bool keepVertexData = false);
+                                                                    // Load a mesh saved using save(). The file is memory mapped and uploaded to
+                                                                    // the GPU directly. Unless keepVertexData is true the vertex attributes and
+                                                                    // indices are not kept on the CPU (attribute getters will return empty
+                                                                    // vectors and the mesh cannot be updated or saved). Returns nullptr on failure
+
         int getVertexCount();                                       // Number of vertices in mesh
 
         std::vector<glm::vec3> getPositions();                      // Get position vertex attribute
@@ -139,13 +164,48 @@ namespace sre {
         int getIndicesSize(int indexSet=0);                         // Return the size of the index set
 
         template<typename T>
-        inline T get(std::string attributeName);                    // Get the vertex attribute of a given type. Type must be float,glm::vec2,
+        inline T get(const std::string& attributeName);             // Get the vertex attribute of a given type. Type must be float,glm::vec2,
                                                                     //                                                          glm::vec3,glm::vec4,glm::i32vec4
 
+        template<typename T>
+        struct AttributeHandle {                                    // Resolved vertex attribute (avoids repeated lookups by name). Becomes invalid
+            const std::vector<T>* values = nullptr;                 // when the mesh is updated.
+            uint32_t version = 0;
+        };
+
+        AttributeView<glm::vec3> getPositionsView();                // Get position vertex attribute without copying
+        AttributeView<glm::vec3> getNormalsView();                  // Get normal vertex attribute without copying
+        AttributeView<glm::vec4> getUVsView();                      // Get uv vertex attribute without copying
+        AttributeView<glm::vec4> getColorsView();                   // Get color vertex attribute without copying
+        AttributeView<glm::vec4> getTangentsView();                 // Get tangent vertex attribute without copying
+        AttributeView<float> getParticleSizesView();                // Get particle size vertex attribute without copying
+
+        template<typename T>
+        AttributeView<T> getAttributeView(const std::string& attributeName);
+                                                                    // Get the vertex attribute of a given type without copying. Type must be float,
+                                                                    // glm::vec2, glm::vec3, glm::vec4 or glm::i32vec4. Returns an empty view if not found
+        template<typename T>
+        AttributeHandle<T> getAttributeHandle(const std::string& attributeName);
+                                                                    // Resolve a vertex attribute once. Use with getAttributeView(handle)
+        template<typename T>
+        AttributeView<T> getAttributeView(const AttributeHandle<T>& handle);
+                                                                    // Get the vertex attribute without a name lookup. Returns an empty view if the
+                                                                    // handle is invalid or the mesh has been updated since the handle was created
+        template<typename T>
+        bool isValid(const AttributeHandle<T>& handle);             // Returns true if the handle refers to an attribute in the current mesh data
+
         std::pair<int,int> getType(const std::string& name);        // return element type, element count
 
         std::vector<std::string> getAttributeNames();               // Names of the vertex attributes
 
+        std::shared_ptr<MeshBVH> getBVH();                          // Get the triangle BVH (in mesh space). The BVH is built on first use and
+                                                                    // rebuilt after the mesh is updated. Returns nullptr if the mesh has no
+                                                                    // positions on the CPU
+        bool raycast(const std::array<glm::vec3,2>& ray, const glm::mat4& transform, RaycastHit& hit);
+                                                                    // Ray cast (ray origin and direction in world space) against the mesh placed
+                                                                    // using transform. Only hits closer than hit.distance are reported, which
+                                                                    // allows ray casting multiple meshes using the same RaycastHit
+
         std::array<glm::vec3,2> getBoundsMinMax();                  // get the local axis aligned bounding box (AABB)
         void setBoundsMinMax(const std::array<glm::vec3,2>& minMax);// set the local axis aligned bounding box (AABB)
 
@@ -179,21 +239,33 @@ namespace sre {
         void update(std::map<std::string,std::vector<float>>&& attributesFloat, std::map<std::string,std::vector<glm::vec2>>&& attributesVec2, std::map<std::string, std::vector<glm::vec3>>&& attributesVec3, std::map<std::string,std::vector<glm::vec4>>&& attributesVec4,std::map<std::string,std::vector<glm::i32vec4>>&& attributesIVec4, std::vector<std::vector<uint32_t>> &&indices, std::vector<MeshTopology> meshTopology, std::string name, RenderStats& renderStats, float lineWidth, glm::vec3 location, glm::vec3 rotation, glm::vec3 scaling, std::shared_ptr<Material> material);
 
         void updateIndexBuffers();
-        std::vector<float> getInterleavedData();
-
+        void uploadAppended(int firstVertex, int firstIndex);       // Upload vertices from firstVertex and indices (of index set 0) from firstIndex after
+                                                                    // the attribute and index vectors have been extended. The set of attributes must
+                                                                    // not change. Buffers grow geometrically, so only the tail is usually uploaded
+        std::vector<float> getInterleavedData(int firstVertex = 0);  // interleaved data of the vertices from firstVertex
+        std::vector<uint8_t> getConcatenatedIndices();              // index data using the layout defined in elementBufferOffsetCount
         int totalBytesPerVertex = 0;
         static uint16_t meshIdCount;
         uint16_t meshId;
 
         void setVertexAttributePointers(Shader* shader);
+        void setVertexAttributeFormat(Shader* shader);              // vertex format for VAOs shared between meshes (GL 4.3+)
+        std::string getVertexFormatKey(Shader* shader);             // identifies the VAO state (excluding buffers) for this mesh and shader
+        bool isAttributeCompatible(unsigned int shaderType, int32_t arraySize, const Attribute* meshAttribute);
+        static void setConstantVertexAttribute(int32_t position, unsigned int type, int32_t arraySize);
         std::vector<MeshTopology> meshTopology;
         unsigned int vertexBufferId;
         struct VAOBinding {
             long shaderId;
             unsigned int vaoID;
         };
-        std::map<unsigned int, VAOBinding> shaderToVertexArrayObject;
+        std::map<unsigned int, VAOBinding> shaderToVertexArrayObject;  // used when VAOs cannot be shared (before GL 4.3)
+        unsigned int sharedVAO = 0;                                 // VAO from Renderer::sharedVertexArrays (0 if not looked up yet)
+        long sharedVAOShaderId = -1;                                // shader the sharedVAO was looked up for
+        unsigned int sharedVAOProgramId = 0;
         unsigned int elementBufferId = 0;
+        int vertexBufferCapacity = 0;                               // allocated size of vertex buffer (in vertices)
+        int elementBufferCapacity = 0;                              // allocated size of element buffer (in bytes)
         std::vector<ElementBufferData> elementBufferOffsetCount;
         int vertexCount;
         int dataSize;
@@ -205,15 +277,23 @@ namespace sre {
         std::map<std::string,std::vector<glm::vec4>> attributesVec4;
         std::map<std::string,std::vector<glm::i32vec4>> attributesIVec4;
 
+        template<typename T>
+        const std::map<std::string,std::vector<T>>& getAttributeMap();
+
         std::vector<std::vector<uint32_t>> indices;
+        uint32_t attributeVersion = 0;                              // incremented when vertex attributes are replaced (invalidates AttributeHandles)
+        bool hasVertexData = true;                                  // false if vertex attributes and indices only exists on the GPU
+        std::shared_ptr<MeshBVH> bvh;
 
         std::array<glm::vec3,2> boundsMinMax;
 
         void bind(Shader* shader);
+        void bindSharedVertexArray(Shader* shader);
         void bindIndexSet();
 
         friend class RenderPass;
         friend class Inspector;
+        friend class LineContainer;
 
         bool hasAttribute(std::string name);
 
@@ -225,28 +305,91 @@ namespace sre {
     };
 
     template<>
-    inline const std::vector<float>& Mesh::get(std::string uniformName) {
-        return attributesFloat[uniformName];
+    inline const std::map<std::string,std::vector<float>>& Mesh::getAttributeMap<float>() {
+        return attributesFloat;
+    }
+
+    template<>
+    inline const std::map<std::string,std::vector<glm::vec2>>& Mesh::getAttributeMap<glm::vec2>() {
+        return attributesVec2;
     }
 
     template<>
-    inline const std::vector<glm::vec2>& Mesh::get(std::string uniformName) {
-        return attributesVec2[uniformName];
+    inline const std::map<std::string,std::vector<glm::vec3>>& Mesh::getAttributeMap<glm::vec3>() {
+        return attributesVec3;
     }
 
     template<>
-    inline const std::vector<glm::vec3>& Mesh::get(std::string uniformName) {
-        return attributesVec3[uniformName];
+    inline const std::map<std::string,std::vector<glm::vec4>>& Mesh::getAttributeMap<glm::vec4>() {
+        return attributesVec4;
     }
 
     template<>
-    inline const std::vector<glm::vec4>& Mesh::get(std::string uniformName) {
-        return attributesVec4[uniformName];
+    inline const std::map<std::string,std::vector<glm::i32vec4>>& Mesh::getAttributeMap<glm::i32vec4>() {
+        return attributesIVec4;
+    }
+
+    template<typename T>
+    inline Mesh::AttributeHandle<T> Mesh::getAttributeHandle(const std::string& attributeName) {
+        auto& map = getAttributeMap<T>();
+        auto res = map.find(attributeName);
+        if (res == map.end()){
+            return {};
+        }
+        return {&res->second, attributeVersion};
+    }
+
+    template<typename T>
+    inline bool Mesh::isValid(const AttributeHandle<T>& handle) {
+        return handle.values != nullptr && handle.version == attributeVersion;
+    }
+
+    template<typename T>
+    inline AttributeView<T> Mesh::getAttributeView(const AttributeHandle<T>& handle) {
+        if (!isValid(handle)){
+            return {};
+        }
+        return {handle.values->data(), handle.values->size()};
+    }
+
+    template<typename T>
+    inline AttributeView<T> Mesh::getAttributeView(const std::string& attributeName) {
+        return getAttributeView(getAttributeHandle<T>(attributeName));
+    }
+
+    template<>
+    inline const std::vector<float>& Mesh::get(const std::string& attributeName) {
+        static const std::vector<float> empty;
+        auto res = attributesFloat.find(attributeName);
+        return res == attributesFloat.end() ? empty : res->second;
     }
 
     template<>
-    inline const std::vector<glm::i32vec4>& Mesh::get(std::string uniformName) {
-        return attributesIVec4[uniformName];
+    inline const std::vector<glm::vec2>& Mesh::get(const std::string& attributeName) {
+        static const std::vector<glm::vec2> empty;
+        auto res = attributesVec2.find(attributeName);
+        return res == attributesVec2.end() ? empty : res->second;
+    }
+
+    template<>
+    inline const std::vector<glm::vec3>& Mesh::get(const std::string& attributeName) {
+        static const std::vector<glm::vec3> empty;
+        auto res = attributesVec3.find(attributeName);
+        return res == attributesVec3.end() ? empty : res->second;
+    }
+
+    template<>
+    inline const std::vector<glm::vec4>& Mesh::get(const std::string& attributeName) {
+        static const std::vector<glm::vec4> empty;
+        auto res = attributesVec4.find(attributeName);
+        return res == attributesVec4.end() ? empty : res->second;
+    }
+
+    template<>
+    inline const std::vector<glm::i32vec4>& Mesh::get(const std::string& attributeName) {
+        static const std::vector<glm::i32vec4> empty;
+        auto res = attributesIVec4.find(attributeName);
+        return res == attributesIVec4.end() ? empty : res->second;
     }
 
     // The LineContainer helper class enables fast drawing of many lines. This
@@ -260,6 +403,14 @@ namespace sre {
 	// is known to be slow, per the notes in RenderPass.hpp) went from
 	// approximately four seconds down to less than 1/60 of a second when
 	// implmented using the LineContainer class (a factor of 15K faster!)
+	//
+	// Lines are grouped by line width (and topology), with the color stored
+	// per vertex, so each group is drawn using a single draw call. Line strips
+	// are stored as line segments, so any number of strips can share a group.
+	// Lines wider than 1 are drawn as screen space quads with miter joins
+	// between the segments of a line strip (see Shader::getUnlitLine()), since
+	// glLineWidth is clamped to 1 in core profiles. Added lines are appended to
+	// the GPU buffers of the group, so only the new vertices are uploaded.
 
 	class LineContainer {
 	public:
@@ -272,17 +423,23 @@ namespace sre {
 		void draw(RenderPass& renderPass);
 		// Clear the container without deallocating the memory
 		void clear();
-		// Output the LineContainer vector sizes and capacities to std::cout
+		// Output the LineContainer group sizes and capacities to std::cout
 		void output();
 	private:
-		enum class MeshStatus {Initialized, Uninitialized};
-		std::vector<Color> m_colors;
-		std::vector<std::shared_ptr<Material>> m_materials;
-		std::vector<MeshTopology> m_topologies;
-		std::vector<float> m_lineWidths;
-		std::vector<std::vector<glm::vec3>> m_vertices;
-		std::vector<std::shared_ptr<sre::Mesh>> m_meshes;
-		std::vector<MeshStatus> m_status;
+		struct Group {
+			float lineWidth;
+			MeshTopology topology;
+			bool wide;                      // rendered as screen space quads
+			std::shared_ptr<Mesh> mesh;     // vertex data is appended directly to the mesh attributes
+			std::shared_ptr<Material> material;
+			int uploadedVertices = 0;
+			int uploadedIndices = 0;
+		};
+		Group& getGroup(float lineWidth, MeshTopology topology);
+		void addWide(Group& group, const std::vector<glm::vec3> & vertices,
+					const glm::vec4 & color, bool strip);
+		std::unordered_map<uint64_t, int> m_groupIndex;     // (line width, topology) to index in m_groups
+		std::vector<Group> m_groups;
 	};
 
 }
@@ -0,0 +1,87 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include "glm/glm.hpp"
+#include <array>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <limits>
+#include "sre/MeshTopology.hpp"
+
+#include "sre/impl/Export.hpp"
+
+namespace sre {
+
+    /**
+     * Result of a ray cast against a mesh.
+     * The distance is measured along the ray direction in the space of the ray (when the ray direction is normalized
+     * the distance is in world units).
+     */
+    struct DllExport RaycastHit {
+        float distance = std::numeric_limits<float>::max();     // distance along the ray
+        glm::vec3 point;                                        // hit point (in the space of the ray)
+        glm::vec3 barycentric;                                  // barycentric coordinates (weight of vertex 0, 1 and 2)
+        std::array<uint32_t,3> vertices;                        // vertex indices of the triangle
+        int triangle = -1;                                      // triangle index within the index set
+        int indexSet = -1;                                      // index set (submesh) of the triangle
+    };
+
+    /**
+     * Bounding volume hierarchy of the triangles in a mesh (in mesh space).
+     *
+     * The BVH is built using binned SAH (surface area heuristic). Large meshes are built using multiple threads.
+     * The nodes are stored in a flat array, where the two children of a node are stored next to each other.
+     *
+     * A MeshBVH is usually created lazily using Mesh::getBVH(), but can also be created directly from vertex positions
+     * and indices. Only triangle topologies (Triangles, TriangleStrip and TriangleFan) are included.
+     */
+    class DllExport MeshBVH {
+    public:
+        struct TriangleId {
+            int indexSet;                                       // index set (submesh) of the triangle
+            int triangle;                                       // triangle index within the index set
+        };
+
+        static std::shared_ptr<MeshBVH> create(const std::vector<glm::vec3>& positions,
+                                               const std::vector<std::vector<uint32_t>>& indices,
+                                               const std::vector<MeshTopology>& meshTopology);
+                                                                // Build BVH. If indices is empty the vertices are used
+                                                                // sequentially (using meshTopology[0])
+
+        bool raycast(const std::array<glm::vec3,2>& ray, RaycastHit& hit, float maxDistance = std::numeric_limits<float>::max()) const;
+                                                                // Find closest triangle intersected by the ray (origin, direction).
+                                                                // Returns false if no triangle is hit within maxDistance
+        bool raycastAny(const std::array<glm::vec3,2>& ray, float maxDistance = std::numeric_limits<float>::max()) const;
+                                                                // Returns true if any triangle is hit within maxDistance (early out)
+        void overlap(const std::array<glm::vec3,2>& aabbMinMax, std::vector<TriangleId>& result) const;
+                                                                // Append the triangles intersecting the axis aligned box to result
+
+        std::array<glm::vec3,2> getBoundsMinMax() const;        // Bounds of all triangles
+        int getTriangleCount() const;
+        int getNodeCount() const;
+        size_t getDataSize() const;                             // Size of the BVH in bytes (CPU memory)
+    private:
+        MeshBVH() = default;
+
+        struct Node {                                           // 32 bytes
+            glm::vec3 boundsMin;
+            uint32_t leftOrFirst;                               // index of left child (right child is leftOrFirst+1) or first triangle in leaf
+            glm::vec3 boundsMax;
+            uint32_t count;                                     // number of triangles in leaf (0 for inner nodes)
+        };
+
+        struct Builder;
+
+        std::vector<Node> nodes;
+        std::vector<glm::vec3> triangleVertices;                // three vertices per triangle (in BVH order)
+        std::vector<TriangleId> triangleIds;                    // (in BVH order)
+        std::vector<std::array<uint32_t,3>> triangleIndices;    // vertex indices (in BVH order)
+    };
+}
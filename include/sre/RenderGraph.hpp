@@ -0,0 +1,118 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "glm/glm.hpp"
+#include "sre/RenderPass.hpp"
+#include "sre/Texture.hpp"
+#include "sre/impl/Export.hpp"
+#include "sre/impl/RenderGraphCompiler.hpp"
+
+namespace sre {
+    /**
+     * A render graph describes the render passes of a frame and the textures they read and write. When executed, the
+     * graph:
+     * - culls passes whose outputs are not used (by the screen, a later pass or a texture marked as output)
+     * - executes the passes in dependency order
+     * - allocates transient textures and framebuffers from the RenderTargetPool. Transient textures only exist
+     *   between the first and last pass using them, so textures with non-overlapping lifetimes are shared. Textures
+     *   marked as output stay allocated until the next execute() or clear() (at most until the end of the frame)
+     * - generates mipmaps of mipmapped textures once after they are written, and only if they are read later
+     *
+     * Passes are built when executed, so ImGui may only be used in the execute function of a pass with GUI enabled
+     * (passes have GUI disabled unless enabled with RenderPassBuilder::withGUI() in the setup function). Materials
+     * should sample transient textures using getTexture() in the execute function.
+     *
+     * Example:
+     * RenderGraph graph("Frame");
+     * auto shadowMap = graph.createTexture("Shadow map", {1024, 1024}, Texture::DepthPrecision::I24);
+     * graph.addPass("Shadow")
+     *      .writeDepth(shadowMap)
+     *      .withSetup([&](RenderPass::RenderPassBuilder& builder){ builder.withCamera(lightCamera); })
+     *      .withExecute([&](RenderPass& renderPass){ renderPass.draw(mesh, transform, shadowMaterial); });
+     * graph.addPass("Main")
+     *      .read(shadowMap)
+     *      .writeScreen()
+     *      .withSetup([&](RenderPass::RenderPassBuilder& builder){ builder.withCamera(camera).withGUI(true); })
+     *      .withExecute([&](RenderPass& renderPass){
+     *          material->set("shadowMap", graph.getTexture(shadowMap));
+     *          renderPass.draw(mesh, transform, material);
+     *      });
+     * graph.execute();                                                   // each frame
+     */
+    class DllExport RenderGraph {
+    public:
+        class DllExport PassBuilder {
+        public:
+            PassBuilder& read(int texture);                                     // The pass samples the texture
+            PassBuilder& writeColor(int texture);                               // Color attachment (in the order declared)
+            PassBuilder& writeDepth(int texture);                               // Depth attachment
+            PassBuilder& writeScreen();                                         // Render to the screen (passes writing the screen are never culled)
+            PassBuilder& withSetup(std::function<void(RenderPass::RenderPassBuilder&)> setup); // Configure the render pass (camera, clear, ...)
+            PassBuilder& withExecute(std::function<void(RenderPass&)> execute); // Draw calls of the pass
+        private:
+            PassBuilder(RenderGraph* graph, int pass);
+            RenderGraph* graph;
+            int pass;
+            friend class RenderGraph;
+        };
+
+        explicit RenderGraph(std::string name = "RenderGraph");
+        ~RenderGraph();
+
+        int createTexture(const std::string& name, glm::ivec2 size,              // Transient texture allocated from the RenderTargetPool
+                          Texture::DepthPrecision depthPrecision = Texture::DepthPrecision::None,
+                          Texture::SamplerColorspace samplerColorspace = Texture::SamplerColorspace::Linear);
+        int importTexture(const std::string& name, std::shared_ptr<Texture> texture); // Texture owned outside the graph
+        void markOutput(int texture);                                           // The texture is used after the graph is executed (see getTexture())
+
+        PassBuilder addPass(const std::string& name);
+
+        bool compile();                                                         // Returns false if the graph is invalid (called by execute if needed)
+        void execute();                                                         // Executes the passes not culled
+        void clear();                                                           // Remove all passes and textures
+
+        std::shared_ptr<Texture> getTexture(int texture);                       // Returns nullptr if a transient texture is not allocated
+        const std::string& getName();
+        std::string toGraphviz();                                               // The compiled graph in the Graphviz dot format
+    private:
+        struct TextureNode {
+            std::string name;
+            glm::ivec2 size;
+            Texture::DepthPrecision depthPrecision;
+            Texture::SamplerColorspace samplerColorspace;
+            std::shared_ptr<Texture> texture;                                   // imported or currently allocated texture
+            bool imported = false;
+            bool output = false;
+        };
+        struct PassNode {
+            std::string name;
+            std::vector<int> reads;
+            std::vector<int> colorWrites;
+            int depthWrite = -1;
+            bool writesScreen = false;
+            std::function<void(RenderPass::RenderPassBuilder&)> setup;
+            std::function<void(RenderPass&)> execute;
+        };
+        bool isValidTexture(int texture);
+        void releaseOutputs();
+        void generateMipmaps(Texture* texture);
+
+        std::string name;
+        std::vector<TextureNode> textures;
+        std::vector<PassNode> passes;
+        RenderGraphCompiler::Result compiled;
+        bool dirty = true;
+        int executedFrame = -1;                                                 // frame of the last execute (outputs are reserved in this frame)
+        friend class Inspector;
+    };
+}
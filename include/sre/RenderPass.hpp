@@ -12,6 +12,7 @@
 #include "sre/Mesh.hpp"
 #include "sre/Material.hpp"
 #include "sre/WorldLights.hpp"
+#include "sre/SpatialIndex.hpp"
 #include <string>
 #include <functional>
 
@@ -53,6 +54,8 @@ namespace sre {
                                                                                                    // calls ImGui::Render() in the end of the renderpass
 
             RenderPassBuilder& withFramebuffer(std::shared_ptr<Framebuffer> framebuffer);
+            RenderPassBuilder& withGenerateMipmaps(bool enabled = true);                           // Regenerate mipmaps of the framebuffer textures when the
+                                                                                                   // renderpass finishes. Default: enabled
             RenderPass build();
         private:
             RenderPassBuilder() = default;
@@ -74,6 +77,7 @@ namespace sre {
             std::shared_ptr<Skybox> skybox;
 
             bool gui = true;
+            bool generateMipmaps = true;
 
             explicit RenderPassBuilder(RenderStats* renderStats);
             friend class RenderPass;
@@ -99,6 +103,9 @@ namespace sre {
                   glm::mat4 modelTransform,                             // The modelTransform defines the modelToWorld transformation
                   std::vector<std::shared_ptr<Material>> materials);    // The number of materials must match the size of index sets in the model
 
+        void draw(SpatialIndex& spatialIndex);                          // Draws the instances of the spatial index which intersects
+                                                                        // the camera frustum
+
         void draw(std::shared_ptr<SpriteBatch>& spriteBatch,            // Draws a spriteBatch using modelTransform
                   glm::mat4 modelTransform = glm::mat4(1));             // using a model-to-world transformation
 
@@ -111,19 +118,17 @@ namespace sre {
         void blit(std::shared_ptr<Material> material,                   // Render material to screen
                   glm::mat4 transformation = glm::mat4(1.0f));
 
-        glm::vec2 frameSize();                                          // Return the frame/window size for this RenderPass 
+        glm::vec2 frameSize();                                          // Return the frame/window size for this RenderPass (see Framebuffer::setRenderScale())
 
         std::vector<Color> readPixels(unsigned int x,                   // Reads pixel(s) from the current framebuffer and returns an array of color values
                                           unsigned int y,               // The defined rectangle must be within the size of the current framebuffer
                                           unsigned int width = 1,       // This function must be called after finish has been explicitly called on the renderPass
-                                          unsigned int height = 1,      // If readFromScreen == true, then read from the screen instead of the framebuffer, which
-                                          bool readFromScreen = false); // is useful when a multipass framebuffer is attached (in this case glReadPixels won't work)
+                                          unsigned int height = 1);     // Multisampled framebuffers are read after being resolved
 
         std::vector<glm::u8vec4> readRawPixels(unsigned int x,          // Similar to 'readPixels' above, except this returns array of 8-bit values
                                           unsigned int y,               // (the format is RGBA per pixel: each pixel generates 4 x 8-bits = 32 bits = 4 bytes,
                                           unsigned int width = 1,       // or one item in the u8vec4 array), useful for using e.g. stbi_write to write images
-                                          unsigned int height = 1,
-                                          bool readFromScreen = false);
+                                          unsigned int height = 1);
 
         void finishGPUCommandBuffer();                                  // GPU command buffer (must be called when
                                                                         // profiling GPU time - should not be called
@@ -159,6 +164,7 @@ namespace sre {
         std::vector<RenderQueueObj> renderQueue;
 
         void drawInstance(RenderQueueObj& rqObj);                       // perform the actual rendering
+        void requestStreamedLevels(RenderQueueObj& rqObj);              // request the mip levels of streamed textures needed for the screen size
 
         RenderPass::RenderPassBuilder builder;
         explicit RenderPass(RenderPass::RenderPassBuilder& builder);
@@ -21,10 +21,24 @@ namespace sre {
         int textureBytes=0;                                   // Size of allocated textures in bytes
         int textureBytesAllocated=0;                          // Size of allocated textures in bytes this frame
         int textureBytesDeallocated=0;                        // Size of deallocated textures in bytes this frame
+        int textureStreamedBytes=0;                           // Size of the resident mip levels of streamed textures in bytes (included in textureBytes)
+        int textureLevelsStreamed=0;                          // Number of mip levels uploaded by texture streaming this frame
+        int textureLevelsEvicted=0;                           // Number of mip levels evicted by texture streaming this frame
+        int renderTargetPoolBytes=0;                          // Size of the textures in the RenderTargetPool in bytes (included in textureBytes)
+        int renderTargetPoolHits=0;                           // Number of render targets reused from the RenderTargetPool this frame
+        int renderTargetPoolMisses=0;                         // Number of render targets allocated by the RenderTargetPool this frame
         int shaderCount=0;                                    // Number of allocated shaders
+        float shaderBuildTime=0;                              // Accumulated time in ms spent building shader programs (compile, link or load binary)
+        int shaderBinaryCacheHits=0;                          // Number of shader programs loaded from the program binary cache
+        int shaderBinaryCacheMisses=0;                        // Number of shader programs compiled because no valid program binary was cached
         int drawCalls=0;                                      // Number of drawCalls per frame
+        int drawCallsSkipped=0;                               // Number of drawCalls skipped per frame, since the shader was still being compiled
         int stateChangesShader=0;                             // Number of state changes for shaders
         int stateChangesMaterial=0;                           // Number of state changes for materials
+        int uniformUploadsElided=0;                           // Number of material uniform uploads skipped per frame, since the program already had the value
+        int textureBindsAvoided=0;                            // Number of texture binds skipped per frame, since the texture was already bound to the texture unit
         int stateChangesMesh=0;                               // Number of state changes for meshes
+        float dynamicResolutionScale=1;                       // Render scale chosen by DynamicResolution (1 if not used)
+        float dynamicResolutionTime=0;                        // Frame time in ms measured by DynamicResolution (GPU time if supported)
     };
 }
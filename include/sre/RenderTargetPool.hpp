@@ -0,0 +1,76 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "glm/glm.hpp"
+#include "sre/Texture.hpp"
+#include "sre/impl/Export.hpp"
+
+namespace sre {
+    class Framebuffer;
+    struct RenderStats;
+
+    /**
+     * Pool of transient render targets (textures and framebuffers), such as shadow maps, G-buffers and post processing
+     * buffers. Use Renderer::getRenderTargetPool() to access the pool.
+     *
+     * getTexture() returns a texture of the requested size and format, which is reserved until the end of the frame
+     * (Renderer::swapWindow()) or until it is given back using release(). Targets whose lifetimes do not overlap share
+     * the same texture, and released targets are reused in later frames. Targets not used for getMaxUnusedFrames()
+     * frames are deleted (e.g. the old size after a window resize).
+     *
+     * Pooled textures are not mipmapped, clamp to edge and must not be used after being released.
+     *
+     * Example:
+     * auto& pool = Renderer::instance->getRenderTargetPool();
+     * auto color = pool.getTexture(Renderer::instance->getDrawableSize());
+     * auto renderPass = RenderPass::create().withFramebuffer(pool.getFramebuffer({color})).build();
+     */
+    class DllExport RenderTargetPool {
+    public:
+        std::shared_ptr<Texture> getTexture(glm::ivec2 size,                                  // Returns a color (RGBA) or depth texture
+                                            Texture::DepthPrecision depthPrecision = Texture::DepthPrecision::None,
+                                            Texture::SamplerColorspace samplerColorspace = Texture::SamplerColorspace::Linear);
+        std::shared_ptr<Framebuffer> getFramebuffer(const std::vector<std::shared_ptr<Texture>>& colorTextures, // Returns a framebuffer with the
+                                                    std::shared_ptr<Texture> depthTexture = nullptr);          // attachments (cached between frames)
+        void release(const std::shared_ptr<Texture>& texture);                                 // The texture may be returned by getTexture() again
+
+        void setMaxUnusedFrames(int frames);                                                   // Frames before unused targets are deleted (default 2)
+        int getMaxUnusedFrames();
+
+        int getTargetCount();                                                                  // Number of pooled textures
+        int getDataSize();                                                                     // Size of pooled textures in bytes on the GPU
+        void clear();                                                                          // Delete all targets (must not be in use)
+    private:
+        RenderTargetPool() = default;
+        void update(RenderStats& renderStats);                                                 // End of frame (called in Renderer::swapWindow())
+
+        struct Target {
+            std::shared_ptr<Texture> texture;
+            glm::ivec2 size;
+            Texture::DepthPrecision depthPrecision;
+            Texture::SamplerColorspace samplerColorspace;
+            bool inUse;
+            int lastUsedFrame;
+        };
+        struct CachedFramebuffer {
+            std::shared_ptr<Framebuffer> framebuffer;
+            std::vector<std::shared_ptr<Texture>> colorTextures;
+            std::shared_ptr<Texture> depthTexture;
+            int lastUsedFrame;
+        };
+        std::vector<Target> targets;
+        std::vector<CachedFramebuffer> framebuffers;
+        int frame = 0;
+        int maxUnusedFrames = 2;
+        int dataSize = 0;
+        friend class Renderer;
+    };
+}
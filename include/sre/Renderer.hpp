@@ -13,9 +13,16 @@
 #include "sre/Camera.hpp"
 #include "sre/RenderPass.hpp"
 
+#include <unordered_map>
+#include <map>
+#include <memory>
 #include "sre/impl/Export.hpp"
 #include "RenderStats.hpp"
 #include "Mesh.hpp"
+#include "sre/impl/TextureBindingCache.hpp"
+#include "sre/impl/TextureStreaming.hpp"
+#include "sre/impl/SamplerCache.hpp"
+#include "sre/RenderTargetPool.hpp"
 
 
 namespace sre {
@@ -26,11 +33,26 @@ namespace sre {
     class Shader;
     class Shader;
 	class VR;
+    class UniformBufferPool;
+    class RenderGraph;
 
     struct RenderInfo{
         bool useFramebufferSRGB = false;
         bool supportTextureSamplerSRGB = false;
         bool supportFBODepthAttachment = false;
+        bool supportVertexAttribBinding = false;   // Separate vertex format and buffer binding (OpenGL 4.3). Allows meshes to share VAOs
+        bool supportProgramBinary = false;         // glGetProgramBinary/glProgramBinary with at least one binary format (see Shader::setProgramBinaryCacheDirectory())
+        bool supportParallelShaderCompile = false; // GL_KHR_parallel_shader_compile. Allows polling the link status of asynchronous shader builds
+        bool supportTextureCompressionS3TC = false;     // BC1 and BC3 (DXT1/DXT5) textures
+        bool supportTextureCompressionS3TCSRGB = false; // sRGB BC1 and BC3 textures
+        bool supportTextureCompressionRGTC = false;     // BC4 and BC5 textures
+        bool supportTextureCompressionBPTC = false;     // BC7 textures
+        bool supportTextureCompressionETC2 = false;     // ETC2 RGB and RGBA textures
+        bool supportSamplerObjects = false;        // Sampler objects (see Sampler). Otherwise textures are sampled using their own settings
+        float maxAnisotropy = 1;                   // Max anisotropic filtering (1 if not supported)
+        int maxSamples = 1;                        // Max samples of multisampled framebuffers (1 if not supported)
+        bool supportInvalidateFramebuffer = false; // glInvalidateFramebuffer (discard multisample attachments after resolve)
+        bool supportTimerQuery = false;            // GL_TIME_ELAPSED queries (GPU time measured by DynamicResolution)
         int graphicsAPIVersionMajor;            // For WebGL uses OpenGL ES api version (WebGL 1.0 = OpenGL ES 2.0)
         int graphicsAPIVersionMinor;
         bool graphicsAPIVersionES;
@@ -88,6 +110,8 @@ namespace sre {
 
         int getMaxSceneLights();                            // Get maximum amout of scenelights per object
 
+        RenderTargetPool& getRenderTargetPool();            // Transient textures and framebuffers (recycled between frames)
+
     private:
         int maxSceneLights = 4;                             // Maximum of scene lights
         SDL_Window *window;
@@ -99,14 +123,26 @@ namespace sre {
         RenderStats renderStats;
 
         std::vector<Framebuffer*> framebufferObjects;
+        std::vector<RenderGraph*> renderGraphs;
         std::vector<Mesh*> meshes;
         std::vector<Shader*> shaders;
         std::vector<Texture*> textures;
         std::vector<SpriteAtlas*> spriteAtlases;
+        std::unordered_map<std::string, GLuint> sharedVertexArrays;  // VAOs shared by meshes with the same vertex format (see Mesh::getVertexFormatKey())
 
         void initGlobalUniformBuffer();
         GLuint globalUniformBuffer = 0;
         GLuint globalUniformBufferSize = 0;
+        static constexpr int globalUniformBindingIndex = 1;
+        static constexpr int materialUniformBindingIndex = 2;
+
+        std::shared_ptr<UniformBufferPool> getMaterialUniformBuffer(int blockSize);
+        std::map<int, std::shared_ptr<UniformBufferPool>> materialUniformBuffers; // shared buffers for "material" uniform blocks by block size
+
+        TextureBindingCache textureBindings;                // textures bound to each texture unit
+        SamplerCache samplers;                              // shared sampler objects
+        TextureStreaming textureStreaming;                  // mip levels of streamed textures
+        RenderTargetPool renderTargetPool;
 
         ImGuiContext* imGuiContext = nullptr;
 
@@ -120,6 +156,10 @@ namespace sre {
         friend class RenderPass;
         friend class Inspector;
         friend class SpriteAtlas;
+        friend class RenderTargetPool;
+        friend class RenderGraph;
+        friend class DynamicResolution;
+        friend class UniformSet;
 		friend class VR;
         friend class RenderPass::RenderPassBuilder;
         friend void ImGui_SRE_NewFrame(SDL_Window *window);
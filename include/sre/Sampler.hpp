@@ -0,0 +1,40 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include "sre/Texture.hpp"
+#include "sre/impl/Export.hpp"
+
+namespace sre {
+    /**
+     * Describes how a texture is sampled (filtering, wrapping, anisotropy and depth compare).
+     *
+     * Each texture has a default sampler (see Texture::getSampler()) defined by the TextureBuilder settings. A material
+     * can override the sampler used for a texture uniform (see Material::setSampler()), so the same texture can be
+     * sampled in different ways without duplicating it.
+     *
+     * Samplers are bound as OpenGL sampler objects, which are shared between equal samplers. Sampler objects are not
+     * supported on OpenGL ES 2 / WebGL 1, where the texture parameters (the default sampler) are always used.
+     */
+    struct DllExport Sampler {
+        enum class Filter {
+            Point,              // Nearest texel
+            Bilinear,           // Linear filtering within a mip level
+            Trilinear           // Linear filtering between mip levels (Bilinear for textures without mipmaps)
+        };
+
+        Filter filter = Filter::Trilinear;
+        Texture::Wrap wrap = Texture::Wrap::Repeat;
+        float anisotropy = 1;   // Max anisotropy (1 = disabled). Clamped to RenderInfo::maxAnisotropy. Ignored by Point filtering
+        bool depthCompare = false; // Compare depth with the reference value (sampler2DShadow). Ignored for non-depth textures
+
+        bool operator==(const Sampler& other) const;
+        bool operator!=(const Sampler& other) const;
+        bool operator<(const Sampler& other) const;
+    };
+}
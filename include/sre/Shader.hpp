@@ -14,12 +14,15 @@
 #include "sre/impl/Export.hpp"
 #include "sre/impl/GL.hpp"
 #include "sre/impl/CPPShim.hpp"
+#include "sre/impl/UniformSet.hpp"
 
 #include <string>
 #include <memory>
 #include <vector>
 #include <map>
 #include <set>
+#include <list>
+#include <unordered_map>
 
 
 namespace sre {
@@ -39,6 +42,7 @@ namespace sre {
         IVec4,
         Texture,
         TextureCube,
+        TextureArray,
         Invalid
     };
 
@@ -61,6 +65,22 @@ namespace sre {
 
     const char* c_str(UniformType u);
 
+    // Handles of uniforms used by the built-in shaders. The names are registered before any other uniform name
+    // (see Shader::getUniformHandle())
+    namespace UniformHandles {
+        constexpr int color = 0;                // "color"
+        constexpr int tex = 1;                  // "tex"
+        constexpr int specularity = 2;          // "specularity"
+        constexpr int metallicRoughness = 3;    // "metallicRoughness"
+        constexpr int mrTex = 4;                // "mrTex"
+        constexpr int normalTex = 5;            // "normalTex"
+        constexpr int normalScale = 6;          // "normalScale"
+        constexpr int emissiveTex = 7;          // "emissiveTex"
+        constexpr int emissiveFactor = 8;       // "emissiveFactor"
+        constexpr int occlusionTex = 9;         // "occlusionTex"
+        constexpr int occlusionStrength = 10;   // "occlusionStrength"
+    }
+
     struct DllExport Uniform {
 		std::string name;
         int id;
@@ -164,6 +184,10 @@ namespace sre {
             ShaderBuilder& withCullFace(CullFace face);
             ShaderBuilder& withStencil(Stencil stencil);
             ShaderBuilder& withName(const std::string& name);
+            ShaderBuilder& withAsyncCompile(bool enabled = true);  // build() returns without waiting for the driver to compile and link the program
+                                                                   // (uses GL_KHR_parallel_shader_compile when supported). Draw calls using the shader
+                                                                   // are skipped until Shader::isReady() returns true. Compile errors are logged later.
+                                                                   // Specializations created from the shader are compiled asynchronously too.
             std::shared_ptr<Shader> build(std::vector<std::string>& errors);
             std::shared_ptr<Shader> build();
             ShaderBuilder(const ShaderBuilder&) = default;
@@ -181,6 +205,7 @@ namespace sre {
             Shader *updateShader = nullptr;
             BlendType blend = BlendType::Disabled;
             Stencil stencil = {};
+            bool asyncCompile = false;
             friend class Shader;
         };
 
@@ -208,6 +233,8 @@ namespace sre {
                                                                //   Adds VertexAttribute "color" vec4 defined in linear space.
                                                                // S_TWO_SIDED
                                                                //   Disables face culling and flips normal on backface
+                                                               // S_TEXTURE_ARRAY
+                                                               //   "tex" is a texture array. The layer is read from uv.z
 
 
         static std::shared_ptr<Shader> getStandardBlinnPhong(); // Blinn-Phong Light Model. Uses light objects and ambient light set in Renderer.
@@ -228,6 +255,8 @@ namespace sre {
                                                                 //   Adds VertexAttribute "tangent" vec4. Used for normal maps. Otherwise compute using
                                                                 // S_NORMALMAP
                                                                 //   Adds Uniforms "normalTex" (Texture) and "normalScale" (float)
+                                                                // S_TEXTURE_ARRAY
+                                                                //   "tex" is a texture array. The layer is read from uv.z
 
 
         static std::shared_ptr<Shader> getStandardPhong();      // Similar to Blinn-Phong, but with more accurate specular highlights
@@ -239,6 +268,18 @@ namespace sre {
                                                                // Specializations
                                                                // S_VERTEX_COLOR
                                                                //   Adds VertexAttribute "color" vec4 defined in linear space.
+                                                               // S_TEXTURE_ARRAY
+                                                               //   "tex" is a texture array. The layer is read from uv.z
+
+        static std::shared_ptr<Shader> getUnlitLine();         // Screen space lines of any width rendered as quads (see LineContainer)
+                                                               // Uniforms
+                                                               //   "color" vec4 (default (1,1,1,1))
+                                                               //   "lineWidth" float (width in pixels)
+                                                               // VertexAttributes
+                                                               //   "position" vec3
+                                                               //   "line_other" vec4 (xyz other end point of the segment, w side -1 or 1)
+                                                               //   "line_adjacent" vec4 (xyz adjacent point, w 1 if miter joined)
+                                                               //   "vertex_color" vec4 defined in linear space.
 
         static std::shared_ptr<Shader> getSkybox();            // Textured skybox
                                                                // Uniforms
@@ -259,6 +300,9 @@ namespace sre {
                                                                // Uniforms
                                                                //   "color" vec4 (default (1,1,1,1))
                                                                //   "tex" shared_ptr<Texture> (default white texture)
+                                                               // Specializations
+                                                               // S_TEXTURE_ARRAY
+                                                               //   "tex" is a texture array. The layer is read from uv.z (see SpriteBatch)
 
         static std::shared_ptr<Shader> getStandardParticles(); // StandardParticles
                                                                // Uniforms
@@ -277,16 +321,46 @@ namespace sre {
                                                               // Uniforms
                                                               //   "tex" shared_ptr<Texture> (default white texture)
 
+        static std::shared_ptr<Shader> getBlitUpscale();      // Shader used for upscaling with sharpening (see DynamicResolution)
+                                                              // Uniforms
+                                                              //   "tex" shared_ptr<Texture> (default white texture)
+                                                              //   "upscale" vec4 xy part of the texture sampled (uv 0.0 - xy), zw 1.0 / texture size
+                                                              //   "sharpness" float 0.0 (bilinear) - 1.0
+
 
 
         static ShaderBuilder create();
+
+        static void setProgramBinaryCacheDirectory(const std::string& directory); // Store linked shader programs as program binaries in directory and
+                                                               // load them instead of compiling when possible. The key of a program
+                                                               // binary is a hash of the preprocessed sources, the specialization
+                                                               // constants and the driver vendor and version. Empty string disables
+                                                               // the cache (default). Build time is reported in RenderStats.
+        static const std::string& getProgramBinaryCacheDirectory();
+        static void setSpecializationCacheSize(int size);      // Number of recently used specializations kept alive when no material uses
+                                                               // them, which avoids recompiling when features are toggled (default 32)
+        static int getSpecializationCacheSize();
+        static void clearSpecializationCache();                // Release the cached specializations (called when the Renderer is destroyed)
         ShaderBuilder update();                                // Update the shader using the builder pattern. (Must end with build()).
 
         ~Shader();
 
         std::shared_ptr<Material> createMaterial(std::map<std::string,std::string> specializationConstants = {});
 
+        std::vector<std::shared_ptr<Shader>> warmup(const std::vector<std::map<std::string,std::string>>& specializations);
+                                                               // Start compiling the specializations in parallel without waiting for the
+                                                               // result (e.g. during a loading screen). The returned shaders must be kept
+                                                               // alive for the variants to be reused by createMaterial()
+
+        bool isReady();                                        // Return true if the shader program is linked and can be used for rendering.
+                                                               // Completes a pending asynchronous build, when the driver is done
+
         Uniform getUniform(const std::string &name);
+        Uniform getUniform(int uniformHandle);                 // Constant time lookup using handle (see getUniformHandle())
+
+        static int getUniformHandle(const std::string &name);  // Return a small integer identifying the uniform name. The handle is the same for
+                                                               // all shaders and stays valid for the lifetime of the application.
+        static const std::string& getUniformName(int uniformHandle);
 
         std::pair<int,int> getAttibuteType(const std::string & name); // Return type, size of the attribute
 
@@ -318,9 +392,8 @@ namespace sre {
         std::set<std::string> getAllSpecializationConstants();
     private:
         std::string precompile(std::string source, std::vector<std::string>& errors, uint32_t shaderType);
-        std::string insertPreprocessorDefines(std::string source,
-                                              std::map<std::string, std::string> &specializationConstants,
-                                              uint32_t shaderType);
+        std::string getPreprocessorDefines(const std::map<std::string, std::string> &specializationConstants,
+                                           uint32_t shaderType);
 
         bool setLights(WorldLights* worldLights);
 
@@ -329,10 +402,18 @@ namespace sre {
         std::map<std::string,std::string> specializationConstants = {};
 
         std::shared_ptr<Shader> parent = nullptr;
-        std::vector<std::weak_ptr<Shader>> specializations;
+        std::unordered_map<uint64_t, std::weak_ptr<Shader>> specializations; // specializations by hash of the sorted constants
+        std::list<std::shared_ptr<Shader>>::iterator specializationCacheEntry;
+        bool inSpecializationCache = false;
+        static void cacheSpecialization(const std::shared_ptr<Shader>& shader);
+        static void trimSpecializationCache();
+        void clearSpecializations();
 
         bool build(std::map<ShaderType,std::string> shaderSources, std::vector<std::string>& errors);
-        bool compileShader(std::string& resource, GLenum type, GLuint& shader, std::vector<std::string>& errors);
+        void setupProgram(unsigned int oldShaderProgramId);
+        void finishPendingBuild();
+        void cancelPendingBuild();
+        std::shared_ptr<Shader> getSpecialization(const std::map<std::string,std::string>& specializationConstants, bool async);
         void bind();
 
         unsigned int shaderProgramId = 0;
@@ -345,10 +426,38 @@ namespace sre {
         BlendType blend = BlendType::Disabled;
         glm::vec2 offset = glm::vec2(0,0);
         Stencil stencil;
+        bool asyncCompile = false;
+
+        struct PendingBuild {                                  // Program object being compiled and linked by the driver
+            unsigned int programId;
+            std::vector<GLuint> shaders;
+            std::map<ShaderType, std::string> shaderSources;
+            std::map<ShaderType, std::string> preprocessedSources;
+            uint64_t programBinaryKey;
+            bool saveProgramBinary;
+            int frame;
+        };
+        std::unique_ptr<PendingBuild> pendingBuild;
 
         std::map<ShaderType, std::string> shaderSources;
 
         std::shared_ptr<std::vector<Uniform>> uniforms;
+        std::vector<int> uniformIndexByHandle;                 // index in uniforms by uniform handle (-1 if not used)
+        UniformShadow uniformShadow;                           // values last uploaded to the program by materials and sampler texture units
+
+        struct MaterialBlockMember {                           // Member of the std140 "material" uniform block
+            int id;                                            // uniform id (see materialBlockUniformId())
+            UniformType type;
+            int arraySize;
+            int offset;
+            int arrayStride;
+            int matrixStride;
+        };
+        int materialBlockSize = 0;                             // size of "material" uniform block in bytes (0 if not used)
+        std::vector<MaterialBlockMember> materialBlockMembers;
+        bool materialBlockHasArrays = false;
+        static int materialBlockUniformId(int offset);         // uniforms in the material block have no location. Use a negative id instead
+        static bool isMaterialBlockUniformId(int id);
 
         struct ShaderAttribute {
             int32_t position;
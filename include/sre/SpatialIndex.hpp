@@ -0,0 +1,104 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include "glm/glm.hpp"
+#include <array>
+#include <vector>
+#include <memory>
+#include "sre/MeshBVH.hpp"
+
+#include "sre/impl/Export.hpp"
+
+namespace sre {
+    class Mesh;
+    class Material;
+
+    /**
+     * Dynamic AABB tree over mesh instances (mesh, transform, materials and a user payload).
+     *
+     * The world space bounds of an instance are derived from Mesh::getBoundsMinMax() and the transform. Leaves store
+     * a slightly enlarged ("fat") bounding box, so moving an instance a small distance does not change the tree.
+     * The tree is kept balanced using tree rotations on insert and remove.
+     *
+     * The index can be drawn using RenderPass::draw(SpatialIndex&), which only adds the instances inside the camera
+     * frustum to the render queue. Ray queries can be done using rays from Camera::screenPointToRay().
+     */
+    class DllExport SpatialIndex {
+    public:
+        struct Instance {
+            std::shared_ptr<Mesh> mesh;
+            glm::mat4 transform;
+            std::vector<std::shared_ptr<Material>> materials;   // one material per index set (see RenderPass::draw())
+            void* payload = nullptr;
+        };
+
+        explicit SpatialIndex(float margin = 0.1f);             // margin is the relative enlargement of the leaf bounds
+
+        int insert(std::shared_ptr<Mesh> mesh,                  // Insert instance and returns its id
+                   const glm::mat4& transform,
+                   std::vector<std::shared_ptr<Material>> materials,
+                   void* payload = nullptr);
+        void remove(int id);                                    // Remove instance
+        void update(int id, const glm::mat4& transform);        // Move instance. The tree is only changed if the new bounds are
+                                                                // outside the enlarged bounds of the leaf
+        void refit();                                           // Recompute all bounds (e.g. after meshes have been updated)
+                                                                // without changing the structure of the tree
+        void clear();
+
+        const Instance& getInstance(int id);
+        std::array<glm::vec3,2> getBoundsMinMax(int id);        // Get the world space bounds of an instance
+        int size();                                             // Number of instances
+
+        void queryFrustum(const glm::mat4& viewProjection,      // Append the ids of instances intersecting the view frustum
+                          std::vector<int>& result);
+        void queryAABB(const std::array<glm::vec3,2>& aabbMinMax,
+                       std::vector<int>& result);               // Append the ids of instances intersecting the box
+        int raycast(const std::array<glm::vec3,2>& ray,         // Ray cast (origin, direction) against the mesh triangles of all
+                    RaycastHit& hit);                           // instances. Returns the id of the closest instance hit or -1.
+                                                                // Only hits closer than hit.distance are reported
+
+        int getHeight();                                        // Height of the tree (0 if empty)
+    private:
+        struct Node {
+            glm::vec3 boundsMin;
+            glm::vec3 boundsMax;
+            int parent = -1;                                    // parent node (next free node when the node is unused)
+            int child1 = -1;                                    // -1 for leaf nodes
+            int child2 = -1;
+            int height = 0;                                     // -1 for unused nodes
+            int instance = -1;
+            bool isLeaf() const { return child1 == -1; }
+        };
+        struct InstanceData {
+            Instance instance;
+            glm::vec3 boundsMin;                                // tight world space bounds
+            glm::vec3 boundsMax;
+            int node = -1;                                      // -1 if instance slot is unused
+        };
+
+        int allocateNode();
+        void freeNode(int node);
+        void insertLeaf(int leaf);
+        void removeLeaf(int leaf);
+        int balance(int node);
+        void updateBounds(int instanceId);
+        void setFatBounds(int leaf, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+        void refitNode(int node);
+        void collectLeaves(int node, std::vector<int>& result);
+
+        float margin;
+        int root = -1;
+        int freeList = -1;
+        int instanceCount = 0;
+        std::vector<Node> nodes;
+        std::vector<InstanceData> instances;
+        std::vector<int> freeInstances;
+        std::vector<int> stack;
+    };
+}
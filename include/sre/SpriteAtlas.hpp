@@ -10,7 +10,9 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <memory>
 #include "sre/Sprite.hpp"
+#include "sre/impl/RectanglePacker.hpp"
 
 //
 // Sprite atlases owns sprite definitions using a single texture.
@@ -45,9 +47,39 @@
 // }]
 // }
 //
+// Sprite atlases can also be packed at runtime from images (files, RGBA data or textures) using SpriteAtlas::pack().
+// The images are trimmed (transparent borders removed), placed using a MaxRects packer and composited into pages on
+// worker threads. Each sprite is surrounded by extruded edge pixels (to avoid bleeding when filtering) and padding.
+// If the images do not fit within maxPageSize, additional pages (textures) are created. Images can be added to a
+// packed atlas later using add(); free space of the existing pages is used before new pages are created (existing
+// pages are not resized, so sprites already in use remain valid).
+//
 namespace sre{
 class SpriteAtlas {
 public:
+    struct PackImage {
+        PackImage(std::string filename);                        // PNG or JPEG file (named after the file)
+        PackImage(std::string name, std::string filename);
+        PackImage(std::string name, std::shared_ptr<Texture> texture); // read from the GPU (see Texture::getRawImage())
+        PackImage(std::string name, const char* rgbaData, int width, int height); // bottom row first
+        std::string name;
+        std::string filename;
+        std::shared_ptr<Texture> texture;
+        std::vector<char> rgba;
+        glm::ivec2 size = {0,0};
+        glm::vec2 pivot = {0.5f,0.5f};                          // relative to the untrimmed image (origin in lower left corner)
+    };
+
+    struct PackOptions {
+        int padding = 2;                                        // transparent pixels between sprites
+        int extrude = 1;                                        // edge pixels repeated around each sprite
+        bool trim = true;                                       // remove transparent borders (alpha = 0)
+        int maxPageSize = 2048;
+        bool powerOfTwo = true;                                 // if false pages are cropped to the used area (add() does not use cropped pages)
+        bool multiplePages = true;                              // if false images which do not fit on the first page are skipped
+        bool filterSampling = true;
+    };
+
     ~SpriteAtlas();
     static std::shared_ptr<SpriteAtlas> create(std::string jsonFile,    // Create sprite atlas based on JSON file
                                                std::string imageFile,
@@ -63,17 +95,37 @@ public:
                                                            glm::ivec2 pos = {0,0},
                                                            glm::ivec2 size = {0,0} );
 
+    static std::shared_ptr<SpriteAtlas> pack(const std::vector<PackImage>& images,   // Create sprite atlas by packing images
+                                             const PackOptions& options = PackOptions(),
+                                             std::string atlasName = "packed_atlas");
+
+    bool add(const std::vector<PackImage>& images);         // Add images to an atlas created with pack(). Returns false if
+                                                            // some images could not be added
+
     Sprite get(std::string name);                           // Return a copy of a Sprite object.
 
     std::vector<std::string> getNames();                    // Returns a list of sprite names in the SpriteAtlas container
 
     std::string getAtlasName();
 
-    std::shared_ptr<Texture> getTexture();                  // Return sprite texture
+    std::shared_ptr<Texture> getTexture(int page = 0);      // Return sprite texture
+
+    int getPageCount();                                     // Number of textures (always 1 unless packed)
 private:
+    struct PackedPage {
+        RectanglePacker packer;
+        std::vector<char> pixels;                               // RGBA (bottom row first)
+        int width;
+        int height;
+    };
+    struct PackedImage;
+
     SpriteAtlas(std::map<std::string, Sprite>&& sprites, std::shared_ptr<Texture> texture, std::string atlasName);
+    bool packImages(std::vector<PackedImage>& images);
     std::string atlasName;
     std::map<std::string, Sprite> sprites;
-    std::shared_ptr<Texture> texture;
+    std::vector<std::shared_ptr<Texture>> textures;
+    std::vector<PackedPage> packedPages;                    // empty unless created using pack()
+    PackOptions packOptions;
 };
 }
@@ -7,6 +7,7 @@
 
 #pragma once 
 #include <vector>
+#include <map>
 #include "sre/Sprite.hpp"
 #include "Mesh.hpp"
 #include "Log.hpp"
@@ -18,6 +19,10 @@
 ///    sprite.orderInBatch (high values will be rendered on top of sprites with lower values)
 ///    sprite.texture (textures will be batched together)
 ///    sprite.drawOrder (sprites added later will be rendered on top of other sprites with same texture and orderInBatch)
+///
+/// When texture arrays are enabled (withTextureArray()) and the sprites use different textures of the same size, the
+/// textures are copied into the layers of a texture array and all sprites are rendered in a single draw call. The
+/// shader must support the S_TEXTURE_ARRAY specialization (such as Shader::getUnlitSprite()).
 namespace sre{
 
 class Shader;
@@ -27,6 +32,7 @@ public:
     class SpriteBatchBuilder {
     public:
         SpriteBatchBuilder& withShader(std::shared_ptr<Shader> shader);
+        SpriteBatchBuilder& withTextureArray(bool enabled = true);    // Batch sprites with different textures of the same size using a texture array
         SpriteBatchBuilder& addSprite(Sprite sprite);
         template< class InputIt >
         SpriteBatchBuilder& addSprites(InputIt first, InputIt last);
@@ -35,13 +41,15 @@ public:
         SpriteBatchBuilder();
         std::shared_ptr<Shader> shader;
         std::vector<Sprite> sprites;
+        bool textureArray = false;
         friend class SpriteBatch;
     };
 
     static SpriteBatchBuilder create();
 
 private:
-    SpriteBatch(std::shared_ptr<Shader> shader, std::vector<Sprite>& sprites);
+    SpriteBatch(std::shared_ptr<Shader> shader, std::vector<Sprite>& sprites, bool textureArray);
+    static std::shared_ptr<Texture> createTextureArray(std::vector<Sprite>& sprites, std::map<Texture*, int>& layerByTexture);
     std::vector<std::shared_ptr<Material>> materials;
     std::vector<std::shared_ptr<Mesh>> spriteMeshes;
     friend class RenderPass;
@@ -11,6 +11,7 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <functional>
 
 #include "sre/impl/Export.hpp"
 #include "sre/Framebuffer.hpp"
@@ -25,6 +26,10 @@ class SDL_Surface;
 namespace sre{
 
     class RenderPass;
+    struct CompressedImage;
+    struct MipmapSettings;
+    struct Sampler;
+    class WorkerPool;
 
     /**
      * Represent a texture (uploaded to the GPU).
@@ -38,6 +43,29 @@ namespace sre{
      *   in general gives faster texture sampling.
      * - wrap texture coordinates: if enabled the texture is repeated when sampling out the 0.0 .. 1.0 values
      * - filter sampling: if enabled the texture sampling will use interpolation to find the colors between pixel centers
+     *
+     * Texture arrays (GL_TEXTURE_2D_ARRAY) are created using withLayers(). All layers have the same size and are stored
+     * as RGBA. Texture arrays are sampled using the S_TEXTURE_ARRAY specialization of the built-in shaders, where the
+     * layer is read from uv.z. This allows objects using different textures of the same size to share a material (and
+     * be drawn without texture changes). Texture arrays are not supported on OpenGL ES 2 / WebGL 1.
+     *
+     * Texture::loadAsync() builds a texture with files decoded on worker threads. The texture is white until the
+     * decoded data has been uploaded (on the main thread in Renderer::swapWindow()).
+     *
+     * KTX2 and DDS files with BC1/BC3/BC4/BC5/BC7 or ETC2 blocks are uploaded compressed with the mip levels of the
+     * file (withGenerateMipmaps() is ignored). Formats not supported by the driver (see RenderInfo) are decompressed on
+     * the CPU. Compressed files are not flipped, so the first row of the file is v = 0 (utils/texture_compressor stores
+     * images bottom-up to match PNG files).
+     *
+     * Mipmaps of PNG/JPEG files and of RGB(A) data are generated on the CPU with gamma correct filtering (for the Linear
+     * sampler colorspace). withMipmapFilter() selects a box or Kaiser filter, and withAlphaCoverage() preserves the
+     * coverage of alpha tested textures. Generated mip chains can be cached on disk (see setMipmapCacheDirectory()).
+     * Depth textures, texture arrays and ReGenerateMipmaps() use glGenerateMipmap.
+     *
+     * Textures built withStreaming() from KTX2/DDS files only upload the lowest mip levels. The more detailed levels
+     * are read from the file on a background thread when RenderPass draws objects using the texture large enough on
+     * the screen. The streamed levels of all textures are kept within a budget (see setStreamingBudget()) by evicting
+     * the least recently used levels. Not supported on OpenGL ES 2 / WebGL 1.
      */
 class DllExport Texture : public std::enable_shared_from_this<Texture> {
 public:
@@ -73,20 +101,33 @@ public:
         Mirror
     };
 
+    enum class MipmapFilter {
+        Box,                // 2x2 average
+        Kaiser              // Kaiser windowed sinc. Sharper than Box, but slower to generate
+    };
+
     class DllExport TextureBuilder {
     public:
         ~TextureBuilder();
         TextureBuilder& withGenerateMipmaps(bool enable);
+        TextureBuilder& withMipmapFilter(MipmapFilter filter);                              // Filter used when generating mipmaps (default Box)
+        TextureBuilder& withAlphaCoverage(float alphaCutoff);                               // Scale the alpha of generated mipmaps to keep the fraction of pixels with alpha > alphaCutoff (for alpha tested textures)
         TextureBuilder& withFilterSampling(bool enable);                                    // if true texture sampling is filtered (bi-linear or tri-linear sampling) otherwise use point sampling.
         TextureBuilder& withWrapUV(Wrap wrap);                                              // Define how texture coordinates are sampled outside the [0.0,1.0] range
+        TextureBuilder& withAnisotropy(float maxAnisotropy);                                // Anisotropic filtering (default 1 = disabled). Clamped to RenderInfo::maxAnisotropy
         TextureBuilder& withFileCubemap(std::string filename, CubemapSide side);            // Must define a cubemap for each side
-        TextureBuilder& withFile(std::string filename);                                     // Currently only PNG files supported
+        TextureBuilder& withFile(std::string filename);                                     // PNG, JPEG, KTX2 or DDS file
         TextureBuilder& withRGBData(const char* data, int width, int height);               // data may be null (for a uninitialized texture)
         TextureBuilder& withRGBAData(const char* data, int width, int height);              // data may be null (for a uninitialized texture)
         TextureBuilder& withWhiteData(int width=2, int height=2);
         TextureBuilder& withSamplerColorspace(SamplerColorspace samplerColorspace);
         TextureBuilder& withWhiteCubemapData(int width=2, int height=2);
         TextureBuilder& withDepth(int width, int height, DepthPrecision precision=DepthPrecision::I16); // Creates a depth texture.
+        TextureBuilder& withLayers(int layers, int width = 0, int height = 0);              // Creates a texture array. If no size is given, the size of the layer data is used
+        TextureBuilder& withLayerFile(int layer, std::string filename);                     // Set layer content from file (texture array only)
+        TextureBuilder& withLayerRGBAData(int layer, const char* data, int width, int height); // Set layer content (texture array only)
+        TextureBuilder& withLayerTexture(int layer, std::shared_ptr<Texture> texture);      // Copy layer content from a 2D texture on the GPU (texture array only)
+        TextureBuilder& withStreaming(int residentLevels = 4);                              // Stream the mip levels of a KTX2/DDS file. Only the lowest residentLevels levels are uploaded when built
         TextureBuilder& withName(const std::string& name);
         TextureBuilder& withDumpDebug();                                                    // Output debug info on build
         std::shared_ptr<Texture> build();
@@ -97,25 +138,46 @@ public:
         struct TextureDefinition {
             int width = -1;
             int height = -1;
-            bool transparent;
-            int bytesPerPixel;
-            uint32_t format;
+            bool transparent = false;
+            int bytesPerPixel = 4;
+            uint32_t format = 0;
             std::string resourcename;
             std::vector<char> data;
+            std::string file;                                                               // file to decode (empty if data is set)
+            bool invertY = true;
+            std::shared_ptr<CompressedImage> compressed;                                    // block compressed mip levels (KTX2 or DDS file)
+            std::vector<std::vector<char>> mipLevels;                                       // mip levels after level 0 generated on the CPU
+            void decodeFile();
+            void generateMipLevels(const MipmapSettings& settings, WorkerPool* workerPool); // Safe to call from worker threads (workerPool must then be null)
+            void setWhite(int width, int height);
+            int upload(uint32_t faceTarget, SamplerColorspace samplerColorspace, int firstLevel = 0); // upload to the bound texture (compressed levels from firstLevel). Returns the size on the GPU
             void dumpDebug();
         };
+        bool buildTextureArray(TextureDefinition& arrayDef);
+        static int getStreamingBaseLevel(const TextureDefinition& textureDef, int residentLevels);
+        void decodeFiles();
+        MipmapSettings getMipmapSettings();
         DepthPrecision depthPrecision = DepthPrecision::None;
         std::string name;
-		bool transparent;
+		bool transparent = false;
         bool generateMipmaps = false;
+        MipmapFilter mipmapFilter = MipmapFilter::Box;
+        float alphaCutoff = -1;                                                             // < 0 = alpha coverage is not preserved
         bool filterSampling = true;                                                         // true = linear/trilinear sampling, false = point sampling
         Wrap wrapUV = Wrap::Repeat;
+        float anisotropy = 1;
         bool dumpDebug = false;
         SamplerColorspace samplerColorspace = SamplerColorspace::Linear;
         uint32_t target = 0;
         unsigned int textureId = 0;
+        int layers = 0;                                                                     // 0 = not a texture array
+        int layerWidth = 0;
+        int layerHeight = 0;
+        int streamingResidentLevels = 0;                                                    // 0 = not streaming
 
         std::map<uint32_t, TextureDefinition> textureTypeData;
+        std::map<int, TextureDefinition> layerData;
+        std::map<int, std::shared_ptr<Texture>> layerTextures;
 
         friend class Texture;
         friend class RenderPass;
@@ -126,16 +188,31 @@ public:
     // Create a new texture using the builder pattern
     static TextureBuilder create();
 
+    // Build texture without waiting for its files to be decoded. The files are read and decoded on worker threads,
+    // while the texture holds a white placeholder. onLoaded is called on the main thread when the data is uploaded.
+    static std::shared_ptr<Texture> loadAsync(TextureBuilder& builder, std::function<void(std::shared_ptr<Texture>)> onLoaded = {});
+
     static std::shared_ptr<Texture> getWhiteTexture();
     static std::shared_ptr<Texture> getSphereTexture();
     static std::shared_ptr<Texture> getDefaultCubemapTexture();
+    static std::shared_ptr<Texture> getWhiteTextureArray();                                 // Texture array with a single white layer
+
+    static void setMipmapCacheDirectory(const std::string& directory);                     // Store generated mip chains in directory and load them instead of generating
+                                                                                            // when possible. Empty string disables the cache (default)
+    static const std::string& getMipmapCacheDirectory();
+    static void setStreamingBudget(int bytes);                                              // Max size of the mip levels of streamed textures on the GPU (default 256 MB)
+    static int getStreamingBudget();
 
     int getWidth();
     int getHeight();
 
     bool isFilterSampling();                                                                // returns true if texture sampling is filtered when sampling (bi-linear or tri-linear sampling).
     Wrap getWrapUV();
+    float getAnisotropy();
+    Sampler getSampler();                                                                   // Default sampler (filtering, wrap and anisotropy of the texture. Depth compare for depth textures)
     bool isCubemap();                                                                       // is cubemap texture
+    bool isArray();                                                                         // is texture array
+    int getLayers();                                                                        // number of layers (1 if not a texture array)
     bool isMipmapped();                                                                     // has texture mipmapped enabled
 	bool isTransparent();																	// Does texture has alpha channel
     SamplerColorspace getSamplerColorSpace();
@@ -143,37 +220,61 @@ public:
 
     int getDataSize();                                                                      // get size of the texture in bytes on GPU
     bool isDepthTexture();
+    bool isLoading();                                                                       // true while decoding files (see loadAsync())
+    bool isStreaming();                                                                     // true if mip levels are streamed (see TextureBuilder::withStreaming())
+    int getBaseMipLevel();                                                                  // most detailed mip level resident on the GPU
     DepthPrecision getDepthPrecision();
 
     std::vector<char> getRawImage();                                                        // Read RGBA texture data from texture (GPU to CPU). Not supported in OpenGL ES
     unsigned int getNativeTextureId();                                                      // get texture id
 	void ReGenerateMipmaps();																// Re-generate the mipmaps (used when the texture data has changed)
+    void updateLayer(int layer, const char* rgbaData);                                      // Upload RGBA data (width*height*4 bytes) to a layer of a texture array. Mipmaps are not updated
+    void updateRows(int firstRow, int rowCount, const char* rgbaData);                      // Upload RGBA data (width*rowCount*4 bytes) to rows of a 2D texture. Mipmaps are not updated
 private:
-    Texture(unsigned int textureId, int width, int height, uint32_t target, std::string string);
+    struct AsyncLoad;
+    Texture(unsigned int textureId, int width, int height, uint32_t target, std::string string, int layers = 1);
+    static void initImageLoader();
+    static void updateAsyncLoads();                                                         // Upload decoded files (called once per frame)
+    void uploadAsyncLoad(AsyncLoad& asyncLoad);
     void updateTextureSampler(bool filterSampling, Wrap wrapTextureCoordinates);
     void invokeGenerateMipmap();
+    void setFileMipLevels(int levels, int dataSize);
+    void setBaseLevel(int level);
+    void startStreaming(const std::string& file, const CompressedImage& image, int baseLevel);
+    int uploadStreamedLevels(const CompressedImage& image, int firstLevel, int lastLevel); // Upload the levels [firstLevel, lastLevel). Returns the size on the GPU
+    void evictStreamedLevel(int dataSize);                                                  // Free the base level (of dataSize bytes)
     static GLenum getFormat(SDL_Surface *image);
     static std::vector<char> loadFileFromMemory(const char* data, int dataSize, GLenum& format, bool & alpha,int& width, int& height, int& bytesPerPixel, bool invertY = true);
     int width;
     int height;
+    int layers;
     uint32_t target;
     bool generateMipmap;
 	bool transparent;
+    bool loading = false;
+    int fileMipLevelsDataSize = 0;                                                          // size of mip levels uploaded from a KTX2/DDS file (0 if estimated from the size)
+    bool streaming = false;
+    int baseLevel = 0;
     DepthPrecision depthPrecision = DepthPrecision::None;
     std::string name;
     SamplerColorspace samplerColorspace;
     bool filterSampling = true; // true = linear/trilinear sampling, false = point sampling
     Wrap wrapUV;
+    float anisotropy = 1;
     unsigned int textureId;
     friend class Shader;
     friend class Material;
     friend class Framebuffer;
     friend class RenderPass;
     friend class Inspector;
+    friend class Renderer;
     friend IMGUI_API void ImGui_RenderTexture(Texture* ,glm::vec2 , const glm::vec2& , const glm::vec2& , const glm::vec4& , const glm::vec4& );
     friend class VR;
     friend class Sprite;
     friend class UniformSet;
+    friend class TextureStreaming;
+    friend class RenderGraph;
+    friend class SpriteAtlas;
 };
 
 
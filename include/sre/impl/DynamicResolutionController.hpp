@@ -0,0 +1,52 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+namespace sre {
+    // Chooses the render scale of DynamicResolution from the measured frame time (GPU time if available).
+    // Does not depend on OpenGL.
+    //
+    // The frame time is assumed to be proportional to the number of pixels rendered (scale^2), so each measurement is
+    // converted into a cost at full resolution, which is averaged over frames. The error between the budget and the
+    // predicted time at the current scale drives a PID controller adjusting the pixel count. To avoid oscillation the
+    // scale is changed in steps and is only increased when more than 'headroom' of the budget is unused and the new
+    // scale is predicted to be within budget (the scale is decreased as soon as the budget is exceeded).
+    class DynamicResolutionController {
+    public:
+        struct Settings {
+            float budget = 14;                                  // target frame time in ms
+            float minScale = 0.5f;
+            float maxScale = 1.0f;
+            float proportionalGain = 0.5f;
+            float integralGain = 0.05f;
+            float derivativeGain = 0.1f;
+            float headroom = 0.1f;                              // fraction of the budget unused before the scale is increased
+            float step = 0.05f;                                 // the scale is a multiple of step (smaller changes are ignored)
+            float smoothing = 0.25f;                            // weight of a new measurement in the averaged cost
+        };
+
+        DynamicResolutionController();
+        explicit DynamicResolutionController(const Settings& settings);
+
+        float update(float time);                               // Measured frame time in ms (ignored if <= 0). Returns the new scale
+        void reset(float scale);                                // Set the scale and forget previous measurements
+
+        float getScale() const;
+        float getPredictedTime() const;                         // Averaged frame time at the current scale (0 if not measured)
+        const Settings& getSettings() const;
+        void setSettings(const Settings& settings);             // The scale is clamped to the new limits
+    private:
+        float clampScale(float scale) const;
+
+        Settings settings;
+        float scale;
+        float cost = 0;                                         // averaged frame time at full resolution
+        float integral = 0;
+        float lastError = 0;
+    };
+}
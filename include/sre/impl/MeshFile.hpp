@@ -0,0 +1,56 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "glm/glm.hpp"
+
+namespace sre {
+    // Reads and writes the binary .srem mesh file (see Mesh::save() and Mesh::loadMapped()). Does not depend on OpenGL.
+    //
+    // File layout (native byte order):
+    //   header   : magic "SREM", version, vertex count, bytes per vertex, bounds, line width, name,
+    //              attribute table, topologies, index set table, vertex data offset/size, index data offset/size
+    //   vertices : interleaved vertex data (as returned by Mesh::getInterleavedData()), 16 byte aligned
+    //   indices  : concatenated index sets (as uploaded by Mesh::updateIndexBuffers()), 16 byte aligned
+    struct MeshFile {
+        struct Attribute {
+            std::string name;
+            int32_t offset;                                     // in bytes within a vertex
+            int32_t elementCount;
+            int32_t dataType;
+            int32_t attributeType;
+        };
+        struct IndexSet {
+            uint32_t offset;                                    // in bytes from the start of the index data
+            uint32_t size;                                      // number of indices
+            uint32_t type;                                      // GL_UNSIGNED_INT or GL_UNSIGNED_SHORT
+        };
+
+        uint32_t vertexCount = 0;
+        uint32_t bytesPerVertex = 0;
+        std::array<glm::vec3,2> bounds;
+        float lineWidth = 1;
+        std::string name;
+        std::vector<Attribute> attributes;
+        std::vector<uint32_t> topologies;                       // MeshTopology of each index set (one topology if no index sets)
+        std::vector<IndexSet> indexSets;
+        const char* vertexData = nullptr;
+        uint64_t vertexDataSize = 0;
+        const char* indexData = nullptr;
+        uint64_t indexDataSize = 0;
+
+        bool write(std::ostream& out) const;                    // Returns false if the stream fails
+        bool read(const char* data, size_t size, std::string& error); // Validates the file. vertexData and indexData point into data
+        bool validateIndices(std::string& error) const;         // Returns false if an index is outside the vertices (reads all indices)
+    };
+}
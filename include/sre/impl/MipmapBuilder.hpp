@@ -0,0 +1,45 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <string>
+
+namespace sre {
+    class WorkerPool;
+
+    struct MipmapSettings {
+        enum class Filter {
+            Box,                                                // 2x2 average
+            Kaiser                                              // Kaiser windowed sinc (sharper, 8 taps per axis)
+        };
+        Filter filter = Filter::Box;
+        bool srgb = false;                                      // color channels are sRGB encoded (filtered in linear space)
+        float alphaCutoff = -1;                                 // if >= 0 the alpha of each level is scaled so the fraction of pixels
+                                                                // with alpha > alphaCutoff matches level 0 (for alpha tested textures)
+    };
+
+    // Builds mip chains of 8 bit RGB or RGBA images on the CPU. Levels are filtered in floating point (using SSE2 or
+    // NEON when available) from the previous level. Rows are filtered in parallel when a WorkerPool is given (must not
+    // be called from a task of the same pool).
+    // The generated chains can be cached in a directory (see setCacheDirectory()). Does not depend on OpenGL.
+    class MipmapBuilder {
+    public:
+        static std::vector<std::vector<char>> build(const char* data, int width, int height, int channels, // Returns the levels after level 0
+                                                    const MipmapSettings& settings, WorkerPool* workerPool = nullptr);
+        static int getLevelCount(int width, int height);        // number of levels including level 0
+        static float getAlphaCoverage(const char* data, int width, int height, int channels, float alphaCutoff); // fraction of pixels with alpha > alphaCutoff
+
+        static void setCacheDirectory(const std::string& directory); // Empty string disables the cache (default)
+        static const std::string& getCacheDirectory();
+        static uint64_t getCacheKey(const char* data, int width, int height, int channels, const MipmapSettings& settings);
+        static bool loadFromCache(uint64_t key, std::vector<std::vector<char>>& levels);
+        static void saveToCache(uint64_t key, const std::vector<std::vector<char>>& levels);
+    };
+}
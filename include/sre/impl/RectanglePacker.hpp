@@ -0,0 +1,46 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+namespace sre {
+    // Packs rectangles into a fixed size area using the MaxRects algorithm (best short side fit). The free area is
+    // kept as a list of maximal (possibly overlapping) free rectangles, which are split when a rectangle is placed.
+    // Rectangles are not rotated. Does not depend on OpenGL.
+    class RectanglePacker {
+    public:
+        struct Rect {
+            int x = 0;
+            int y = 0;
+            int width = 0;
+            int height = 0;
+        };
+
+        RectanglePacker(int width = 0, int height = 0);
+
+        bool insert(int width, int height, Rect& res);          // Returns false if the rectangle does not fit
+
+        int getWidth();
+        int getHeight();
+        int getUsedWidth();                                     // Bounding box of the inserted rectangles
+        int getUsedHeight();
+        float getOccupancy();                                   // Fraction of the area used by inserted rectangles
+    private:
+        void splitFreeRects(const Rect& used);
+        void pruneFreeRects();
+
+        int width;
+        int height;
+        int usedWidth = 0;
+        int usedHeight = 0;
+        int64_t usedArea = 0;
+        std::vector<Rect> freeRects;
+    };
+}
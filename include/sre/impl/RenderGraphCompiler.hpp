@@ -0,0 +1,43 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace sre {
+    // Compiles the passes and resources declared in a RenderGraph: culls passes whose outputs are unused, orders the
+    // remaining passes by their dependencies, computes the lifetime of each resource and schedules mipmap generation.
+    // Does not depend on OpenGL.
+    //
+    // A pass reading a resource depends on all passes writing it, and passes writing the same resource (or the
+    // screen) are executed in declaration order. Independent passes keep the declaration order.
+    class RenderGraphCompiler {
+    public:
+        struct Pass {
+            std::vector<int> reads;                             // resource indices
+            std::vector<int> writes;
+            bool writesScreen = false;
+        };
+        struct Resource {
+            bool output = false;                                // used after the graph (writers are never culled)
+            bool mipmapped = false;                             // mipmaps must be generated after being written
+        };
+        struct Result {
+            bool valid = false;
+            std::string error;
+            std::vector<int> order;                             // executed passes in execution order
+            std::vector<bool> culled;                           // by pass
+            std::vector<int> firstUse;                          // by resource: position in order (-1 if unused)
+            std::vector<int> lastUse;                           // order.size() for used outputs (alive after the last pass)
+            std::vector<std::vector<int>> generateMipmaps;      // by pass: resources to generate mipmaps for after the pass
+        };
+
+        static Result compile(const std::vector<Pass>& passes, const std::vector<Resource>& resources);
+    };
+}
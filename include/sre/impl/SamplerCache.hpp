@@ -0,0 +1,34 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include "sre/impl/GL.hpp"
+#include "sre/Sampler.hpp"
+#include <map>
+
+#ifndef GL_TEXTURE_MAX_ANISOTROPY_EXT
+#define GL_TEXTURE_MAX_ANISOTROPY_EXT 0x84FE
+#endif
+#ifndef GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT 0x84FF
+#endif
+
+namespace sre {
+    class Texture;
+
+    // OpenGL sampler objects shared by equal samplers (created on first use)
+    class SamplerCache {
+    public:
+        GLuint get(const Sampler& sampler, Texture& texture);   // Returns the sampler object for sampling the texture
+        static Sampler resolve(Sampler sampler, Texture& texture); // Adjust the sampler to the texture (e.g. no mipmap filtering
+                                                                // of textures without mipmaps)
+        void clear();                                           // Delete all sampler objects (must be called before the context is deleted)
+    private:
+        std::map<Sampler, GLuint> samplers;
+    };
+}
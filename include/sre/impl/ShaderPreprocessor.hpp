@@ -0,0 +1,52 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <cstdint>
+
+namespace sre {
+    // Single pass GLSL preprocessor used when building shaders. In one scan over the source it
+    // - replaces #pragma include "name" with the content of the resource (see Resource::loadText())
+    // - inserts defines after the last #version or #extension directive
+    // - translates GLSL 330 to GLSL ES 1.00 or 3.00 (version, precision, in/out, fragColor and texture lookups)
+    // Include resources are cached by name until clearIncludeCache() is called.
+    class ShaderPreprocessor {
+    public:
+        static std::string process(const std::string& source,
+                                   const std::string& defines,          // Inserted after #version and #extension directives (may be empty)
+                                   uint32_t shaderType,                 // GL shader type (e.g. GL_VERTEX_SHADER)
+                                   int esVersion,                       // 0 (no translation), 100 or 300
+                                   std::vector<std::string>& errors);
+
+        static std::set<std::string> findSpecializationConstants(const std::string& source); // Return identifiers starting with S_
+
+        static void clearIncludeCache();                                // Must be called when include resources are modified
+    private:
+        ShaderPreprocessor(uint32_t shaderType, int esVersion, std::vector<std::string>& errors);
+
+        void processSource(const std::string& source, int lineBase, int depth);
+        bool processDirective(const std::string& source, size_t begin, size_t end, int lineBase, int lineNumber, int depth);
+        void processTokens(const std::string& source, size_t begin, size_t end);
+        size_t translateIdentifier(const std::string& source, size_t begin, size_t end, size_t lineEnd, bool firstToken);
+
+        std::string out;
+        uint32_t shaderType;
+        bool vertexShader;
+        int esVersion;
+        std::vector<std::string>& errors;
+        std::map<std::string, std::string> samplers;                    // sampler name to texture lookup suffix (GLSL ES 1.00)
+        bool inBlockComment = false;
+        int includes = 0;
+        size_t insertPos = 0;                                           // output position after last #version or #extension
+        int insertLine = 1;
+    };
+}
@@ -1,5 +1,5 @@
 // autogenerated by
-// files_to_cpp shader src/embedded_deps/shadow_frag.glsl shadow_frag.glsl src/embedded_deps/shadow_vert.glsl shadow_vert.glsl src/embedded_deps/skybox_proc_frag.glsl skybox_proc_frag.glsl src/embedded_deps/skybox_proc_vert.glsl skybox_proc_vert.glsl src/embedded_deps/skybox_frag.glsl skybox_frag.glsl src/embedded_deps/skybox_vert.glsl skybox_vert.glsl src/embedded_deps/sre_utils_incl.glsl sre_utils_incl.glsl src/embedded_deps/debug_normal_frag.glsl debug_normal_frag.glsl src/embedded_deps/debug_normal_vert.glsl debug_normal_vert.glsl src/embedded_deps/debug_uv_frag.glsl debug_uv_frag.glsl src/embedded_deps/debug_uv_vert.glsl debug_uv_vert.glsl src/embedded_deps/light_incl.glsl light_incl.glsl src/embedded_deps/particles_frag.glsl particles_frag.glsl src/embedded_deps/particles_vert.glsl particles_vert.glsl src/embedded_deps/sprite_frag.glsl sprite_frag.glsl src/embedded_deps/sprite_vert.glsl sprite_vert.glsl src/embedded_deps/standard_pbr_frag.glsl standard_pbr_frag.glsl src/embedded_deps/standard_pbr_vert.glsl standard_pbr_vert.glsl src/embedded_deps/standard_blinn_phong_frag.glsl standard_blinn_phong_frag.glsl src/embedded_deps/standard_blinn_phong_vert.glsl standard_blinn_phong_vert.glsl src/embedded_deps/standard_phong_frag.glsl standard_phong_frag.glsl src/embedded_deps/standard_phong_vert.glsl standard_phong_vert.glsl src/embedded_deps/blit_frag.glsl blit_frag.glsl src/embedded_deps/blit_vert.glsl blit_vert.glsl src/embedded_deps/unlit_frag.glsl unlit_frag.glsl src/embedded_deps/unlit_vert.glsl unlit_vert.glsl src/embedded_deps/debug_tangent_frag.glsl debug_tangent_frag.glsl src/embedded_deps/debug_tangent_vert.glsl debug_tangent_vert.glsl src/embedded_deps/normalmap_incl.glsl normalmap_incl.glsl src/embedded_deps/global_uniforms_incl.glsl global_uniforms_incl.glsl include/sre/impl/ShaderSource.inl
+// files_to_cpp shader src/embedded_deps/shadow_frag.glsl shadow_frag.glsl src/embedded_deps/shadow_vert.glsl shadow_vert.glsl src/embedded_deps/skybox_proc_frag.glsl skybox_proc_frag.glsl src/embedded_deps/skybox_proc_vert.glsl skybox_proc_vert.glsl src/embedded_deps/skybox_frag.glsl skybox_frag.glsl src/embedded_deps/skybox_vert.glsl skybox_vert.glsl src/embedded_deps/sre_utils_incl.glsl sre_utils_incl.glsl src/embedded_deps/debug_normal_frag.glsl debug_normal_frag.glsl src/embedded_deps/debug_normal_vert.glsl debug_normal_vert.glsl src/embedded_deps/debug_uv_frag.glsl debug_uv_frag.glsl src/embedded_deps/debug_uv_vert.glsl debug_uv_vert.glsl src/embedded_deps/light_incl.glsl light_incl.glsl src/embedded_deps/particles_frag.glsl particles_frag.glsl src/embedded_deps/particles_vert.glsl particles_vert.glsl src/embedded_deps/sprite_frag.glsl sprite_frag.glsl src/embedded_deps/sprite_vert.glsl sprite_vert.glsl src/embedded_deps/standard_pbr_frag.glsl standard_pbr_frag.glsl src/embedded_deps/standard_pbr_vert.glsl standard_pbr_vert.glsl src/embedded_deps/standard_blinn_phong_frag.glsl standard_blinn_phong_frag.glsl src/embedded_deps/standard_blinn_phong_vert.glsl standard_blinn_phong_vert.glsl src/embedded_deps/standard_phong_frag.glsl standard_phong_frag.glsl src/embedded_deps/standard_phong_vert.glsl standard_phong_vert.glsl src/embedded_deps/blit_frag.glsl blit_frag.glsl src/embedded_deps/blit_vert.glsl blit_vert.glsl src/embedded_deps/unlit_frag.glsl unlit_frag.glsl src/embedded_deps/unlit_vert.glsl unlit_vert.glsl src/embedded_deps/debug_tangent_frag.glsl debug_tangent_frag.glsl src/embedded_deps/debug_tangent_vert.glsl debug_tangent_vert.glsl src/embedded_deps/normalmap_incl.glsl normalmap_incl.glsl src/embedded_deps/global_uniforms_incl.glsl global_uniforms_incl.glsl src/embedded_deps/line_frag.glsl line_frag.glsl src/embedded_deps/line_vert.glsl line_vert.glsl src/embedded_deps/blit_upscale_frag.glsl blit_upscale_frag.glsl include/sre/impl/ShaderSource.inl
 #include <map>
 #include <utility>
 #include <string>
@@ -396,13 +396,25 @@ out vec4 fragColor;
 in vec2 vUV;
 in vec4 vColor;
 
+#ifdef S_TEXTURE_ARRAY
+in float vLayer;
+#ifdef GL_ES
+precision highp sampler2DArray;
+#endif
+uniform sampler2DArray tex;
+#else
 uniform sampler2D tex;
+#endif
 
 #pragma include "sre_utils_incl.glsl"
 
 void main(void)
 {
+#ifdef S_TEXTURE_ARRAY
+    fragColor = vColor * toLinear(texture(tex, vec3(vUV, vLayer)));
+#else
     fragColor = vColor * toLinear(texture(tex, vUV));
+#endif
     fragColor = toOutput(fragColor);
 })"),
 std::make_pair<std::string,std::string>("sprite_vert.glsl",R"(#version 330
@@ -410,6 +422,9 @@ in vec3 position;
 in vec4 uv;
 in vec4 vertex_color;
 out vec2 vUV;
+#ifdef S_TEXTURE_ARRAY
+out float vLayer;
+#endif
 out vec4 vColor;
 
 #pragma include "global_uniforms_incl.glsl"
@@ -417,6 +432,9 @@ out vec4 vColor;
 void main(void) {
     gl_Position = g_projection * g_view * g_model * vec4(position,1.0);
     vUV = uv.xy;
+#ifdef S_TEXTURE_ARRAY
+    vLayer = uv.z;
+#endif
     vColor = vertex_color;
 })"),
 std::make_pair<std::string,std::string>("standard_pbr_frag.glsl",R"(#version 330
@@ -434,7 +452,15 @@ in vec3 vWsPos;
 uniform vec4 color;
 uniform vec4 metallicRoughness;
 
+#ifdef S_TEXTURE_ARRAY
+in float vLayer;
+#ifdef GL_ES
+precision highp sampler2DArray;
+#endif
+uniform sampler2DArray tex;
+#else
 uniform sampler2D tex;
+#endif
 #ifdef S_METALROUGHNESSMAP
 uniform sampler2D mrTex;
 #endif
@@ -541,7 +567,11 @@ void main(void)
     float alphaRoughness = perceptualRoughness * perceptualRoughness;
 
 #ifndef S_NO_BASECOLORMAP
+#ifdef S_TEXTURE_ARRAY
+    vec4 baseColor = toLinear(texture(tex, vec3(vUV, vLayer))) * color;
+#else
     vec4 baseColor = toLinear(texture(tex, vUV)) * color;
+#endif
 #else
     vec4 baseColor = color;
 #endif
@@ -636,6 +666,9 @@ in vec4 vertex_color;
 out vec4 vColor;
 #endif
 out vec2 vUV;
+#ifdef S_TEXTURE_ARRAY
+out float vLayer;
+#endif
 out vec3 vWsPos;
 #ifdef S_SHADOW
 uniform mat4 shadowViewProjOffset;
@@ -656,6 +689,9 @@ void main(void) {
     vNormal = normalize(g_model_it * normal);
 #endif
     vUV = uv.xy;
+#ifdef S_TEXTURE_ARRAY
+    vLayer = uv.z;
+#endif
 #ifdef S_VERTEX_COLOR
     vColor = vertex_color;
 #endif
@@ -681,7 +717,15 @@ in vec4 vColor;
 #endif
 
 uniform vec4 color;
+#ifdef S_TEXTURE_ARRAY
+in float vLayer;
+#ifdef GL_ES
+precision highp sampler2DArray;
+#endif
+uniform sampler2DArray tex;
+#else
 uniform sampler2D tex;
+#endif
 
 #pragma include "global_uniforms_incl.glsl"
 #pragma include "light_incl.glsl"
@@ -690,7 +734,11 @@ uniform sampler2D tex;
 
 void main()
 {
+#ifdef S_TEXTURE_ARRAY
+    vec4 c = color * toLinear(texture(tex, vec3(vUV, vLayer)));
+#else
     vec4 c = color * toLinear(texture(tex, vUV));
+#endif
 #ifdef S_VERTEX_COLOR
     c = c * vColor;
 #endif
@@ -706,6 +754,9 @@ in vec3 position;
 in vec3 normal;
 in vec4 uv;
 out vec2 vUV;
+#ifdef S_TEXTURE_ARRAY
+out float vLayer;
+#endif
 #if defined(S_TANGENTS) && defined(S_NORMALMAP)
 in vec4 tangent;
 out mat3 vTBN;
@@ -734,6 +785,9 @@ void main(void) {
     vNormal = normalize(g_model_it * normal);
 #endif
     vUV = uv.xy;
+#ifdef S_TEXTURE_ARRAY
+    vLayer = uv.z;
+#endif
     vWsPos = wsPos.xyz;
 
 #ifdef S_VERTEX_COLOR
@@ -762,7 +816,15 @@ in vec4 vColor;
 #endif
 
 uniform vec4 color;
+#ifdef S_TEXTURE_ARRAY
+in float vLayer;
+#ifdef GL_ES
+precision highp sampler2DArray;
+#endif
+uniform sampler2DArray tex;
+#else
 uniform sampler2D tex;
+#endif
 
 #pragma include "global_uniforms_incl.glsl"
 #pragma include "light_incl.glsl"
@@ -771,7 +833,11 @@ uniform sampler2D tex;
 
 void main()
 {
+#ifdef S_TEXTURE_ARRAY
+    vec4 c = color * toLinear(texture(tex, vec3(vUV, vLayer)));
+#else
     vec4 c = color * toLinear(texture(tex, vUV));
+#endif
 #ifdef S_VERTEX_COLOR
     c = c * vColor;
 #endif
@@ -787,6 +853,9 @@ in vec3 position;
 in vec3 normal;
 in vec4 uv;
 out vec2 vUV;
+#ifdef S_TEXTURE_ARRAY
+out float vLayer;
+#endif
 #if defined(S_TANGENTS) && defined(S_NORMALMAP)
 in vec4 tangent;
 out mat3 vTBN;
@@ -815,6 +884,9 @@ void main(void) {
     vNormal = normalize(g_model_it * normal);
 #endif
     vUV = uv.xy;
+#ifdef S_TEXTURE_ARRAY
+    vLayer = uv.z;
+#endif
     vWsPos = wsPos.xyz;
 
 #ifdef S_VERTEX_COLOR
@@ -857,13 +929,25 @@ in vec4 vColor;
 #endif
 
 uniform vec4 color;
+#ifdef S_TEXTURE_ARRAY
+in float vLayer;
+#ifdef GL_ES
+precision highp sampler2DArray;
+#endif
+uniform sampler2DArray tex;
+#else
 uniform sampler2D tex;
+#endif
 
 #pragma include "sre_utils_incl.glsl"
 
 void main(void)
 {
+#ifdef S_TEXTURE_ARRAY
+    fragColor = color * toLinear(texture(tex, vec3(vUV, vLayer)));
+#else
     fragColor = color * toLinear(texture(tex, vUV));
+#endif
 #ifdef S_VERTEX_COLOR
     fragColor = fragColor * vColor;
 #endif
@@ -878,12 +962,18 @@ out vec4 vColor;
 #endif
 in vec4 uv;
 out vec2 vUV;
+#ifdef S_TEXTURE_ARRAY
+out float vLayer;
+#endif
 
 #pragma include "global_uniforms_incl.glsl"
 
 void main(void) {
     gl_Position = g_projection * g_view * g_model * vec4(position,1.0);
     vUV = uv.xy;
+#ifdef S_TEXTURE_ARRAY
+    vLayer = uv.z;
+#endif
 #ifdef S_VERTEX_COLOR
     vColor = vertex_color;
 #endif
@@ -977,4 +1067,90 @@ uniform vec4 g_lightPosType[SI_LIGHTS];
 uniform mat4 g_model;
 uniform mat3 g_model_it;
 uniform mat3 g_model_view_it;)"),
+std::make_pair<std::string,std::string>("line_frag.glsl",R"(#version 330
+out vec4 fragColor;
+in vec4 vColor;
+
+uniform vec4 color;
+
+#pragma include "sre_utils_incl.glsl"
+
+void main(void)
+{
+    fragColor = toOutput(color * vColor);
+})"),
+std::make_pair<std::string,std::string>("line_vert.glsl",R"(#version 330
+in vec3 position;
+in vec4 line_other;         // xyz: other end point of segment, w: side of line (-1 or 1)
+in vec4 line_adjacent;      // xyz: adjacent point (next point after this end point), w: 1 if joined with adjacent segment
+in vec4 vertex_color;
+out vec4 vColor;
+
+uniform float lineWidth;
+
+#pragma include "global_uniforms_incl.glsl"
+
+vec2 toScreen(vec4 clip){
+    return clip.xy / clip.w * g_viewport.xy * 0.5;
+}
+
+vec2 perpendicular(vec2 v){
+    return vec2(-v.y, v.x);
+}
+
+void main(void) {
+    mat4 mvp = g_projection * g_view * g_model;
+    vec4 clip = mvp * vec4(position, 1.0);
+    vec2 screen = toScreen(clip);
+    vec2 dir = toScreen(mvp * vec4(line_other.xyz, 1.0)) - screen;
+    dir = length(dir) > 0.0 ? normalize(dir) : vec2(1.0, 0.0);
+    vec2 normal = perpendicular(dir);
+    float halfWidth = lineWidth * 0.5;
+    vec2 offset = normal * halfWidth;
+    if (line_adjacent.w > 0.0){
+        // miter join
+        vec2 adjacentDir = screen - toScreen(mvp * vec4(line_adjacent.xyz, 1.0));
+        if (length(adjacentDir) > 0.0){
+            vec2 tangent = normalize(adjacentDir) + dir;
+            if (length(tangent) > 0.0001){
+                vec2 miter = perpendicular(normalize(tangent));
+                float miterLength = halfWidth / max(dot(miter, normal), 0.25); // limit miter to 4 x half width
+                offset = miter * miterLength;
+            }
+        }
+    }
+    gl_Position = clip;
+    gl_Position.xy += offset * line_other.w / (g_viewport.xy * 0.5) * clip.w;
+    vColor = vertex_color;
+})"),
+std::make_pair<std::string,std::string>("blit_upscale_frag.glsl",R"(#version 330
+out vec4 fragColor;
+in vec2 vUV;
+
+uniform sampler2D tex;
+uniform vec4 upscale;           // xy: part of the texture rendered into (uv), zw: 1.0 / texture size
+uniform float sharpness;        // 0.0 bilinear, 1.0 max sharpening
+
+#pragma include "sre_utils_incl.glsl"
+
+vec4 sampleTex(vec2 uv){
+    // bilinear filtering must not read outside the part rendered into
+    return toLinear(texture(tex, clamp(uv, upscale.zw * 0.5, upscale.xy - upscale.zw * 0.5)));
+}
+
+void main(void)
+{
+    vec2 uv = vUV * upscale.xy;
+    vec2 texelSize = upscale.zw;
+    vec4 center = sampleTex(uv);
+    vec4 left = sampleTex(uv - vec2(texelSize.x, 0.0));
+    vec4 right = sampleTex(uv + vec2(texelSize.x, 0.0));
+    vec4 down = sampleTex(uv - vec2(0.0, texelSize.y));
+    vec4 up = sampleTex(uv + vec2(0.0, texelSize.y));
+    // unsharp mask limited to the range of the neighborhood (avoids ringing)
+    vec4 sharpened = center + (center * 4.0 - left - right - down - up) * (sharpness * 0.25);
+    vec4 minColor = min(center, min(min(left, right), min(down, up)));
+    vec4 maxColor = max(center, max(max(left, right), max(down, up)));
+    fragColor = toOutput(clamp(sharpened, minColor, maxColor));
+})"),
 };
\ No newline at end of file
@@ -0,0 +1,39 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include "sre/impl/GL.hpp"
+#include <vector>
+
+namespace sre {
+    // Tracks the textures bound to each texture unit and target, so textures already resident on a unit are not
+    // bound again. All texture binds done by sre must go through the cache (code which binds textures without the
+    // cache must restore the previous bindings or call reset()).
+    class TextureBindingCache {
+    public:
+        bool bind(int unit, GLenum target, GLuint textureId);   // Bind texture to unit. Returns false if already bound
+        void bindForUpdate(GLenum target, GLuint textureId);    // Bind texture to the active unit (used when uploading data
+                                                                // or changing texture parameters)
+        bool bindSampler(int unit, GLuint samplerId);           // Bind sampler object to unit. Returns false if already bound
+        void remove(GLuint textureId);                          // Forget a deleted texture (OpenGL unbinds it from all units)
+        void reset();                                           // Forget all bindings (textures and samplers) and activate unit 0
+    private:
+        enum TargetIndex {
+            Texture2D,
+            TextureCube,
+            Texture2DArray,
+            TargetCount
+        };
+        static int getTargetIndex(GLenum target);
+        GLuint& getBinding(int unit, GLenum target);
+
+        std::vector<GLuint> bindings;                           // bound texture ids by unit * TargetCount + target index
+        std::vector<GLuint> samplerBindings;                    // bound sampler ids by unit
+        int activeUnit = 0;
+    };
+}
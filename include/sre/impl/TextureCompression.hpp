@@ -0,0 +1,54 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <string>
+
+namespace sre {
+    enum class CompressedFormat {
+        BC1,                // RGB (DXT1), 8 bytes per 4x4 block
+        BC3,                // RGBA (DXT5), 16 bytes per block
+        BC4,                // R, 8 bytes per block
+        BC5,                // RG, 16 bytes per block
+        BC7,                // RGBA, 16 bytes per block
+        ETC2_RGB,           // RGB, 8 bytes per block
+        ETC2_RGBA           // RGBA (EAC alpha), 16 bytes per block
+    };
+
+    // Block compressed image with a mip chain (level 0 first)
+    struct CompressedImage {
+        CompressedFormat format = CompressedFormat::BC1;
+        bool srgb = false;                                      // color data is sRGB encoded
+        int width = 0;
+        int height = 0;
+        std::vector<std::vector<char>> levels;
+    };
+
+    // Reads and writes KTX2 and DDS containers with block compressed data. Contains CPU decoders (used when the
+    // graphics driver does not support a format) and simple encoders (used by utils/texture_compressor).
+    // Does not depend on OpenGL.
+    class TextureCompression {
+    public:
+        static bool isCompressedFile(const std::vector<char>& fileData);   // true if KTX2 or DDS
+        static bool load(const std::vector<char>& fileData, CompressedImage& image, std::string& error);
+        static std::vector<char> saveKTX2(const CompressedImage& image);
+        static std::vector<char> saveDDS(const CompressedImage& image);     // ETC2 is not supported in DDS (returns empty)
+
+        static int getBlockBytes(CompressedFormat format);                  // bytes per 4x4 block
+        static int getLevelBytes(CompressedFormat format, int width, int height);
+        static bool hasAlpha(CompressedFormat format);
+        static uint32_t getGLFormat(CompressedFormat format, bool srgb);    // GL internal format (0 if no sRGB variant)
+        static const char* getName(CompressedFormat format);
+
+        static std::vector<char> decompress(CompressedFormat format, const char* data, int width, int height); // Returns RGBA8
+        static std::vector<char> compress(CompressedFormat format, const char* rgba, int width, int height,  // rgba is RGBA8
+                                          int firstBlockRow = 0, int blockRows = -1);                        // Compress a range of block rows (-1 = all)
+    };
+}
@@ -0,0 +1,79 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sre {
+    class Texture;
+    class WorkerPool;
+    struct CompressedImage;
+    struct RenderStats;
+
+    // Keeps the mip levels of streamed textures (see TextureBuilder::withStreaming()) within a global budget.
+    // RenderPass requests the mip level needed for each draw. Missing levels are read from the KTX2/DDS file on a
+    // background thread and uploaded in update(). When the budget is exceeded, the most detailed levels of the least
+    // recently used textures are evicted (clamped using GL_TEXTURE_BASE_LEVEL). The lowest levels uploaded when the
+    // texture was built are always resident.
+    class TextureStreaming {
+    public:
+        TextureStreaming();
+        ~TextureStreaming();
+
+        void add(Texture* texture, const std::string& file, std::vector<int> levelBytes); // levelBytes is the GPU size of each mip level
+        void remove(Texture* texture);
+        bool isActive();                                        // true if any textures are streamed
+
+        void requestLevel(Texture* texture, int level);         // mip level used by a draw call this frame
+        void update(RenderStats& renderStats);                  // Upload loaded levels, start loads and evict (called once per frame)
+
+        void setBudget(int bytes);
+        int getBudget();
+        int getResidentBytes();
+
+        static int getDesiredLevel(int textureSize, float screenSize); // mip level with about one texel per pixel, when a texture of
+                                                                // textureSize texels covers screenSize pixels
+    private:
+        struct Entry {
+            int id;                                             // identifies the texture in loads (a new texture may reuse the address)
+            std::string file;
+            std::vector<int> levelBytes;
+            int permanentLevel;                                 // most detailed of the levels which are never evicted
+            int requestedLevel;                                 // most detailed level requested this frame (levelBytes.size() if unused)
+            int lastUsedFrame = -1;
+            int loadingBytes = 0;                               // size of the levels being loaded (0 if not loading)
+            bool failed = false;                                // file could not be reloaded
+        };
+        struct LoadedLevels {
+            Texture* texture;
+            int id;
+            int firstLevel;
+            std::shared_ptr<CompressedImage> image;             // null if the file could not be loaded
+        };
+
+        int getBytes(Entry& entry, int firstLevel, int lastLevel);
+        void load(Texture* texture, Entry& entry, int firstLevel);
+        bool evictLevel(RenderStats& renderStats, Texture* keep, bool onlyUnused);
+
+        std::unordered_map<Texture*, Entry> entries;
+        int nextId = 0;
+        int frame = 0;
+        int budget = 256*1024*1024;
+        int residentBytes = 0;
+        int loadingBytes = 0;
+
+        std::mutex mutex;
+        std::vector<LoadedLevels> completed;                    // loaded, but not uploaded yet (guarded by mutex)
+        std::unique_ptr<WorkerPool> loader;                     // created on first load. Declared last, so loads finish before the
+                                                                // other members are destroyed
+    };
+}
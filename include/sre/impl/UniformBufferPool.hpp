@@ -0,0 +1,38 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include "sre/impl/GL.hpp"
+#include <vector>
+
+namespace sre {
+    // Uniform buffer shared by all materials using a "material" uniform block of the same size.
+    // Each material owns one slot (aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT). The buffer grows when needed.
+    class UniformBufferPool {
+    public:
+        explicit UniformBufferPool(int blockSize);
+        ~UniformBufferPool();
+
+        int allocate();                                 // Return a free slot
+        void release(int slot);
+
+        void update(int slot, const void* data);        // Upload blockSize bytes to slot
+        void bind(int slot, int bindingIndex);          // Bind slot to uniform buffer binding index
+
+        int getBlockSize();
+    private:
+        void grow();
+
+        GLuint buffer = 0;
+        int blockSize;
+        int stride;                                     // blockSize rounded up to the offset alignment
+        int capacity = 0;                               // number of slots in buffer
+        int slotCount = 0;                              // number of slots handed out (including released slots)
+        std::vector<int> freeSlots;
+    };
+}
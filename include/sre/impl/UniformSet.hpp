@@ -7,13 +7,29 @@
 
 #pragma once
 
-#include "sre/Texture.hpp"
 #include "sre/Color.hpp"
 #include "glm/glm.hpp"
 #include <string>
-#include <map>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <cstdint>
 
 namespace sre {
+    class Texture;
+    struct Sampler;
+    struct RenderStats;
+
+    // Values last uploaded to the uniforms of a shader program (uniform state is stored per program).
+    // Used by UniformSet::bind() to skip uploads of unchanged values.
+    struct UniformShadow {
+        std::vector<int> offsetByLocation;              // offset in values (-1 if unknown)
+        std::vector<float> values;
+        std::vector<int> textureUnitByLocation;         // texture unit of sampler uniforms, assigned when the program is linked (-1 if not a sampler)
+        void clear();
+    };
+
+    // Uniform values stored in a flat array sorted by uniform location (id)
     class UniformSet {
     public:
         void set(int id, glm::vec4 value);
@@ -30,57 +46,91 @@ namespace sre {
 
         void set(int id, Color value);
 
+        bool setSampler(int id, std::shared_ptr<const Sampler> sampler); // Override the sampler of a texture value (nullptr to use the
+                                                                         // sampler of the texture). Returns false if not a texture value
+        std::shared_ptr<const Sampler> getSampler(int id);  // Returns nullptr if not overridden
+
         void clear();
 
-        void bind();
+        void bind(UniformShadow& shadow, RenderStats& renderStats); // Upload values to the current program and bind textures
+
+        bool contains(int id);
+
+        const std::vector<std::shared_ptr<sre::Texture>>& getTextures(); // Texture values (may contain null)
 
         template<typename T>
-        inline T get(int id);
+        inline T get(int id);                           // Returns default value if not found
     private:
-        std::map<int,std::shared_ptr<sre::Texture>> textureValues;
-        std::map<int,glm::vec4> vectorValues;
-        std::map<int,glm::mat4> mat4Values;
-        std::map<int,std::shared_ptr<std::vector<glm::mat4>>> mat4sValues;
-        std::map<int,std::shared_ptr<std::vector<glm::mat3>>> mat3sValues;
-        std::map<int,float> floatValues;
-
-        friend class Material;
+        enum class ValueType : uint8_t {
+            Float,
+            Vec4,
+            Mat4,
+            Texture,
+            Mat3Array,
+            Mat4Array
+        };
+        struct Value {
+            int id;
+            ValueType type;
+            int index;                                  // index in floats (Float, Vec4, Mat4) or in the vector of the type
+        };
+
+        Value* find(int id);
+        Value& insert(int id, ValueType type, int floatCount);
+        float* uploadIfChanged(UniformShadow& shadow, int location, const float* data, int count, int& elided);
+
+        std::vector<Value> values;                      // sorted by id
+        std::vector<float> floats;
+        std::vector<std::shared_ptr<sre::Texture>> textureValues;
+        std::vector<std::shared_ptr<const Sampler>> samplerValues;  // sampler overrides (same index as textureValues)
+        std::vector<std::shared_ptr<std::vector<glm::mat4>>> mat4sValues;
+        std::vector<std::shared_ptr<std::vector<glm::mat3>>> mat3sValues;
     };
 
     template<>
     inline std::shared_ptr<sre::Texture> UniformSet::get(int id) {
-        return textureValues[id];
+        auto v = find(id);
+        return v && v->type == ValueType::Texture ? textureValues[v->index] : nullptr;
     }
 
     template<>
     inline glm::vec4 UniformSet::get(int id)  {
-        return vectorValues[id];
+        auto v = find(id);
+        return v && v->type == ValueType::Vec4 ? glm::vec4(floats[v->index], floats[v->index+1], floats[v->index+2], floats[v->index+3]) : glm::vec4(0);
     }
 
     template<>
     inline glm::mat4 UniformSet::get(int id)  {
-        return mat4Values[id];
+        glm::mat4 res(1);
+        auto v = find(id);
+        if (v && v->type == ValueType::Mat4){
+            memcpy(&res[0][0], &floats[v->index], sizeof(glm::mat4));
+        }
+        return res;
     }
 
     template<>
     inline Color UniformSet::get(int id)  {
         Color value;
-        value.setFromLinear(vectorValues[id]);
+        value.setFromLinear(get<glm::vec4>(id));
         return value;
     }
 
     template<>
     inline float UniformSet::get(int id) {
-        return floatValues[id];
+        auto v = find(id);
+        return v && v->type == ValueType::Float ? floats[v->index] : 0.0f;
     }
 
     template<>
     inline std::shared_ptr<std::vector<glm::mat3>> UniformSet::get(int id) {
-        return mat3sValues[id];
+        auto v = find(id);
+        return v && v->type == ValueType::Mat3Array ? mat3sValues[v->index] : nullptr;
     }
 
     template<>
     inline std::shared_ptr<std::vector<glm::mat4>> UniformSet::get(int id) {
-        return mat4sValues[id];
+        auto v = find(id);
+        return v && v->type == ValueType::Mat4Array ? mat4sValues[v->index] : nullptr;
     }
-}
\ No newline at end of file
+}
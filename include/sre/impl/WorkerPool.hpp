@@ -0,0 +1,36 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace sre {
+    // Fixed size pool of worker threads running tasks in FIFO order. Tasks must not call OpenGL.
+    // On Emscripten (no threads) tasks are run when enqueued.
+    class WorkerPool {
+    public:
+        explicit WorkerPool(int threadCount = 0);                       // 0 = number of hardware threads - 1 (at least 1)
+        ~WorkerPool();                                                  // Waits for running tasks. Pending tasks are discarded
+
+        void enqueue(std::function<void()> task);
+        int getThreadCount();
+    private:
+        void run();
+
+        std::vector<std::thread> threads;
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool stopping = false;
+    };
+}
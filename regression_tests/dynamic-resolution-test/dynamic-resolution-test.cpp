@@ -0,0 +1,125 @@
+#include <iostream>
+#include <vector>
+
+#include "sre/Texture.hpp"
+#include "sre/Renderer.hpp"
+#include "sre/Material.hpp"
+#include "sre/DynamicResolution.hpp"
+#include "sre/Inspector.hpp"
+#include "sre/SDLRenderer.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace sre;
+
+// Renders lit spheres into the DynamicResolution framebuffer and upscales them to the screen. The "Load" slider adds
+// overlapping spheres drawn back to front (overdraw), which increases the frame time and lowers the render scale.
+// A second camera uses a viewport in the upper right corner (the viewport is scaled with the framebuffer).
+class DynamicResolutionTest {
+public:
+    DynamicResolutionTest() {
+        r.init();
+
+        camera.lookAt({0, 0, 6}, {0, 0, 0}, {0, 1, 0});
+        camera.setPerspectiveProjection(60, 0.1f, 100);
+        topCamera.lookAt({0, 6, 0.01f}, {0, 0, 0}, {0, 1, 0});
+        topCamera.setPerspectiveProjection(60, 0.1f, 100);
+        topCamera.setViewport({0.7f, 0.7f}, {0.3f, 0.3f});
+
+        material = Shader::getStandardPBR()->createMaterial();
+        material->setColor({1, .5f, .2f, 1});
+        material->setMetallicRoughness({.5f, .3f});
+        sphere = Mesh::create().withSphere(32, 64).build();
+        worldLights.setAmbientLight({.05f, .05f, .05f});
+        worldLights.addLight(Light::create().withDirectionalLight({1, 1, 1}).withColor({1, 1, 1}).build());
+
+        dynamicResolution = std::make_unique<DynamicResolution>(14.0f);
+
+        r.frameRender = [&](){
+            render();
+        };
+
+        r.startEventLoop();
+    }
+
+    void drawScene(RenderPass& renderPass){
+        for (int i = 0; i < load; i++){
+            // back to front, so each sphere passes the depth test
+            renderPass.draw(sphere, glm::translate(glm::mat4(1), {0, 0, -2 + i * 0.01f}) * glm::scale(glm::mat4(1), glm::vec3(2.5f)), material);
+        }
+        for (int i = 0; i < 8; i++){
+            float angle = glm::radians(i * 45.0f);
+            renderPass.draw(sphere, glm::translate(glm::mat4(1), {glm::cos(angle) * 2.5f, glm::sin(angle) * 2.5f, 0}) * glm::scale(glm::mat4(1), glm::vec3(.4f)), material);
+        }
+    }
+
+    void render(){
+        auto framebuffer = dynamicResolution->begin();
+        {
+            auto&& builder = RenderPass::create();
+            builder.withFramebuffer(framebuffer)
+                    .withCamera(camera)
+                    .withWorldLights(&worldLights)
+                    .withClearColor(true, {.3f, .3f, 1, 1})
+                    .withGUI(false);
+            auto scenePass = builder.build();
+            drawScene(scenePass);
+            scenePass.finish();
+        }
+        {
+            auto&& builder = RenderPass::create();
+            builder.withFramebuffer(framebuffer)
+                    .withCamera(topCamera)
+                    .withWorldLights(&worldLights)
+                    .withClearColor(true, {.1f, .1f, .1f, 1})
+                    .withGUI(false);
+            auto topPass = builder.build();
+            drawScene(topPass);
+            topPass.finish();
+        }
+
+        auto screenPass = RenderPass::create()
+                .withClearColor(true, {0, 0, 0, 1})
+                .build();
+        dynamicResolution->end(screenPass);
+
+        auto size = framebuffer->getRenderSize();
+        ImGui::LabelText("Render size", "%ix%i", size.x, size.y);
+        ImGui::LabelText("Scale", "%.2f", dynamicResolution->getScale());
+        ImGui::LabelText(dynamicResolution->isGPUTimed() ? "GPU time" : "Frame time", "%.2f ms", dynamicResolution->getFrameTime());
+        ImGui::SliderInt("Load", &load, 1, 400);
+        float budget = dynamicResolution->getBudget();
+        if (ImGui::SliderFloat("Budget ms", &budget, 1, 33)){
+            dynamicResolution->setBudget(budget);
+        }
+        float minScale = dynamicResolution->getMinScale();
+        if (ImGui::SliderFloat("Min scale", &minScale, 0.25f, 1)){
+            dynamicResolution->setScaleLimits(minScale);
+        }
+        float sharpness = dynamicResolution->getSharpness();
+        if (ImGui::SliderFloat("Sharpness", &sharpness, 0, 1)){
+            dynamicResolution->setSharpness(sharpness);
+        }
+        bool enabled = dynamicResolution->isEnabled();
+        if (ImGui::Checkbox("Enabled", &enabled)){
+            dynamicResolution->setEnabled(enabled);
+        }
+        static Inspector inspector;
+        inspector.update();
+        inspector.gui();
+    }
+private:
+    SDLRenderer r;
+    Camera camera;
+    Camera topCamera;
+    WorldLights worldLights;
+    std::shared_ptr<Material> material;
+    std::shared_ptr<Mesh> sphere;
+    std::unique_ptr<DynamicResolution> dynamicResolution;
+    int load = 1;
+};
+
+int main() {
+    std::make_unique<DynamicResolutionTest>();
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include <iostream>
+#include <vector>
+
+#include "sre/Texture.hpp"
+#include "sre/Renderer.hpp"
+#include "sre/Material.hpp"
+#include "sre/SDLRenderer.hpp"
+#include "sre/imgui_sre.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace sre;
+
+// A material using several texture units (color, metallic-roughness and normal map) rendered together with ImGui
+// drawing a texture. ImGui binds textures without the TextureBindingCache, so it must restore the bindings of all
+// units. Otherwise the sphere samples the wrong textures from the second frame (expected: red/white checker sphere
+// lit from the upper right and a blue image in the GUI).
+class ImGuiTextureBindingTest {
+public:
+    ImGuiTextureBindingTest() {
+        r.init();
+
+        camera.lookAt({0, 0, 3}, {0, 0, 0}, {0, 1, 0});
+        camera.setPerspectiveProjection(60, 0.1f, 100);
+        worldLights.setAmbientLight({.1f, .1f, .1f});
+        worldLights.addLight(Light::create().withDirectionalLight(glm::normalize(glm::vec3(1, 1, 1))).withColor({1, 1, 1}).build());
+
+        sphere = Mesh::create().withSphere(32, 64).build();
+        material = Shader::getStandardPBR()->createMaterial({{"S_METALROUGHNESSMAP", "1"}, {"S_NORMALMAP", "1"}});
+        material->setColor({1, 1, 1, 1});
+        material->setMetallicRoughness({1, 1});
+        material->set("tex", createTexture({255, 0, 0, 255}, {255, 255, 255, 255}));
+        material->set("mrTex", createTexture({0, 128, 0, 255}, {0, 128, 0, 255}));
+        material->set("normalTex", createTexture({128, 128, 255, 255}, {128, 128, 255, 255}));
+        material->set("normalScale", 1.0f);
+        guiTexture = createTexture({0, 0, 255, 255}, {0, 0, 255, 255});
+
+        r.frameRender = [&](){
+            render();
+        };
+
+        r.startEventLoop();
+    }
+
+    // 8x8 checker texture
+    std::shared_ptr<Texture> createTexture(std::vector<unsigned char> color1, std::vector<unsigned char> color2){
+        std::vector<unsigned char> data;
+        for (int y = 0; y < 8; y++){
+            for (int x = 0; x < 8; x++){
+                auto& color = (x + y) % 2 == 0 ? color1 : color2;
+                data.insert(data.end(), color.begin(), color.end());
+            }
+        }
+        return Texture::create()
+                .withRGBAData(reinterpret_cast<const char*>(data.data()), 8, 8)
+                .withFilterSampling(false)
+                .build();
+    }
+
+    void render(){
+        auto renderPass = RenderPass::create()
+                .withCamera(camera)
+                .withWorldLights(&worldLights)
+                .withClearColor(true, {0, 0, 0, 1})
+                .build();
+        renderPass.draw(sphere, glm::mat4(1), material);
+
+        ImGui::Begin("GUI texture");
+        ImGui_RenderTexture(guiTexture.get(), {64, 64});
+        ImGui::End();
+    }
+private:
+    SDLRenderer r;
+    Camera camera;
+    WorldLights worldLights;
+    std::shared_ptr<Mesh> sphere;
+    std::shared_ptr<Material> material;
+    std::shared_ptr<Texture> guiTexture;
+};
+
+int main() {
+    std::make_unique<ImGuiTextureBindingTest>();
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+
+#include "sre/Renderer.hpp"
+#include "sre/Material.hpp"
+#include "sre/Shader.hpp"
+#include "sre/Mesh.hpp"
+#include "sre/Camera.hpp"
+#include "sre/SDLRenderer.hpp"
+#include "sre/Log.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace sre;
+
+// Measures the CPU time of submitting and finishing a render pass where many materials (with 4, 16 or 64 vec4
+// uniforms) are drawn. Only every tenth material has unique values, so most uploads can be elided.
+// The "block" variants store the values in a material uniform block instead.
+class MaterialBindBenchmark {
+public:
+    MaterialBindBenchmark() {
+        r.init();
+
+        camera.lookAt({0,0,50},{0,0,0},{0,1,0});
+        camera.setPerspectiveProjection(60,0.1,100);
+
+        mesh = Mesh::create()
+                .withQuad(0.4f)
+                .build();
+
+        r.frameRender = [&](){
+            render();
+        };
+
+        r.startEventLoop();
+    }
+
+    std::string getFragmentShader(int uniformCount, bool uniformBlock){
+        std::string res = "#version 330\nout vec4 fragColor;\n";
+        if (uniformBlock){
+            res += "layout(std140) uniform material {\n";
+            for (int i=0;i<uniformCount;i++){
+                res += "    vec4 value"+std::to_string(i)+";\n";
+            }
+            res += "};\n";
+        } else {
+            for (int i=0;i<uniformCount;i++){
+                res += "uniform vec4 value"+std::to_string(i)+";\n";
+            }
+        }
+        res += "void main(void){\n    fragColor = vec4(0.0);\n";
+        for (int i=0;i<uniformCount;i++){
+            res += "    fragColor += value"+std::to_string(i)+";\n";
+        }
+        res += "    fragColor /= "+std::to_string(uniformCount)+".0;\n}\n";
+        return res;
+    }
+
+    void setupVariant(int uniformCount, bool uniformBlock){
+        std::string vertexShader = R"(#version 330
+in vec3 position;
+#pragma include "global_uniforms_incl.glsl"
+void main(void) {
+    gl_Position = g_projection * g_view * g_model * vec4(position,1.0);
+}
+)";
+        auto shader = Shader::create()
+                .withSourceString(vertexShader, ShaderType::Vertex)
+                .withSourceString(getFragmentShader(uniformCount, uniformBlock), ShaderType::Fragment)
+                .withName(std::string(uniformBlock ? "block" : "uniforms") + std::to_string(uniformCount))
+                .build();
+        materials.clear();
+        for (int i=0;i<materialCount;i++){
+            auto material = shader->createMaterial();
+            for (int j=0;j<uniformCount;j++){
+                float v = (i % 10 == 0) ? (float)i / materialCount : 0.5f;
+                material->set("value"+std::to_string(j), glm::vec4(v, (float)j / uniformCount, 0.5f, 1.0f));
+            }
+            materials.push_back(material);
+        }
+    }
+
+    double renderMaterials(){
+        auto start = std::chrono::high_resolution_clock::now();
+        auto renderPass = RenderPass::create()
+                .withCamera(camera)
+                .withClearColor(true, {0, 0, 0, 1})
+                .withGUI(false)
+                .build();
+        int columns = 50;
+        for (int i=0;i<materialCount;i++){
+            glm::vec3 pos((i % columns) - columns/2, (i / columns) - columns/2, 0);
+            renderPass.draw(mesh, glm::translate(glm::mat4(1), pos*0.5f), materials[i]);
+        }
+        renderPass.finish();
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    void render(){
+        if (benchmarkStep >= 0){
+            int uniformCounts[] = {4, 16, 64};
+            int uniformCount = uniformCounts[benchmarkStep % 3];
+            bool uniformBlock = benchmarkStep >= 3;
+            if (frame == 0){
+                setupVariant(uniformCount, uniformBlock);
+                result = {uniformCount, uniformBlock, 0, 0};
+            }
+            double ms = renderMaterials();
+            if (frame >= warmupFrames){
+                result.ms += ms / measuredFrames;
+                // stats of the previous frame (which rendered the same variant)
+                result.uploadsElided += Renderer::instance->getRenderStats().uniformUploadsElided;
+            }
+            frame++;
+            if (frame == warmupFrames + measuredFrames){
+                result.uploadsElided /= measuredFrames;
+                LOG_INFO("Material bind %s %i: %i materials %.3f ms, %i uploads elided per frame",
+                         uniformBlock ? "block" : "uniforms", uniformCount, materialCount, result.ms, result.uploadsElided);
+                results.push_back(result);
+                frame = 0;
+                benchmarkStep++;
+                if (benchmarkStep == 6){
+                    benchmarkStep = -1;
+                    materials.clear();
+                }
+            }
+        }
+
+        auto renderPass = RenderPass::create()
+                .withClearColor(false)
+                .build();
+
+        ImGui::LabelText("Materials", "%i", materialCount);
+        if (benchmarkStep >= 0){
+            ImGui::LabelText("","Benchmark running");
+        } else if (ImGui::Button("Start benchmark")){
+            results.clear();
+            benchmarkStep = 0;
+        }
+        ImGui::Columns(3);
+        ImGui::Text("Variant"); ImGui::NextColumn();
+        ImGui::Text("CPU ms"); ImGui::NextColumn();
+        ImGui::Text("Uploads elided"); ImGui::NextColumn();
+        for (auto & res : results){
+            ImGui::Text("%s %i", res.uniformBlock ? "block" : "uniforms", res.uniformCount); ImGui::NextColumn();
+            ImGui::Text("%.3f", res.ms); ImGui::NextColumn();
+            ImGui::Text("%i", res.uploadsElided); ImGui::NextColumn();
+        }
+        ImGui::Columns(1);
+    }
+private:
+    struct Result {
+        int uniformCount;
+        bool uniformBlock;
+        double ms;
+        int uploadsElided;
+    };
+    SDLRenderer r;
+    Camera camera;
+    std::shared_ptr<Mesh> mesh;
+    std::vector<std::shared_ptr<Material>> materials;
+    std::vector<Result> results;
+    Result result;
+    const int materialCount = 2500;
+    const int warmupFrames = 5;
+    const int measuredFrames = 30;
+    int benchmarkStep = 0;
+    int frame = 0;
+};
+
+int main() {
+    std::make_unique<MaterialBindBenchmark>();
+    return 0;
+}
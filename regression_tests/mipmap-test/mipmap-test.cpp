@@ -0,0 +1,93 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+
+#include "sre/Texture.hpp"
+#include "sre/Renderer.hpp"
+#include "sre/Material.hpp"
+#include "sre/SDLRenderer.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace sre;
+
+// Compares mipmaps generated on the CPU (box and Kaiser filter, filtered in linear space) with glGenerateMipmap on
+// receding planes with a fine black and white checkerboard. Gamma correct mipmaps keep the average brightness in the
+// distance.
+class MipmapTest {
+public:
+    MipmapTest() {
+        r.init();
+
+        camera.lookAt({0, 1, 3}, {0, 0, -10}, {0, 1, 0});
+        camera.setPerspectiveProjection(60, 0.1f, 100);
+        mesh = Mesh::create().withQuad(1).build();
+
+        const int size = 1024;
+        std::vector<char> data(size * size * 4, (char)255);
+        for (int y = 0; y < size; y++){
+            for (int x = 0; x < size; x++){
+                if ((x / 2 + y / 2) % 2 == 0){
+                    for (int c = 0; c < 3; c++){
+                        data[(x + y * size) * 4 + c] = 0;
+                    }
+                }
+            }
+        }
+        const char* names[] = {"CPU box", "CPU Kaiser", "glGenerateMipmap"};
+        for (int i = 0; i < 3; i++){
+            auto start = std::chrono::high_resolution_clock::now();
+            auto texture = Texture::create()
+                    .withRGBAData(data.data(), size, size)
+                    .withGenerateMipmaps(true)
+                    .withMipmapFilter(i == 1 ? Texture::MipmapFilter::Kaiser : Texture::MipmapFilter::Box)
+                    .withName(names[i])
+                    .build();
+            if (i == 2){
+                texture->ReGenerateMipmaps();
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            buildTimeMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+            auto material = Shader::getUnlit()->createMaterial();
+            material->setTexture(texture);
+            materials.push_back(material);
+            textures.push_back(texture);
+        }
+
+        r.frameRender = [&](){
+            render();
+        };
+
+        r.startEventLoop();
+    }
+
+    void render(){
+        auto renderPass = RenderPass::create()
+                .withCamera(camera)
+                .withClearColor(true, {.5f, .5f, .5f, 1})
+                .build();
+
+        for (int i = 0; i < (int)materials.size(); i++){
+            auto transform = glm::translate(glm::mat4(1), glm::vec3((i - 1) * 2.1f, 0, -10)) *
+                             glm::rotate(glm::mat4(1), glm::radians(-90.0f), glm::vec3(1, 0, 0)) *
+                             glm::scale(glm::mat4(1), glm::vec3(1, 10, 1));
+            renderPass.draw(mesh, transform, materials[i]);
+        }
+
+        for (int i = 0; i < (int)textures.size(); i++){
+            ImGui::LabelText(textures[i]->getName().c_str(), "%.1f ms", buildTimeMs[i]);
+        }
+    }
+private:
+    SDLRenderer r;
+    Camera camera;
+    std::shared_ptr<Mesh> mesh;
+    std::vector<std::shared_ptr<Material>> materials;
+    std::vector<std::shared_ptr<Texture>> textures;
+    std::vector<double> buildTimeMs;
+};
+
+int main() {
+    std::make_unique<MipmapTest>();
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <iostream>
+#include <vector>
+
+#include "sre/Texture.hpp"
+#include "sre/Renderer.hpp"
+#include "sre/Material.hpp"
+#include "sre/Framebuffer.hpp"
+#include "sre/SDLRenderer.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace sre;
+
+// Renders a rotated cube into a framebuffer without multisampling (left) and into a 4x multisampled framebuffer
+// (right), which is resolved into its texture when the render pass finishes. Both textures are drawn to the screen
+// using point sampling, so the anti-aliased edges are visible. The center pixel of the multisampled framebuffer is
+// read back after the resolve.
+class MSAAFramebufferTest {
+public:
+    MSAAFramebufferTest() {
+        r.init();
+
+        camera.lookAt({0, 0, 3}, {0, 0, 0}, {0, 1, 0});
+        camera.setPerspectiveProjection(60, 0.1f, 100);
+        screenCamera.setOrthographicProjection(1, -1, 1);
+
+        for (int samples : {1, 4}){
+            auto texture = Texture::create()
+                    .withRGBAData(nullptr, 128, 128)
+                    .withFilterSampling(false)
+                    .withName(std::string("MSAA ") + std::to_string(samples) + "x")
+                    .build();
+            auto depthTexture = Texture::create()
+                    .withDepth(128, 128, Texture::DepthPrecision::I24)
+                    .build();
+            framebuffers.push_back(Framebuffer::create()
+                    .withColorTexture(texture)
+                    .withDepthTexture(depthTexture)
+                    .withSamples(samples)
+                    .build());
+            auto material = Shader::getUnlit()->createMaterial();
+            material->setTexture(texture);
+            materials.push_back(material);
+        }
+
+        cubeMaterial = Shader::getStandardBlinnPhong()->createMaterial();
+        cubeMaterial->setColor({1, 1, 1, 1});
+        cube = Mesh::create().withCube(0.8f).build();
+        quad = Mesh::create().withQuad(0.45f).build();
+        worldLights.addLight(Light::create().withDirectionalLight({1, 1, 1}).withColor({1, 1, 1}).build());
+
+        r.frameRender = [&](){
+            render();
+        };
+
+        r.startEventLoop();
+    }
+
+    void render(){
+        auto transform = glm::rotate(glm::mat4(1), glm::radians(30.0f), glm::vec3(1, 1, 0));
+        glm::u8vec4 center;
+        for (auto& framebuffer : framebuffers){
+            auto renderPass = RenderPass::create()
+                    .withCamera(camera)
+                    .withWorldLights(&worldLights)
+                    .withFramebuffer(framebuffer)
+                    .withClearColor(true, {0, 0, 0, 1})
+                    .withGUI(false)
+                    .build();
+            renderPass.draw(cube, transform, cubeMaterial);
+            renderPass.finish();
+            center = renderPass.readRawPixels(64, 64)[0];
+        }
+
+        auto renderPass = RenderPass::create()
+                .withCamera(screenCamera)
+                .withClearColor(true, {.3f, .3f, 1, 1})
+                .build();
+        for (int i=0;i<(int)materials.size();i++){
+            renderPass.draw(quad, glm::translate(glm::mat4(1), glm::vec3(i - 0.5f, 0, 0)), materials[i]);
+        }
+
+        ImGui::LabelText("Max samples", "%i", renderInfo().maxSamples);
+        ImGui::LabelText("Samples", "%i", framebuffers[1]->getSamples());
+        ImGui::LabelText("Center pixel", "%i %i %i %i", center.r, center.g, center.b, center.a);
+    }
+private:
+    SDLRenderer r;
+    Camera camera;
+    Camera screenCamera;
+    WorldLights worldLights;
+    std::shared_ptr<Mesh> cube;
+    std::shared_ptr<Mesh> quad;
+    std::shared_ptr<Material> cubeMaterial;
+    std::vector<std::shared_ptr<Framebuffer>> framebuffers;
+    std::vector<std::shared_ptr<Material>> materials;
+};
+
+int main() {
+    std::make_unique<MSAAFramebufferTest>();
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include <iostream>
+#include <vector>
+
+#include "sre/Texture.hpp"
+#include "sre/Renderer.hpp"
+#include "sre/Material.hpp"
+#include "sre/RenderGraph.hpp"
+#include "sre/Inspector.hpp"
+#include "sre/SDLRenderer.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace sre;
+
+// A render graph with four passes:
+// - "Pattern" renders a sphere into an imported mipmapped texture (mipmaps are generated, since it is read later)
+// - "Scene" renders a cube textured with the pattern into a transient color and depth texture
+// - "Unused" renders into a transient texture, which is never read (the pass is culled)
+// - "Present" is declared before "Scene", reads the transient color texture and blits it to the screen with the GUI
+// The compiled graph is shown in the Inspector.
+class RenderGraphTest {
+public:
+    RenderGraphTest() {
+        r.init();
+
+        camera.lookAt({0, 0, 3}, {0, 0, 0}, {0, 1, 0});
+        camera.setPerspectiveProjection(60, 0.1f, 100);
+        patternCamera.setOrthographicProjection(1, -1, 1);
+
+        patternTexture = Texture::create()
+                .withRGBAData(nullptr, 256, 256)
+                .withGenerateMipmaps(true)
+                .withName("Pattern")
+                .build();
+        patternMaterial = Shader::getUnlit()->createMaterial();
+        patternMaterial->setColor({1, .5f, 0, 1});
+        cubeMaterial = Shader::getUnlit()->createMaterial();
+        cubeMaterial->setTexture(patternTexture);
+        sphere = Mesh::create().withSphere().build();
+        cube = Mesh::create().withCube(0.8f).build();
+
+        graph = std::make_unique<RenderGraph>("Test graph");
+        auto size = Renderer::instance->getDrawableSize();
+        int pattern = graph->importTexture("Pattern", patternTexture);
+        int color = graph->createTexture("Scene color", size);
+        int depth = graph->createTexture("Scene depth", size, Texture::DepthPrecision::I24);
+        int unused = graph->createTexture("Unused", size);
+
+        graph->addPass("Pattern")
+                .writeColor(pattern)
+                .withSetup([&](RenderPass::RenderPassBuilder& builder){
+                    builder.withCamera(patternCamera).withClearColor(true, {0, 0, 1, 1});
+                })
+                .withExecute([&](RenderPass& renderPass){
+                    renderPass.draw(sphere, glm::mat4(1), patternMaterial);
+                });
+        graph->addPass("Present")
+                .read(color)
+                .writeScreen()
+                .withSetup([&](RenderPass::RenderPassBuilder& builder){
+                    builder.withGUI(true);
+                })
+                .withExecute([&, color](RenderPass& renderPass){
+                    renderPass.blit(graph->getTexture(color));
+                    static Inspector inspector;
+                    inspector.update();
+                    inspector.gui(true);
+                });
+        graph->addPass("Scene")
+                .read(pattern)
+                .writeColor(color)
+                .writeDepth(depth)
+                .withSetup([&](RenderPass::RenderPassBuilder& builder){
+                    builder.withCamera(camera).withClearColor(true, {.3f, .3f, 1, 1});
+                })
+                .withExecute([&](RenderPass& renderPass){
+                    renderPass.draw(cube, glm::rotate(glm::mat4(1), glm::radians(30.0f), glm::vec3(1, 1, 0)), cubeMaterial);
+                });
+        graph->addPass("Unused")
+                .writeColor(unused)
+                .withExecute([&](RenderPass& renderPass){
+                    renderPass.draw(cube, glm::mat4(1), cubeMaterial);
+                });
+
+        r.frameRender = [&](){
+            graph->execute();
+        };
+
+        r.startEventLoop();
+    }
+private:
+    SDLRenderer r;
+    std::unique_ptr<RenderGraph> graph;
+    Camera camera;
+    Camera patternCamera;
+    std::shared_ptr<Mesh> sphere;
+    std::shared_ptr<Mesh> cube;
+    std::shared_ptr<Texture> patternTexture;
+    std::shared_ptr<Material> patternMaterial;
+    std::shared_ptr<Material> cubeMaterial;
+};
+
+int main() {
+    std::make_unique<RenderGraphTest>();
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include <iostream>
+#include <vector>
+
+#include "sre/Texture.hpp"
+#include "sre/Renderer.hpp"
+#include "sre/Material.hpp"
+#include "sre/SDLRenderer.hpp"
+#include "sre/RenderTargetPool.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace sre;
+
+// Renders a spinning cube into a window sized render target from the RenderTargetPool and shows it on a full screen
+// quad. The scene texture is released after use, so the picture-in-picture target (same size) reuses it within the
+// frame. Resizing the window allocates new targets and the old ones are deleted after a few frames.
+class RenderTargetPoolTest {
+public:
+    RenderTargetPoolTest() {
+        r.init().withSdlWindowFlags(SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE);
+
+        cube = Mesh::create().withCube(0.5f).build();
+        quad = Mesh::create().withQuad(1).build();
+        sceneMaterial = Shader::getStandardBlinnPhong()->createMaterial();
+        sceneMaterial->setColor({1, .5f, .2f, 1});
+        quadMaterial = Shader::getUnlit()->createMaterial();
+        worldLights.setAmbientLight({.2f, .2f, .2f});
+        worldLights.addLight(Light::create().withPointLight({0, 2, 4}).build());
+
+        r.frameRender = [&](){
+            render();
+        };
+
+        r.startEventLoop();
+    }
+
+    void renderScene(std::shared_ptr<Texture> target, Color clearColor){
+        auto& pool = Renderer::instance->getRenderTargetPool();
+        Camera camera;
+        camera.setPerspectiveProjection(60, 0.1f, 10);
+        camera.lookAt({0, 0, 3}, {0, 0, 0}, {0, 1, 0});
+        auto renderPass = RenderPass::create()
+                .withFramebuffer(pool.getFramebuffer({target}))
+                .withCamera(camera)
+                .withWorldLights(&worldLights)
+                .withClearColor(true, clearColor)
+                .withGUI(false)
+                .build();
+        renderPass.draw(cube, glm::rotate(glm::mat4(1), rotation, glm::vec3(1, 1, 0)), sceneMaterial);
+        renderPass.finish();
+    }
+
+    void drawQuad(RenderPass& renderPass, std::shared_ptr<Texture> texture, glm::vec2 offset, float scale){
+        auto size = Renderer::instance->getDrawableSize();
+        float aspect = size.x / (float)size.y;
+        quadMaterial->setTexture(texture);
+        glm::mat4 transform = glm::translate(glm::mat4(1), glm::vec3(offset, 0)) * glm::scale(glm::mat4(1), glm::vec3(aspect * scale, scale, 1));
+        renderPass.draw(quad, transform, quadMaterial);
+    }
+
+    void render(){
+        rotation += 0.01f;
+        auto& pool = Renderer::instance->getRenderTargetPool();
+        auto size = Renderer::instance->getDrawableSize();
+
+        auto sceneTexture = pool.getTexture(size);
+        renderScene(sceneTexture, {.3f, .3f, 1, 1});
+
+        Camera camera;
+        camera.setOrthographicProjection(1, -1, 1);
+        auto renderPass = RenderPass::create()
+                .withCamera(camera)
+                .withClearColor(true, {0, 0, 0, 1})
+                .withGUI(false)
+                .build();
+        drawQuad(renderPass, sceneTexture, {0, 0}, 1);
+        renderPass.finish();
+        pool.release(sceneTexture);
+
+        auto pipTexture = pool.getTexture(size);                // reuses the scene texture
+        renderScene(pipTexture, {1, .3f, .3f, 1});
+        auto guiPass = RenderPass::create()
+                .withCamera(camera)
+                .withClearColor(false)
+                .build();
+        drawQuad(guiPass, pipTexture, {.6f, -.6f}, .3f);
+
+        auto& stats = Renderer::instance->getRenderStats();
+        ImGui::LabelText("Targets", "%i", pool.getTargetCount());
+        ImGui::LabelText("Pool size", "%.1f MB", stats.renderTargetPoolBytes / 1000000.0f);
+        ImGui::LabelText("Hits / misses", "%i / %i", stats.renderTargetPoolHits, stats.renderTargetPoolMisses);
+    }
+private:
+    SDLRenderer r;
+    std::shared_ptr<Mesh> cube;
+    std::shared_ptr<Mesh> quad;
+    std::shared_ptr<Material> sceneMaterial;
+    std::shared_ptr<Material> quadMaterial;
+    WorldLights worldLights;
+    float rotation = 0;
+};
+
+int main() {
+    std::make_unique<RenderTargetPoolTest>();
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <iostream>
+#include <vector>
+
+#include "sre/Texture.hpp"
+#include "sre/Renderer.hpp"
+#include "sre/Material.hpp"
+#include "sre/Sampler.hpp"
+#include "sre/SDLRenderer.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace sre;
+
+// Draws the same mipmapped checkerboard texture on three tilted planes using material sampler overrides: point
+// sampling, trilinear filtering and trilinear filtering with 16x anisotropy. Only one texture object is created.
+class SamplerTest {
+public:
+    SamplerTest() {
+        r.init();
+
+        camera.lookAt({0, 1.5f, 6}, {0, 0, 0}, {0, 1, 0});
+        camera.setPerspectiveProjection(60, 0.1f, 100);
+        mesh = Mesh::create().withQuad(1).build();
+
+        std::vector<char> rgba(256 * 256 * 4);
+        for (int y = 0; y < 256; y++){
+            for (int x = 0; x < 256; x++){
+                bool checker = ((x / 16) + (y / 16)) % 2 == 0;
+                char* p = &rgba[(x + y * 256) * 4];
+                p[0] = p[1] = p[2] = (char)(checker ? 255 : 32);
+                p[3] = (char)255;
+            }
+        }
+        texture = Texture::create()
+                .withRGBAData(rgba.data(), 256, 256)
+                .withGenerateMipmaps(true)
+                .withName("Checkerboard")
+                .build();
+
+        Sampler point;
+        point.filter = Sampler::Filter::Point;
+        Sampler trilinear;
+        Sampler anisotropic;
+        anisotropic.anisotropy = 16;
+        for (auto& sampler : {point, trilinear, anisotropic}){
+            auto material = Shader::getUnlit()->createMaterial();
+            material->setTexture(texture);
+            material->setSampler("tex", sampler);
+            materials.push_back(material);
+        }
+
+        r.frameRender = [&](){
+            render();
+        };
+
+        r.startEventLoop();
+    }
+
+    void render(){
+        auto renderPass = RenderPass::create()
+                .withCamera(camera)
+                .withClearColor(true, {.3f, .3f, 1, 1})
+                .build();
+
+        for (int i=0;i<(int)materials.size();i++){
+            auto transform = glm::translate(glm::mat4(1), glm::vec3((i - 1) * 2.2f, 0, 0)) *
+                             glm::rotate(glm::mat4(1), glm::radians(-80.0f), glm::vec3(1, 0, 0)) *
+                             glm::scale(glm::mat4(1), glm::vec3(1, 4, 1));
+            renderPass.draw(mesh, transform, materials[i]);
+        }
+
+        ImGui::LabelText("Sampler objects", "%s", renderInfo().supportSamplerObjects ? "true" : "false");
+        ImGui::LabelText("Max anisotropy", "%.0fx", renderInfo().maxAnisotropy);
+    }
+private:
+    SDLRenderer r;
+    Camera camera;
+    std::shared_ptr<Mesh> mesh;
+    std::shared_ptr<Texture> texture;
+    std::vector<std::shared_ptr<Material>> materials;
+};
+
+int main() {
+    std::make_unique<SamplerTest>();
+    return 0;
+}
@@ -0,0 +1,279 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <regex>
+#include <sstream>
+
+#include "sre/Renderer.hpp"
+#include "sre/Shader.hpp"
+#include "sre/Resource.hpp"
+#include "sre/SDLRenderer.hpp"
+#include "sre/Log.hpp"
+#include "sre/impl/GL.hpp"
+#include "sre/impl/ShaderPreprocessor.hpp"
+
+using namespace sre;
+
+// Measures the shader preprocessor (include expansion, defines and GLSL ES translation) over all built-in shaders
+// in src/embedded_deps with a number of specializations each. The regex based implementation used previously is
+// kept below as reference.
+namespace legacy {
+    std::string pragmaInclude(std::string source, std::vector<std::string>& errors, uint32_t shaderType){
+        if (source.find("#pragma include")==-1) {
+            return source;
+        }
+        std::stringstream sstream;
+
+        std::regex e ( R"_(#pragma\s+include\s+"([^"]*)")_", std::regex::ECMAScript);
+        int lineNumber = 0;
+        std::stringstream lines(source);
+        int includes = 0;
+        for (std::string s; std::getline(lines, s); )
+        {
+            lineNumber++;
+
+            std::smatch m;
+            if (std::regex_search (s,m,e)) {
+                std::string match = m[1];
+                auto res = Resource::loadText(match);
+                if (res.empty()){
+                    errors.push_back(std::string("0:")+std::to_string(lineNumber)+" cannot find include file "+match+"##"+std::to_string(shaderType));
+                    sstream << s << "\n";
+                } else {
+                    includes++;
+                    sstream << "#line "<<(includes*10000+1) <<"\n";
+                    sstream << res << "\n";
+                    sstream << "#line "<<lineNumber << "\n";
+                }
+            } else {
+                sstream << s << "\n";
+            }
+        }
+        return sstream.str();
+    }
+
+    std::string insertPreprocessorDefines(std::string source, const std::string& defines){
+        auto version = static_cast<int>(source.rfind("#version"));
+        auto extension = static_cast<int>(source.rfind("#extension"));
+        auto last = std::max(version, extension);
+        if (last == -1){
+            return defines + "#line 1\n" + source;
+        }
+        auto insertPos = source.find('\n', last);
+        int lines = 0;
+        for (int i=0;i<insertPos;i++){
+            if (source.at(i) == '\n'){
+                lines++;
+            }
+        }
+        return source.substr(0, insertPos+1) +
+               defines + "#line "+std::to_string(lines+1)+"\n" +
+               source.substr(insertPos+1);
+    }
+
+    std::string translateToGLSLES(std::string source, bool vertexShader, int version) {
+        using namespace std;
+        string replace = "#version 330";
+        string replaceWith = string("#version ")+std::to_string(version);
+        if (version >100){
+            replaceWith += " es";
+        }
+
+        size_t f = source.find(replace);
+        if (f != std::string::npos){
+            source = source.replace(f, replace.length(), replaceWith);
+        }
+        if (!vertexShader){
+            auto extension = source.rfind("#extension");
+            string::size_type insertPrecisionPos = string::npos;
+            if (extension != string::npos){
+                insertPrecisionPos = source.find('\n',extension);
+            } else {
+                insertPrecisionPos = source.find('\n');
+            }
+            if (insertPrecisionPos == string::npos){
+                insertPrecisionPos = 0;
+            }
+            source = source.substr(0, insertPrecisionPos)+
+                     "\n"
+                     "#ifdef GL_FRAGMENT_PRECISION_HIGH    \n"
+                     "   precision highp float;            \n"
+                     "   precision highp int;            \n"
+                     "#else                                \n"
+                     "   precision mediump float;          \n"
+                     "   precision mediump int;          \n"
+                     "#endif                               \n"
+                     "#line 2"+
+                     source.substr(insertPrecisionPos);
+        }
+        if (version == 100){
+            if (vertexShader){
+                regex regExpSearchShim3 { R"(\n\s*out\b)"};
+                source = regex_replace(source, regExpSearchShim3, "\nvarying");
+                regex regExpSearchShim4 { R"(\n\s*in\b)"};
+                source = regex_replace(source, regExpSearchShim4, "\nattribute");
+            } else {
+                regex regExpSearchShim2 { R"(\bfragColor\b)"};
+                source = regex_replace(source, regExpSearchShim2, "gl_FragColor");
+                regex regExpSearchShim3 { R"(\n\s*out\b)"};
+                source = regex_replace(source, regExpSearchShim3, "\n// out");
+                regex regExpSearchShim4 { R"(\n\s*in\b)"};
+                source = regex_replace(source, regExpSearchShim4, "\nvarying");
+            }
+
+            regex regExpSearchShim1 { R"(\s*uniform\s+sampler([\w]*)\s+([\w_]*)\s*;.*)"};
+            istringstream iss(source);
+            map<string,string> textureType;
+            smatch match;
+            for (std::string line; std::getline(iss, line); )
+            {
+                regex_search(line, match, regExpSearchShim1);
+                if (!match.empty()){
+                    textureType[match[2].str()] = match[1].str();
+                }
+            }
+
+            for (auto val : textureType){
+                regex regExpSearchShim4 { string{R"(texture\s*\(\s*)"}+val.first+"\\s*," };
+                source = regex_replace(source, regExpSearchShim4, string{"texture"}+val.second+"("+val.first+",");
+            }
+        }
+        return source;
+    }
+
+    std::string process(const std::string& source, const std::string& defines, bool vertexShader, int esVersion, std::vector<std::string>& errors){
+        auto res = insertPreprocessorDefines(pragmaInclude(source, errors, 0), defines);
+        if (esVersion > 0){
+            res = translateToGLSLES(res, vertexShader, esVersion);
+        }
+        return res;
+    }
+}
+
+class ShaderPreprocessorBenchmark {
+public:
+    ShaderPreprocessorBenchmark() {
+        r.init();
+
+        for (auto& key : Resource::getKeys(ResourceType::BuiltIn)){
+            bool isShader = key.find(".glsl") != std::string::npos && key.find("_incl") == std::string::npos;
+            if (isShader){
+                shaders.push_back(key);
+            }
+        }
+
+        r.frameRender = [&](){
+            render();
+        };
+
+        r.startEventLoop();
+    }
+
+    template<typename F>
+    double measureMs(F f){
+        auto start = std::chrono::high_resolution_clock::now();
+        f();
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    // defines for a specialization (similar to Shader::getPreprocessorDefines())
+    std::string getDefines(int specialization, bool vertexShader){
+        const char* constants[] = {"S_SHADOW", "S_NORMALMAP", "S_TANGENTS", "S_VERTEX_COLOR", "S_TWO_SIDED", "S_METALROUGHNESSMAP"};
+        std::string defines = "#define SI_LIGHTS 4\n";
+        defines += vertexShader ? "#define SI_VERTEX 1\n" : "#define SI_FRAGMENT 1\n";
+        for (int i=0;i<6;i++){
+            if (specialization & (1<<i)){
+                defines += std::string("#define ")+constants[i]+" 1\n";
+            }
+        }
+        return defines;
+    }
+
+    void runBenchmark(int esVersion){
+        Result result;
+        result.esVersion = esVersion;
+        result.variants = 0;
+        size_t bytes = 0;
+        std::vector<std::string> errors;
+        result.legacyMs = measureMs([&]{
+            for (auto& name : shaders){
+                bool vertexShader = name.find("_vert") != std::string::npos;
+                auto source = Resource::loadText(name);
+                for (int i=0;i<specializations;i++){
+                    bytes += legacy::process(source, getDefines(i, vertexShader), vertexShader, esVersion, errors).size();
+                }
+            }
+        });
+        ShaderPreprocessor::clearIncludeCache();
+        result.preprocessorMs = measureMs([&]{
+            for (auto& name : shaders){
+                bool vertexShader = name.find("_vert") != std::string::npos;
+                auto source = Resource::loadText(name);
+                for (int i=0;i<specializations;i++){
+                    bytes += ShaderPreprocessor::process(source, getDefines(i, vertexShader), vertexShader ? GL_VERTEX_SHADER : GL_FRAGMENT_SHADER, esVersion, errors).size();
+                    result.variants++;
+                }
+            }
+        });
+        LOG_INFO("Shader preprocessor GLSL %s: %i variants, regex %.2f ms, single pass %.2f ms (%i bytes)",
+                 esVersion == 0 ? "330" : std::to_string(esVersion).c_str(), result.variants, result.legacyMs, result.preprocessorMs, (int)bytes);
+        results.push_back(result);
+    }
+
+    void render(){
+        if (benchmarkStep >= 0){
+            int esVersions[] = {0, 100, 300};
+            runBenchmark(esVersions[benchmarkStep]);
+            benchmarkStep++;
+            if (benchmarkStep == 3){
+                benchmarkStep = -1;
+            }
+        }
+
+        auto renderPass = RenderPass::create()
+                .withClearColor(true, {0, 0, 0, 1})
+                .build();
+
+        ImGui::LabelText("Shaders", "%i", (int)shaders.size());
+        if (benchmarkStep >= 0){
+            ImGui::LabelText("","Benchmark running");
+        } else if (ImGui::Button("Start benchmark")){
+            results.clear();
+            benchmarkStep = 0;
+        }
+        ImGui::Columns(4);
+        ImGui::Text("Target"); ImGui::NextColumn();
+        ImGui::Text("Variants"); ImGui::NextColumn();
+        ImGui::Text("Regex ms"); ImGui::NextColumn();
+        ImGui::Text("Single pass ms"); ImGui::NextColumn();
+        for (auto & res : results){
+            if (res.esVersion == 0){
+                ImGui::Text("GLSL 330"); ImGui::NextColumn();
+            } else {
+                ImGui::Text("GLSL ES %i", res.esVersion); ImGui::NextColumn();
+            }
+            ImGui::Text("%i", res.variants); ImGui::NextColumn();
+            ImGui::Text("%.2f", res.legacyMs); ImGui::NextColumn();
+            ImGui::Text("%.2f", res.preprocessorMs); ImGui::NextColumn();
+        }
+        ImGui::Columns(1);
+    }
+private:
+    struct Result {
+        int esVersion;
+        int variants;
+        double legacyMs;
+        double preprocessorMs;
+    };
+    SDLRenderer r;
+    std::vector<std::string> shaders;
+    std::vector<Result> results;
+    const int specializations = 64;
+    int benchmarkStep = 0;
+};
+
+int main() {
+    std::make_unique<ShaderPreprocessorBenchmark>();
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+
+#include "sre/Renderer.hpp"
+#include "sre/Material.hpp"
+#include "sre/SpatialIndex.hpp"
+#include "sre/SDLRenderer.hpp"
+#include "sre/Log.hpp"
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/transform.hpp>
+#include <glm/gtc/random.hpp>
+
+using namespace sre;
+
+// Measures SpatialIndex insert, update, frustum query and ray cast time from 1k to 1M instances.
+// The frustum query is compared with a linear scan over the instance bounds.
+class SpatialIndexBenchmark {
+public:
+    SpatialIndexBenchmark() {
+        r.init();
+
+        camera.setPerspectiveProjection(60,0.1,1000);
+        camera.lookAt({0,0,0},{0,0,-1},{0,1,0});
+
+        worldLights.addLight(Light::create().withDirectionalLight(glm::vec3(1,1,1)).withColor(Color(1,1,1),1).build());
+        mesh = Mesh::create().withCube(0.5f).build();
+        material = Shader::getStandardBlinnPhong()->createMaterial();
+
+        r.frameRender = [&](){
+            render();
+        };
+
+        r.startEventLoop();
+    }
+
+    template<typename F>
+    double measureMs(F f){
+        auto start = std::chrono::high_resolution_clock::now();
+        f();
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    void runBenchmark(int count){
+        Result result;
+        result.count = count;
+        float worldSize = 20.0f * cbrtf((float)count);
+        std::vector<glm::mat4> transforms(count);
+        for (auto & t : transforms){
+            t = glm::translate(glm::linearRand(glm::vec3(-worldSize), glm::vec3(worldSize)));
+        }
+
+        index = SpatialIndex();
+        std::vector<int> ids(count);
+        result.insertMs = measureMs([&]{
+            for (int i=0;i<count;i++){
+                ids[i] = index.insert(mesh, transforms[i], {material});
+            }
+        });
+        int updates = std::max(1, count / 10);
+        result.updateMs = measureMs([&]{
+            for (int i=0;i<updates;i++){
+                int id = ids[glm::linearRand(0, count-1)];
+                index.update(id, transforms[id] * glm::translate(glm::ballRand(0.5f)));
+            }
+        });
+
+        glm::mat4 viewProjection = camera.getProjectionTransform(glm::uvec2(Renderer::instance->getDrawableSize())) * camera.getViewTransform();
+        std::vector<int> visible;
+        result.frustumMs = measureMs([&]{
+            index.queryFrustum(viewProjection, visible);
+        });
+        result.visible = (int)visible.size();
+
+        // linear reference: test the center of every instance against the frustum in clip space
+        int linearVisible = 0;
+        result.linearFrustumMs = measureMs([&]{
+            for (int i=0;i<count;i++){
+                auto bounds = index.getBoundsMinMax(ids[i]);
+                glm::vec3 center = (bounds[0]+bounds[1])*0.5f;
+                glm::vec4 clip = viewProjection * glm::vec4(center, 1.0f);
+                if (glm::abs(clip.x) <= clip.w && glm::abs(clip.y) <= clip.w && glm::abs(clip.z) <= clip.w){
+                    linearVisible++;
+                }
+            }
+        });
+
+        const int rays = 1000;
+        int hits = 0;
+        result.raycastMs = measureMs([&]{
+            for (int i=0;i<rays;i++){
+                RaycastHit hit;
+                glm::vec3 dir = glm::sphericalRand(1.0f);
+                if (index.raycast({glm::vec3(0), dir}, hit) != -1){
+                    hits++;
+                }
+            }
+        });
+        result.height = index.getHeight();
+        LOG_INFO("SpatialIndex %i instances: insert %.2f ms, update %.2f ms, frustum %.3f ms (%i visible, linear %.3f ms), %i rays %.2f ms (%i hits), height %i",
+                 count, result.insertMs, result.updateMs, result.frustumMs, result.visible, result.linearFrustumMs, rays, result.raycastMs, hits, result.height);
+        results.push_back(result);
+    }
+
+    void render(){
+        if (benchmarkStep >= 0){
+            int counts[] = {1000, 10000, 100000, 1000000};
+            runBenchmark(counts[benchmarkStep]);
+            benchmarkStep++;
+            if (benchmarkStep == 4){
+                benchmarkStep = -1;
+            }
+        }
+
+        auto renderPass = RenderPass::create()
+                .withCamera(camera)
+                .withWorldLights(&worldLights)
+                .withClearColor(true, {0, 0, 0, 1})
+                .build();
+
+        if (index.size() <= 10000){
+            renderPass.draw(index);
+        }
+
+        if (benchmarkStep >= 0){
+            ImGui::LabelText("","Benchmark running");
+        } else if (ImGui::Button("Start benchmark")){
+            results.clear();
+            benchmarkStep = 0;
+        }
+        ImGui::Columns(7);
+        ImGui::Text("Instances"); ImGui::NextColumn();
+        ImGui::Text("Insert ms"); ImGui::NextColumn();
+        ImGui::Text("Update ms"); ImGui::NextColumn();
+        ImGui::Text("Frustum ms"); ImGui::NextColumn();
+        ImGui::Text("Linear ms"); ImGui::NextColumn();
+        ImGui::Text("1k rays ms"); ImGui::NextColumn();
+        ImGui::Text("Height"); ImGui::NextColumn();
+        for (auto & res : results){
+            ImGui::Text("%i", res.count); ImGui::NextColumn();
+            ImGui::Text("%.2f", res.insertMs); ImGui::NextColumn();
+            ImGui::Text("%.2f", res.updateMs); ImGui::NextColumn();
+            ImGui::Text("%.3f", res.frustumMs); ImGui::NextColumn();
+            ImGui::Text("%.3f", res.linearFrustumMs); ImGui::NextColumn();
+            ImGui::Text("%.2f", res.raycastMs); ImGui::NextColumn();
+            ImGui::Text("%i", res.height); ImGui::NextColumn();
+        }
+        ImGui::Columns(1);
+    }
+private:
+    struct Result {
+        int count;
+        double insertMs;
+        double updateMs;
+        double frustumMs;
+        double linearFrustumMs;
+        double raycastMs;
+        int visible;
+        int height;
+    };
+    SDLRenderer r;
+    Camera camera;
+    WorldLights worldLights;
+    std::shared_ptr<Mesh> mesh;
+    std::shared_ptr<Material> material;
+    SpatialIndex index;
+    std::vector<Result> results;
+    int benchmarkStep = 0;
+};
+
+int main() {
+    std::make_unique<SpatialIndexBenchmark>();
+    return 0;
+}
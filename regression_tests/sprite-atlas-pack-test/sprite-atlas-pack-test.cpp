@@ -0,0 +1,104 @@
+#include <iostream>
+#include <vector>
+
+#include "sre/Texture.hpp"
+#include "sre/Renderer.hpp"
+#include "sre/SpriteAtlas.hpp"
+#include "sre/SpriteBatch.hpp"
+#include "sre/SDLRenderer.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace sre;
+
+// Packs procedural circles (with transparent borders, which are trimmed) into a sprite atlas with small pages, so
+// several pages are created. Sprites are drawn in a grid using a single SpriteBatch (one draw call per page).
+// "Add sprites" inserts more images into the existing atlas.
+class SpriteAtlasPackTest {
+public:
+    SpriteAtlasPackTest() {
+        r.init();
+        camera.setWindowCoordinates();
+
+        std::vector<SpriteAtlas::PackImage> images;
+        for (int i = 0; i < 40; i++){
+            images.push_back(createCircle(i));
+        }
+        SpriteAtlas::PackOptions options;
+        options.maxPageSize = 256;
+        atlas = SpriteAtlas::pack(images, options, "circles");
+        updateSpriteBatch();
+
+        r.frameRender = [&](){
+            render();
+        };
+
+        r.startEventLoop();
+    }
+
+    // circle in a larger transparent image (bottom row first)
+    SpriteAtlas::PackImage createCircle(int index){
+        int radius = 8 + (index * 7) % 28;
+        int border = 1 + index % 5;
+        int size = (radius + border) * 2;
+        glm::vec3 color = glm::vec3((index * 37) % 256, (index * 91) % 256, (index * 53 + 128) % 256);
+        std::vector<char> rgba(size * size * 4, 0);
+        for (int y = 0; y < size; y++){
+            for (int x = 0; x < size; x++){
+                glm::vec2 d = glm::vec2(x, y) + 0.5f - glm::vec2(size / 2.0f);
+                if (glm::length(d) > radius){
+                    continue;
+                }
+                char* p = &rgba[(x + y * size) * 4];
+                float shade = y < size / 2 ? 0.6f : 1.0f;       // darker lower half (to verify orientation)
+                for (int c = 0; c < 3; c++){
+                    p[c] = (char)(int)(color[c] * shade);
+                }
+                p[3] = (char)255;
+            }
+        }
+        return SpriteAtlas::PackImage("circle" + std::to_string(index), rgba.data(), size, size);
+    }
+
+    void updateSpriteBatch(){
+        auto builder = SpriteBatch::create();
+        int i = 0;
+        for (auto& name : atlas->getNames()){
+            auto sprite = atlas->get(name);
+            sprite.setPosition(glm::vec2(40 + (i % 12) * 64, 560 - (i / 12) * 64));
+            builder.addSprite(sprite);
+            i++;
+        }
+        spriteBatch = builder.build();
+    }
+
+    void render(){
+        auto renderPass = RenderPass::create()
+                .withCamera(camera)
+                .withClearColor(true, {.3f, .3f, 1, 1})
+                .build();
+        renderPass.draw(spriteBatch);
+
+        ImGui::LabelText("Sprites", "%i", (int)atlas->getNames().size());
+        ImGui::LabelText("Pages", "%i", atlas->getPageCount());
+        if (ImGui::Button("Add sprites")){
+            std::vector<SpriteAtlas::PackImage> images;
+            for (int i = 0; i < 10; i++){
+                images.push_back(createCircle(nextIndex++));
+            }
+            atlas->add(images);
+            updateSpriteBatch();
+        }
+    }
+private:
+    SDLRenderer r;
+    Camera camera;
+    std::shared_ptr<SpriteAtlas> atlas;
+    std::shared_ptr<SpriteBatch> spriteBatch;
+    int nextIndex = 40;
+};
+
+int main() {
+    std::make_unique<SpriteAtlasPackTest>();
+    return 0;
+}
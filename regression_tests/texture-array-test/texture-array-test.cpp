@@ -0,0 +1,94 @@
+#include <iostream>
+#include <vector>
+
+#include "sre/Texture.hpp"
+#include "sre/Renderer.hpp"
+#include "sre/Material.hpp"
+#include "sre/SDLRenderer.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace sre;
+
+// Draws quads using different layers of a texture array in a single draw call. The layer is stored in uv.z.
+// Layer 0-2 are uploaded from memory, layer 3 is copied from the sphere texture on the GPU.
+class TextureArrayTest {
+public:
+    TextureArrayTest() {
+        r.init();
+
+        camera.setOrthographicProjection(2.5f, -2, 2);
+
+        int size = 128;
+        glm::u8vec4 colors[] = {{255,0,0,255}, {0,255,0,255}, {0,0,255,255}};
+        auto&& builder = Texture::create();
+        builder.withLayers(4)
+                .withGenerateMipmaps(true)
+                .withName("Texture array");
+        for (int layer = 0; layer < 3; layer++){
+            std::vector<glm::u8vec4> data(size*size);
+            for (int y = 0; y < size; y++){
+                for (int x = 0; x < size; x++){
+                    bool checker = ((x / 16) + (y / 16)) % 2 == 0;
+                    data[x + y * size] = checker ? colors[layer] : glm::u8vec4(255, 255, 255, 255);
+                }
+            }
+            builder.withLayerRGBAData(layer, (const char*)data.data(), size, size);
+        }
+        builder.withLayerTexture(3, Texture::getSphereTexture());
+        texture = builder.build();
+
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec4> uvs;
+        std::vector<uint32_t> indices;
+        for (int i = 0; i < 8; i++){
+            glm::vec3 offset((i % 4) - 1.5f, (i / 4) - 0.5f, 0);
+            float layer = (float)(i % texture->getLayers());
+            glm::vec2 corners[] = {{-0.45f,-0.45f}, {0.45f,-0.45f}, {0.45f,0.45f}, {-0.45f,0.45f}};
+            glm::vec2 cornerUvs[] = {{0,0}, {1,0}, {1,1}, {0,1}};
+            auto idx = (uint32_t)positions.size();
+            for (int c = 0; c < 4; c++){
+                positions.push_back(offset + glm::vec3(corners[c], 0));
+                uvs.push_back({cornerUvs[c], layer, 0});
+            }
+            indices.insert(indices.end(), {idx, idx+1, idx+2, idx, idx+2, idx+3});
+        }
+        mesh = Mesh::create()
+                .withPositions(positions)
+                .withUVs(uvs)
+                .withIndices(indices)
+                .build();
+
+        material = Shader::getUnlit()->createMaterial({{"S_TEXTURE_ARRAY", "1"}});
+        material->setTexture(texture);
+
+        r.frameRender = [&](){
+            render();
+        };
+
+        r.startEventLoop();
+    }
+
+    void render(){
+        auto renderPass = RenderPass::create()
+                .withCamera(camera)
+                .withClearColor(true, {.3f, .3f, 1, 1})
+                .build();
+
+        renderPass.draw(mesh, glm::mat4(1), material);
+
+        ImGui::LabelText("Layers", "%i", texture->getLayers());
+        ImGui::LabelText("Draw calls", "%i", Renderer::instance->getRenderStats().drawCalls);
+    }
+private:
+    SDLRenderer r;
+    Camera camera;
+    std::shared_ptr<Mesh> mesh;
+    std::shared_ptr<Texture> texture;
+    std::shared_ptr<Material> material;
+};
+
+int main() {
+    std::make_unique<TextureArrayTest>();
+    return 0;
+}
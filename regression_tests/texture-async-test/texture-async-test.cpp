@@ -0,0 +1,95 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+
+#include "sre/Texture.hpp"
+#include "sre/Renderer.hpp"
+#include "sre/Material.hpp"
+#include "sre/SDLRenderer.hpp"
+#include "sre/Log.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace sre;
+
+// Loads the images of texture-test using Texture::loadAsync(). The textures are white until decoded.
+// Compares the time spent on the main thread with synchronous loading.
+class TextureAsyncTest {
+public:
+    TextureAsyncTest() {
+        r.init();
+
+        camera.setOrthographicProjection(4,-2,2);
+
+        mesh = Mesh::create().withQuad(0.4f).build();
+        loadTextures(true);
+
+        r.frameRender = [&](){
+            render();
+        };
+
+        r.startEventLoop();
+    }
+
+    void loadTextures(bool async){
+        const char* filenames[] = {
+            "basn0g01.png", "basn0g02.png", "basn0g04.png", "basn0g08.png", "basn0g16.png", "basn2c08.png",
+            "basn2c16.png", "basn3p01.png", "basn3p02.png", "basn3p04.png", "basn4a08.png", "basn6a08.png", "basn6a16.png"
+        };
+        materials.clear();
+        loaded = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (auto filename : filenames){
+            auto material = Shader::getUnlit()->createMaterial();
+            std::shared_ptr<Texture> texture;
+            auto&& builder = Texture::create();
+            builder.withFile(std::string("../texture-test/") + filename);
+            if (async){
+                texture = Texture::loadAsync(builder, [&](std::shared_ptr<Texture> texture){
+                    loaded++;
+                    LOG_INFO("Loaded %s (%ix%i)", texture->getName().c_str(), texture->getWidth(), texture->getHeight());
+                });
+            } else {
+                texture = builder.build();
+                loaded++;
+            }
+            material->setTexture(texture);
+            materials.push_back(material);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        mainThreadMs = std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    void render(){
+        auto renderPass = RenderPass::create()
+                .withCamera(camera)
+                .withClearColor(true, {.3f, .3f, 1, 1})
+                .build();
+
+        for (int i=0;i<materials.size();i++){
+            glm::vec3 pos((i % 5) * 1.0f - 2.0f, 1.0f - (i / 5) * 1.0f, 0);
+            renderPass.draw(mesh, glm::translate(glm::mat4(1), pos), materials[i]);
+        }
+
+        ImGui::LabelText("Loaded", "%i / %i", loaded, (int)materials.size());
+        ImGui::LabelText("Main thread", "%.2f ms", mainThreadMs);
+        if (ImGui::Button("Load async")){
+            loadTextures(true);
+        }
+        if (ImGui::Button("Load sync")){
+            loadTextures(false);
+        }
+    }
+private:
+    SDLRenderer r;
+    Camera camera;
+    std::shared_ptr<Mesh> mesh;
+    std::vector<std::shared_ptr<Material>> materials;
+    int loaded = 0;
+    double mainThreadMs = 0;
+};
+
+int main() {
+    std::make_unique<TextureAsyncTest>();
+    return 0;
+}
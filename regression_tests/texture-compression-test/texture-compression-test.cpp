@@ -0,0 +1,103 @@
+#include <iostream>
+#include <vector>
+#include <fstream>
+
+#include "sre/Texture.hpp"
+#include "sre/Renderer.hpp"
+#include "sre/Material.hpp"
+#include "sre/SDLRenderer.hpp"
+#include "sre/impl/TextureCompression.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace sre;
+
+// Compresses a test pattern (with mip levels) into each block compressed format, saves it as KTX2 and loads it using
+// Texture::create().withFile(). Formats not supported by the driver are decompressed on the CPU.
+class TextureCompressionTest {
+public:
+    TextureCompressionTest() {
+        r.init();
+
+        camera.setOrthographicProjection(2.5f, -2, 2);
+        mesh = Mesh::create().withQuad(0.45f).build();
+
+        CompressedFormat formats[] = {CompressedFormat::BC1, CompressedFormat::BC3, CompressedFormat::BC4, CompressedFormat::BC5,
+                                      CompressedFormat::BC7, CompressedFormat::ETC2_RGB, CompressedFormat::ETC2_RGBA};
+        for (auto format : formats){
+            auto filename = std::string("compressed-") + std::to_string((int)format) + ".ktx2";
+            writeKTX2(format, filename);
+            auto texture = Texture::create()
+                    .withFile(filename)
+                    .withName(TextureCompression::getName(format))
+                    .build();
+            auto material = Shader::getUnlit()->createMaterial();
+            material->setTexture(texture);
+            materials.push_back(material);
+            textures.push_back(texture);
+        }
+
+        r.frameRender = [&](){
+            render();
+        };
+
+        r.startEventLoop();
+    }
+
+    // colored checkerboard with a circular alpha gradient
+    void writeKTX2(CompressedFormat format, const std::string& filename){
+        CompressedImage image;
+        image.format = format;
+        image.srgb = TextureCompression::getGLFormat(format, true) != 0;
+        image.width = 128;
+        image.height = 128;
+        for (int size = 128; size >= 1; size /= 2){
+            std::vector<char> rgba(size * size * 4);
+            for (int y = 0; y < size; y++){
+                for (int x = 0; x < size; x++){
+                    glm::vec2 uv((x + 0.5f) / size, (y + 0.5f) / size);
+                    bool checker = ((int)(uv.x * 8) + (int)(uv.y * 8)) % 2 == 0;
+                    char* p = &rgba[(x + y * size) * 4];
+                    p[0] = (char)(checker ? 255 : (int)(uv.x * 255));
+                    p[1] = (char)(checker ? 255 : (int)(uv.y * 255));
+                    p[2] = (char)(checker ? 255 : 64);
+                    p[3] = (char)(255 * glm::clamp(2.0f - 2.0f * glm::length(uv - glm::vec2(0.5f)) * 2.0f, 0.0f, 1.0f));
+                }
+            }
+            image.levels.push_back(TextureCompression::compress(format, rgba.data(), size, size));
+        }
+        auto data = TextureCompression::saveKTX2(image);
+        std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size());
+    }
+
+    void render(){
+        auto renderPass = RenderPass::create()
+                .withCamera(camera)
+                .withClearColor(true, {.3f, .3f, 1, 1})
+                .build();
+
+        for (int i=0;i<(int)materials.size();i++){
+            glm::vec3 pos((i % 4) - 1.5f, 0.5f - (i / 4), 0);
+            renderPass.draw(mesh, glm::translate(glm::mat4(1), pos), materials[i]);
+        }
+
+        for (auto& texture : textures){
+            ImGui::LabelText(texture->getName().c_str(), "%i bytes", texture->getDataSize());
+        }
+        ImGui::LabelText("S3TC / RGTC / BPTC / ETC2", "%i %i %i %i", renderInfo().supportTextureCompressionS3TC,
+                         renderInfo().supportTextureCompressionRGTC, renderInfo().supportTextureCompressionBPTC,
+                         renderInfo().supportTextureCompressionETC2);
+    }
+private:
+    SDLRenderer r;
+    Camera camera;
+    std::shared_ptr<Mesh> mesh;
+    std::vector<std::shared_ptr<Material>> materials;
+    std::vector<std::shared_ptr<Texture>> textures;
+};
+
+int main() {
+    std::make_unique<TextureCompressionTest>();
+    return 0;
+}
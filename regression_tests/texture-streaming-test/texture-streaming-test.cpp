@@ -0,0 +1,114 @@
+#include <iostream>
+#include <vector>
+#include <fstream>
+
+#include "sre/Texture.hpp"
+#include "sre/Renderer.hpp"
+#include "sre/Material.hpp"
+#include "sre/SDLRenderer.hpp"
+#include "sre/impl/TextureCompression.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace sre;
+
+// Streams textures (BC1 KTX2 files written at startup) on a row of quads going into the distance. Each mip level has
+// a different color, so the resident levels are visible. Lowering the budget evicts the levels of the textures
+// furthest away (which are least recently requested when moving the camera).
+class TextureStreamingTest {
+public:
+    TextureStreamingTest() {
+        r.init();
+
+        Texture::setStreamingBudget(budgetKB * 1024);
+        mesh = Mesh::create().withQuad(0.5f).build();
+
+        for (int i = 0; i < textureCount; i++){
+            auto filename = std::string("streamed-") + std::to_string(i) + ".ktx2";
+            writeKTX2(i, filename);
+            auto texture = Texture::create()
+                    .withFile(filename)
+                    .withStreaming(3)
+                    .build();
+            auto material = Shader::getUnlit()->createMaterial();
+            material->setTexture(texture);
+            materials.push_back(material);
+            textures.push_back(texture);
+        }
+
+        r.frameRender = [&](){
+            render();
+        };
+
+        r.startEventLoop();
+    }
+
+    // checkerboard tinted with a color per mip level
+    void writeKTX2(int index, const std::string& filename){
+        const glm::vec3 levelColors[] = {{1,1,1}, {1,0,0}, {0,1,0}, {0,0,1}, {1,1,0}, {0,1,1}, {1,0,1}, {.5f,.5f,.5f}};
+        CompressedImage image;
+        image.format = CompressedFormat::BC1;
+        image.width = textureSize;
+        image.height = textureSize;
+        int level = 0;
+        for (int size = textureSize; size >= 1; size /= 2){
+            glm::vec3 color = levelColors[std::min(level, 7)];
+            std::vector<char> rgba(size * size * 4);
+            for (int y = 0; y < size; y++){
+                for (int x = 0; x < size; x++){
+                    bool checker = ((x * 8 / size) + (y * 8 / size) + index) % 2 == 0;
+                    char* p = &rgba[(x + y * size) * 4];
+                    for (int c = 0; c < 3; c++){
+                        p[c] = (char)(int)(color[c] * (checker ? 255 : 128));
+                    }
+                    p[3] = (char)255;
+                }
+            }
+            image.levels.push_back(TextureCompression::compress(image.format, rgba.data(), size, size));
+            level++;
+        }
+        auto data = TextureCompression::saveKTX2(image);
+        std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size());
+    }
+
+    void render(){
+        camera.setPerspectiveProjection(60, 0.1f, 200);
+        camera.lookAt({0, 0.5f, cameraZ}, {0, 0, cameraZ - 5}, {0, 1, 0});
+        auto renderPass = RenderPass::create()
+                .withCamera(camera)
+                .withClearColor(true, {.3f, .3f, 1, 1})
+                .build();
+
+        for (int i = 0; i < textureCount; i++){
+            glm::vec3 pos((i % 2) * 1.2f - 0.6f, 0, -2.0f * i);
+            renderPass.draw(mesh, glm::translate(glm::mat4(1), pos), materials[i]);
+        }
+
+        ImGui::SliderFloat("Camera z", &cameraZ, -30, 3);
+        if (ImGui::SliderInt("Budget KB", &budgetKB, 16, 4096)){
+            Texture::setStreamingBudget(budgetKB * 1024);
+        }
+        auto& stats = Renderer::instance->getRenderStats();
+        ImGui::LabelText("Resident", "%i KB", stats.textureStreamedBytes / 1024);
+        ImGui::LabelText("Streamed / evicted", "%i / %i levels", stats.textureLevelsStreamed, stats.textureLevelsEvicted);
+        for (auto& texture : textures){
+            ImGui::LabelText(texture->getName().c_str(), "level %i", texture->getBaseMipLevel());
+        }
+    }
+private:
+    static constexpr int textureCount = 16;
+    static constexpr int textureSize = 512;
+    SDLRenderer r;
+    Camera camera;
+    std::shared_ptr<Mesh> mesh;
+    std::vector<std::shared_ptr<Material>> materials;
+    std::vector<std::shared_ptr<Texture>> textures;
+    float cameraZ = 2;
+    int budgetKB = 4096;
+};
+
+int main() {
+    std::make_unique<TextureStreamingTest>();
+    return 0;
+}
@@ -0,0 +1,30 @@
+#version 330
+out vec4 fragColor;
+in vec2 vUV;
+
+uniform sampler2D tex;
+uniform vec4 upscale;           // xy: part of the texture rendered into (uv), zw: 1.0 / texture size
+uniform float sharpness;        // 0.0 bilinear, 1.0 max sharpening
+
+#pragma include "sre_utils_incl.glsl"
+
+vec4 sampleTex(vec2 uv){
+    // bilinear filtering must not read outside the part rendered into
+    return toLinear(texture(tex, clamp(uv, upscale.zw * 0.5, upscale.xy - upscale.zw * 0.5)));
+}
+
+void main(void)
+{
+    vec2 uv = vUV * upscale.xy;
+    vec2 texelSize = upscale.zw;
+    vec4 center = sampleTex(uv);
+    vec4 left = sampleTex(uv - vec2(texelSize.x, 0.0));
+    vec4 right = sampleTex(uv + vec2(texelSize.x, 0.0));
+    vec4 down = sampleTex(uv - vec2(0.0, texelSize.y));
+    vec4 up = sampleTex(uv + vec2(0.0, texelSize.y));
+    // unsharp mask limited to the range of the neighborhood (avoids ringing)
+    vec4 sharpened = center + (center * 4.0 - left - right - down - up) * (sharpness * 0.25);
+    vec4 minColor = min(center, min(min(left, right), min(down, up)));
+    vec4 maxColor = max(center, max(max(left, right), max(down, up)));
+    fragColor = toOutput(clamp(sharpened, minColor, maxColor));
+}
@@ -0,0 +1,12 @@
+#version 330
+out vec4 fragColor;
+in vec4 vColor;
+
+uniform vec4 color;
+
+#pragma include "sre_utils_incl.glsl"
+
+void main(void)
+{
+    fragColor = toOutput(color * vColor);
+}
\ No newline at end of file
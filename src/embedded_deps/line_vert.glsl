@@ -0,0 +1,44 @@
+#version 330
+in vec3 position;
+in vec4 line_other;         // xyz: other end point of segment, w: side of line (-1 or 1)
+in vec4 line_adjacent;      // xyz: adjacent point (next point after this end point), w: 1 if joined with adjacent segment
+in vec4 vertex_color;
+out vec4 vColor;
+
+uniform float lineWidth;
+
+#pragma include "global_uniforms_incl.glsl"
+
+vec2 toScreen(vec4 clip){
+    return clip.xy / clip.w * g_viewport.xy * 0.5;
+}
+
+vec2 perpendicular(vec2 v){
+    return vec2(-v.y, v.x);
+}
+
+void main(void) {
+    mat4 mvp = g_projection * g_view * g_model;
+    vec4 clip = mvp * vec4(position, 1.0);
+    vec2 screen = toScreen(clip);
+    vec2 dir = toScreen(mvp * vec4(line_other.xyz, 1.0)) - screen;
+    dir = length(dir) > 0.0 ? normalize(dir) : vec2(1.0, 0.0);
+    vec2 normal = perpendicular(dir);
+    float halfWidth = lineWidth * 0.5;
+    vec2 offset = normal * halfWidth;
+    if (line_adjacent.w > 0.0){
+        // miter join
+        vec2 adjacentDir = screen - toScreen(mvp * vec4(line_adjacent.xyz, 1.0));
+        if (length(adjacentDir) > 0.0){
+            vec2 tangent = normalize(adjacentDir) + dir;
+            if (length(tangent) > 0.0001){
+                vec2 miter = perpendicular(normalize(tangent));
+                float miterLength = halfWidth / max(dot(miter, normal), 0.25); // limit miter to 4 x half width
+                offset = miter * miterLength;
+            }
+        }
+    }
+    gl_Position = clip;
+    gl_Position.xy += offset * line_other.w / (g_viewport.xy * 0.5) * clip.w;
+    vColor = vertex_color;
+}
\ No newline at end of file
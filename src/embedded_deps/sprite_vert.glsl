@@ -3,6 +3,9 @@ in vec3 position;
 in vec4 uv;
 in vec4 vertex_color;
 out vec2 vUV;
+#ifdef S_TEXTURE_ARRAY
+out float vLayer;
+#endif
 out vec4 vColor;
 
 #pragma include "global_uniforms_incl.glsl"
@@ -10,5 +13,8 @@ out vec4 vColor;
 void main(void) {
     gl_Position = g_projection * g_view * g_model * vec4(position,1.0);
     vUV = uv.xy;
+#ifdef S_TEXTURE_ARRAY
+    vLayer = uv.z;
+#endif
     vColor = vertex_color;
 }
\ No newline at end of file
@@ -3,6 +3,9 @@ in vec3 position;
 in vec3 normal;
 in vec4 uv;
 out vec2 vUV;
+#ifdef S_TEXTURE_ARRAY
+out float vLayer;
+#endif
 #if defined(S_TANGENTS) && defined(S_NORMALMAP)
 in vec4 tangent;
 out mat3 vTBN;
@@ -31,6 +34,9 @@ void main(void) {
     vNormal = normalize(g_model_it * normal);
 #endif
     vUV = uv.xy;
+#ifdef S_TEXTURE_ARRAY
+    vLayer = uv.z;
+#endif
     vWsPos = wsPos.xyz;
 
 #ifdef S_VERTEX_COLOR
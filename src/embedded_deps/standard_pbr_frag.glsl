@@ -13,7 +13,15 @@ in vec3 vWsPos;
 uniform vec4 color;
 uniform vec4 metallicRoughness;
 
+#ifdef S_TEXTURE_ARRAY
+in float vLayer;
+#ifdef GL_ES
+precision highp sampler2DArray;
+#endif
+uniform sampler2DArray tex;
+#else
 uniform sampler2D tex;
+#endif
 #ifdef S_METALROUGHNESSMAP
 uniform sampler2D mrTex;
 #endif
@@ -120,7 +128,11 @@ void main(void)
     float alphaRoughness = perceptualRoughness * perceptualRoughness;
 
 #ifndef S_NO_BASECOLORMAP
+#ifdef S_TEXTURE_ARRAY
+    vec4 baseColor = toLinear(texture(tex, vec3(vUV, vLayer))) * color;
+#else
     vec4 baseColor = toLinear(texture(tex, vUV)) * color;
+#endif
 #else
     vec4 baseColor = color;
 #endif
@@ -13,6 +13,9 @@ in vec4 vertex_color;
 out vec4 vColor;
 #endif
 out vec2 vUV;
+#ifdef S_TEXTURE_ARRAY
+out float vLayer;
+#endif
 out vec3 vWsPos;
 #ifdef S_SHADOW
 uniform mat4 shadowViewProjOffset;
@@ -33,6 +36,9 @@ void main(void) {
     vNormal = normalize(g_model_it * normal);
 #endif
     vUV = uv.xy;
+#ifdef S_TEXTURE_ARRAY
+    vLayer = uv.z;
+#endif
 #ifdef S_VERTEX_COLOR
     vColor = vertex_color;
 #endif
@@ -17,7 +17,15 @@ in vec4 vColor;
 #endif
 
 uniform vec4 color;
+#ifdef S_TEXTURE_ARRAY
+in float vLayer;
+#ifdef GL_ES
+precision highp sampler2DArray;
+#endif
+uniform sampler2DArray tex;
+#else
 uniform sampler2D tex;
+#endif
 
 #pragma include "global_uniforms_incl.glsl"
 #pragma include "light_incl.glsl"
@@ -26,7 +34,11 @@ uniform sampler2D tex;
 
 void main()
 {
+#ifdef S_TEXTURE_ARRAY
+    vec4 c = color * toLinear(texture(tex, vec3(vUV, vLayer)));
+#else
     vec4 c = color * toLinear(texture(tex, vUV));
+#endif
 #ifdef S_VERTEX_COLOR
     c = c * vColor;
 #endif
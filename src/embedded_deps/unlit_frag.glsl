@@ -6,13 +6,25 @@ in vec4 vColor;
 #endif
 
 uniform vec4 color;
+#ifdef S_TEXTURE_ARRAY
+in float vLayer;
+#ifdef GL_ES
+precision highp sampler2DArray;
+#endif
+uniform sampler2DArray tex;
+#else
 uniform sampler2D tex;
+#endif
 
 #pragma include "sre_utils_incl.glsl"
 
 void main(void)
 {
+#ifdef S_TEXTURE_ARRAY
+    fragColor = color * toLinear(texture(tex, vec3(vUV, vLayer)));
+#else
     fragColor = color * toLinear(texture(tex, vUV));
+#endif
 #ifdef S_VERTEX_COLOR
     fragColor = fragColor * vColor;
 #endif
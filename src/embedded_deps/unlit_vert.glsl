@@ -7,12 +7,18 @@ out vec4 vColor;
 #endif
 in vec4 uv;
 out vec2 vUV;
+#ifdef S_TEXTURE_ARRAY
+out float vLayer;
+#endif
 
 #pragma include "global_uniforms_incl.glsl"
 
 void main(void) {
     gl_Position = g_projection * g_view * g_model * vec4(position,1.0);
     vUV = uv.xy;
+#ifdef S_TEXTURE_ARRAY
+    vLayer = uv.z;
+#endif
 #ifdef S_VERTEX_COLOR
     vColor = vertex_color;
 #endif
@@ -0,0 +1,209 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/DynamicResolution.hpp"
+
+#include "sre/Renderer.hpp"
+#include "sre/Framebuffer.hpp"
+#include "sre/Material.hpp"
+#include "sre/RenderPass.hpp"
+#include "sre/Shader.hpp"
+#include "sre/Texture.hpp"
+#include "sre/impl/GL.hpp"
+
+#include <algorithm>
+
+namespace sre {
+    namespace {
+        const int timerQueryCount = 4;                                       // results are read up to 3 frames later
+    }
+
+    DynamicResolution::DynamicResolution(float budget) {
+        setBudget(budget);
+        upscaleMaterial = Shader::getBlitUpscale()->createMaterial();
+        gpuTimed = renderInfo().supportTimerQuery;
+#ifndef GL_ES_VERSION_2_0
+        if (gpuTimed){
+            timerQueries.resize(timerQueryCount);
+            timerQueryPending.resize(timerQueryCount, false);
+            glGenQueries(timerQueryCount, timerQueries.data());
+        }
+#endif
+    }
+
+    DynamicResolution::~DynamicResolution() {
+        auto r = Renderer::instance;
+        if (r){
+#ifndef GL_ES_VERSION_2_0
+            if (!timerQueries.empty()){
+                glDeleteQueries((GLsizei)timerQueries.size(), timerQueries.data());
+            }
+#endif
+            r->renderStats.dynamicResolutionScale = 1;
+            r->renderStats.dynamicResolutionTime = 0;
+        }
+    }
+
+    std::shared_ptr<Framebuffer> DynamicResolution::begin() {
+        float time = 0;
+        if (gpuTimed){
+            time = readTimerQueries();
+        } else {
+            auto now = std::chrono::high_resolution_clock::now();
+            if (hasLastBegin){
+                time = std::chrono::duration<float, std::milli>(now - lastBegin).count();
+            }
+            lastBegin = now;
+            hasLastBegin = true;
+        }
+        if (time > 0){
+            frameTime = time;
+            if (enabled){
+                controller.update(time);
+            }
+        }
+        if (!enabled){
+            controller.reset(controller.getSettings().maxScale);
+        }
+
+        updateFramebuffer();
+        framebuffer->setRenderScale(controller.getScale());
+        auto& renderStats = Renderer::instance->renderStats;
+        renderStats.dynamicResolutionScale = controller.getScale();
+        renderStats.dynamicResolutionTime = frameTime;
+
+#ifndef GL_ES_VERSION_2_0
+        if (gpuTimed){
+            glBeginQuery(GL_TIME_ELAPSED, timerQueries[timerQueryIndex]);
+            timerQueryActive = true;
+        }
+#endif
+        return framebuffer;
+    }
+
+    void DynamicResolution::end(RenderPass& renderPass) {
+#ifndef GL_ES_VERSION_2_0
+        if (timerQueryActive){
+            glEndQuery(GL_TIME_ELAPSED);
+            timerQueryPending[timerQueryIndex] = true;
+            timerQueryIndex = (timerQueryIndex + 1) % timerQueryCount;
+            timerQueryActive = false;
+        }
+#endif
+        if (!framebuffer){
+            return;
+        }
+        auto textureSize = glm::vec2(colorTexture->getWidth(), colorTexture->getHeight());
+        auto uvScale = glm::vec2(framebuffer->getRenderSize()) / textureSize;
+        upscaleMaterial->setTexture(colorTexture);
+        upscaleMaterial->set("upscale", glm::vec4(uvScale, 1.0f / textureSize));
+        upscaleMaterial->set("sharpness", controller.getScale() < 1 ? sharpness : 0.0f);   // no sharpening when not scaled
+        renderPass.blit(upscaleMaterial);
+    }
+
+    // Reads the results of the pending queries in the order issued. If all queries are pending, the result of the
+    // oldest (which is reused next) is waited for.
+    float DynamicResolution::readTimerQueries() {
+        float time = 0;
+#ifndef GL_ES_VERSION_2_0
+        bool wait = timerQueryPending[timerQueryIndex];
+        for (int i = 0; i < timerQueryCount; i++){
+            int index = (timerQueryIndex + i) % timerQueryCount;
+            if (!timerQueryPending[index]){
+                continue;
+            }
+            if (!wait || index != timerQueryIndex){
+                GLint available = 0;
+                glGetQueryObjectiv(timerQueries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available){
+                    break;
+                }
+            }
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(timerQueries[index], GL_QUERY_RESULT, &elapsed);
+            timerQueryPending[index] = false;
+            time = elapsed / 1000000.0f;
+        }
+#endif
+        return time;
+    }
+
+    void DynamicResolution::updateFramebuffer() {
+        auto size = Renderer::instance->getDrawableSize();
+        if (colorTexture && colorTexture->getWidth() == size.x && colorTexture->getHeight() == size.y){
+            return;
+        }
+        colorTexture = Texture::create()
+                .withRGBAData(nullptr, size.x, size.y)
+                .withGenerateMipmaps(false)
+                .withFilterSampling(true)
+                .withWrapUV(Texture::Wrap::ClampToEdge)
+                .withName("DynamicResolution color")
+                .build();
+        framebuffer = Framebuffer::create()
+                .withColorTexture(colorTexture)
+                .withName("DynamicResolution")
+                .build();
+    }
+
+    void DynamicResolution::setBudget(float budget) {
+        auto settings = controller.getSettings();
+        settings.budget = std::max(budget, 0.1f);
+        controller.setSettings(settings);
+    }
+
+    float DynamicResolution::getBudget() {
+        return controller.getSettings().budget;
+    }
+
+    void DynamicResolution::setScaleLimits(float minScale, float maxScale) {
+        auto settings = controller.getSettings();
+        settings.maxScale = glm::clamp(maxScale, settings.step, 1.0f);
+        settings.minScale = glm::clamp(minScale, settings.step, settings.maxScale);
+        controller.setSettings(settings);
+    }
+
+    float DynamicResolution::getMinScale() {
+        return controller.getSettings().minScale;
+    }
+
+    float DynamicResolution::getMaxScale() {
+        return controller.getSettings().maxScale;
+    }
+
+    void DynamicResolution::setSharpness(float sharpness) {
+        this->sharpness = glm::clamp(sharpness, 0.0f, 1.0f);
+    }
+
+    float DynamicResolution::getSharpness() {
+        return sharpness;
+    }
+
+    void DynamicResolution::setEnabled(bool enabled) {
+        this->enabled = enabled;
+    }
+
+    bool DynamicResolution::isEnabled() {
+        return enabled;
+    }
+
+    float DynamicResolution::getScale() {
+        return controller.getScale();
+    }
+
+    float DynamicResolution::getFrameTime() {
+        return frameTime;
+    }
+
+    bool DynamicResolution::isGPUTimed() {
+        return gpuTimed;
+    }
+
+    std::shared_ptr<Texture> DynamicResolution::getColorTexture() {
+        return colorTexture;
+    }
+}
@@ -13,7 +13,81 @@
 #include <algorithm>
 #include <sre/Renderer.hpp>
 
+namespace {
+    // Sized format of a renderbuffer matching the color texture (framebuffer color textures are RGBA)
+    GLenum getColorFormat(sre::Texture* texture){
+        return texture->getSamplerColorSpace() == sre::Texture::SamplerColorspace::Linear ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+    }
+
+    GLenum getDepthFormat(sre::Texture* depthTexture){
+        switch (depthTexture->getDepthPrecision()){
+            case sre::Texture::DepthPrecision::I24:
+                return GL_DEPTH_COMPONENT24;
+#ifndef GL_ES_VERSION_2_0
+            case sre::Texture::DepthPrecision::I32:
+                return GL_DEPTH_COMPONENT32;
+            case sre::Texture::DepthPrecision::STENCIL8:
+                return GL_STENCIL_INDEX8;
+#endif
+            case sre::Texture::DepthPrecision::I24_STENCIL8:
+                return GL_DEPTH24_STENCIL8;
+            case sre::Texture::DepthPrecision::F32_STENCIL8:
+                return GL_DEPTH32F_STENCIL8;
+            case sre::Texture::DepthPrecision::F32:
+                return GL_DEPTH_COMPONENT32F;
+            default:
+                return GL_DEPTH_COMPONENT16;
+        }
+    }
+
+    GLenum getDepthAttachment(sre::Texture* depthTexture){
+        switch (depthTexture->getDepthPrecision()){
+            case sre::Texture::DepthPrecision::I24_STENCIL8:
+            case sre::Texture::DepthPrecision::F32_STENCIL8:
+                return GL_DEPTH_STENCIL_ATTACHMENT;
+#ifndef GL_ES_VERSION_2_0
+            case sre::Texture::DepthPrecision::STENCIL8:
+                return GL_STENCIL_ATTACHMENT;
+#endif
+            default:
+                return GL_DEPTH_ATTACHMENT;
+        }
+    }
+
+    GLbitfield getDepthBufferBits(sre::Texture* depthTexture){
+        switch (getDepthAttachment(depthTexture)){
+            case GL_DEPTH_STENCIL_ATTACHMENT:
+                return GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT;
+            case GL_STENCIL_ATTACHMENT:
+                return GL_STENCIL_BUFFER_BIT;
+            default:
+                return GL_DEPTH_BUFFER_BIT;
+        }
+    }
+
+    // Create a renderbuffer and attach it to the bound framebuffer
+    GLuint createRenderbuffer(GLenum attachment, GLenum internalFormat, int samples, glm::uvec2 size){
+        GLuint renderbuffer;
+        glGenRenderbuffers(1, &renderbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+        if (samples > 1){
+            glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, internalFormat, size.x, size.y);
+        } else {
+            glRenderbufferStorage(GL_RENDERBUFFER, internalFormat, size.x, size.y);
+        }
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, renderbuffer);
+        return renderbuffer;
+    }
+
+    GLenum getDefaultDepthFormat(){
+        return sre::renderInfo().graphicsAPIVersionES && sre::renderInfo().graphicsAPIVersionMajor <= 2 ? GL_DEPTH_COMPONENT16 : GL_DEPTH_COMPONENT24;
+    }
+}
+
 namespace sre{
+    void checkStatus();
+
     Framebuffer::FrameBufferBuilder& Framebuffer::FrameBufferBuilder::withColorTexture(std::shared_ptr<Texture> texture) {
         assert(!texture->isDepthTexture());
         auto s = glm::uvec2{texture->getWidth(), texture->getHeight()};
@@ -26,20 +100,6 @@ namespace sre{
         return *this;
     }
 
-    Framebuffer::FrameBufferBuilder& Framebuffer::FrameBufferBuilder::withColorTexture(unsigned int textureID, int width, int height) {
-//        assert(!texture->isDepthTexture());
-//        auto s = glm::uvec2{texture->getWidth(), texture->getHeight()};
-//        if (!textures.empty() || depthTexture.get()){
-//            assert(this->size == s);
-//        } else {
-//            this->size = s;
-//        }
-//        textures.push_back(texture);
-        this->size = glm::uvec2{width, height};
-        screenTextureId = textureID;
-        return *this;
-    }
-
     Framebuffer::FrameBufferBuilder& Framebuffer::FrameBufferBuilder::withDepthTexture(std::shared_ptr<Texture> texture) {
         assert(texture->isDepthTexture());
         auto s = glm::uvec2{texture->getWidth(), texture->getHeight()};
@@ -52,6 +112,11 @@ namespace sre{
         return *this;
     }
 
+    Framebuffer::FrameBufferBuilder& Framebuffer::FrameBufferBuilder::withSamples(int samples) {
+        this->samples = std::max(1, samples);
+        return *this;
+    }
+
     Framebuffer::FrameBufferBuilder &Framebuffer::FrameBufferBuilder::withName(std::string name) {
         this->name = std::move(name);
         return *this;
@@ -68,9 +133,13 @@ namespace sre{
         auto r = Renderer::instance;
         if (r){
             r->framebufferObjects.erase(std::remove(r->framebufferObjects.begin(), r->framebufferObjects.end(), this));
-            if (renderbuffer != 0){
-                glDeleteRenderbuffers(1, &renderbuffer);
+            if (colorRenderbuffer != 0){
+                glDeleteRenderbuffers(1, &colorRenderbuffer);
+            }
+            if (depthRenderbuffer != 0){
+                glDeleteRenderbuffers(1, &depthRenderbuffer);
             }
+            deleteMultisampleFramebuffer();
             glDeleteFramebuffers(1,&frameBufferObjectId);
         }
     }
@@ -108,6 +177,25 @@ namespace sre{
         return name;
     }
 
+    int Framebuffer::getSamples() {
+        return samples;
+    }
+
+    void Framebuffer::setRenderScale(float scale) {
+        renderScale = glm::clamp(scale, 0.0f, 1.0f);
+    }
+
+    float Framebuffer::getRenderScale() {
+        return renderScale;
+    }
+
+    glm::uvec2 Framebuffer::getRenderSize() {
+        if (renderScale >= 1){
+            return size;
+        }
+        return glm::max(glm::uvec2(glm::round(glm::vec2(size) * renderScale)), glm::uvec2(1));
+    }
+
     void Framebuffer::setColorTexture(std::shared_ptr<Texture> tex, int index) {
         assert(textures.size() > index && index >= 0);
         assert(!tex->isDepthTexture());
@@ -123,20 +211,118 @@ namespace sre{
 
 
     void Framebuffer::bind() {
+        bindResolved();
+        if (samples > 1){
+            glBindFramebuffer(GL_FRAMEBUFFER, multisampleFrameBufferObjectId);
+        }
+    }
+
+    void Framebuffer::bindResolved() {
         glBindFramebuffer(GL_FRAMEBUFFER, frameBufferObjectId);
         if (dirty){
-			
-			if (screenTextureId)
-		        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                                GL_TEXTURE_2D_MULTISAMPLE, screenTextureId, 0);
-
             for (int i=0;i<textures.size();i++){
                 glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0+i, GL_TEXTURE_2D, textures[i]->textureId, 0);
             }
             if (depthTexture){
-                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture->textureId, 0);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, getDepthAttachment(depthTexture.get()), GL_TEXTURE_2D, depthTexture->textureId, 0);
             }
             dirty = false;
+            if (samples > 1){
+                // the multisample renderbuffers must match the formats of the textures
+                deleteMultisampleFramebuffer();
+                createMultisampleFramebuffer();
+                glBindFramebuffer(GL_FRAMEBUFFER, frameBufferObjectId);
+            }
+        }
+    }
+
+    // Blit each multisample color renderbuffer (and depth if a depth texture is attached) into the attached textures.
+    // Afterwards the multisample attachments are invalidated, so tile based GPUs do not write them back to memory.
+    void Framebuffer::resolve() {
+        if (samples <= 1){
+            return;
+        }
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, multisampleFrameBufferObjectId);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, frameBufferObjectId);
+        // blits are affected by the scissor test and write masks (restored after the blit)
+        GLboolean scissorTest = glIsEnabled(GL_SCISSOR_TEST);
+        GLboolean colorMask[4];
+        GLboolean depthMask;
+        glGetBooleanv(GL_COLOR_WRITEMASK, colorMask);
+        glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+        glDisable(GL_SCISSOR_TEST);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthMask(GL_TRUE);
+        auto renderSize = getRenderSize();                          // only the part rendered into is resolved
+        GLint width = renderSize.x;
+        GLint height = renderSize.y;
+        std::vector<GLenum> drawBuffers(textures.size(), GL_NONE);
+        for (int i=0;i<textures.size();i++){
+            glReadBuffer(GL_COLOR_ATTACHMENT0+i);
+            if (textures.size() > 1){
+                drawBuffers[i] = GL_COLOR_ATTACHMENT0+i;
+                glDrawBuffers(i+1, drawBuffers.data());
+                drawBuffers[i] = GL_NONE;
+            }
+            glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        }
+        if (depthTexture){
+            glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, getDepthBufferBits(depthTexture.get()), GL_NEAREST);
+        }
+        if (textures.size() > 1){
+            for (int i=0;i<textures.size();i++){
+                drawBuffers[i] = GL_COLOR_ATTACHMENT0+i;
+            }
+            glDrawBuffers((GLsizei)drawBuffers.size(), drawBuffers.data());
+        }
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        if (scissorTest){
+            glEnable(GL_SCISSOR_TEST);
+        }
+        glColorMask(colorMask[0], colorMask[1], colorMask[2], colorMask[3]);
+        glDepthMask(depthMask);
+#if defined(GL_VERSION_4_3) || defined(EMSCRIPTEN)
+        if (renderInfo().supportInvalidateFramebuffer){
+            std::vector<GLenum> attachments;
+            for (int i=0;i<std::max<int>(1, (int)textures.size());i++){
+                attachments.push_back(GL_COLOR_ATTACHMENT0+i);
+            }
+            attachments.push_back(depthTexture ? getDepthAttachment(depthTexture.get()) : GL_DEPTH_ATTACHMENT);
+            glInvalidateFramebuffer(GL_READ_FRAMEBUFFER, (GLsizei)attachments.size(), attachments.data());
+        }
+#endif
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void Framebuffer::createMultisampleFramebuffer() {
+        glGenFramebuffers(1, &multisampleFrameBufferObjectId);
+        glBindFramebuffer(GL_FRAMEBUFFER, multisampleFrameBufferObjectId);
+        std::vector<GLenum> drawBuffers;
+        for (int i=0;i<textures.size();i++){
+            multisampleRenderbuffers.push_back(createRenderbuffer(GL_COLOR_ATTACHMENT0+i, getColorFormat(textures[i].get()), samples, size));
+            drawBuffers.push_back(GL_COLOR_ATTACHMENT0+i);
+        }
+        if (textures.empty()){
+            multisampleRenderbuffers.push_back(createRenderbuffer(GL_COLOR_ATTACHMENT0, GL_RGBA8, samples, size));
+        }
+        if (depthTexture){
+            multisampleRenderbuffers.push_back(createRenderbuffer(getDepthAttachment(depthTexture.get()), getDepthFormat(depthTexture.get()), samples, size));
+        } else {
+            multisampleRenderbuffers.push_back(createRenderbuffer(GL_DEPTH_ATTACHMENT, getDefaultDepthFormat(), samples, size));
+        }
+        glDrawBuffers((GLsizei)drawBuffers.size(), drawBuffers.data());
+        glReadBuffer(drawBuffers.empty() ? GL_NONE : GL_COLOR_ATTACHMENT0);
+        checkStatus();
+    }
+
+    void Framebuffer::deleteMultisampleFramebuffer() {
+        if (!multisampleRenderbuffers.empty()){
+            glDeleteRenderbuffers((GLsizei)multisampleRenderbuffers.size(), multisampleRenderbuffers.data());
+            multisampleRenderbuffers.clear();
+        }
+        if (multisampleFrameBufferObjectId != 0){
+            glDeleteFramebuffers(1, &multisampleFrameBufferObjectId);
+            multisampleFrameBufferObjectId = 0;
         }
     }
 
@@ -191,72 +377,42 @@ namespace sre{
         if (name.length()==0){
             name = "Framebuffer";
         }
+        if (samples > renderInfo().maxSamples){
+            if (renderInfo().maxSamples <= 1){
+                LOG_WARNING("Framebuffer %s: Multisampling not supported", name.c_str());
+            }
+            samples = renderInfo().maxSamples;
+        }
+        if (samples > 1 && textures.empty() && !depthTexture){
+            LOG_ERROR("Framebuffer %s: Multisampling requires a color or depth texture to resolve into", name.c_str());
+            samples = 1;
+        }
         auto framebuffer = new Framebuffer(name);
         framebuffer->size = size;
-        // Hardwire the number of samples to 4, should check GL_MAX_SAMPLES
-        // This needs to be consistent with the use of multisample textures
-        // For this reason, it should not be hardwired but should be an option
-        GLsizei msaa = 4;
-        glEnable(GL_MULTISAMPLE);
+        framebuffer->samples = samples;
+        bool multisample = samples > 1;
+#ifndef GL_ES_VERSION_2_0
+        if (multisample){
+            glEnable(GL_MULTISAMPLE);
+        }
+#endif
         glGenFramebuffers(1, &(framebuffer->frameBufferObjectId));
         glBindFramebuffer(GL_FRAMEBUFFER, framebuffer->frameBufferObjectId);
 
         std::vector<GLenum> drawBuffers;
-        if (screenTextureId)
-		{
-	        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                                GL_TEXTURE_2D_MULTISAMPLE, screenTextureId, 0);
-			drawBuffers.push_back(GL_COLOR_ATTACHMENT0);
-		}
         for (unsigned i=0;i<textures.size();i++){
             glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0+i, GL_TEXTURE_2D, textures[i]->textureId, 0);
             drawBuffers.push_back(GL_COLOR_ATTACHMENT0+i);
         }
 
-        if (textures.empty() && !screenTextureId){
-            glGenRenderbuffers(1,&framebuffer->renderbuffer); // Create a renderbuffer object
-            glBindRenderbuffer(GL_RENDERBUFFER, framebuffer->renderbuffer);
-            glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size.x, size.y);
-
-            glBindRenderbuffer(GL_RENDERBUFFER, 0);
-            // attach the renderbuffer to depth attachment point
-            glFramebufferRenderbuffer(GL_FRAMEBUFFER,
-                                      GL_COLOR_ATTACHMENT0,
-                                      GL_RENDERBUFFER,
-                                      framebuffer->renderbuffer);
+        // when multisampled only the attached textures are needed (as resolve targets)
+        if (textures.empty() && !multisample){
+            framebuffer->colorRenderbuffer = createRenderbuffer(GL_COLOR_ATTACHMENT0, GL_RGBA8, 1, size);
         }
-        
         if (depthTexture){
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture->textureId, 0);
-        } else {
-            glGenRenderbuffers(1,&framebuffer->renderbuffer); // Create a renderbuffer object
-            glBindRenderbuffer(GL_RENDERBUFFER, framebuffer->renderbuffer);
-
-            if (renderInfo().graphicsAPIVersionES){
-				if (screenTextureId)
-	                glRenderbufferStorageMultisample(GL_RENDERBUFFER, msaa,
-						renderInfo().graphicsAPIVersionMajor<=2
-						?GL_DEPTH_COMPONENT16:GL_DEPTH_COMPONENT24,
-						size.x, size.y);
-				else
-	                glRenderbufferStorage(GL_RENDERBUFFER,
-						renderInfo().graphicsAPIVersionMajor<=2
-						?GL_DEPTH_COMPONENT16:GL_DEPTH_COMPONENT24,
-						size.x, size.y);
-            } else {
-				if (screenTextureId)
-                	glRenderbufferStorageMultisample(GL_RENDERBUFFER, msaa,
-										GL_DEPTH_COMPONENT, size.x, size.y);
-				else
-                	glRenderbufferStorage(GL_RENDERBUFFER,
-										GL_DEPTH_COMPONENT, size.x, size.y);
-            }
-            glBindRenderbuffer(GL_RENDERBUFFER, 0);
-            // attach the renderbuffer to depth attachment point
-            glFramebufferRenderbuffer(GL_FRAMEBUFFER,
-                                      GL_DEPTH_ATTACHMENT,
-                                      GL_RENDERBUFFER,
-                                      framebuffer->renderbuffer);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, getDepthAttachment(depthTexture.get()), GL_TEXTURE_2D, depthTexture->textureId, 0);
+        } else if (!multisample){
+            framebuffer->depthRenderbuffer = createRenderbuffer(GL_DEPTH_ATTACHMENT, getDefaultDepthFormat(), 1, size);
         }
         if (!renderInfo().graphicsAPIVersionES || renderInfo().graphicsAPIVersionMajor>=3){
             glDrawBuffers((GLsizei)drawBuffers.size(), drawBuffers.data());
@@ -270,6 +426,10 @@ namespace sre{
         checkStatus();
         framebuffer->textures = textures;
         framebuffer->depthTexture = depthTexture;
+        framebuffer->dirty = false;
+        if (multisample){
+            framebuffer->createMultisampleFramebuffer();
+        }
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
         return std::shared_ptr<Framebuffer>(framebuffer);
@@ -24,6 +24,7 @@
 #include "sre/SpriteAtlas.hpp"
 #include "sre/Framebuffer.hpp"
 #include "sre/RenderPass.hpp"
+#include "sre/RenderGraph.hpp"
 #include "sre/Sprite.hpp"
 #include "imgui_internal.h"
 #include <SDL_image.h>
@@ -161,7 +162,11 @@ namespace sre {
             ImGui::LabelText("Colorspace", "%s", colorSpace);
             const char* wrap = tex->getWrapUV()==Texture::Wrap::Repeat?"Repeat":(tex->getWrapUV()==Texture::Wrap::Mirror?"Mirror":"Clamp to edge");
             ImGui::LabelText("Wrap tex-coords","%s",wrap);
+            ImGui::LabelText("Anisotropy","%.0fx",tex->getAnisotropy());
             ImGui::LabelText("Data size","%f MB",tex->getDataSize()/(1000*1000.0f));
+            if (tex->isStreaming()){
+                ImGui::LabelText("Resident mip level","%i",tex->getBaseMipLevel());
+            }
             if (!tex->isCubemap()){
                 ImGui_RenderTexture(tex,glm::vec2(previewSize, previewSize),{0,1},{1,0});
             }
@@ -263,13 +268,13 @@ namespace sre {
 
             }
             if (mesh->hasAttribute("position")){
-                initFramebuffer();
+                initWorldLights();
 
                 Camera camera;
                 camera.setPerspectiveProjection(60,0.1,10);
                 camera.lookAt({0,0,4},{0,0,0},{0,1,0});
                 auto offscreenTexture = getTmpTexture();
-                framebuffer->setColorTexture(offscreenTexture);
+                auto framebuffer = Renderer::instance->renderTargetPool.getFramebuffer({offscreenTexture});
 
                 auto renderToTexturePass = RenderPass::create()
                      .withCamera(camera)
@@ -419,7 +424,7 @@ namespace sre {
             }
             ImGui::LabelText("Offset","factor: %.1f units: %.1f",shader->getOffset().x,shader->getOffset().y);
 
-            initFramebuffer();
+            initWorldLights();
 
             auto mat = shader->createMaterial();
 
@@ -429,7 +434,7 @@ namespace sre {
             camera.setPerspectiveProjection(60,0.1,10);
             camera.lookAt({0,0,4},{0,0,0},{0,1,0});
             auto offscreenTexture = getTmpTexture();
-            framebuffer->setColorTexture(offscreenTexture);
+            auto framebuffer = Renderer::instance->renderTargetPool.getFramebuffer({offscreenTexture});
             auto renderToTexturePass = RenderPass::create()
                     .withCamera(camera)
                     .withWorldLights(&worldLights)
@@ -463,6 +468,8 @@ namespace sre {
                 return "texture";
             case UniformType::TextureCube:
                 return "texture cube";
+            case UniformType::TextureArray:
+                return "texture array";
             case UniformType::Vec3:
                 return "vec3";
             case UniformType::Vec4:
@@ -495,8 +502,9 @@ namespace sre {
                 ImGui::TreePop();
             }
             if (!fbo->depthTexture.get()){
-                ImGui::LabelText("RenderBuffer Depth","%s",fbo->renderbuffer?"true":"false");
+                ImGui::LabelText("RenderBuffer Depth","%s",fbo->depthRenderbuffer || fbo->samples > 1?"true":"false");
             }
+            ImGui::LabelText("Samples","%i",fbo->samples);
             ImGui::TreePop();
         }
     }
@@ -595,6 +603,16 @@ namespace sre {
             ImGui::PlotLines(res,data.data(),frames, 0, "State changes", -1,max*1.2f,ImVec2(ImGui::CalcItemWidth(),150));
 
             plotTimings(millisecondsFrameTime.data(), "Frame-time ms");
+
+            if (r->renderStatsLast.dynamicResolutionTime > 0){
+                for (int i=0;i<frames;i++){
+                    int idx = (frameCount + i)%frames;
+                    data[(-frameCount%frames+idx+frames)%frames] = stats[idx].dynamicResolutionScale;
+                }
+                sprintf(res,"Cur: %4.2f\n"
+                            "Time: %4.2f ms",r->renderStatsLast.dynamicResolutionScale, r->renderStatsLast.dynamicResolutionTime);
+                ImGui::PlotLines(res,data.data(),frames, 0, "Dynamic resolution scale", 0,1,ImVec2(ImGui::CalcItemWidth(),150));
+            }
         }
         if (ImGui::CollapsingHeader("Frame inspector")){
             if (ImGui::Button("Capture frame")){
@@ -698,8 +716,27 @@ namespace sre {
                         "Count: %i",avg,max, data[frames-1],(int)r->textures.size());
 
             ImGui::PlotLines(res,data.data(),frames, 0, "Texture MB", -1,max*1.2f,ImVec2(ImGui::CalcItemWidth(),150));
+
+            if (r->textureStreaming.isActive()){
+                ImGui::LabelText("Streamed textures", "%4.1f / %4.1f MB", r->renderStatsLast.textureStreamedBytes/1000000.0f, r->textureStreaming.getBudget()/1000000.0f);
+                ImGui::LabelText("Levels streamed", "%i", r->renderStatsLast.textureLevelsStreamed);
+                ImGui::LabelText("Levels evicted", "%i", r->renderStatsLast.textureLevelsEvicted);
+            }
+            if (r->renderTargetPool.getTargetCount() > 0){
+                ImGui::LabelText("Render target pool", "%4.1f MB (%i targets)", r->renderStatsLast.renderTargetPoolBytes/1000000.0f, r->renderTargetPool.getTargetCount());
+                ImGui::LabelText("Pool hits / misses", "%i / %i", r->renderStatsLast.renderTargetPoolHits, r->renderStatsLast.renderTargetPoolMisses);
+            }
         }
         if (ImGui::CollapsingHeader("Shaders")){
+            ImGui::LabelText("Build time", "%.1f ms", r->renderStats.shaderBuildTime);
+            if (!Shader::getProgramBinaryCacheDirectory().empty()){
+                ImGui::LabelText("Binary cache", "%i hits, %i misses", r->renderStats.shaderBinaryCacheHits, r->renderStats.shaderBinaryCacheMisses);
+            }
+            ImGui::LabelText("Uniform uploads elided", "%i", r->renderStatsLast.uniformUploadsElided);
+            ImGui::LabelText("Texture binds avoided", "%i", r->renderStatsLast.textureBindsAvoided);
+            if (r->renderStatsLast.drawCallsSkipped > 0){
+                ImGui::LabelText("Skipped draw calls", "%i (shaders compiling)", r->renderStatsLast.drawCallsSkipped);
+            }
             for (auto s : r->shaders){
                 showShader(s);
             }
@@ -737,6 +774,13 @@ namespace sre {
                 }
             }
         }
+        if (!r->renderGraphs.empty()) {
+            if (ImGui::CollapsingHeader("Render graphs")) {
+                for (auto graph : r->renderGraphs) {
+                    showRenderGraph(graph);
+                }
+            }
+        }
         if (useWindow) {
             ImGui::End();
         }
@@ -976,7 +1020,6 @@ namespace sre {
     }
 
     void Inspector::update() {
-        usedTextures = 0;
         auto tick = Clock::now();
         float deltaTime = std::chrono::duration_cast<Milliseconds>(tick - lastTick).count();
         time += deltaTime;
@@ -993,6 +1036,69 @@ namespace sre {
         frameCount++;
     }
 
+    // Passes in execution order followed by the culled passes, and the lifetime of each texture
+    void Inspector::showRenderGraph(RenderGraph *graph) {
+        std::string s = graph->getName()+"##"+std::to_string((int64_t)graph);
+        if (ImGui::TreeNode(s.c_str())){
+            if (graph->dirty){
+                graph->compile();
+            }
+            auto& compiled = graph->compiled;
+            if (!compiled.valid){
+                ImGui::LabelText("Error", "%s", compiled.error.c_str());
+            }
+            auto textureNames = [&](const std::vector<int>& textures){
+                std::string res;
+                for (int t : textures){
+                    res += (res.empty() ? "" : ", ") + graph->textures[t].name;
+                }
+                return res;
+            };
+            if (ImGui::TreeNode("Passes")){
+                std::vector<int> passes = compiled.order;
+                for (int p = 0; p < (int)graph->passes.size(); p++){
+                    if (compiled.culled[p]){
+                        passes.push_back(p);
+                    }
+                }
+                for (int p : passes){
+                    auto& pass = graph->passes[p];
+                    std::string label = pass.name + (compiled.culled[p] ? " (culled)" : "") + "##" + std::to_string(p);
+                    if (ImGui::TreeNode(label.c_str())){
+                        auto writes = pass.colorWrites;
+                        if (pass.depthWrite != -1){
+                            writes.push_back(pass.depthWrite);
+                        }
+                        ImGui::LabelText("Reads", "%s", textureNames(pass.reads).c_str());
+                        ImGui::LabelText("Writes", "%s", pass.writesScreen ? "Screen" : textureNames(writes).c_str());
+                        ImGui::LabelText("Generate mipmaps", "%s", textureNames(compiled.generateMipmaps[p]).c_str());
+                        ImGui::TreePop();
+                    }
+                }
+                ImGui::TreePop();
+            }
+            if (ImGui::TreeNode("Textures")){
+                for (int t = 0; t < (int)graph->textures.size(); t++){
+                    auto& texture = graph->textures[t];
+                    if (compiled.firstUse[t] == -1){
+                        ImGui::LabelText(texture.name.c_str(), "%s unused", texture.imported ? "Imported" : "Transient");
+                    } else if (texture.output){
+                        ImGui::LabelText(texture.name.c_str(), "%s %ix%i passes %i- (output)", texture.imported ? "Imported" : "Transient",
+                                         texture.size.x, texture.size.y, compiled.firstUse[t]);
+                    } else {
+                        ImGui::LabelText(texture.name.c_str(), "%s %ix%i passes %i-%i", texture.imported ? "Imported" : "Transient",
+                                         texture.size.x, texture.size.y, compiled.firstUse[t], compiled.lastUse[t]);
+                    }
+                }
+                ImGui::TreePop();
+            }
+            if (ImGui::Button("Copy Graphviz")){
+                ImGui::SetClipboardText(graph->toGraphviz().c_str());
+            }
+            ImGui::TreePop();
+        }
+    }
+
     void Inspector::showSpriteAtlas(SpriteAtlas *pAtlas) {
         std::string s = pAtlas->getAtlasName()+"##"+std::to_string((int64_t)pAtlas);
         if (ImGui::TreeNode(s.c_str())){
@@ -1009,6 +1115,9 @@ namespace sre {
                 elem = spriteAtlasSelection.find(pAtlas);
             }
             int* index = &elem->second;
+            if (pAtlas->getPageCount() > 1){
+                ImGui::LabelText("Pages", "%i", pAtlas->getPageCount());
+            }
             ImGui::Combo("Sprite names", index, ss_str.c_str());
 
             if (*index != -1){
@@ -1027,28 +1136,17 @@ namespace sre {
         }
     }
 
-    void Inspector::initFramebuffer() {
-        if (framebuffer == nullptr){
-            framebuffer = Framebuffer::create().withColorTexture(getTmpTexture())
-                    .withName("SRE Inspector Framebufferobject")
-                    .build();
-            usedTextures = 0; // reset usedTextures count to avoid an extra texture to be created
+    void Inspector::initWorldLights() {
+        if (worldLights.lightCount() == 0){
             worldLights.setAmbientLight({0.2,0.2,0.2});
             auto light = Light::create().withPointLight({0,0,4}).build();
             worldLights.addLight(light);
         }
     }
 
+    // preview texture reserved until the end of the frame
     std::shared_ptr<Texture> Inspector::getTmpTexture() {
-        if (usedTextures < offscreenTextures.size()){
-            int index = usedTextures;
-            usedTextures++;
-            return offscreenTextures[index];
-        }
-        auto offscreenTex = Texture::create().withRGBData(nullptr, 256,256).withName(std::string("SRE Inspector Tex #")+std::to_string(offscreenTextures.size())).build();
-        offscreenTextures.push_back(offscreenTex);
-        usedTextures++;
-        return offscreenTex;
+        return Renderer::instance->renderTargetPool.getTexture({256,256});
     }
 
     void Inspector::showMaterial(Material *material) {
@@ -1073,7 +1171,8 @@ namespace sre {
                     }
                         break;
                     case UniformType::Texture:
-                    case UniformType::TextureCube:{
+                    case UniformType::TextureCube:
+                    case UniformType::TextureArray:{
                         std::shared_ptr<Texture> valueTex = material->get<std::shared_ptr<Texture>>(name);
                         ImGui::LabelText("%s %s",name.c_str(),valueTex->getName().c_str());
                     }
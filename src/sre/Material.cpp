@@ -11,6 +11,9 @@
 #include <glm/gtc/color_space.hpp>
 #include "sre/Renderer.hpp"
 #include "sre/Log.hpp"
+#include "sre/impl/UniformBufferPool.hpp"
+#include <cstring>
+#include <algorithm>
 
 
 namespace sre {
@@ -23,13 +26,82 @@ namespace sre {
     }
 
     Material::~Material(){
+        if (materialBuffer){
+            materialBuffer->release(materialBufferSlot);
+        }
     }
 
     void Material::bind(){
         if (shader->uniforms != uniforms){
             setShader(shader);
         }
-        uniformMap.bind();
+        uniformMap.bind(shader->uniformShadow, Renderer::instance->renderStats);
+        if (materialBuffer){
+            // matrix arrays are shared pointers, which may be modified without calling set
+            if (materialBufferDirty || shader->materialBlockHasArrays){
+                updateMaterialBuffer();
+                materialBuffer->update(materialBufferSlot, materialBufferData.data());
+                materialBufferDirty = false;
+            }
+            materialBuffer->bind(materialBufferSlot, Renderer::materialUniformBindingIndex);
+        }
+    }
+
+    template<typename T>
+    bool Material::setValue(const Uniform& uniform, T value){
+        uniformMap.set(uniform.id, value);
+        if (Shader::isMaterialBlockUniformId(uniform.id)){
+            materialBufferDirty = true;
+        }
+        return true;
+    }
+
+    // Write values of the "material" uniform block using the std140 offsets and strides reported by the shader
+    void Material::updateMaterialBuffer() {
+        char* data = materialBufferData.data();
+        for (auto& m : shader->materialBlockMembers){
+            switch (m.type){
+                case UniformType::Float: {
+                    float value = uniformMap.get<float>(m.id);
+                    memcpy(data + m.offset, &value, sizeof(float));
+                }
+                break;
+                case UniformType::Vec4: {
+                    glm::vec4 value = uniformMap.get<glm::vec4>(m.id);
+                    memcpy(data + m.offset, &value, sizeof(glm::vec4));
+                }
+                break;
+                case UniformType::Mat4: {
+                    glm::mat4 value = uniformMap.get<glm::mat4>(m.id);
+                    for (int c=0;c<4;c++){
+                        memcpy(data + m.offset + c * m.matrixStride, &value[c], sizeof(glm::vec4));
+                    }
+                }
+                break;
+                case UniformType::Mat4Array: {
+                    auto values = uniformMap.get<std::shared_ptr<std::vector<glm::mat4>>>(m.id);
+                    int count = values ? std::min((int)values->size(), m.arraySize) : 0;
+                    for (int i=0;i<count;i++){
+                        for (int c=0;c<4;c++){
+                            memcpy(data + m.offset + i * m.arrayStride + c * m.matrixStride, &(*values)[i][c], sizeof(glm::vec4));
+                        }
+                    }
+                }
+                break;
+                case UniformType::Mat3Array: {
+                    auto values = uniformMap.get<std::shared_ptr<std::vector<glm::mat3>>>(m.id);
+                    int count = values ? std::min((int)values->size(), m.arraySize) : 0;
+                    for (int i=0;i<count;i++){
+                        for (int c=0;c<3;c++){
+                            memcpy(data + m.offset + i * m.arrayStride + c * m.matrixStride, &(*values)[i][c], sizeof(glm::vec3));
+                        }
+                    }
+                }
+                break;
+                default:
+                    break;
+            }
+        }
     }
 
     std::shared_ptr<sre::Shader> Material::getShader()  {
@@ -59,6 +131,11 @@ namespace sre {
                     uniformMap.set(u.id, Texture::getDefaultCubemapTexture());
                 }
                 break;
+                case UniformType::TextureArray:
+                {
+                    uniformMap.set(u.id, Texture::getWhiteTextureArray());
+                }
+                break;
                 case UniformType::Float:
                 {
                     uniformMap.set(u.id, 0.0f);
@@ -89,8 +166,10 @@ namespace sre {
             for (auto &oldUniform : *uniforms) {
                 for (auto &u : *(shader->uniforms)) {
 
+                    // array values are copied regardless of size (provisional uniforms do not know the array size)
+                    bool isArray = u.type == UniformType::Mat3Array || u.type == UniformType::Mat4Array;
                     if (u.type == oldUniform.type &&
-                        u.arraySize == oldUniform.arraySize &&
+                        (u.arraySize == oldUniform.arraySize || isArray) &&
                         u.name == oldUniform.name) {
                         switch (u.type) {
                             case UniformType::Vec4: {
@@ -98,8 +177,10 @@ namespace sre {
                             }
                                 break;
                             case UniformType::Texture:
-                            case UniformType::TextureCube: {
+                            case UniformType::TextureCube:
+                            case UniformType::TextureArray: {
                                 uniformMap.set(u.id, oldUniformMap.get<std::shared_ptr<Texture>>(oldUniform.id));
+                                uniformMap.setSampler(u.id, oldUniformMap.getSampler(oldUniform.id));
                             }
                                 break;
                             case UniformType::Float: {
@@ -134,30 +215,88 @@ namespace sre {
             }
         }
         uniforms = shader->uniforms;
+
+        // uniform buffer for "material" uniform block
+        if (materialBuffer && materialBuffer->getBlockSize() != shader->materialBlockSize){
+            materialBuffer->release(materialBufferSlot);
+            materialBuffer.reset();
+            materialBufferSlot = -1;
+        }
+        if (shader->materialBlockSize > 0 && !materialBuffer){
+            materialBuffer = Renderer::instance->getMaterialUniformBuffer(shader->materialBlockSize);
+            materialBufferSlot = materialBuffer->allocate();
+        }
+        materialBufferData.assign((size_t)shader->materialBlockSize, 0);
+        materialBufferDirty = true;
+    }
+
+    Uniform Material::getUniform(const std::string &name, UniformType type) {
+        if (shader->shaderProgramId != 0){
+            return shader->getUniform(name);
+        }
+        // The shader is still being compiled (see Shader::ShaderBuilder::withAsyncCompile()). Keep the values in
+        // provisional uniforms, which are copied by name when the shader is ready.
+        if (uniforms == shader->uniforms){
+            uniforms = std::make_shared<std::vector<Uniform>>(*shader->uniforms);
+        }
+        for (auto & u : *uniforms){
+            if (u.name == name){
+                return u;
+            }
+        }
+        Uniform u;
+        u.name = name;
+        u.type = type;
+        u.id = -2 - (int)uniforms->size();
+        u.arraySize = 1;
+        if (type != UniformType::Invalid){
+            uniforms->push_back(u);
+        } else {
+            u.id = -1;
+            u.arraySize = -1;
+        }
+        return u;
+    }
+
+    UniformType Material::getTextureUniformType(const std::shared_ptr<Texture>& texture) {
+        if (texture && texture->isCubemap()){
+            return UniformType::TextureCube;
+        }
+        if (texture && texture->isArray()){
+            return UniformType::TextureArray;
+        }
+        return UniformType::Texture;
+    }
+
+    Uniform Material::getUniform(int uniformHandle, UniformType type) {
+        if (shader->shaderProgramId != 0){
+            return shader->getUniform(uniformHandle);
+        }
+        return getUniform(Shader::getUniformName(uniformHandle), type);
     }
 
     Color Material::getColor()   {
-        return get<Color>("color");
+        return get<Color>(UniformHandles::color);
     }
 
     bool Material::setColor(const Color &color) {
-        return set("color", color);
+        return set(UniformHandles::color, color);
     }
 
     Color Material::getSpecularity()   {
-        return get<Color>("specularity");
+        return get<Color>(UniformHandles::specularity);
     }
 
     bool Material::setSpecularity(Color specularity) {
-        return set("specularity", specularity);
+        return set(UniformHandles::specularity, specularity);
     }
 
     std::shared_ptr<sre::Texture> Material::getTexture()  {
-        return get<std::shared_ptr<sre::Texture>>("tex");
+        return get<std::shared_ptr<sre::Texture>>(UniformHandles::tex);
     }
 
     bool Material::setTexture(std::shared_ptr<sre::Texture> texture) {
-        return set("tex",texture);
+        return set(UniformHandles::tex,texture);
     }
 
     const std::string &Material::getName()  {
@@ -168,63 +307,118 @@ namespace sre {
         Material::name = name;
     }
 
-    bool Material::set(std::string uniformName, glm::vec4 value){
-        auto type = shader->getUniform(uniformName);
-        uniformMap.set(type.id, value);
-        return true;
+    bool Material::set(const std::string& uniformName, glm::vec4 value){
+        auto type = getUniform(uniformName, UniformType::Vec4);
+        return setValue(type, value);
     }
 
-    bool Material::set(std::string uniformName, glm::mat4 value){
-        auto type = shader->getUniform(uniformName);
-        uniformMap.set(type.id, value);
-        return true;
+    bool Material::set(const std::string& uniformName, glm::mat4 value){
+        auto type = getUniform(uniformName, UniformType::Mat4);
+        return setValue(type, value);
     }
 
 
-    bool Material::set(std::string uniformName, std::shared_ptr<std::vector<glm::mat3>> value){
-        auto type = shader->getUniform(uniformName);
-        uniformMap.set(type.id, value);
-        return true;
+    bool Material::set(const std::string& uniformName, std::shared_ptr<std::vector<glm::mat3>> value){
+        auto type = getUniform(uniformName, UniformType::Mat3Array);
+        return setValue(type, value);
     }
 
-    bool Material::set(std::string uniformName, std::shared_ptr<std::vector<glm::mat4>> value){
-        auto type = shader->getUniform(uniformName);
-        uniformMap.set(type.id, value);
-        return true;
+    bool Material::set(const std::string& uniformName, std::shared_ptr<std::vector<glm::mat4>> value){
+        auto type = getUniform(uniformName, UniformType::Mat4Array);
+        return setValue(type, value);
     }
 
-    bool Material::set(std::string uniformName, Color value){
-        auto type = shader->getUniform(uniformName);
-        uniformMap.set(type.id, value);
-        return true;
+    bool Material::set(const std::string& uniformName, Color value){
+        auto type = getUniform(uniformName, UniformType::Vec4);
+        return setValue(type, value);
     }
 
-    bool Material::set(std::string uniformName, float value){
-        auto type = shader->getUniform(uniformName);
-        uniformMap.set(type.id, value);
-        return true;
+    bool Material::set(const std::string& uniformName, float value){
+        auto type = getUniform(uniformName, UniformType::Float);
+        return setValue(type, value);
     }
 
-    bool Material::set(std::string uniformName, std::shared_ptr<sre::Texture> value){
-        auto type = shader->getUniform(uniformName);
-        uniformMap.set(type.id, value);
-        return true;
+    bool Material::set(const std::string& uniformName, std::shared_ptr<sre::Texture> value){
+        auto type = getUniform(uniformName, getTextureUniformType(value));
+        return setValue(type, value);
+    }
+
+    bool Material::set(int uniformHandle, glm::vec4 value){
+        auto type = getUniform(uniformHandle, UniformType::Vec4);
+        return setValue(type, value);
+    }
+
+    bool Material::set(int uniformHandle, glm::mat4 value){
+        auto type = getUniform(uniformHandle, UniformType::Mat4);
+        return setValue(type, value);
+    }
+
+    bool Material::set(int uniformHandle, std::shared_ptr<std::vector<glm::mat3>> value){
+        auto type = getUniform(uniformHandle, UniformType::Mat3Array);
+        return setValue(type, value);
+    }
+
+    bool Material::set(int uniformHandle, std::shared_ptr<std::vector<glm::mat4>> value){
+        auto type = getUniform(uniformHandle, UniformType::Mat4Array);
+        return setValue(type, value);
+    }
+
+    bool Material::set(int uniformHandle, Color value){
+        auto type = getUniform(uniformHandle, UniformType::Vec4);
+        return setValue(type, value);
+    }
+
+    bool Material::set(int uniformHandle, float value){
+        auto type = getUniform(uniformHandle, UniformType::Float);
+        return setValue(type, value);
+    }
+
+    bool Material::set(int uniformHandle, std::shared_ptr<sre::Texture> value){
+        auto type = getUniform(uniformHandle, getTextureUniformType(value));
+        return setValue(type, value);
+    }
+
+    bool Material::setSamplerValue(const Uniform& uniform, std::shared_ptr<const Sampler> sampler) {
+        if (uniform.type != UniformType::Texture && uniform.type != UniformType::TextureCube && uniform.type != UniformType::TextureArray){
+            return false;
+        }
+        if (!uniformMap.contains(uniform.id)){
+            uniformMap.set(uniform.id, uniform.type == UniformType::TextureCube ? Texture::getDefaultCubemapTexture() :
+                                       uniform.type == UniformType::TextureArray ? Texture::getWhiteTextureArray() : Texture::getWhiteTexture());
+        }
+        return uniformMap.setSampler(uniform.id, std::move(sampler));
+    }
+
+    bool Material::setSampler(const std::string& uniformName, const Sampler& sampler) {
+        return setSamplerValue(getUniform(uniformName, UniformType::Texture), std::make_shared<const Sampler>(sampler));
+    }
+
+    bool Material::setSampler(int uniformHandle, const Sampler& sampler) {
+        return setSamplerValue(getUniform(uniformHandle, UniformType::Texture), std::make_shared<const Sampler>(sampler));
+    }
+
+    bool Material::removeSampler(const std::string& uniformName) {
+        return setSamplerValue(getUniform(uniformName, UniformType::Texture), nullptr);
+    }
+
+    std::shared_ptr<const Sampler> Material::getSampler(const std::string& uniformName) {
+        return uniformMap.getSampler(getUniform(uniformName).id);
     }
 
     std::shared_ptr<sre::Texture> Material::getMetallicRoughnessTexture() {
-        return get<std::shared_ptr<sre::Texture>>("mrTex");
+        return get<std::shared_ptr<sre::Texture>>(UniformHandles::mrTex);
     }
 
     bool Material::setMetallicRoughnessTexture(std::shared_ptr<sre::Texture> texture) {
-        return set("mrTex",texture);
+        return set(UniformHandles::mrTex,texture);
 
     }
 
     glm::vec2 Material::getMetallicRoughness() {
-        return (glm::vec2)get<glm::vec4>("metallicRoughness");
+        return (glm::vec2)get<glm::vec4>(UniformHandles::metallicRoughness);
     }
 
     bool Material::setMetallicRoughness(glm::vec2 metallicRoughness) {
-        return set("metallicRoughness",glm::vec4(metallicRoughness,0,0));
+        return set(UniformHandles::metallicRoughness,glm::vec4(metallicRoughness,0,0));
     }
 }
\ No newline at end of file
@@ -21,12 +21,125 @@
 #include "sre/RenderPass.hpp"
 #include "sre/Shader.hpp"
 #include "sre/Log.hpp"
+#include "sre/impl/MeshFile.hpp"
+#include <fstream>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #define BUFFER_OFFSET(i) ((char *)NULL + (i))
 
 class Material;
 
 namespace sre {
+    namespace {
+        // Read-only memory mapping of a file. Falls back to reading the file into memory if mapping fails.
+        class MappedFile {
+        public:
+            explicit MappedFile(const std::string& path){
+#ifdef _WIN32
+                file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+                if (file != INVALID_HANDLE_VALUE){
+                    LARGE_INTEGER fileSize;
+                    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0){
+                        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                        if (mapping != nullptr){
+                            ptr = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                            if (ptr != nullptr){
+                                length = (size_t)fileSize.QuadPart;
+                                return;
+                            }
+                        }
+                    }
+                }
+#else
+                int fd = open(path.c_str(), O_RDONLY);
+                if (fd != -1){
+                    struct stat st;
+                    if (fstat(fd, &st) == 0 && st.st_size > 0){
+                        void* res = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                        if (res != MAP_FAILED){
+#ifdef MADV_SEQUENTIAL
+                            madvise(res, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+                            ptr = static_cast<const char*>(res);
+                            length = (size_t)st.st_size;
+                            mapped = true;
+                        }
+                    }
+                    close(fd);
+                    if (mapped){
+                        return;
+                    }
+                }
+#endif
+                std::ifstream in(path, std::ios::binary | std::ios::ate);
+                if (in){
+                    auto size = in.tellg();
+                    fallback.resize((size_t)size);
+                    in.seekg(0, std::ios::beg);
+                    if (in.read(fallback.data(), size)){
+                        ptr = fallback.data();
+                        length = fallback.size();
+                    }
+                }
+            }
+
+            ~MappedFile(){
+#ifdef _WIN32
+                if (ptr != nullptr && fallback.empty()){
+                    UnmapViewOfFile(ptr);
+                }
+                if (mapping != nullptr){
+                    CloseHandle(mapping);
+                }
+                if (file != INVALID_HANDLE_VALUE){
+                    CloseHandle(file);
+                }
+#else
+                if (mapped){
+                    munmap((void*)ptr, length);
+                }
+#endif
+            }
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            const char* data() { return ptr; }
+            size_t size() { return length; }
+        private:
+            const char* ptr = nullptr;
+            size_t length = 0;
+            std::vector<char> fallback;
+#ifdef _WIN32
+            HANDLE file = INVALID_HANDLE_VALUE;
+            HANDLE mapping = nullptr;
+#else
+            bool mapped = false;
+#endif
+        };
+
+        template<typename T>
+        std::vector<T> deinterleave(const char* vertexData, int vertexCount, int stride, int offset){
+            std::vector<T> res(vertexCount);
+            for (int i=0;i<vertexCount;i++){
+                memcpy(&res[i], vertexData + (size_t)stride*i + offset, sizeof(T));
+            }
+            return res;
+        }
+    }
+
     uint16_t Mesh::meshIdCount = 0;
 
     Mesh::Mesh(std::map<std::string,std::vector<float>>&& attributesFloat, std::map<std::string,std::vector<glm::vec2>>&& attributesVec2, std::map<std::string, std::vector<glm::vec3>>&& attributesVec3, std::map<std::string,std::vector<glm::vec4>>&& attributesVec4,std::map<std::string,std::vector<glm::i32vec4>>&& attributesIVec4, std::vector<std::vector<uint32_t>> &&indices, std::vector<MeshTopology> meshTopology, std::string name, RenderStats& renderStats, float lineWidth, glm::vec3 location, glm::vec3 rotation, glm::vec3 scaling, std::shared_ptr<Material> material)
@@ -77,7 +190,9 @@ namespace sre {
     }
 
     void Mesh::bind(Shader* shader) {
-        if (renderInfo().graphicsAPIVersionMajor >= 3) {
+        if (renderInfo().supportVertexAttribBinding) {
+            bindSharedVertexArray(shader);
+        } else if (renderInfo().graphicsAPIVersionMajor >= 3) {
             auto res = shaderToVertexArrayObject.find(shader->shaderProgramId);
             if (res != shaderToVertexArrayObject.end() && res->second.shaderId == shader->shaderUniqueId) {
                 GLuint vao = res->second.vaoID;
@@ -100,6 +215,50 @@ namespace sre {
         }
         glLineWidth(lineWidth);
     }
+
+    void Mesh::bindSharedVertexArray(Shader* shader) {
+#ifdef GL_VERSION_4_3
+        if (sharedVAO == 0 || sharedVAOShaderId != shader->shaderUniqueId || sharedVAOProgramId != shader->shaderProgramId){
+            auto& vertexArrays = Renderer::instance->sharedVertexArrays;
+            auto key = getVertexFormatKey(shader);
+            auto res = vertexArrays.find(key);
+            if (res != vertexArrays.end()){
+                sharedVAO = res->second;
+            } else {
+                glGenVertexArrays(1, &sharedVAO);
+                glBindVertexArray(sharedVAO);
+                setVertexAttributeFormat(shader);
+                vertexArrays[key] = sharedVAO;
+            }
+            sharedVAOShaderId = shader->shaderUniqueId;
+            sharedVAOProgramId = shader->shaderProgramId;
+        }
+        // the vertex format is stored in the VAO - only the buffers are mesh specific
+        glBindVertexArray(sharedVAO);
+        glBindVertexBuffer(0, vertexBufferId, 0, totalBytesPerVertex);
+        bindIndexSet();
+#endif
+    }
+
+    std::string Mesh::getVertexFormatKey(Shader* shader) {
+        // per shader attribute: location, mesh attribute type and offset (or 0 if a constant is used)
+        std::vector<int32_t> key;
+        key.reserve(shader->attributes.size()*4);
+        for (auto& shaderAttribute : shader->attributes) {
+            auto meshAttribute = attributeByName.find(shaderAttribute.first);
+            key.push_back(shaderAttribute.second.position);
+            key.push_back(shaderAttribute.second.type);
+            if (isAttributeCompatible(shaderAttribute.second.type, shaderAttribute.second.arraySize, meshAttribute == attributeByName.end() ? nullptr : &meshAttribute->second)){
+                key.push_back(meshAttribute->second.attributeType);
+                key.push_back(meshAttribute->second.offset);
+            } else {
+                key.push_back(0);
+                key.push_back(0);
+            }
+        }
+        return std::string(reinterpret_cast<const char*>(key.data()), key.size()*sizeof(int32_t));
+    }
+
     void Mesh::bindIndexSet(){
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBufferId);
     }
@@ -126,6 +285,7 @@ namespace sre {
             }
             shaderToVertexArrayObject.clear();
         }
+        sharedVAO = 0;                  // vertex format may have changed
         attributeByName.clear();
 
         this->indices         = std::move(indices);
@@ -134,6 +294,9 @@ namespace sre {
         this->attributesVec3  = std::move(attributesVec3);
         this->attributesVec4  = std::move(attributesVec4);
         this->attributesIVec4 = std::move(attributesIVec4);
+        hasVertexData = true;
+        attributeVersion++;
+        bvh.reset();
 
         auto interleavedData = getInterleavedData();
 
@@ -142,6 +305,7 @@ namespace sre {
         }
         glBindBuffer(GL_ARRAY_BUFFER, vertexBufferId);
         glBufferData(GL_ARRAY_BUFFER, sizeof(float)*interleavedData.size(), interleavedData.data(), GL_STATIC_DRAW);
+        vertexBufferCapacity = vertexCount;
 
         updateIndexBuffers();
 
@@ -168,6 +332,7 @@ namespace sre {
 
     void Mesh::updateIndexBuffers() {
         elementBufferOffsetCount.clear();
+        elementBufferCapacity = 0;
         if (this->indices.empty()){
             if (elementBufferId != 0){
                 glDeleteBuffers(1, &elementBufferId);
@@ -203,78 +368,183 @@ namespace sre {
                 elementBufferOffsetCount.push_back({offset, (uint32_t)this->indices[i].size(), type});
                 offset += indexSize;
             }
-            std::vector<uint8_t> concatenatedIndices;
-            concatenatedIndices.reserve(offset);
+            std::vector<uint8_t> concatenatedIndices = getConcatenatedIndices();
 
-            for (int i=0;i<this->indices.size();i++) {
-                uint8_t* dest = concatenatedIndices.data()+elementBufferOffsetCount[i].offset;
-                if (elementBufferOffsetCount[i].type == GL_UNSIGNED_INT){
-                    void* srcData = this->indices[i].data();
-                    memcpy( dest,srcData, this->indices[i].size() * sizeof(uint32_t));
-                } else {
-                    uint16_t* dest16 = reinterpret_cast<uint16_t *>(dest);
-                    for (int j=0;j<this->indices[i].size();j++){
-                        dest16[j] = static_cast<uint16_t>(this->indices[i][j]);
-                    }
-                }
-            }
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBufferId);
             glBufferData(GL_ELEMENT_ARRAY_BUFFER, offset, concatenatedIndices.data(), GL_STATIC_DRAW);
+            elementBufferCapacity = offset;
 
             this->dataSize += offset;
         }
     }
 
+    void Mesh::uploadAppended(int firstVertex, int firstIndex) {
+        RenderStats& renderStats = Renderer::instance->renderStats;
+        int oldDataSize = dataSize;
+        attributeVersion++;
+        bvh.reset();
+
+        vertexCount = 0;
+        auto tail = getInterleavedData(firstVertex);
+        if (renderInfo().graphicsAPIVersionMajor >= 3) {
+            glBindVertexArray(0);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBufferId);
+        if (vertexCount > vertexBufferCapacity){
+            // grow buffer and upload all vertices
+            vertexBufferCapacity = std::max(vertexCount, vertexBufferCapacity*2);
+            auto interleavedData = firstVertex == 0 ? std::move(tail) : getInterleavedData();
+            glBufferData(GL_ARRAY_BUFFER, vertexBufferCapacity * totalBytesPerVertex, nullptr, GL_DYNAMIC_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float)*interleavedData.size(), interleavedData.data());
+        } else if (!tail.empty()){
+            glBufferSubData(GL_ARRAY_BUFFER, firstVertex * totalBytesPerVertex, sizeof(float)*tail.size(), tail.data());
+        }
+
+        if (indices.size() == 1){
+            auto& idx = indices[0];
+            uint32_t type = vertexCount < std::numeric_limits<uint16_t>().max() ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+            uint32_t indexSize = type == GL_UNSIGNED_INT ? sizeof(uint32_t) : sizeof(uint16_t);
+            bool typeChanged = elementBufferOffsetCount.empty() || elementBufferOffsetCount[0].type != type;
+            elementBufferOffsetCount = {{0, (uint32_t)idx.size(), type}};
+            if (elementBufferId == 0){
+                glGenBuffers(1, &elementBufferId);
+            }
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBufferId);
+            if (typeChanged || idx.size() * indexSize > elementBufferCapacity){
+                // grow buffer and upload all indices
+                elementBufferCapacity = std::max((int)(idx.size() * indexSize), elementBufferCapacity*2);
+                auto concatenatedIndices = getConcatenatedIndices();
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, elementBufferCapacity, nullptr, GL_DYNAMIC_DRAW);
+                glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, concatenatedIndices.size(), concatenatedIndices.data());
+            } else if (firstIndex < idx.size()){
+                std::vector<uint8_t> tailIndices((idx.size() - firstIndex) * indexSize);
+                for (int i = firstIndex; i < idx.size(); i++){
+                    if (type == GL_UNSIGNED_INT){
+                        reinterpret_cast<uint32_t*>(tailIndices.data())[i - firstIndex] = idx[i];
+                    } else {
+                        reinterpret_cast<uint16_t*>(tailIndices.data())[i - firstIndex] = static_cast<uint16_t>(idx[i]);
+                    }
+                }
+                glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, firstIndex * indexSize, tailIndices.size(), tailIndices.data());
+            }
+        }
+
+        if (firstVertex == 0){
+            boundsMinMax[0] = glm::vec3{std::numeric_limits<float>::max()};
+            boundsMinMax[1] = glm::vec3{-std::numeric_limits<float>::max()};
+        }
+        auto pos = attributesVec3.find("position");
+        if (pos != attributesVec3.end()){
+            for (int i = firstVertex; i < pos->second.size(); i++){
+                boundsMinMax[0] = glm::min(boundsMinMax[0], pos->second[i]);
+                boundsMinMax[1] = glm::max(boundsMinMax[1], pos->second[i]);
+            }
+        }
+
+        dataSize = totalBytesPerVertex * vertexBufferCapacity + elementBufferCapacity;
+        renderStats.meshBytes += dataSize - oldDataSize;
+        if (dataSize > oldDataSize){
+            renderStats.meshBytesAllocated += dataSize - oldDataSize;
+        }
+    }
+
+    std::vector<uint8_t> Mesh::getConcatenatedIndices() {
+        uint32_t size = 0;
+        for (auto & e : elementBufferOffsetCount){
+            size = std::max(size, (uint32_t)(e.offset + e.size * (e.type == GL_UNSIGNED_INT ? sizeof(uint32_t) : sizeof(uint16_t))));
+        }
+        std::vector<uint8_t> concatenatedIndices(size, 0);
+
+        for (int i=0;i<elementBufferOffsetCount.size() && i<this->indices.size();i++) {
+            uint8_t* dest = concatenatedIndices.data()+elementBufferOffsetCount[i].offset;
+            if (elementBufferOffsetCount[i].type == GL_UNSIGNED_INT){
+                void* srcData = this->indices[i].data();
+                memcpy( dest,srcData, this->indices[i].size() * sizeof(uint32_t));
+            } else {
+                uint16_t* dest16 = reinterpret_cast<uint16_t *>(dest);
+                for (int j=0;j<this->indices[i].size();j++){
+                    dest16[j] = static_cast<uint16_t>(this->indices[i][j]);
+                }
+            }
+        }
+        return concatenatedIndices;
+    }
+
+    bool Mesh::isAttributeCompatible(unsigned int shaderType, int32_t arraySize, const Attribute* meshAttribute) {
+        bool attributeFoundInMesh = meshAttribute != nullptr;
+        // allows mesh attributes to be smaller than shader attributes. E.g. if mesh is Vec2 and shader is Vec4, then OpenGL automatically append
+        // (z = 0.0, w=1.0) to the attribute in the shader
+        // currently only supported from vec2 or vec3 (not float)
+        // TODO: add support float - vecX
+        bool equalType = attributeFoundInMesh && (shaderType == meshAttribute->attributeType ||
+                (shaderType >= GL_FLOAT_VEC2 && shaderType <= GL_FLOAT_VEC4 && shaderType>= meshAttribute->attributeType)
+                || (shaderType >= GL_INT_VEC2 && shaderType <= GL_INT_VEC4 && shaderType>= meshAttribute->attributeType)
+                                                 );
+        return attributeFoundInMesh && equalType && arraySize == 1;
+    }
+
     void Mesh::setVertexAttributePointers(Shader* shader) {
         glBindBuffer(GL_ARRAY_BUFFER, vertexBufferId);
-        int vertexAttribArray = 0;
         for (auto shaderAttribute : shader->attributes) {
             auto meshAttribute = attributeByName.find(shaderAttribute.first);
-
-            bool attributeFoundInMesh = meshAttribute != attributeByName.end();
-            // allows mesh attributes to be smaller than shader attributes. E.g. if mesh is Vec2 and shader is Vec4, then OpenGL automatically append
-            // (z = 0.0, w=1.0) to the attribute in the shader
-            // currently only supported from vec2 or vec3 (not float)
-            // TODO: add support float - vecX
-            bool equalType = attributeFoundInMesh && (shaderAttribute.second.type == meshAttribute->second.attributeType ||
-                    (shaderAttribute.second.type >= GL_FLOAT_VEC2 && shaderAttribute.second.type <= GL_FLOAT_VEC4 && shaderAttribute.second.type>= meshAttribute->second.attributeType)
-                    || (shaderAttribute.second.type >= GL_INT_VEC2 && shaderAttribute.second.type <= GL_INT_VEC4 && shaderAttribute.second.type>= meshAttribute->second.attributeType)
-                                                     );
-            if (attributeFoundInMesh &&  equalType && shaderAttribute.second.arraySize == 1) {
+            if (isAttributeCompatible(shaderAttribute.second.type, shaderAttribute.second.arraySize, meshAttribute == attributeByName.end() ? nullptr : &meshAttribute->second)) {
                 glEnableVertexAttribArray(shaderAttribute.second.position);
                 if ((shaderAttribute.second.type >= GL_INT_VEC2 && shaderAttribute.second.type <= GL_INT_VEC4 && shaderAttribute.second.type>= meshAttribute->second.attributeType)){
                     glVertexAttribIPointer(shaderAttribute.second.position, meshAttribute->second.elementCount, meshAttribute->second.dataType, totalBytesPerVertex, BUFFER_OFFSET(meshAttribute->second.offset));
                 } else {
                     glVertexAttribPointer(shaderAttribute.second.position, meshAttribute->second.elementCount, meshAttribute->second.dataType, GL_FALSE, totalBytesPerVertex, BUFFER_OFFSET(meshAttribute->second.offset));
                 }
-                vertexAttribArray++;
             } else {
-                assert(shaderAttribute.second.arraySize == 1 && "Constant vertex attributes not supported as arrays");
-                glDisableVertexAttribArray(shaderAttribute.second.position);
-                static const float a[] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-                switch (shaderAttribute.second.type) {
-                case GL_INT_VEC4:
-                    glVertexAttribI4iv(shaderAttribute.second.position, (GLint*)a);
-                    break;
-                case GL_FLOAT_VEC4:
-                    glVertexAttrib4fv(shaderAttribute.second.position, a);
-                    break;
-                case GL_FLOAT_VEC3:
-                    glVertexAttrib3fv(shaderAttribute.second.position, a);
-                    break;
-                case GL_FLOAT_VEC2:
-                    glVertexAttrib2fv(shaderAttribute.second.position, a);
-                    break;
-                case GL_FLOAT:
-                    glVertexAttrib1fv(shaderAttribute.second.position, a);
-                    break;
-                default:
-                    LOG_ERROR("Unhandled attribute type: %i",(int)shaderAttribute.second.type);
-                    break;
+                setConstantVertexAttribute(shaderAttribute.second.position, shaderAttribute.second.type, shaderAttribute.second.arraySize);
+            }
+        }
+    }
 
+    void Mesh::setVertexAttributeFormat(Shader* shader) {
+#ifdef GL_VERSION_4_3
+        // same as setVertexAttributePointers, but using the separate attribute format (GL 4.3) with all attributes
+        // sourced from vertex buffer binding 0
+        for (auto shaderAttribute : shader->attributes) {
+            auto meshAttribute = attributeByName.find(shaderAttribute.first);
+            if (isAttributeCompatible(shaderAttribute.second.type, shaderAttribute.second.arraySize, meshAttribute == attributeByName.end() ? nullptr : &meshAttribute->second)) {
+                glEnableVertexAttribArray(shaderAttribute.second.position);
+                if ((shaderAttribute.second.type >= GL_INT_VEC2 && shaderAttribute.second.type <= GL_INT_VEC4 && shaderAttribute.second.type>= meshAttribute->second.attributeType)){
+                    glVertexAttribIFormat(shaderAttribute.second.position, meshAttribute->second.elementCount, meshAttribute->second.dataType, meshAttribute->second.offset);
+                } else {
+                    glVertexAttribFormat(shaderAttribute.second.position, meshAttribute->second.elementCount, meshAttribute->second.dataType, GL_FALSE, meshAttribute->second.offset);
                 }
+                glVertexAttribBinding(shaderAttribute.second.position, 0);
+            } else {
+                setConstantVertexAttribute(shaderAttribute.second.position, shaderAttribute.second.type, shaderAttribute.second.arraySize);
             }
         }
+#endif
+    }
+
+    void Mesh::setConstantVertexAttribute(int32_t position, unsigned int type, int32_t arraySize) {
+        assert(arraySize == 1 && "Constant vertex attributes not supported as arrays");
+        glDisableVertexAttribArray(position);
+        static const float a[] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+        switch (type) {
+        case GL_INT_VEC4:
+            glVertexAttribI4iv(position, (GLint*)a);
+            break;
+        case GL_FLOAT_VEC4:
+            glVertexAttrib4fv(position, a);
+            break;
+        case GL_FLOAT_VEC3:
+            glVertexAttrib3fv(position, a);
+            break;
+        case GL_FLOAT_VEC2:
+            glVertexAttrib2fv(position, a);
+            break;
+        case GL_FLOAT:
+            glVertexAttrib1fv(position, a);
+            break;
+        default:
+            LOG_ERROR("Unhandled attribute type: %i",(int)type);
+            break;
+        }
     }
 
     std::vector<glm::vec3> Mesh::getPositions() {
@@ -309,6 +579,9 @@ namespace sre {
     }
 
     Mesh::MeshBuilder Mesh::update() {
+        if (!hasVertexData){
+            LOG_WARNING("Mesh %s has no vertex data on the CPU (see Mesh::loadMapped()). Update will replace the mesh content.", name.c_str());
+        }
         Mesh::MeshBuilder res;
         res.updateMesh = this;
 
@@ -329,7 +602,7 @@ namespace sre {
 
     std::vector<glm::vec4> Mesh::getColors() {
         std::vector<glm::vec4> res;
-        auto ref = attributesVec4.find("color");
+        auto ref = attributesVec4.find("vertex_color");
         if (ref != attributesVec4.end()){
             res = ref->second;
         }
@@ -345,6 +618,30 @@ namespace sre {
         return res;
     }
 
+    AttributeView<glm::vec3> Mesh::getPositionsView() {
+        return getAttributeView<glm::vec3>("position");
+    }
+
+    AttributeView<glm::vec3> Mesh::getNormalsView() {
+        return getAttributeView<glm::vec3>("normal");
+    }
+
+    AttributeView<glm::vec4> Mesh::getUVsView() {
+        return getAttributeView<glm::vec4>("uv");
+    }
+
+    AttributeView<glm::vec4> Mesh::getColorsView() {
+        return getAttributeView<glm::vec4>("vertex_color");
+    }
+
+    AttributeView<glm::vec4> Mesh::getTangentsView() {
+        return getAttributeView<glm::vec4>("tangent");
+    }
+
+    AttributeView<float> Mesh::getParticleSizesView() {
+        return getAttributeView<float>("particleSize");
+    }
+
     int Mesh::getDataSize() {
         return dataSize;
     }
@@ -385,6 +682,36 @@ namespace sre {
         return boundsMinMax;
     }
 
+    std::shared_ptr<MeshBVH> Mesh::getBVH() {
+        if (bvh == nullptr){
+            auto pos = attributesVec3.find("position");
+            if (pos == attributesVec3.end()){
+                LOG_WARNING("Cannot build BVH for mesh %s. No position vertex attribute on the CPU.", name.c_str());
+                return nullptr;
+            }
+            bvh = MeshBVH::create(pos->second, indices, meshTopology);
+        }
+        return bvh;
+    }
+
+    bool Mesh::raycast(const std::array<glm::vec3,2>& ray, const glm::mat4& transform, RaycastHit& hit) {
+        auto meshBVH = getBVH();
+        if (meshBVH == nullptr){
+            return false;
+        }
+        // the direction is not normalized in mesh space, which keeps the ray parameter equal to the world space distance
+        glm::mat4 inverseTransform = glm::inverse(transform);
+        std::array<glm::vec3,2> localRay = {
+                glm::vec3(inverseTransform * glm::vec4(ray[0], 1.0f)),
+                glm::vec3(inverseTransform * glm::vec4(ray[1], 0.0f))
+        };
+        if (!meshBVH->raycast(localRay, hit, hit.distance)){
+            return false;
+        }
+        hit.point = ray[0] + ray[1] * hit.distance;
+        return true;
+    }
+
     std::pair<int,int> Mesh::getType(const std::string &name) {
         auto res = attributeByName.find(name);
         if (res != attributeByName.end()){
@@ -410,8 +737,8 @@ namespace sre {
     }
 
     int Mesh::getIndicesSize(int indexSet) {
-        if (indexSet < indices.size()) {
-            return static_cast<int>(indices[indexSet].size());
+        if (indexSet < elementBufferOffsetCount.size()) {
+            return static_cast<int>(elementBufferOffsetCount[indexSet].size);
         }
         LOG_ERROR("Indexset %i out of bounds.",indexSet);
         return -1;
@@ -426,7 +753,7 @@ namespace sre {
         return res;
     }
 
-    std::vector<float> Mesh::getInterleavedData() {
+    std::vector<float> Mesh::getInterleavedData(int firstVertex) {
         totalBytesPerVertex = 0;
         std::vector<int> offset;
         // enforced std140 layout rules ( https://learnopengl.com/#!Advanced-OpenGL/Advanced-GLSL )
@@ -465,42 +792,42 @@ namespace sre {
         if (totalBytesPerVertex%(sizeof(float)*4) != 0) {
             totalBytesPerVertex += sizeof(float)*4 - totalBytesPerVertex%(sizeof(float)*4);
         }
-        std::vector<float> interleavedData((vertexCount * totalBytesPerVertex) / sizeof(float), 0);
+        std::vector<float> interleavedData((std::max(0, vertexCount - firstVertex) * totalBytesPerVertex) / sizeof(float), 0);
         const char * dataPtr = (char*) interleavedData.data();
 
         // add data (copy each element into interleaved buffer)
         for (auto & pair : attributesVec3){
             auto& offsetBytes = attributeByName[pair.first];
-            for (int i=0;i<pair.second.size();i++){
-                glm::vec3 * locationPtr = (glm::vec3 *) (dataPtr + (totalBytesPerVertex * i) + offsetBytes.offset);
+            for (int i=firstVertex;i<pair.second.size();i++){
+                glm::vec3 * locationPtr = (glm::vec3 *) (dataPtr + (totalBytesPerVertex * (i - firstVertex)) + offsetBytes.offset);
                 *locationPtr = pair.second[i];
             }
         }
         for (auto & pair : attributesVec4){
             auto& offsetBytes = attributeByName[pair.first];
-            for (int i=0;i<pair.second.size();i++) {
-                glm::vec4 * locationPtr = (glm::vec4 *) (dataPtr + totalBytesPerVertex * i + offsetBytes.offset);
+            for (int i=firstVertex;i<pair.second.size();i++) {
+                glm::vec4 * locationPtr = (glm::vec4 *) (dataPtr + totalBytesPerVertex * (i - firstVertex) + offsetBytes.offset);
                 *locationPtr = pair.second[i];
             }
         }
         for (auto & pair : attributesIVec4){
             auto& offsetBytes = attributeByName[pair.first];
-            for (int i=0;i<pair.second.size();i++) {
-                glm::i32vec4 * locationPtr = (glm::i32vec4 *) (dataPtr + totalBytesPerVertex * i + offsetBytes.offset);
+            for (int i=firstVertex;i<pair.second.size();i++) {
+                glm::i32vec4 * locationPtr = (glm::i32vec4 *) (dataPtr + totalBytesPerVertex * (i - firstVertex) + offsetBytes.offset);
                 *locationPtr = pair.second[i];
             }
         }
         for (auto & pair : attributesVec2){
             auto& offsetBytes = attributeByName[pair.first];
-            for (int i=0;i<pair.second.size();i++) {
-                glm::vec2 * locationPtr = (glm::vec2 *) (dataPtr + totalBytesPerVertex * i + offsetBytes.offset);
+            for (int i=firstVertex;i<pair.second.size();i++) {
+                glm::vec2 * locationPtr = (glm::vec2 *) (dataPtr + totalBytesPerVertex * (i - firstVertex) + offsetBytes.offset);
                 *locationPtr = pair.second[i];
             }
         }
         for (auto & pair : attributesFloat){
             auto& offsetBytes = attributeByName[pair.first];
-            for (int i=0;i<pair.second.size();i++) {
-                float * locationPtr = (float *) (dataPtr + totalBytesPerVertex * i + offsetBytes.offset);
+            for (int i=firstVertex;i<pair.second.size();i++) {
+                float * locationPtr = (float *) (dataPtr + totalBytesPerVertex * (i - firstVertex) + offsetBytes.offset);
                 *locationPtr = pair.second[i];
             }
         }
@@ -515,6 +842,150 @@ namespace sre {
         return attributeByName.find(name) != attributeByName.end();
     }
 
+    bool Mesh::save(const std::string& path) {
+        if (!hasVertexData){
+            LOG_ERROR("Cannot save mesh %s. Vertex data is not available on the CPU (see Mesh::loadMapped()).", name.c_str());
+            return false;
+        }
+        auto interleavedData = getInterleavedData();
+        auto indexData = getConcatenatedIndices();
+
+        MeshFile meshFile;
+        meshFile.vertexCount = (uint32_t)vertexCount;
+        meshFile.bytesPerVertex = (uint32_t)totalBytesPerVertex;
+        meshFile.bounds = boundsMinMax;
+        meshFile.lineWidth = lineWidth;
+        meshFile.name = name;
+        for (auto & a : attributeByName){
+            meshFile.attributes.push_back({a.first, a.second.offset, a.second.elementCount, a.second.dataType, a.second.attributeType});
+        }
+        for (auto t : meshTopology){
+            meshFile.topologies.push_back((uint32_t)t);
+        }
+        for (auto & e : elementBufferOffsetCount){
+            meshFile.indexSets.push_back({e.offset, e.size, e.type});
+        }
+        meshFile.vertexData = reinterpret_cast<const char*>(interleavedData.data());
+        meshFile.vertexDataSize = interleavedData.size()*sizeof(float);
+        meshFile.indexData = reinterpret_cast<const char*>(indexData.data());
+        meshFile.indexDataSize = indexData.size();
+
+        std::ofstream out(path, std::ios::binary);
+        if (!out || !meshFile.write(out)){
+            LOG_ERROR("Cannot write mesh file %s", path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    std::shared_ptr<Mesh> Mesh::loadMapped(const std::string& path, bool keepVertexData) {
+        if ( Renderer::instance == nullptr){
+            LOG_FATAL("Cannot instantiate sre::Mesh before sre::Renderer is created.");
+        }
+        MappedFile file(path);
+        if (file.data() == nullptr){
+            LOG_ERROR("Cannot open mesh file %s", path.c_str());
+            return nullptr;
+        }
+        MeshFile meshFile;
+        std::string error;
+        // indices kept on the CPU are used without checks (e.g. by getBVH()), so they must be inside the vertices
+        if (!meshFile.read(file.data(), file.size(), error) || (keepVertexData && !meshFile.validateIndices(error))){
+            LOG_ERROR("Mesh file %s: %s", path.c_str(), error.c_str());
+            return nullptr;
+        }
+        std::map<std::string,Attribute> attributes;
+        for (auto & a : meshFile.attributes){
+            Attribute attribute{};
+            attribute.offset = a.offset;
+            attribute.elementCount = a.elementCount;
+            attribute.dataType = a.dataType;
+            attribute.attributeType = a.attributeType;
+            attributes[a.name] = attribute;
+        }
+        std::vector<MeshTopology> topologies;
+        for (auto t : meshFile.topologies){
+            topologies.push_back((MeshTopology)t);
+        }
+        std::vector<ElementBufferData> elementBuffers;
+        for (auto & e : meshFile.indexSets){
+            elementBuffers.push_back({e.offset, e.size, e.type});
+        }
+        auto vertexCount = meshFile.vertexCount;
+        auto bytesPerVertex = meshFile.bytesPerVertex;
+
+        RenderStats& renderStats = Renderer::instance->renderStats;
+        auto mesh = new Mesh({}, {}, {}, {}, {}, {}, topologies, meshFile.name, renderStats, meshFile.lineWidth, glm::vec3(0), glm::vec3(0), glm::vec3(1), nullptr);
+        const char* vertexData = meshFile.vertexData;
+        const char* indexData = meshFile.indexData;
+
+        mesh->attributeByName = std::move(attributes);
+        mesh->totalBytesPerVertex = bytesPerVertex;
+        mesh->vertexCount = vertexCount;
+        mesh->elementBufferOffsetCount = elementBuffers;
+        mesh->boundsMinMax = meshFile.bounds;
+        mesh->indices.resize(elementBuffers.size());
+
+        if (renderInfo().graphicsAPIVersionMajor >= 3) {
+            glBindVertexArray(0);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBufferId);
+        glBufferData(GL_ARRAY_BUFFER, meshFile.vertexDataSize, vertexData, GL_STATIC_DRAW);
+        if (!elementBuffers.empty()){
+            glGenBuffers(1, &mesh->elementBufferId);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->elementBufferId);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, meshFile.indexDataSize, indexData, GL_STATIC_DRAW);
+        }
+
+        if (keepVertexData){
+            for (auto & a : mesh->attributeByName){
+                switch (a.second.attributeType){
+                    case GL_FLOAT_VEC3:
+                        mesh->attributesVec3[a.first] = deinterleave<glm::vec3>(vertexData, vertexCount, bytesPerVertex, a.second.offset);
+                        break;
+                    case GL_FLOAT_VEC4:
+                        mesh->attributesVec4[a.first] = deinterleave<glm::vec4>(vertexData, vertexCount, bytesPerVertex, a.second.offset);
+                        break;
+                    case GL_INT_VEC4:
+                        mesh->attributesIVec4[a.first] = deinterleave<glm::i32vec4>(vertexData, vertexCount, bytesPerVertex, a.second.offset);
+                        break;
+                    case GL_FLOAT_VEC2:
+                        mesh->attributesVec2[a.first] = deinterleave<glm::vec2>(vertexData, vertexCount, bytesPerVertex, a.second.offset);
+                        break;
+                    case GL_FLOAT:
+                        mesh->attributesFloat[a.first] = deinterleave<float>(vertexData, vertexCount, bytesPerVertex, a.second.offset);
+                        break;
+                    default:
+                        LOG_ERROR("Unhandled attribute type: %i",(int)a.second.attributeType);
+                        break;
+                }
+            }
+            for (int i=0;i<elementBuffers.size();i++){
+                auto & e = elementBuffers[i];
+                auto & idx = mesh->indices[i];
+                idx.resize(e.size);
+                if (e.type == GL_UNSIGNED_INT){
+                    memcpy(idx.data(), indexData + e.offset, e.size * sizeof(uint32_t));
+                } else {
+                    const uint16_t* src16 = reinterpret_cast<const uint16_t *>(indexData + e.offset);
+                    for (int j=0;j<e.size;j++){
+                        idx[j] = src16[j];
+                    }
+                }
+            }
+        } else {
+            mesh->hasVertexData = false;
+        }
+
+        renderStats.meshBytes -= mesh->dataSize;
+        mesh->dataSize = (int)(meshFile.vertexDataSize + meshFile.indexDataSize);
+        renderStats.meshBytes += mesh->dataSize;
+        renderStats.meshBytesAllocated += mesh->dataSize;
+        renderStats.meshCount++;
+
+        return std::shared_ptr<Mesh>(mesh);
+    }
+
     Mesh::MeshBuilder& Mesh::MeshBuilder::withLineWidth(float lineWidth) {
         this->lineWidth = lineWidth;
         return *this;
@@ -1275,118 +1746,160 @@ namespace sre {
 
     // LineContainer Class =====================================================
 
-    // TODO: This class contains a set of "paired" vectors: m_colors,
-    //       m_materials, m_lineWidths, m_topologies, m_meshes, and m_status.
-    //       Instead of using seperate vectors, the code could be cleaned up
-    //       by using a vector of std::tuple. However, you would still need
-    //       to store the vertices vectors in a seperate vector. This is because
-    //       we do not want to clear the vertices vector completely (we want to
-    //       retain the storage).
-
     void LineContainer::add(const std::vector<glm::vec3> & verticesIn,
                             const Color & colorIn, const float & lineWidthIn,
                             const MeshTopology & topologyIn)
     {
-        assert(m_colors.size() == m_topologies.size());
-        assert(m_colors.size() == m_lineWidths.size());
-        assert(m_colors.size() == m_status.size());
-        // m_vertices.size() may be larger than others -- see note in ::clear
-        assert(m_colors.size() <= m_vertices.size());
-
-        bool found = false;
-        // Size used is same for all vectors -- use m_colors to set index
-        for (int i = 0; i < m_colors.size(); i++) {
-            if (m_colors[i] == colorIn && m_topologies[i] == topologyIn
-                                       && m_lineWidths[i] == lineWidthIn) {
-                m_status[i] = MeshStatus::Uninitialized;
-                m_vertices[i].insert(m_vertices[i].end(), verticesIn.begin(), 
-                                                          verticesIn.end());
-                found = true;
+        if (verticesIn.empty()) {
+            return;
+        }
+        // Colors are stored per vertex in linear space (Color::toLinear() is not const)
+        glm::vec4 color = Color(colorIn).toLinear();
+        Group& group = getGroup(lineWidthIn, topologyIn);
+        if (group.wide) {
+            addWide(group, verticesIn, color, topologyIn == MeshTopology::LineStrip);
+            return;
+        }
+        auto& positions = group.mesh->attributesVec3["position"];
+        auto& colors = group.mesh->attributesVec4["vertex_color"];
+        if (topologyIn == MeshTopology::LineStrip) {
+            // store strip as segments, so strips added to the same group are not connected
+            positions.reserve(positions.size() + 2 * (verticesIn.size() - 1));
+            for (int i = 1; i < verticesIn.size(); i++) {
+                positions.push_back(verticesIn[i-1]);
+                positions.push_back(verticesIn[i]);
             }
+        } else {
+            positions.insert(positions.end(), verticesIn.begin(), verticesIn.end());
         }
+        colors.resize(positions.size(), color);
+    }
 
-        if (!found) {
-            m_colors.push_back(colorIn);    
-            // Note: the Material class has a getColor() function, but it
-            // returns a color constructed from the shader that it stores. This
-            // construction from the shader results in small changes in the rgb
-            // values of the colors that prevent accurate comparison.
-            auto material = sre::Shader::getUnlit()->createMaterial();
-            material->setColor(colorIn);
-            m_materials.push_back(material);
-            m_lineWidths.push_back(lineWidthIn);    
-            m_topologies.push_back(topologyIn); 
-            m_status.push_back(MeshStatus::Uninitialized);
-            m_meshes.push_back(nullptr);
-
-            // Use m_colors to set m_vertices index (see note in ::clear)
-            int i = m_colors.size()-1;
-            if (i == m_vertices.size())
-            {
-                m_vertices.push_back(std::vector<glm::vec3>());
-            }
-            assert(i < m_vertices.size());
-            m_vertices[i] = verticesIn;
+    void LineContainer::addWide(Group& group, const std::vector<glm::vec3> & vertices,
+                                const glm::vec4 & color, bool strip)
+    {
+        auto& positions = group.mesh->attributesVec3["position"];
+        auto& colors = group.mesh->attributesVec4["vertex_color"];
+        auto& other = group.mesh->attributesVec4["line_other"];
+        auto& adjacent = group.mesh->attributesVec4["line_adjacent"];
+        auto& indices = group.mesh->indices[0];
+
+        int step = strip ? 1 : 2;
+        int segments = strip ? (int)vertices.size() - 1 : (int)vertices.size() / 2;
+        positions.reserve(positions.size() + segments * 4);
+        for (int i = 0; i + 1 < vertices.size(); i += step) {
+            const glm::vec3& a = vertices[i];
+            const glm::vec3& b = vertices[i+1];
+            // in line strips the end points are joined with the previous and next segment
+            bool hasPrev = strip && i > 0;
+            bool hasNext = strip && i + 2 < vertices.size();
+            glm::vec4 prev(hasPrev ? vertices[i-1] : a, hasPrev ? 1.0f : 0.0f);
+            glm::vec4 next(hasNext ? vertices[i+2] : b, hasNext ? 1.0f : 0.0f);
+
+            // quad corners. The side is relative to the direction towards the other end point
+            auto base = (uint32_t)positions.size();
+            positions.insert(positions.end(), {a, a, b, b});
+            other.insert(other.end(), {glm::vec4(b, 1.0f), glm::vec4(b, -1.0f), glm::vec4(a, -1.0f), glm::vec4(a, 1.0f)});
+            adjacent.insert(adjacent.end(), {prev, prev, next, next});
+            indices.insert(indices.end(), {base, base + 1, base + 2, base + 2, base + 1, base + 3});
+        }
+        colors.resize(positions.size(), color);
+    }
+
+    LineContainer::Group& LineContainer::getGroup(float lineWidth, MeshTopology topology)
+    {
+        bool isLine = topology == MeshTopology::Lines || topology == MeshTopology::LineStrip;
+        if (isLine) {
+            topology = MeshTopology::Lines;     // strips are stored as segments
+        }
+        uint32_t widthBits;
+        memcpy(&widthBits, &lineWidth, sizeof(float));
+        uint64_t key = ((uint64_t)widthBits << 32) | (uint32_t)topology;
+        auto res = m_groupIndex.find(key);
+        if (res != m_groupIndex.end()) {
+            return m_groups[res->second];
+        }
+
+        Group group;
+        group.lineWidth = lineWidth;
+        group.topology = topology;
+        group.wide = isLine && lineWidth > 1.0f;
+        if (group.wide) {
+            group.material = Shader::getUnlitLine()->createMaterial();
+            group.material->set("lineWidth", lineWidth);
+            group.mesh = Mesh::create()
+                    .withPositions(std::vector<glm::vec3>())
+                    .withColors(std::vector<glm::vec4>())
+                    .withAttribute("line_other", std::vector<glm::vec4>())
+                    .withAttribute("line_adjacent", std::vector<glm::vec4>())
+                    .withIndices(std::vector<uint32_t>(), MeshTopology::Triangles)
+                    .withName("LineContainer wide lines")
+                    .build();
+        } else {
+            group.material = Shader::getUnlit()->createMaterial({{"S_VERTEX_COLOR", "1"}});
+            group.mesh = Mesh::create()
+                    .withPositions(std::vector<glm::vec3>())
+                    .withColors(std::vector<glm::vec4>())
+                    .withMeshTopology(topology)
+                    .withLineWidth(lineWidth)
+                    .withName("LineContainer lines")
+                    .build();
         }
+        m_groupIndex[key] = (int)m_groups.size();
+        m_groups.push_back(group);
+        return m_groups.back();
     }
 
     void LineContainer::draw(RenderPass& renderPass)
     {
-        assert(m_colors.size() == m_status.size());
-        assert(m_colors.size() == m_meshes.size());
-        assert(m_colors.size() == m_materials.size());
-        assert(m_colors.size() == m_lineWidths.size());
-        assert(m_colors.size() == m_topologies.size());
-        assert(m_colors.size() <= m_vertices.size());
-
-        // Size used is same for all vectors -- use m_colors to set index
-        for (int i = 0; i < m_colors.size(); i++) {
-            if (m_status[i] == MeshStatus::Uninitialized) {
-                m_meshes[i] = sre::Mesh::create()
-                                    .withMaterial(m_materials[i])
-                                    .withLineWidth(m_lineWidths[i])
-                                    .withMeshTopology(m_topologies[i])
-                                    .withPositions(m_vertices[i])
-                                    .build();
-                m_status[i] = MeshStatus::Initialized;
+        for (auto& group : m_groups) {
+            int vertexCount = (int)group.mesh->attributesVec3["position"].size();
+            if (vertexCount == 0) {
+                continue;
             }
-            m_meshes[i]->draw(renderPass);
+            if (vertexCount != group.uploadedVertices) {
+                group.mesh->uploadAppended(group.uploadedVertices, group.uploadedIndices);
+                group.uploadedVertices = vertexCount;
+                group.uploadedIndices = group.wide ? (int)group.mesh->indices[0].size() : 0;
+            }
+            renderPass.draw(group.mesh, glm::mat4(1), group.material);
         }
     }
 
     void LineContainer::clear()
     {
-        m_colors.clear();
-        m_materials.clear();
-        m_lineWidths.clear();
-        m_topologies.clear();
-        m_meshes.clear();
-        m_status.clear();
-        // Clearing entire m_vertices vector clears the allocated space for each
-        // m_vertices[i] vector (resize(0) gives same result). Instead, clear
-        // each m_vertices[i] vector, which will retain the allocated space for
-        // each m_vertices[i] vector, which allows reuse of the space. The
-        // result is that m_vertices.size() will not be set to zero. This
-        // creates a small amount of complexity in the ::add function above.
-        for(int i = 0; i < m_vertices.size(); i++)
-        {
-            m_vertices[i].clear();
+        // Clear the vectors of each group (which retains the allocated space),
+        // and keep the GPU buffers of the meshes for reuse.
+        for (auto& group : m_groups) {
+            auto mesh = group.mesh.get();
+            for (auto& attribute : mesh->attributesVec3) {
+                attribute.second.clear();
+            }
+            for (auto& attribute : mesh->attributesVec4) {
+                attribute.second.clear();
+            }
+            for (auto& indexSet : mesh->indices) {
+                indexSet.clear();
+            }
+            group.uploadedVertices = 0;
+            group.uploadedIndices = 0;
         }
     }
 
     void LineContainer::output()
     {
-        std::cout << "m_colors.size() = " << m_colors.size()
-                  << "  .capacity() = " << m_colors.capacity()
-                  << "  m_vertices.size() = " << m_vertices.size()
-                  << "  .capcity() = " << m_vertices.capacity()
+        std::cout << "groups.size() = " << m_groups.size()
+                  << "  .capacity() = " << m_groups.capacity()
                   << std::endl;
-        for (int i = 0; i < m_vertices.size(); i++)
+        for (int i = 0; i < m_groups.size(); i++)
         {
-            std::cout << "m_vertices[" << i << "].size() = "
-                      << m_vertices[i].size() << "  .capacity() = "
-                      << m_vertices[i].capacity() << std::endl;
-        } 
+            auto& positions = m_groups[i].mesh->attributesVec3["position"];
+            std::cout << "group[" << i << "] lineWidth = " << m_groups[i].lineWidth
+                      << "  vertices.size() = " << positions.size()
+                      << "  .capacity() = " << positions.capacity()
+                      << "  gpu capacity = " << m_groups[i].mesh->vertexBufferCapacity
+                      << std::endl;
+        }
     }
 
 }
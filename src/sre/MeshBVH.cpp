@@ -0,0 +1,447 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/MeshBVH.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <future>
+#include "sre/Log.hpp"
+
+namespace sre {
+    namespace {
+        const int binCount = 16;
+        const uint32_t minLeafSize = 2;
+        const uint32_t maxLeafSize = 16;
+        const int maxDepth = 60;                                // keeps the traversal stack bounded
+        const uint32_t parallelBuildThreshold = 64*1024;        // minimum triangles in a node before building children in parallel
+        const float inf = std::numeric_limits<float>::max();
+
+        float surfaceArea(const glm::vec3& bmin, const glm::vec3& bmax){
+            glm::vec3 e = glm::max(bmax - bmin, glm::vec3(0.0f));
+            return e.x*e.y + e.y*e.z + e.z*e.x;
+        }
+
+        // returns the entry distance or inf if the box is missed
+        float intersectAABB(const glm::vec3& bmin, const glm::vec3& bmax, const glm::vec3& origin, const glm::vec3& invDir, float maxDistance){
+            glm::vec3 t0 = (bmin - origin) * invDir;
+            glm::vec3 t1 = (bmax - origin) * invDir;
+            glm::vec3 tmin = glm::min(t0, t1);
+            glm::vec3 tmax = glm::max(t0, t1);
+            float tnear = std::max(std::max(tmin.x, tmin.y), std::max(tmin.z, 0.0f));
+            float tfar = std::min(std::min(tmax.x, tmax.y), std::min(tmax.z, maxDistance));
+            return tnear <= tfar ? tnear : inf;
+        }
+
+        // Möller–Trumbore ray triangle intersection (double sided)
+        bool intersectTriangle(const glm::vec3& origin, const glm::vec3& dir, const glm::vec3* v, float& t, float& u, float& w){
+            glm::vec3 e1 = v[1] - v[0];
+            glm::vec3 e2 = v[2] - v[0];
+            glm::vec3 p = glm::cross(dir, e2);
+            float det = glm::dot(e1, p);
+            if (det == 0.0f){
+                return false;
+            }
+            float invDet = 1.0f / det;
+            glm::vec3 s = origin - v[0];
+            u = glm::dot(s, p) * invDet;
+            if (u < 0.0f || u > 1.0f){
+                return false;
+            }
+            glm::vec3 q = glm::cross(s, e1);
+            w = glm::dot(dir, q) * invDet;
+            if (w < 0.0f || u + w > 1.0f){
+                return false;
+            }
+            t = glm::dot(e2, q) * invDet;
+            return t >= 0.0f;
+        }
+
+        // separating axis test of triangle (relative to box center) against box with half size h
+        bool separatedOnAxis(const glm::vec3* v, const glm::vec3& h, const glm::vec3& axis){
+            float p0 = glm::dot(v[0], axis);
+            float p1 = glm::dot(v[1], axis);
+            float p2 = glm::dot(v[2], axis);
+            float r = h.x * std::abs(axis.x) + h.y * std::abs(axis.y) + h.z * std::abs(axis.z);
+            return std::max(p0, std::max(p1, p2)) < -r || std::min(p0, std::min(p1, p2)) > r;
+        }
+
+        bool intersectTriangleAABB(const glm::vec3* triangle, const glm::vec3& bmin, const glm::vec3& bmax){
+            glm::vec3 center = (bmin + bmax) * 0.5f;
+            glm::vec3 h = (bmax - bmin) * 0.5f;
+            glm::vec3 v[3] = {triangle[0] - center, triangle[1] - center, triangle[2] - center};
+            glm::vec3 edges[3] = {v[1] - v[0], v[2] - v[1], v[0] - v[2]};
+            glm::vec3 boxAxes[3] = {glm::vec3(1,0,0), glm::vec3(0,1,0), glm::vec3(0,0,1)};
+            for (auto & boxAxis : boxAxes){
+                if (separatedOnAxis(v, h, boxAxis)){
+                    return false;
+                }
+            }
+            if (separatedOnAxis(v, h, glm::cross(edges[0], edges[1]))){
+                return false;
+            }
+            for (auto & edge : edges){
+                for (auto & boxAxis : boxAxes){
+                    if (separatedOnAxis(v, h, glm::cross(edge, boxAxis))){
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+    }
+
+    struct MeshBVH::Builder {
+        MeshBVH& bvh;
+        std::vector<glm::vec3> triangleMin;
+        std::vector<glm::vec3> triangleMax;
+        std::vector<glm::vec3> centroids;
+        std::vector<uint32_t> order;
+        std::atomic<uint32_t> nodesUsed{1};
+        int maxParallelDepth = 0;
+
+        explicit Builder(MeshBVH& bvh)
+        :bvh(bvh)
+        {}
+
+        void makeLeaf(Node& node, uint32_t first, uint32_t count){
+            node.leftOrFirst = first;
+            node.count = count;
+        }
+
+        void build(uint32_t nodeIndex, uint32_t first, uint32_t count, int depth){
+            Node& node = bvh.nodes[nodeIndex];
+            glm::vec3 bmin(inf), bmax(-inf), cmin(inf), cmax(-inf);
+            for (uint32_t i = first; i < first + count; i++){
+                uint32_t t = order[i];
+                bmin = glm::min(bmin, triangleMin[t]);
+                bmax = glm::max(bmax, triangleMax[t]);
+                cmin = glm::min(cmin, centroids[t]);
+                cmax = glm::max(cmax, centroids[t]);
+            }
+            node.boundsMin = bmin;
+            node.boundsMax = bmax;
+            if (count <= minLeafSize || depth >= maxDepth){
+                makeLeaf(node, first, count);
+                return;
+            }
+
+            // binned SAH
+            float bestCost = inf;
+            int bestAxis = -1;
+            int bestSplit = -1;
+            for (int axis = 0; axis < 3; axis++){
+                float extent = cmax[axis] - cmin[axis];
+                if (extent <= 0.0f){
+                    continue;
+                }
+                struct Bin {
+                    glm::vec3 bmin{inf};
+                    glm::vec3 bmax{-inf};
+                    uint32_t count = 0;
+                } bins[binCount];
+                float scale = binCount / extent;
+                for (uint32_t i = first; i < first + count; i++){
+                    uint32_t t = order[i];
+                    int b = std::min(binCount - 1, (int)((centroids[t][axis] - cmin[axis]) * scale));
+                    bins[b].bmin = glm::min(bins[b].bmin, triangleMin[t]);
+                    bins[b].bmax = glm::max(bins[b].bmax, triangleMax[t]);
+                    bins[b].count++;
+                }
+                float leftArea[binCount - 1];
+                uint32_t leftCount[binCount - 1];
+                glm::vec3 accMin(inf), accMax(-inf);
+                uint32_t accCount = 0;
+                for (int i = 0; i < binCount - 1; i++){
+                    accCount += bins[i].count;
+                    accMin = glm::min(accMin, bins[i].bmin);
+                    accMax = glm::max(accMax, bins[i].bmax);
+                    leftCount[i] = accCount;
+                    leftArea[i] = accCount > 0 ? surfaceArea(accMin, accMax) : 0.0f;
+                }
+                accMin = glm::vec3(inf);
+                accMax = glm::vec3(-inf);
+                accCount = 0;
+                for (int i = binCount - 1; i > 0; i--){
+                    accCount += bins[i].count;
+                    accMin = glm::min(accMin, bins[i].bmin);
+                    accMax = glm::max(accMax, bins[i].bmax);
+                    float rightArea = accCount > 0 ? surfaceArea(accMin, accMax) : 0.0f;
+                    float cost = leftCount[i - 1] * leftArea[i - 1] + accCount * rightArea;
+                    if (leftCount[i - 1] > 0 && accCount > 0 && cost < bestCost){
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestSplit = i - 1;
+                    }
+                }
+            }
+
+            float parentArea = surfaceArea(bmin, bmax);
+            float leafCost = count * parentArea;
+            float splitCost = parentArea + bestCost;            // traversal cost is approximated by one triangle intersection
+            if (bestAxis == -1 || (splitCost >= leafCost && count <= maxLeafSize)){
+                makeLeaf(node, first, count);
+                return;
+            }
+
+            float scale = binCount / (cmax[bestAxis] - cmin[bestAxis]);
+            float splitMin = cmin[bestAxis];
+            auto middle = std::partition(order.begin() + first, order.begin() + first + count, [&](uint32_t t){
+                int b = std::min(binCount - 1, (int)((centroids[t][bestAxis] - splitMin) * scale));
+                return b <= bestSplit;
+            });
+            uint32_t leftCount = (uint32_t)(middle - (order.begin() + first));
+            if (leftCount == 0 || leftCount == count){
+                makeLeaf(node, first, count);
+                return;
+            }
+
+            uint32_t left = nodesUsed.fetch_add(2);
+            node.leftOrFirst = left;
+            node.count = 0;
+#ifndef EMSCRIPTEN
+            if (depth < maxParallelDepth && count >= parallelBuildThreshold){
+                auto leftBuild = std::async(std::launch::async, [=]{
+                    build(left, first, leftCount, depth + 1);
+                });
+                build(left + 1, first + leftCount, count - leftCount, depth + 1);
+                leftBuild.get();
+                return;
+            }
+#endif
+            build(left, first, leftCount, depth + 1);
+            build(left + 1, first + leftCount, count - leftCount, depth + 1);
+        }
+    };
+
+    std::shared_ptr<MeshBVH> MeshBVH::create(const std::vector<glm::vec3>& positions,
+                                             const std::vector<std::vector<uint32_t>>& indices,
+                                             const std::vector<MeshTopology>& meshTopology) {
+        std::vector<std::array<uint32_t,3>> triangles;
+        std::vector<TriangleId> ids;
+        auto addTriangle = [&](int indexSet, int triangle, uint32_t a, uint32_t b, uint32_t c){
+            if (a >= positions.size() || b >= positions.size() || c >= positions.size()){
+                return;
+            }
+            triangles.push_back({a, b, c});
+            ids.push_back({indexSet, triangle});
+        };
+        auto addIndexSet = [&](int indexSet, MeshTopology topology, size_t count, const uint32_t* idx){
+            switch (topology){
+                case MeshTopology::Triangles:
+                    for (size_t i = 0; i + 2 < count; i += 3){
+                        addTriangle(indexSet, (int)(i / 3), idx ? idx[i] : i, idx ? idx[i+1] : i+1, idx ? idx[i+2] : i+2);
+                    }
+                    break;
+                case MeshTopology::TriangleStrip:
+                    for (size_t i = 0; i + 2 < count; i++){
+                        size_t a = i % 2 == 0 ? i : i + 1;
+                        size_t b = i % 2 == 0 ? i + 1 : i;
+                        addTriangle(indexSet, (int)i, idx ? idx[a] : a, idx ? idx[b] : b, idx ? idx[i+2] : i+2);
+                    }
+                    break;
+                case MeshTopology::TriangleFan:
+                    for (size_t i = 1; i + 1 < count; i++){
+                        addTriangle(indexSet, (int)(i - 1), idx ? idx[0] : 0, idx ? idx[i] : i, idx ? idx[i+1] : i+1);
+                    }
+                    break;
+                default:
+                    break;
+            }
+        };
+        if (indices.empty()){
+            addIndexSet(0, meshTopology.empty() ? MeshTopology::Triangles : meshTopology[0], positions.size(), nullptr);
+        } else {
+            for (int i = 0; i < indices.size(); i++){
+                addIndexSet(i, i < meshTopology.size() ? meshTopology[i] : MeshTopology::Triangles, indices[i].size(), indices[i].data());
+            }
+        }
+
+        auto res = std::shared_ptr<MeshBVH>(new MeshBVH());
+        if (triangles.empty()){
+            return res;
+        }
+        uint32_t triangleCount = (uint32_t)triangles.size();
+
+        Builder builder(*res);
+        builder.triangleMin.resize(triangleCount);
+        builder.triangleMax.resize(triangleCount);
+        builder.centroids.resize(triangleCount);
+        builder.order.resize(triangleCount);
+        for (uint32_t i = 0; i < triangleCount; i++){
+            auto & t = triangles[i];
+            const glm::vec3& a = positions[t[0]];
+            const glm::vec3& b = positions[t[1]];
+            const glm::vec3& c = positions[t[2]];
+            builder.triangleMin[i] = glm::min(a, glm::min(b, c));
+            builder.triangleMax[i] = glm::max(a, glm::max(b, c));
+            builder.centroids[i] = (builder.triangleMin[i] + builder.triangleMax[i]) * 0.5f;
+            builder.order[i] = i;
+        }
+        unsigned int threads = std::thread::hardware_concurrency();
+        while ((1u << builder.maxParallelDepth) < threads){
+            builder.maxParallelDepth++;
+        }
+
+        res->nodes.resize(triangleCount * 2 - 1);
+        builder.build(0, 0, triangleCount, 0);
+        res->nodes.resize(builder.nodesUsed);
+        res->nodes.shrink_to_fit();
+
+        res->triangleVertices.resize(triangleCount * 3);
+        res->triangleIds.resize(triangleCount);
+        res->triangleIndices.resize(triangleCount);
+        for (uint32_t i = 0; i < triangleCount; i++){
+            uint32_t t = builder.order[i];
+            for (int j = 0; j < 3; j++){
+                res->triangleVertices[i * 3 + j] = positions[triangles[t][j]];
+            }
+            res->triangleIds[i] = ids[t];
+            res->triangleIndices[i] = triangles[t];
+        }
+        return res;
+    }
+
+    bool MeshBVH::raycast(const std::array<glm::vec3,2>& ray, RaycastHit& hit, float maxDistance) const {
+        if (nodes.empty()){
+            return false;
+        }
+        const glm::vec3& origin = ray[0];
+        const glm::vec3& dir = ray[1];
+        glm::vec3 invDir = 1.0f / dir;
+        float closest = maxDistance;
+        int hitTriangle = -1;
+        float hitU = 0, hitW = 0;
+
+        uint32_t stack[maxDepth + 4];
+        int stackSize = 0;
+        if (intersectAABB(nodes[0].boundsMin, nodes[0].boundsMax, origin, invDir, closest) != inf){
+            stack[stackSize++] = 0;
+        }
+        while (stackSize > 0){
+            const Node& node = nodes[stack[--stackSize]];
+            if (node.count > 0){
+                for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++){
+                    float t, u, w;
+                    if (intersectTriangle(origin, dir, &triangleVertices[i * 3], t, u, w) && t < closest){
+                        closest = t;
+                        hitTriangle = i;
+                        hitU = u;
+                        hitW = w;
+                    }
+                }
+                continue;
+            }
+            uint32_t nearChild = node.leftOrFirst;
+            uint32_t farChild = node.leftOrFirst + 1;
+            float distNear = intersectAABB(nodes[nearChild].boundsMin, nodes[nearChild].boundsMax, origin, invDir, closest);
+            float distFar = intersectAABB(nodes[farChild].boundsMin, nodes[farChild].boundsMax, origin, invDir, closest);
+            if (distFar < distNear){
+                std::swap(nearChild, farChild);
+                std::swap(distNear, distFar);
+            }
+            if (distFar != inf){
+                stack[stackSize++] = farChild;
+            }
+            if (distNear != inf){
+                stack[stackSize++] = nearChild;
+            }
+        }
+        if (hitTriangle == -1){
+            return false;
+        }
+        hit.distance = closest;
+        hit.point = origin + dir * closest;
+        hit.barycentric = glm::vec3(1.0f - hitU - hitW, hitU, hitW);
+        hit.vertices = triangleIndices[hitTriangle];
+        hit.triangle = triangleIds[hitTriangle].triangle;
+        hit.indexSet = triangleIds[hitTriangle].indexSet;
+        return true;
+    }
+
+    bool MeshBVH::raycastAny(const std::array<glm::vec3,2>& ray, float maxDistance) const {
+        if (nodes.empty()){
+            return false;
+        }
+        const glm::vec3& origin = ray[0];
+        const glm::vec3& dir = ray[1];
+        glm::vec3 invDir = 1.0f / dir;
+
+        uint32_t stack[maxDepth + 4];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0){
+            const Node& node = nodes[stack[--stackSize]];
+            if (intersectAABB(node.boundsMin, node.boundsMax, origin, invDir, maxDistance) == inf){
+                continue;
+            }
+            if (node.count > 0){
+                for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++){
+                    float t, u, w;
+                    if (intersectTriangle(origin, dir, &triangleVertices[i * 3], t, u, w) && t < maxDistance){
+                        return true;
+                    }
+                }
+                continue;
+            }
+            stack[stackSize++] = node.leftOrFirst + 1;
+            stack[stackSize++] = node.leftOrFirst;
+        }
+        return false;
+    }
+
+    void MeshBVH::overlap(const std::array<glm::vec3,2>& aabbMinMax, std::vector<TriangleId>& result) const {
+        if (nodes.empty()){
+            return;
+        }
+        const glm::vec3& qmin = aabbMinMax[0];
+        const glm::vec3& qmax = aabbMinMax[1];
+        uint32_t stack[maxDepth + 4];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0){
+            const Node& node = nodes[stack[--stackSize]];
+            if (glm::any(glm::lessThan(node.boundsMax, qmin)) || glm::any(glm::greaterThan(node.boundsMin, qmax))){
+                continue;
+            }
+            if (node.count > 0){
+                for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++){
+                    if (intersectTriangleAABB(&triangleVertices[i * 3], qmin, qmax)){
+                        result.push_back(triangleIds[i]);
+                    }
+                }
+                continue;
+            }
+            stack[stackSize++] = node.leftOrFirst + 1;
+            stack[stackSize++] = node.leftOrFirst;
+        }
+    }
+
+    std::array<glm::vec3,2> MeshBVH::getBoundsMinMax() const {
+        if (nodes.empty()){
+            return {glm::vec3(inf), glm::vec3(-inf)};
+        }
+        return {nodes[0].boundsMin, nodes[0].boundsMax};
+    }
+
+    int MeshBVH::getTriangleCount() const {
+        return (int)triangleIds.size();
+    }
+
+    int MeshBVH::getNodeCount() const {
+        return (int)nodes.size();
+    }
+
+    size_t MeshBVH::getDataSize() const {
+        return nodes.size() * sizeof(Node) +
+               triangleVertices.size() * sizeof(glm::vec3) +
+               triangleIds.size() * sizeof(TriangleId) +
+               triangleIndices.size() * sizeof(std::array<uint32_t,3>);
+    }
+}
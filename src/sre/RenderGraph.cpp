@@ -0,0 +1,312 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/RenderGraph.hpp"
+
+#include "sre/Renderer.hpp"
+#include "sre/Framebuffer.hpp"
+#include "sre/Log.hpp"
+#include "sre/impl/GL.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+namespace sre {
+
+    RenderGraph::PassBuilder::PassBuilder(RenderGraph* graph, int pass)
+    :graph(graph), pass(pass)
+    {
+    }
+
+    RenderGraph::PassBuilder& RenderGraph::PassBuilder::read(int texture) {
+        if (graph->isValidTexture(texture)){
+            graph->passes[pass].reads.push_back(texture);
+            graph->dirty = true;
+        }
+        return *this;
+    }
+
+    RenderGraph::PassBuilder& RenderGraph::PassBuilder::writeColor(int texture) {
+        if (graph->isValidTexture(texture)){
+            if (graph->textures[texture].depthPrecision != Texture::DepthPrecision::None){
+                LOG_ERROR("RenderGraph %s: %s is a depth texture", graph->name.c_str(), graph->textures[texture].name.c_str());
+                return *this;
+            }
+            graph->passes[pass].colorWrites.push_back(texture);
+            graph->dirty = true;
+        }
+        return *this;
+    }
+
+    RenderGraph::PassBuilder& RenderGraph::PassBuilder::writeDepth(int texture) {
+        if (graph->isValidTexture(texture)){
+            if (graph->textures[texture].depthPrecision == Texture::DepthPrecision::None){
+                LOG_ERROR("RenderGraph %s: %s is not a depth texture", graph->name.c_str(), graph->textures[texture].name.c_str());
+                return *this;
+            }
+            graph->passes[pass].depthWrite = texture;
+            graph->dirty = true;
+        }
+        return *this;
+    }
+
+    RenderGraph::PassBuilder& RenderGraph::PassBuilder::writeScreen() {
+        graph->passes[pass].writesScreen = true;
+        graph->dirty = true;
+        return *this;
+    }
+
+    RenderGraph::PassBuilder& RenderGraph::PassBuilder::withSetup(std::function<void(RenderPass::RenderPassBuilder&)> setup) {
+        graph->passes[pass].setup = std::move(setup);
+        return *this;
+    }
+
+    RenderGraph::PassBuilder& RenderGraph::PassBuilder::withExecute(std::function<void(RenderPass&)> execute) {
+        graph->passes[pass].execute = std::move(execute);
+        return *this;
+    }
+
+    RenderGraph::RenderGraph(std::string name)
+    :name(std::move(name))
+    {
+        if (Renderer::instance){
+            Renderer::instance->renderGraphs.push_back(this);
+        }
+    }
+
+    RenderGraph::~RenderGraph() {
+        auto r = Renderer::instance;
+        if (r){
+            releaseOutputs();
+            r->renderGraphs.erase(std::remove(r->renderGraphs.begin(), r->renderGraphs.end(), this), r->renderGraphs.end());
+        }
+    }
+
+    int RenderGraph::createTexture(const std::string& name, glm::ivec2 size, Texture::DepthPrecision depthPrecision, Texture::SamplerColorspace samplerColorspace) {
+        TextureNode node;
+        node.name = name;
+        node.size = size;
+        node.depthPrecision = depthPrecision;
+        node.samplerColorspace = samplerColorspace;
+        textures.push_back(node);
+        dirty = true;
+        return (int)textures.size() - 1;
+    }
+
+    int RenderGraph::importTexture(const std::string& name, std::shared_ptr<Texture> texture) {
+        if (!texture){
+            LOG_ERROR("RenderGraph %s: Cannot import null texture %s", this->name.c_str(), name.c_str());
+            return -1;
+        }
+        TextureNode node;
+        node.name = name;
+        node.size = {texture->getWidth(), texture->getHeight()};
+        node.depthPrecision = texture->getDepthPrecision();
+        node.samplerColorspace = texture->getSamplerColorSpace();
+        node.texture = std::move(texture);
+        node.imported = true;
+        textures.push_back(node);
+        dirty = true;
+        return (int)textures.size() - 1;
+    }
+
+    void RenderGraph::markOutput(int texture) {
+        if (isValidTexture(texture)){
+            textures[texture].output = true;
+            dirty = true;
+        }
+    }
+
+    RenderGraph::PassBuilder RenderGraph::addPass(const std::string& name) {
+        PassNode pass;
+        pass.name = name;
+        passes.push_back(pass);
+        dirty = true;
+        return PassBuilder(this, (int)passes.size() - 1);
+    }
+
+    bool RenderGraph::isValidTexture(int texture) {
+        if (texture < 0 || texture >= (int)textures.size()){
+            LOG_ERROR("RenderGraph %s: Invalid texture %i", name.c_str(), texture);
+            return false;
+        }
+        return true;
+    }
+
+    bool RenderGraph::compile() {
+        std::vector<RenderGraphCompiler::Pass> compilerPasses;
+        for (auto& pass : passes){
+            RenderGraphCompiler::Pass compilerPass;
+            compilerPass.reads = pass.reads;
+            compilerPass.writes = pass.colorWrites;
+            if (pass.depthWrite != -1){
+                compilerPass.writes.push_back(pass.depthWrite);
+            }
+            compilerPass.writesScreen = pass.writesScreen;
+            compilerPasses.push_back(compilerPass);
+        }
+        std::vector<RenderGraphCompiler::Resource> compilerResources;
+        for (auto& texture : textures){
+            RenderGraphCompiler::Resource resource;
+            resource.output = texture.output;
+            resource.mipmapped = texture.imported && texture.texture->isMipmapped();  // transient textures have no mipmaps
+            compilerResources.push_back(resource);
+        }
+        compiled = RenderGraphCompiler::compile(compilerPasses, compilerResources);
+        dirty = false;
+        if (!compiled.valid){
+            LOG_ERROR("RenderGraph %s: %s", name.c_str(), compiled.error.c_str());
+        }
+        return compiled.valid;
+    }
+
+    void RenderGraph::execute() {
+        if (dirty){
+            compile();
+        }
+        releaseOutputs();
+        if (!compiled.valid){
+            return;
+        }
+        auto& pool = Renderer::instance->renderTargetPool;
+        executedFrame = Renderer::instance->renderStats.frame;
+        for (int position = 0; position < (int)compiled.order.size(); position++){
+            auto& pass = passes[compiled.order[position]];
+            for (int i = 0; i < (int)textures.size(); i++){
+                auto& texture = textures[i];
+                if (!texture.imported && compiled.firstUse[i] == position){
+                    texture.texture = pool.getTexture(texture.size, texture.depthPrecision, texture.samplerColorspace);
+                }
+            }
+
+            auto&& builder = RenderPass::create();
+            builder.withName(pass.name)
+                    .withGUI(false)
+                    .withGenerateMipmaps(false);                    // mipmaps are generated only if read later
+            if (!pass.writesScreen){
+                std::vector<std::shared_ptr<Texture>> colorTextures;
+                for (int texture : pass.colorWrites){
+                    colorTextures.push_back(textures[texture].texture);
+                }
+                auto depthTexture = pass.depthWrite != -1 ? textures[pass.depthWrite].texture : nullptr;
+                builder.withFramebuffer(pool.getFramebuffer(colorTextures, depthTexture));
+            }
+            if (pass.setup){
+                pass.setup(builder);
+            }
+            auto renderPass = builder.build();
+            if (pass.execute){
+                pass.execute(renderPass);
+            }
+            renderPass.finish();
+
+            for (int texture : compiled.generateMipmaps[compiled.order[position]]){
+                generateMipmaps(textures[texture].texture.get());
+            }
+            for (int i = 0; i < (int)textures.size(); i++){
+                auto& texture = textures[i];
+                if (!texture.imported && compiled.lastUse[i] == position){
+                    pool.release(texture.texture);
+                    texture.texture.reset();
+                }
+            }
+        }
+    }
+
+    void RenderGraph::generateMipmaps(Texture* texture) {
+        Renderer::instance->textureBindings.bindForUpdate(texture->target, texture->textureId);
+        glGenerateMipmap(texture->target);
+        Renderer::instance->textureBindings.bindForUpdate(texture->target, 0);
+    }
+
+    // Transient textures marked as output are kept after execute(). The pool reserves them until the end of the frame,
+    // so they are only released if still in the frame they were allocated in.
+    void RenderGraph::releaseOutputs() {
+        bool reserved = Renderer::instance && Renderer::instance->renderStats.frame == executedFrame;
+        for (auto& texture : textures){
+            if (!texture.imported && texture.texture){
+                if (reserved){
+                    Renderer::instance->renderTargetPool.release(texture.texture);
+                }
+                texture.texture.reset();
+            }
+        }
+    }
+
+    void RenderGraph::clear() {
+        releaseOutputs();
+        passes.clear();
+        textures.clear();
+        compiled = RenderGraphCompiler::Result();
+        dirty = true;
+    }
+
+    std::shared_ptr<Texture> RenderGraph::getTexture(int texture) {
+        if (!isValidTexture(texture)){
+            return nullptr;
+        }
+        return textures[texture].texture;
+    }
+
+    const std::string& RenderGraph::getName() {
+        return name;
+    }
+
+    // Passes are boxes (culled passes are dashed), textures are ellipses (transient textures are dashed).
+    // Edges are labeled with the execution order of passes, and mipmap generation is shown on the write edge.
+    std::string RenderGraph::toGraphviz() {
+        if (dirty){
+            compile();
+        }
+        std::stringstream ss;
+        ss << "digraph \"" << name << "\" {\n";
+        std::vector<int> position(passes.size(), -1);
+        for (int i = 0; i < (int)compiled.order.size(); i++){
+            position[compiled.order[i]] = i;
+        }
+        bool screen = false;
+        for (int p = 0; p < (int)passes.size(); p++){
+            auto& pass = passes[p];
+            ss << "  pass" << p << " [shape=box, label=\"" << pass.name;
+            if (position[p] != -1){
+                ss << " (" << position[p] << ")";
+            }
+            ss << "\"" << (compiled.culled.empty() || compiled.culled[p] ? ", style=dashed" : "") << "];\n";
+            screen |= pass.writesScreen;
+        }
+        for (int t = 0; t < (int)textures.size(); t++){
+            auto& texture = textures[t];
+            ss << "  texture" << t << " [shape=ellipse, label=\"" << texture.name << "\\n" << texture.size.x << "x" << texture.size.y << "\"";
+            if (!texture.imported){
+                ss << ", style=dashed";
+            }
+            ss << "];\n";
+        }
+        if (screen){
+            ss << "  screen [shape=doublecircle];\n";
+        }
+        for (int p = 0; p < (int)passes.size(); p++){
+            auto& pass = passes[p];
+            for (int t : pass.reads){
+                ss << "  texture" << t << " -> pass" << p << ";\n";
+            }
+            auto writes = pass.colorWrites;
+            if (pass.depthWrite != -1){
+                writes.push_back(pass.depthWrite);
+            }
+            for (int t : writes){
+                bool mipmaps = compiled.valid && std::find(compiled.generateMipmaps[p].begin(), compiled.generateMipmaps[p].end(), t) != compiled.generateMipmaps[p].end();
+                ss << "  pass" << p << " -> texture" << t << (mipmaps ? " [label=\"mipmaps\"]" : "") << ";\n";
+            }
+            if (pass.writesScreen){
+                ss << "  pass" << p << " -> screen;\n";
+            }
+        }
+        ss << "}\n";
+        return ss.str();
+    }
+}
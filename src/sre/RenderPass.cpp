@@ -89,6 +89,11 @@ namespace sre {
         return *this;
     }
 
+    RenderPass::RenderPassBuilder &RenderPass::RenderPassBuilder::withGenerateMipmaps(bool enabled) {
+        this->generateMipmaps = enabled;
+        return *this;
+    }
+
     RenderPass RenderPass::RenderPassBuilder::build(){
 
         return RenderPass(*this);
@@ -108,6 +113,11 @@ namespace sre {
         if (builder.skybox){
             renderQueue.push_back({}); // reserve empty obj
         }
+        // computed once, so culling (see draw(SpatialIndex&)) uses the projection used for rendering
+        glm::vec2 windowSize = frameSize();
+        viewportOffset = static_cast<glm::uvec2>(builder.camera.viewportOffset * windowSize);
+        viewportSize = static_cast<glm::uvec2>(windowSize * builder.camera.viewportSize);
+        projection = builder.camera.getProjectionTransform(viewportSize);
     }
 
     RenderPass::RenderPass(RenderPass &&rp) noexcept {
@@ -258,7 +268,7 @@ namespace sre {
 
     glm::vec2 RenderPass::frameSize() {
         if (builder.framebuffer) {
-            return builder.framebuffer->size;
+            return static_cast<glm::vec2>(builder.framebuffer->getRenderSize());
         } else {
             return static_cast<glm::vec2>(Renderer::instance->getDrawableSize());
         }
@@ -274,9 +284,6 @@ namespace sre {
             glBindFramebuffer(GL_FRAMEBUFFER, 0);
         }
 
-        glm::vec2 windowSize = frameSize();
-        viewportOffset = static_cast<glm::uvec2>(builder.camera.viewportOffset * windowSize);
-        viewportSize = static_cast<glm::uvec2>(windowSize * builder.camera.viewportSize);
         glEnable(GL_SCISSOR_TEST);
         glScissor(viewportOffset.x, viewportOffset.y, viewportSize.x,viewportSize.y);
         glViewport(viewportOffset.x, viewportOffset.y, viewportSize.x,viewportSize.y);
@@ -302,8 +309,6 @@ namespace sre {
             glClear(clear);
         }
 
-        projection = builder.camera.getProjectionTransform(viewportSize);
-
         if (builder.skybox) {
             // Create an infinite projection
             glm::mat4 inf = builder.camera.getInfiniteProjectionTransform(viewportSize);
@@ -322,13 +327,16 @@ namespace sre {
             ImGui::Render();
             ImGui_SRE_RenderDrawData(ImGui::GetDrawData());
         }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
         if (builder.framebuffer != nullptr){
+            builder.framebuffer->resolve();
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (builder.framebuffer != nullptr && builder.generateMipmaps){
             for(auto& tex : builder.framebuffer->textures){
                 if (tex->generateMipmap){
-                    glBindTexture(tex->target,tex->textureId);
+                    Renderer::instance->textureBindings.bindForUpdate(tex->target,tex->textureId);
                     glGenerateMipmap(tex->target);
-                    glBindTexture(tex->target,0);
+                    Renderer::instance->textureBindings.bindForUpdate(tex->target,0);
                 }
             }
         }
@@ -342,38 +350,35 @@ namespace sre {
         } 
     }
 
-    std::vector<Color> RenderPass::readPixels(unsigned int x, unsigned int y, unsigned int width, unsigned int height, bool readFromScreen) {
+    // Multisampled framebuffers are read from the resolved textures
+    std::vector<Color> RenderPass::readPixels(unsigned int x, unsigned int y, unsigned int width, unsigned int height) {
         assert(mIsFinished);
-        if (readFromScreen) {
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        } else if (builder.framebuffer!=nullptr){
-            builder.framebuffer->bind();
+        if (builder.framebuffer!=nullptr){
+            builder.framebuffer->bindResolved();
         }
         std::vector<Color> res(width * height);
 
         glReadPixels(x, y, width, height, GL_RGBA, GL_FLOAT, res.data());
 
         // set default framebuffer
-        if (!readFromScreen && builder.framebuffer!=nullptr) {
+        if (builder.framebuffer!=nullptr) {
             glBindFramebuffer(GL_FRAMEBUFFER, 0);
         }
 
         return res;
     }
 
-    std::vector<glm::u8vec4> RenderPass::readRawPixels(unsigned int x, unsigned int y, unsigned int width, unsigned int height, bool readFromScreen) {
+    std::vector<glm::u8vec4> RenderPass::readRawPixels(unsigned int x, unsigned int y, unsigned int width, unsigned int height) {
         assert(mIsFinished);
-        if (readFromScreen) {
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        } else if (builder.framebuffer!=nullptr){
-            builder.framebuffer->bind();
+        if (builder.framebuffer!=nullptr){
+            builder.framebuffer->bindResolved();
         }
         std::vector<glm::u8vec4> bytes(width * height);
 
         glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, bytes.data());
 
         // set default framebuffer
-        if (!readFromScreen && builder.framebuffer!=nullptr) {
+        if (builder.framebuffer!=nullptr) {
             glBindFramebuffer(GL_FRAMEBUFFER, 0);
         }
 
@@ -391,6 +396,21 @@ namespace sre {
         }
     }
 
+    void RenderPass::draw(SpatialIndex& spatialIndex) {
+        assert(!mIsFinished && "RenderPass is finished. Can no longer be modified.");
+        glm::mat4 viewProjection = projection * builder.camera.getViewTransform();
+        std::vector<int> visible;
+        spatialIndex.queryFrustum(viewProjection, visible);
+        for (auto id : visible){
+            auto & instance = spatialIndex.getInstance(id);
+            int subMesh = 0;
+            for (auto & mat : instance.materials){
+                renderQueue.emplace_back(RenderQueueObj{instance.mesh, instance.transform, mat, subMesh});
+                subMesh++;
+            }
+        }
+    }
+
     void RenderPass::drawInstance(RenderQueueObj& rqObj) {
 
 
@@ -398,7 +418,21 @@ namespace sre {
         auto material = rqObj.material.get();
         auto shader = material->getShader().get();
         assert(mesh  != nullptr);
+        bool pendingBuild = shader->pendingBuild != nullptr;
+        if (!shader->isReady()){
+            builder.renderStats->drawCallsSkipped++;         // shader is still being compiled
+            return;
+        }
+        if (pendingBuild && shader->pendingBuild == nullptr){
+            // the shader program was replaced by an asynchronous build
+            lastBoundShader = nullptr;
+            lastBoundMaterial = nullptr;
+            lastBoundMeshId = -1;
+        }
         builder.renderStats->drawCalls++;
+        if (Renderer::instance->textureStreaming.isActive()){
+            requestStreamedLevels(rqObj);
+        }
         setupShader(rqObj.modelTransform, shader);
         if (material != lastBoundMaterial)
         {
@@ -421,6 +455,32 @@ namespace sre {
         }
     }
 
+    // Estimates the screen size of the mesh from its bounding sphere, and requests the mip level of each streamed
+    // texture with about one texel per pixel
+    void RenderPass::requestStreamedLevels(RenderQueueObj& rqObj) {
+        float screenSize = -1;
+        for (auto& texture : rqObj.material->uniformMap.getTextures()){
+            if (!texture || !texture->streaming){
+                continue;
+            }
+            if (screenSize < 0){
+                auto bounds = rqObj.mesh->getBoundsMinMax();
+                glm::vec3 center = (bounds[0] + bounds[1]) * 0.5f;
+                auto& m = rqObj.modelTransform;
+                float scale = glm::max(glm::length(glm::vec3(m[0])), glm::max(glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2]))));
+                float radius = glm::length(bounds[1] - bounds[0]) * 0.5f * scale;
+                glm::vec4 clip = projection * builder.camera.viewTransform * m * glm::vec4(center, 1.0f);
+                if (clip.w < -radius){
+                    return;                                         // behind the camera
+                }
+                // clip.w is the distance for perspective projections and 1 for orthographic projections
+                screenSize = radius * projection[1][1] * viewportSize.y / glm::max(clip.w, 0.0001f);
+            }
+            int textureSize = std::max(texture->width, texture->height);
+            Renderer::instance->textureStreaming.requestLevel(texture.get(), TextureStreaming::getDesiredLevel(textureSize, screenSize));
+        }
+    }
+
     void RenderPass::finishGPUCommandBuffer() {
         glFinish();
     }
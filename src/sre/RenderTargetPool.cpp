@@ -0,0 +1,123 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/RenderTargetPool.hpp"
+
+#include "sre/Renderer.hpp"
+#include "sre/Framebuffer.hpp"
+#include "sre/RenderStats.hpp"
+#include "sre/Log.hpp"
+
+#include <algorithm>
+#include <string>
+
+namespace sre {
+
+    std::shared_ptr<Texture> RenderTargetPool::getTexture(glm::ivec2 size, Texture::DepthPrecision depthPrecision, Texture::SamplerColorspace samplerColorspace) {
+        if (size.x <= 0 || size.y <= 0){
+            LOG_ERROR("Invalid render target size %ix%i", size.x, size.y);
+            return nullptr;
+        }
+        auto& renderStats = Renderer::instance->renderStats;
+        bool depth = depthPrecision != Texture::DepthPrecision::None;
+        for (auto& target : targets){
+            if (!target.inUse && target.size == size && target.depthPrecision == depthPrecision && (depth || target.samplerColorspace == samplerColorspace)){
+                target.inUse = true;
+                target.lastUsedFrame = frame;
+                renderStats.renderTargetPoolHits++;
+                return target.texture;
+            }
+        }
+        renderStats.renderTargetPoolMisses++;
+        auto name = std::string("RenderTargetPool ") + (depth ? "depth " : "color ") + std::to_string(size.x) + "x" + std::to_string(size.y) + " #" + std::to_string(targets.size());
+        auto&& builder = Texture::create();
+        builder.withGenerateMipmaps(false)
+                .withWrapUV(Texture::Wrap::ClampToEdge)
+                .withName(name);
+        if (depth){
+            builder.withDepth(size.x, size.y, depthPrecision);
+        } else {
+            builder.withRGBAData(nullptr, size.x, size.y)
+                    .withSamplerColorspace(samplerColorspace);
+        }
+        auto texture = builder.build();
+        dataSize += texture->getDataSize();
+        targets.push_back({texture, size, depthPrecision, samplerColorspace, true, frame});
+        return texture;
+    }
+
+    std::shared_ptr<Framebuffer> RenderTargetPool::getFramebuffer(const std::vector<std::shared_ptr<Texture>>& colorTextures, std::shared_ptr<Texture> depthTexture) {
+        for (auto& cached : framebuffers){
+            if (cached.colorTextures == colorTextures && cached.depthTexture == depthTexture){
+                cached.lastUsedFrame = frame;
+                return cached.framebuffer;
+            }
+        }
+        auto&& builder = Framebuffer::create();
+        builder.withName("RenderTargetPool framebuffer #" + std::to_string(framebuffers.size()));
+        for (auto& texture : colorTextures){
+            builder.withColorTexture(texture);
+        }
+        if (depthTexture){
+            builder.withDepthTexture(depthTexture);
+        }
+        auto framebuffer = builder.build();
+        framebuffers.push_back({framebuffer, colorTextures, depthTexture, frame});
+        return framebuffer;
+    }
+
+    void RenderTargetPool::release(const std::shared_ptr<Texture>& texture) {
+        for (auto& target : targets){
+            if (target.texture == texture){
+                target.inUse = false;
+                return;
+            }
+        }
+        LOG_WARNING("Cannot release texture %s. Not from RenderTargetPool.", texture ? texture->getName().c_str() : "null");
+    }
+
+    void RenderTargetPool::update(RenderStats& renderStats) {
+        // framebuffers are deleted first, since they reference the textures
+        framebuffers.erase(std::remove_if(framebuffers.begin(), framebuffers.end(), [&](const CachedFramebuffer& cached){
+            return frame - cached.lastUsedFrame >= maxUnusedFrames;
+        }), framebuffers.end());
+        targets.erase(std::remove_if(targets.begin(), targets.end(), [&](const Target& target){
+            if (frame - target.lastUsedFrame >= maxUnusedFrames){
+                dataSize -= target.texture->getDataSize();
+                return true;
+            }
+            return false;
+        }), targets.end());
+        for (auto& target : targets){
+            target.inUse = false;
+        }
+        renderStats.renderTargetPoolBytes = dataSize;
+        frame++;
+    }
+
+    void RenderTargetPool::setMaxUnusedFrames(int frames) {
+        maxUnusedFrames = std::max(1, frames);
+    }
+
+    int RenderTargetPool::getMaxUnusedFrames() {
+        return maxUnusedFrames;
+    }
+
+    int RenderTargetPool::getTargetCount() {
+        return (int)targets.size();
+    }
+
+    int RenderTargetPool::getDataSize() {
+        return dataSize;
+    }
+
+    void RenderTargetPool::clear() {
+        framebuffers.clear();
+        targets.clear();
+        dataSize = 0;
+    }
+}
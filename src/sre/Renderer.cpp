@@ -21,8 +21,11 @@ __declspec(dllexport) int AmdPowerXpressRequestHighPerformance = 1;
 #include "sre/Renderer.hpp"
 #include "sre/Framebuffer.hpp"
 #include "sre/Texture.hpp"
+#include "sre/Shader.hpp"
 
 #include "sre/impl/GL.hpp"
+#include "sre/impl/UniformBufferPool.hpp"
+#include <algorithm>
 
 #ifdef EMSCRIPTEN
 #include "emscripten.h"
@@ -135,8 +138,56 @@ namespace sre {
             glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 		}
         renderInfo_.supportFBODepthAttachment = !renderInfo_.graphicsAPIVersionES || renderInfo_.graphicsAPIVersionMajor>2;
+#ifndef EMSCRIPTEN
+        if ((renderInfo_.graphicsAPIVersionES && renderInfo_.graphicsAPIVersionMajor >= 3) ||
+            (!renderInfo_.graphicsAPIVersionES && (renderInfo_.graphicsAPIVersionMajor > 4 || (renderInfo_.graphicsAPIVersionMajor == 4 && renderInfo_.graphicsAPIVersionMinor >= 1))) ||
+            hasExtension("GL_ARB_get_program_binary")){
+            GLint programBinaryFormats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &programBinaryFormats);
+            renderInfo_.supportProgramBinary = programBinaryFormats > 0;
+        }
+#endif
+        renderInfo_.supportParallelShaderCompile = hasExtension("GL_KHR_parallel_shader_compile") ||
+                hasExtension("GL_ARB_parallel_shader_compile");
+        // Block compressed textures (formats which are not supported are decompressed on the CPU)
+        bool desktopGL = !renderInfo_.graphicsAPIVersionES;
+        int glVersion = renderInfo_.graphicsAPIVersionMajor * 10 + renderInfo_.graphicsAPIVersionMinor;
+        renderInfo_.supportTextureCompressionS3TC = hasExtension("GL_EXT_texture_compression_s3tc") ||
+                hasExtension("GL_WEBGL_compressed_texture_s3tc");
+        renderInfo_.supportTextureCompressionS3TCSRGB = renderInfo_.supportTextureCompressionS3TC && (desktopGL ||
+                hasExtension("GL_EXT_texture_compression_s3tc_srgb") || hasExtension("GL_WEBGL_compressed_texture_s3tc_srgb"));
+        renderInfo_.supportTextureCompressionRGTC = desktopGL || hasExtension("GL_EXT_texture_compression_rgtc");
+        renderInfo_.supportTextureCompressionBPTC = (desktopGL && glVersion >= 42) ||
+                hasExtension("GL_ARB_texture_compression_bptc") || hasExtension("GL_EXT_texture_compression_bptc");
+#ifdef EMSCRIPTEN
+        renderInfo_.supportTextureCompressionETC2 = hasExtension("GL_WEBGL_compressed_texture_etc");   // not part of WebGL 2
+#else
+        renderInfo_.supportTextureCompressionETC2 = (desktopGL ? glVersion >= 43 : glVersion >= 30) ||
+                hasExtension("GL_ARB_ES3_compatibility");
+#endif
+        renderInfo_.supportSamplerObjects = (desktopGL ? glVersion >= 33 : glVersion >= 30) || hasExtension("GL_ARB_sampler_objects");
+        if (hasExtension("GL_EXT_texture_filter_anisotropic") || hasExtension("GL_ARB_texture_filter_anisotropic") ||
+                (desktopGL && glVersion >= 46)){
+            glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &renderInfo_.maxAnisotropy);
+            renderInfo_.maxAnisotropy = std::max(1.0f, renderInfo_.maxAnisotropy);
+        }
+        if (desktopGL || glVersion >= 30){
+            glGetIntegerv(GL_MAX_SAMPLES, &renderInfo_.maxSamples);
+            renderInfo_.maxSamples = std::max(1, renderInfo_.maxSamples);
+        }
+#if defined(GL_VERSION_4_3) || defined(EMSCRIPTEN)
+        renderInfo_.supportInvalidateFramebuffer = desktopGL ? glVersion >= 43 || hasExtension("GL_ARB_invalidate_subdata") : glVersion >= 30;
+#endif
+#ifndef GL_ES_VERSION_2_0
+        renderInfo_.supportTimerQuery = desktopGL && (glVersion >= 33 || hasExtension("GL_ARB_timer_query"));
+#endif
+#ifdef GL_VERSION_4_3
+        renderInfo_.supportVertexAttribBinding = !renderInfo_.graphicsAPIVersionES &&
+                (renderInfo_.graphicsAPIVersionMajor > 4 || (renderInfo_.graphicsAPIVersionMajor == 4 && renderInfo_.graphicsAPIVersionMinor >= 3));
+#endif
 
         initGlobalUniformBuffer();
+        textureBindings.reset();
 
         // initialize ImGUI
         imGuiContext = ImGui::CreateContext();
@@ -150,21 +201,38 @@ namespace sre {
         ImGui_SRE_Shutdown();
         ImGui::DestroyContext(imGuiContext);
         glDeleteBuffers(1,&globalUniformBuffer);
+        materialUniformBuffers.clear();
+        renderTargetPool.clear();
+        samplers.clear();
+        Shader::clearSpecializationCache();
+        for (auto& vao : sharedVertexArrays){
+            glDeleteVertexArrays(1, &vao.second);
+        }
         SDL_GL_DeleteContext(glcontext);
         instance = nullptr;
     }
 
     void Renderer::swapWindow() {
+        Texture::updateAsyncLoads();
+        textureStreaming.update(renderStats);
+        renderTargetPool.update(renderStats);
         renderStatsLast = renderStats;
         renderStats.frame++;
         renderStats.meshBytesAllocated=0;
         renderStats.meshBytesDeallocated=0;
         renderStats.textureBytesAllocated=0;
         renderStats.textureBytesDeallocated=0;
+        renderStats.textureLevelsStreamed=0;
+        renderStats.textureLevelsEvicted=0;
+        renderStats.renderTargetPoolHits=0;
+        renderStats.renderTargetPoolMisses=0;
         renderStats.drawCalls=0;
+        renderStats.drawCallsSkipped=0;
         renderStats.stateChangesShader = 0;
         renderStats.stateChangesMesh = 0;
         renderStats.stateChangesMaterial = 0;
+        renderStats.uniformUploadsElided = 0;
+        renderStats.textureBindsAvoided = 0;
 #ifndef EMSCRIPTEN
         SDL_GL_SwapWindow(window);
 #endif
@@ -194,6 +262,10 @@ namespace sre {
         return maxSceneLights;
     }
 
+    RenderTargetPool& Renderer::getRenderTargetPool() {
+        return renderTargetPool;
+    }
+
     void Renderer::initGlobalUniformBuffer(){
         if (renderInfo_.graphicsAPIVersionMajor <= 2){
             globalUniformBuffer = 0;
@@ -206,4 +278,12 @@ namespace sre {
         glBufferData(GL_UNIFORM_BUFFER, globalUniformBufferSize, NULL, GL_STREAM_DRAW);
         glBindBuffer(GL_UNIFORM_BUFFER, 0);
     }
+
+    std::shared_ptr<UniformBufferPool> Renderer::getMaterialUniformBuffer(int blockSize) {
+        auto& pool = materialUniformBuffers[blockSize];
+        if (!pool){
+            pool = std::make_shared<UniformBufferPool>(blockSize);
+        }
+        return pool;
+    }
 }
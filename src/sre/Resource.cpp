@@ -10,6 +10,7 @@
 #include <sre/Resource.hpp>
 
 #include "sre/impl/ShaderSource.inl"
+#include "sre/impl/ShaderPreprocessor.hpp"
 
 using namespace std;
 using namespace sre;
@@ -48,10 +49,12 @@ std::string sre::Resource::loadText(std::string filename, ResourceType filter) {
 
 void sre::Resource::set(const std::string& name, const std::string& value) {
     memoryOnlyResources[name] = value;
+    ShaderPreprocessor::clearIncludeCache();
 }
 
 void Resource::reset() {
     memoryOnlyResources.clear();
+    ShaderPreprocessor::clearIncludeCache();
 }
 
 set<string> Resource::getKeys(ResourceType filter) {
@@ -14,11 +14,22 @@
 #include <glm/gtc/type_ptr.hpp>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/string_cast.hpp>
-#include <regex>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
 #include "sre/Log.hpp"
 #include "sre/Resource.hpp"
 #include "sre/Renderer.hpp"
+#include "sre/impl/ShaderPreprocessor.hpp"
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
 
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
 
 using namespace std;
 
@@ -33,67 +44,160 @@ namespace sre {
         std::shared_ptr<Shader> skybox;
         std::shared_ptr<Shader> skyboxProcedural;
         std::shared_ptr<Shader> blit;
+        std::shared_ptr<Shader> blitUpscale;
         std::shared_ptr<Shader> unlitSprite;
+        std::shared_ptr<Shader> unlitLine;
         std::shared_ptr<Shader> standardParticles;
 
         long globalShaderCounter = 1;
 
-        // From https://stackoverflow.com/a/8473603/420250
-        template <typename Map>
-        bool map_compare (Map const &lhs, Map const &rhs) {
-            // No predicate needed because there is operator== for pairs already.
-            return lhs.size() == rhs.size()
-                   && std::equal(lhs.begin(), lhs.end(),
-                                 rhs.begin());
+        int specializationCacheSize = 32;
+        std::list<std::shared_ptr<Shader>> specializationCache;     // most recently used specializations first
+
+        std::string programBinaryCacheDirectory;
+
+        struct UniformHandleRegistry {
+            std::unordered_map<std::string, int> handles;
+            std::vector<std::string> names;
+            UniformHandleRegistry(){
+                // must match the constants in sre::UniformHandles
+                for (auto name : {"color", "tex", "specularity", "metallicRoughness", "mrTex", "normalTex", "normalScale",
+                                  "emissiveTex", "emissiveFactor", "occlusionTex", "occlusionStrength"}){
+                    handles[name] = (int)names.size();
+                    names.emplace_back(name);
+                }
+            }
+        };
+
+        UniformHandleRegistry& uniformHandleRegistry(){
+            static UniformHandleRegistry registry;
+            return registry;
         }
 
-        template<typename Out>
-        void split(const std::string &s, char delim, Out result) {
-            std::stringstream ss(s);
-            std::string item;
-            while (std::getline(ss, item, delim)) {
-                *(result++) = item;
+        const char programBinaryMagic[4] = {'S','R','E','P'};
+        const uint32_t programBinaryVersion = 1;
+
+        // FNV-1a 64 bit
+        uint64_t hashString(const std::string& s, uint64_t hash = 14695981039346656037ULL){
+            for (auto c : s){
+                hash ^= (uint8_t)c;
+                hash *= 1099511628211ULL;
             }
+            return hash;
         }
 
-        std::vector<std::string> split(const std::string &s, char delim) {
-            std::vector<std::string> elems;
-            split(s, delim, std::back_inserter(elems));
-            return elems;
+        // Key of a program binary. Based on the preprocessed shader sources, the specialization constants and the driver
+        uint64_t programBinaryKey(const std::map<ShaderType,std::string>& preprocessedSources, const std::map<std::string,std::string>& specializationConstants){
+            uint64_t hash = hashString(renderInfo().graphicsAPIVendor);
+            hash = hashString(renderInfo().graphicsAPIVersion, hash);
+            for (auto& source : preprocessedSources){
+                hash = hashString(std::to_string((int)source.first), hash);
+                hash = hashString(source.second, hash);
+            }
+            for (auto& constant : specializationConstants){
+                hash = hashString(constant.first + "=" + constant.second, hash);
+            }
+            return hash;
         }
 
-        std::string pragmaInclude(std::string source, std::vector<std::string>& errors, uint32_t shaderType){
-            if (source.find("#pragma include")==-1) {
-                return source;
+        std::string programBinaryPath(uint64_t key){
+            char name[32];
+            snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+            return programBinaryCacheDirectory + "/" + name;
+        }
+
+        // File layout: magic, version, key, binary format, binary length, checksum of binary, binary
+        bool loadProgramBinary(GLuint program, uint64_t key){
+#ifndef EMSCRIPTEN
+            std::ifstream file(programBinaryPath(key), std::ios::binary);
+            if (!file){
+                return false;
+            }
+            char magic[4];
+            uint32_t version = 0, format = 0, length = 0;
+            uint64_t fileKey = 0, checksum = 0;
+            file.read(magic, sizeof(magic));
+            file.read((char*)&version, sizeof(version));
+            file.read((char*)&fileKey, sizeof(fileKey));
+            file.read((char*)&format, sizeof(format));
+            file.read((char*)&length, sizeof(length));
+            file.read((char*)&checksum, sizeof(checksum));
+            if (!file || memcmp(magic, programBinaryMagic, sizeof(magic)) != 0 || version != programBinaryVersion || fileKey != key || length == 0){
+                return false;
             }
-            std::stringstream sstream;
+            std::string binary(length, '\0');
+            file.read(&binary[0], length);
+            if (!file || hashString(binary) != checksum){
+                LOG_WARNING("Ignoring corrupt program binary %s", programBinaryPath(key).c_str());
+                return false;
+            }
+            glProgramBinary(program, format, binary.data(), length);
+            GLint linked = GL_FALSE;
+            glGetProgramiv(program, GL_LINK_STATUS, &linked);
+            return linked == GL_TRUE;       // fails if the driver does not accept the binary
+#else
+            return false;
+#endif
+        }
 
-            std::regex e ( R"_(#pragma\s+include\s+"([^"]*)")_", std::regex::ECMAScript);
-            int lineNumber = 0;
-            std::vector<std::string> lines = split(source, '\n');
-            int includes = 0;
-            for (auto& s : lines)
+        void saveProgramBinary(GLuint program, uint64_t key){
+#ifndef EMSCRIPTEN
+            GLint length = 0;
+            glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+            if (length <= 0){
+                return;
+            }
+            std::string binary((size_t)length, '\0');
+            GLenum format = 0;
+            glGetProgramBinary(program, length, &length, &format, &binary[0]);
+            binary.resize((size_t)length);
+            uint32_t formatValue = format;
+            uint32_t lengthValue = (uint32_t)length;
+            uint64_t checksum = hashString(binary);
+
+            // write to temporary file first, to avoid leaving partially written files in the cache
+            auto path = programBinaryPath(key);
+            auto tmpPath = path + ".tmp";
             {
-                lineNumber++;
-
-                std::smatch m;
-                if (std::regex_search (s,m,e)) {
-                    std::string match = m[1];
-                    auto res = Resource::loadText(match);
-                    if (res.empty()){
-                        errors.push_back(std::string("0:")+std::to_string(lineNumber)+" cannot find include file "+match+"##"+std::to_string(shaderType));
-                        sstream << s << "\n";
-                    } else {
-                        includes++;
-                        sstream << "#line "<<(includes*10000+1) <<"\n";
-                        sstream << res << "\n";
-                        sstream << "#line "<<lineNumber << "\n";
-                    }
-                } else {
-                    sstream << s << "\n";
+                std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+                file.write(programBinaryMagic, sizeof(programBinaryMagic));
+                file.write((const char*)&programBinaryVersion, sizeof(programBinaryVersion));
+                file.write((const char*)&key, sizeof(key));
+                file.write((const char*)&formatValue, sizeof(formatValue));
+                file.write((const char*)&lengthValue, sizeof(lengthValue));
+                file.write((const char*)&checksum, sizeof(checksum));
+                file.write(binary.data(), binary.size());
+                if (!file){
+                    LOG_WARNING("Cannot write program binary %s", tmpPath.c_str());
+                    return;
                 }
             }
-            return sstream.str();
+            std::remove(path.c_str());
+            if (std::rename(tmpPath.c_str(), path.c_str()) != 0){
+                std::remove(tmpPath.c_str());
+            }
+#endif
+        }
+
+        // Hash of the sorted specialization constants
+        uint64_t specializationKey(const std::map<std::string,std::string>& specializationConstants){
+            uint64_t hash = hashString("");
+            for (auto& sc : specializationConstants){
+                hash = hashString(sc.first, hash);
+                hash = hashString("=", hash);
+                hash = hashString(sc.second, hash);
+                hash = hashString("\n", hash);
+            }
+            return hash;
+        }
+
+        // From https://stackoverflow.com/a/8473603/420250
+        template <typename Map>
+        bool map_compare (Map const &lhs, Map const &rhs) {
+            // No predicate needed because there is operator== for pairs already.
+            return lhs.size() == rhs.size()
+                   && std::equal(lhs.begin(), lhs.end(),
+                                 rhs.begin());
         }
 
         void logCurrentCompileInfo(GLuint &shader, GLenum type, vector<string> &errors, const std::string& source, const std::string name, bool compileSuccess) {
@@ -138,12 +242,14 @@ namespace sre {
             }
         }
 
-        bool linkProgram(GLuint mShaderProgram, std::vector<std::string>& errors){
+        void startLinkProgram(GLuint mShaderProgram){
 #ifndef EMSCRIPTEN
             glBindFragDataLocation(mShaderProgram, 0, "fragColor");
 #endif
             glLinkProgram(mShaderProgram);
+        }
 
+        bool checkLinkProgram(GLuint mShaderProgram, std::vector<std::string>& errors){
             GLint  linked;
             glGetProgramiv(mShaderProgram, GL_LINK_STATUS, &linked );
             if (linked == GL_FALSE) {
@@ -159,6 +265,24 @@ namespace sre {
             }
             return true;
         }
+
+        GLuint startCompileShader(const std::string& source, GLenum type){
+            GLuint shader = glCreateShader(type);
+            auto stringPtr = source.c_str();
+            auto length = (GLint)source.size();
+            glShaderSource(shader, 1, &stringPtr, &length);
+            glCompileShader(shader);
+            return shader;
+        }
+
+        bool checkCompileShader(GLuint shader, GLenum type, std::vector<std::string>& errors, const std::string& source, const std::string& name){
+            GLint success = 0;
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+            logCurrentCompileInfo(shader, type, errors, source, name, success==1);
+
+            return success == 1;
+        }
     }
 
     const char *c_str(UniformType u) {
@@ -179,6 +303,8 @@ namespace sre {
                 return "texture";
             case UniformType::TextureCube:
                 return "textureCube";
+            case UniformType::TextureArray:
+                return "textureArray";
             case UniformType::Invalid:
             default:
                 return "invalid";
@@ -211,6 +337,11 @@ namespace sre {
         return *this;
     }
 
+    Shader::ShaderBuilder &Shader::ShaderBuilder::withAsyncCompile(bool enabled) {
+        this->asyncCompile = enabled;
+        return *this;
+    }
+
     Shader::ShaderBuilder &Shader::ShaderBuilder::withCullFace(CullFace face) {
         this->cullFace = face;
         return *this;
@@ -232,6 +363,7 @@ namespace sre {
             shader = std::shared_ptr<Shader>(new Shader());
             shader->specializationConstants = this->specializationConstants;
         }
+        shader->asyncCompile = this->asyncCompile;
         bool compileSuccess = shader->build(shaderSources, errors);
         if (!compileSuccess){
             if (!updateShader) {
@@ -249,6 +381,9 @@ namespace sre {
         shader->stencil = stencil;
         shader->colorWrite = colorWrite;
         shader->cullFace = cullFace;
+        if (updateShader){
+            shader->clearSpecializations();                 // specializations are rebuilt from the updated sources when requested
+        }
         return std::shared_ptr<Shader>(shader);
     }
 
@@ -278,79 +413,8 @@ namespace sre {
     }
 
     std::string Shader::translateToGLSLES(std::string source, bool vertexShader, int version) {
-        using namespace std;
-        string replace = "#version 330";
-        string replaceWith = string("#version ")+std::to_string(version);
-        if (version >100){
-            replaceWith += " es";
-        }
-
-        size_t f = source.find(replace);
-        if (f != std::string::npos){
-            source = source.replace(f, replace.length(), replaceWith);
-        }
-        if (!vertexShader){
-            auto extension = source.rfind("#extension");
-            // insert precision after extensions
-	    string::size_type insertPrecisionPos = string::npos;
-            if (extension != string::npos){
-                insertPrecisionPos = source.find('\n',extension);
-            } else {
-                insertPrecisionPos = source.find('\n');
-            }
-            if (insertPrecisionPos == string::npos){
-                LOG_ERROR("insertPrecisionPos invalid");
-                insertPrecisionPos = 0;
-            }
-            source = source.substr(0, insertPrecisionPos)+
-                     "\n"
-                     "#ifdef GL_FRAGMENT_PRECISION_HIGH    \n"
-                     "   precision highp float;            \n"
-                     "   precision highp int;            \n"
-                     "   precision highp int;            \n"
-                     "#else                                \n"
-                     "   precision mediump float;          \n"
-                     "   precision mediump int;          \n"
-                     "#endif                               \n"
-                     "#line 2"+
-                     source.substr(insertPrecisionPos);
-        }
-        if (version == 100){
-            // replace textures
-            if (vertexShader){
-                regex regExpSearchShim3 { R"(\n\s*out\b)"};
-                source = regex_replace(source, regExpSearchShim3, "\nvarying");
-                regex regExpSearchShim4 { R"(\n\s*in\b)"};
-                source = regex_replace(source, regExpSearchShim4, "\nattribute");
-            } else {
-                regex regExpSearchShim2 { R"(\bfragColor\b)"};
-                source = regex_replace(source, regExpSearchShim2, "gl_FragColor");
-                regex regExpSearchShim3 { R"(\n\s*out\b)"};
-                source = regex_replace(source, regExpSearchShim3, "\n// out");
-                regex regExpSearchShim4 { R"(\n\s*in\b)"};
-                source = regex_replace(source, regExpSearchShim4, "\nvarying");
-            }
-
-            regex regExpSearchShim1 { R"(\s*uniform\s+sampler([\w]*)\s+([\w_]*)\s*;.*)"};
-            istringstream iss(source);
-            map<string,string> textureType;
-            smatch match;
-            for (std::string line; std::getline(iss, line); )
-            {
-                regex_search(line, match, regExpSearchShim1);
-                if (!match.empty()){
-                    string samplerType = match[1].str();
-                    string samplerName = match[2].str();
-                    textureType[samplerName] = samplerType;
-                }
-            }
-
-            for (auto val : textureType){
-                regex regExpSearchShim4 { string{R"(texture\s*\(\s*)"}+val.first+"\\s*," };
-                source = regex_replace(source, regExpSearchShim4, string{"texture"}+val.second+"("+val.first+",");
-            }
-        }
-        return source;
+        std::vector<std::string> errors;
+        return ShaderPreprocessor::process(source, "", vertexShader ? GL_VERTEX_SHADER : GL_FRAGMENT_SHADER, version, errors);
     }
 
     void Shader::updateUniformsAndAttributes() {
@@ -365,6 +429,20 @@ namespace sre {
         uniformLocationLightColorRange = -1;
         uniformLocationCameraPosition = -1;
         uniforms = std::make_shared<std::vector<Uniform>>();
+        uniformIndexByHandle.clear();
+        uniformShadow.clear();
+        materialBlockSize = 0;
+        materialBlockMembers.clear();
+        materialBlockHasArrays = false;
+
+        // uniform buffer objects are not supported on OpenGL ES 2.0 / WebGL 1.0
+        GLuint materialBlockIndex = GL_INVALID_INDEX;
+        if (renderInfo().graphicsAPIVersionMajor > 2) {
+            materialBlockIndex = glGetUniformBlockIndex(shaderProgramId, "material");
+            if (materialBlockIndex != GL_INVALID_INDEX){
+                glGetActiveUniformBlockiv(shaderProgramId, materialBlockIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &materialBlockSize);
+            }
+        }
 
         bool hasGlobalUniformBuffer = false;
         if (Renderer::instance->globalUniformBuffer) {
@@ -374,6 +452,7 @@ namespace sre {
         GLint uniformCount;
         glGetProgramiv(shaderProgramId,GL_ACTIVE_UNIFORMS,&uniformCount);
         UniformType uniformType = UniformType::Invalid;
+        int textureUnitCount = 0;
         for (int i=0;i<uniformCount;i++){
             const int nameSize = 50;
             GLchar name[nameSize];
@@ -420,6 +499,9 @@ namespace sre {
                 case GL_SAMPLER_CUBE:
                     uniformType = UniformType::TextureCube;
                     break;
+                case GL_SAMPLER_2D_ARRAY:
+                    uniformType = UniformType::TextureArray;
+                    break;
                 default:
                 LOG_ERROR("Unsupported shader type %s name %s",type,name);
             }
@@ -430,13 +512,42 @@ namespace sre {
             }
             bool isGlobalUniform = name[0] == 'g' && name[1] == '_';
             GLint location = glGetUniformLocation(shaderProgramId, name);
+            if (materialBlockIndex != GL_INVALID_INDEX){
+                GLuint uniformIndex = (GLuint)i;
+                GLint blockIndex = -1;
+                glGetActiveUniformsiv(shaderProgramId, 1, &uniformIndex, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+                if (blockIndex == (GLint)materialBlockIndex){
+                    MaterialBlockMember member;
+                    member.type = uniformType;
+                    member.arraySize = size;
+                    glGetActiveUniformsiv(shaderProgramId, 1, &uniformIndex, GL_UNIFORM_OFFSET, &member.offset);
+                    glGetActiveUniformsiv(shaderProgramId, 1, &uniformIndex, GL_UNIFORM_ARRAY_STRIDE, &member.arrayStride);
+                    glGetActiveUniformsiv(shaderProgramId, 1, &uniformIndex, GL_UNIFORM_MATRIX_STRIDE, &member.matrixStride);
+                    member.id = materialBlockUniformId(member.offset);
+                    materialBlockMembers.push_back(member);
+                    materialBlockHasArrays |= uniformType == UniformType::Mat3Array || uniformType == UniformType::Mat4Array;
+                    location = member.id;
+                }
+            }
             if (!isGlobalUniform){
                 Uniform u;
                 u.name = name;
                 u.id = location;
                 u.arraySize = size;
                 u.type = uniformType;
+                int handle = getUniformHandle(u.name);
+                if (handle >= (int)uniformIndexByHandle.size()){
+                    uniformIndexByHandle.resize(handle+1, -1);
+                }
+                uniformIndexByHandle[handle] = (int)uniforms->size();
                 uniforms->push_back(u);
+                bool isSampler = uniformType == UniformType::Texture || uniformType == UniformType::TextureCube || uniformType == UniformType::TextureArray;
+                if (isSampler && location >= 0){
+                    if (location >= (int)uniformShadow.textureUnitByLocation.size()){
+                        uniformShadow.textureUnitByLocation.resize(location + 1, -1);
+                    }
+                    uniformShadow.textureUnitByLocation[location] = textureUnitCount++;
+                }
             } else {
                 if (Renderer::instance->globalUniformBuffer){
                     if (strncmp(name, "g_model_it",64)!=0 &&
@@ -522,6 +633,20 @@ namespace sre {
             }
         }
 
+        // sampler to texture unit assignments are fixed, so glUniform1i is only needed here
+        if (textureUnitCount > 0){
+            GLint previousProgram;
+            glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+            glUseProgram(shaderProgramId);
+            for (int location = 0; location < (int)uniformShadow.textureUnitByLocation.size(); location++){
+                int unit = uniformShadow.textureUnitByLocation[location];
+                if (unit >= 0){
+                    glUniform1i(location, unit);
+                }
+            }
+            glUseProgram((GLuint)previousProgram);
+        }
+
         // update attributes
         attributes.clear();
         GLint attributeCount;
@@ -560,6 +685,9 @@ namespace sre {
             r->renderStats.shaderCount--;
 
             r->shaders.erase(std::remove(r->shaders.begin(), r->shaders.end(), this));
+            if (pendingBuild){
+                cancelPendingBuild();
+            }
 
             glDeleteShader(shaderProgramId);
         }
@@ -697,6 +825,20 @@ namespace sre {
 
 
 
+    std::shared_ptr<Shader> Shader::getUnlitLine() {
+        if (unlitLine != nullptr){
+            return unlitLine;
+        }
+
+        unlitLine = create()
+                .withSourceResource("line_vert.glsl", ShaderType::Vertex)
+                .withSourceResource("line_frag.glsl", ShaderType::Fragment)
+                .withCullFace(CullFace::None)
+                .withName("Unlit Line")
+                .build();
+        return unlitLine;
+    }
+
     std::shared_ptr<Shader> Shader::getSkybox() {
         if (skybox != nullptr){
             return skybox;
@@ -756,6 +898,19 @@ namespace sre {
         return blit;
     }
 
+    std::shared_ptr<Shader> Shader::getBlitUpscale() {
+        if (blitUpscale != nullptr){
+            return blitUpscale;
+        }
+
+        blitUpscale = create()
+                .withSourceResource("blit_vert.glsl", ShaderType::Vertex)
+                .withSourceResource("blit_upscale_frag.glsl", ShaderType::Fragment)
+                .withName("Blit Upscale")
+                .build();
+        return blitUpscale;
+    }
+
     std::shared_ptr<Shader> Shader::getUnlitSprite() {
         if (unlitSprite != nullptr){
             return unlitSprite;
@@ -784,10 +939,11 @@ namespace sre {
     }
 
     Uniform Shader::getUniform(const std::string &name) {
-		for (auto& uniform : *uniforms) {
-			if (uniform.name == name)
-				return uniform;
-		}
+        auto& registry = uniformHandleRegistry();
+        auto res = registry.handles.find(name);
+        if (res != registry.handles.end()){
+            return getUniform(res->second);
+        }
 		Uniform u;
 		u.type = UniformType::Invalid;
 		u.id = -1;
@@ -795,6 +951,41 @@ namespace sre {
 		return u;
     }
 
+    Uniform Shader::getUniform(int uniformHandle) {
+        if (uniformHandle >= 0 && uniformHandle < (int)uniformIndexByHandle.size()){
+            int index = uniformIndexByHandle[uniformHandle];
+            if (index != -1){
+                return (*uniforms)[index];
+            }
+        }
+        Uniform u;
+        u.type = UniformType::Invalid;
+        u.id = -1;
+        u.arraySize = -1;
+        return u;
+    }
+
+    int Shader::getUniformHandle(const std::string &name) {
+        auto& registry = uniformHandleRegistry();
+        auto res = registry.handles.find(name);
+        if (res != registry.handles.end()){
+            return res->second;
+        }
+        int handle = (int)registry.names.size();
+        registry.handles[name] = handle;
+        registry.names.push_back(name);
+        return handle;
+    }
+
+    const std::string& Shader::getUniformName(int uniformHandle) {
+        auto& registry = uniformHandleRegistry();
+        if (uniformHandle < 0 || uniformHandle >= (int)registry.names.size()){
+            static std::string empty;
+            return empty;
+        }
+        return registry.names[uniformHandle];
+    }
+
     // The particle size used in this shader depends on the height of the screensize (to make the particles resolution independent):
     // for perspective projection, the size of particles are defined in screenspace size at the distance of 1.0 on a viewport of height 600.
     // for orthographic projection, the size of particles are defined in screenspace size on a viewport of height 600.
@@ -813,11 +1004,36 @@ namespace sre {
         return standardParticles;
     }
 
+    void Shader::setProgramBinaryCacheDirectory(const std::string& directory) {
+        programBinaryCacheDirectory = directory;
+        if (!directory.empty()){
+            // create directory if missing (parent directory must exist)
+#ifdef _WIN32
+            _mkdir(directory.c_str());
+#else
+            mkdir(directory.c_str(), 0755);
+#endif
+        }
+    }
+
+    const std::string& Shader::getProgramBinaryCacheDirectory() {
+        return programBinaryCacheDirectory;
+    }
+
     Shader::ShaderBuilder Shader::create() {
         return Shader::ShaderBuilder();
     }
 
     bool Shader::build(std::map<ShaderType,std::string> shaderSources, std::vector<std::string>& errors) {
+        auto startTime = std::chrono::high_resolution_clock::now();
+        RenderStats& renderStats = Renderer::instance->renderStats;
+        auto addBuildTime = [&](){
+            auto endTime = std::chrono::high_resolution_clock::now();
+            renderStats.shaderBuildTime += std::chrono::duration<float, std::milli>(endTime - startTime).count();
+        };
+        if (pendingBuild){
+            cancelPendingBuild();
+        }
         unsigned int oldShaderProgramId = shaderProgramId;
         shaderProgramId = glCreateProgram();
         assert(shaderProgramId != 0);
@@ -829,31 +1045,88 @@ namespace sre {
             }
         };
 
-        for (ShaderType i=ShaderType::Vertex;i<ShaderType::NumberOfShaderTypes;i = (ShaderType )((int)i+1)) {
-            auto shaderSourcesIter = shaderSources.find(i);
-            if (shaderSourcesIter!=shaderSources.end()) {
-                GLuint s;
-                GLenum shader = to_id(i);
-                bool res = compileShader(shaderSourcesIter->second, shader, s, errors);
-                if (!res) {
-                    cleanupShaders();
-                    glDeleteProgram( shaderProgramId );
-                    shaderProgramId = oldShaderProgramId;
-                    return false;
-                } else {
+        std::map<ShaderType,std::string> preprocessedSources;
+        for (auto& shaderSource : shaderSources) {
+            preprocessedSources[shaderSource.first] = precompile(Resource::loadText(shaderSource.second), errors, to_id(shaderSource.first));
+        }
+
+        bool useProgramBinaryCache = !programBinaryCacheDirectory.empty() && renderInfo().supportProgramBinary;
+        uint64_t programBinaryCacheKey = 0;
+        bool linked = false;
+        if (useProgramBinaryCache){
+            programBinaryCacheKey = programBinaryKey(preprocessedSources, specializationConstants);
+            linked = loadProgramBinary(shaderProgramId, programBinaryCacheKey);
+            if (linked){
+                renderStats.shaderBinaryCacheHits++;
+            } else {
+                // fall back to compiling (using a new program object, since the binary may have been rejected)
+                renderStats.shaderBinaryCacheMisses++;
+                glDeleteProgram( shaderProgramId );
+                shaderProgramId = glCreateProgram();
+            }
+        }
+
+        if (!linked){
+            for (ShaderType i=ShaderType::Vertex;i<ShaderType::NumberOfShaderTypes;i = (ShaderType )((int)i+1)) {
+                auto shaderSourcesIter = preprocessedSources.find(i);
+                if (shaderSourcesIter!=preprocessedSources.end()) {
+                    GLenum shaderType = to_id(i);
+                    GLuint s = startCompileShader(shaderSourcesIter->second, shaderType);
                     shaders.push_back(s);
+                    // async builds check the compile status when the program is linked (see isReady())
+                    if (!asyncCompile && !checkCompileShader(s, shaderType, errors, shaderSourcesIter->second, shaderSources[i])) {
+                        cleanupShaders();
+                        glDeleteProgram( shaderProgramId );
+                        shaderProgramId = oldShaderProgramId;
+                        addBuildTime();
+                        return false;
+                    }
+                    glAttachShader(shaderProgramId,  s);
                 }
-                glAttachShader(shaderProgramId,  s);
             }
-        }
+#ifndef EMSCRIPTEN
+            if (useProgramBinaryCache){
+                glProgramParameteri(shaderProgramId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            }
+#endif
+            startLinkProgram(shaderProgramId);
+
+            if (asyncCompile){
+                // keep using the old program (if any) until the new program is linked
+                pendingBuild.reset(new PendingBuild());
+                pendingBuild->programId = shaderProgramId;
+                pendingBuild->shaders = shaders;
+                pendingBuild->shaderSources = shaderSources;
+                pendingBuild->preprocessedSources = std::move(preprocessedSources);
+                pendingBuild->programBinaryKey = programBinaryCacheKey;
+                pendingBuild->saveProgramBinary = useProgramBinaryCache;
+                pendingBuild->frame = renderStats.frame;
+                shaderProgramId = oldShaderProgramId;
+                if (!uniforms){
+                    uniforms = std::make_shared<std::vector<Uniform>>();
+                }
+                addBuildTime();
+                return true;
+            }
 
-        bool linked = linkProgram(shaderProgramId, errors);
-        cleanupShaders();
-        if (!linked) {
-            glDeleteProgram( shaderProgramId );
-            shaderProgramId = oldShaderProgramId; // revert to old shader
-            return false;
+            linked = checkLinkProgram(shaderProgramId, errors);
+            cleanupShaders();
+            if (!linked) {
+                glDeleteProgram( shaderProgramId );
+                shaderProgramId = oldShaderProgramId; // revert to old shader
+                addBuildTime();
+                return false;
+            }
+            if (useProgramBinaryCache){
+                saveProgramBinary(shaderProgramId, programBinaryCacheKey);
+            }
         }
+        setupProgram(oldShaderProgramId);
+        addBuildTime();
+        return true;
+    }
+
+    void Shader::setupProgram(unsigned int oldShaderProgramId) {
         if (oldShaderProgramId != 0){
             glDeleteProgram( oldShaderProgramId ); // delete old shader if any
         }
@@ -862,7 +1135,7 @@ namespace sre {
             glUseProgram(shaderProgramId);
             auto index = glGetUniformBlockIndex(shaderProgramId, "g_global_uniforms");
             if (index != GL_INVALID_INDEX){
-                const int globalUniformBindingIndex = 1;
+                const int globalUniformBindingIndex = Renderer::globalUniformBindingIndex;
                 glUniformBlockBinding(shaderProgramId, index, globalUniformBindingIndex);
                 glBindBufferRange(GL_UNIFORM_BUFFER, globalUniformBindingIndex,
                                   Renderer::instance->globalUniformBuffer, 0, Renderer::instance->globalUniformBufferSize);
@@ -870,7 +1143,91 @@ namespace sre {
         }
 
         updateUniformsAndAttributes();
-        return true;
+
+        if (materialBlockSize > 0){
+            auto index = glGetUniformBlockIndex(shaderProgramId, "material");
+            glUniformBlockBinding(shaderProgramId, index, Renderer::materialUniformBindingIndex);
+        }
+    }
+
+    int Shader::materialBlockUniformId(int offset) {
+        return -(1<<20) - offset;
+    }
+
+    bool Shader::isMaterialBlockUniformId(int id) {
+        return id <= -(1<<20);
+    }
+
+    bool Shader::isReady() {
+        if (pendingBuild){
+            if (renderInfo().supportParallelShaderCompile){
+                GLint completed = GL_FALSE;
+                glGetProgramiv(pendingBuild->programId, GL_COMPLETION_STATUS_KHR, &completed);
+                if (completed == GL_FALSE){
+                    return shaderProgramId != 0;
+                }
+            } else if (Renderer::instance->renderStats.frame == pendingBuild->frame){
+                // without parallel shader compile the status query blocks until the program is linked. Give the driver
+                // until next frame to complete the work.
+                return shaderProgramId != 0;
+            }
+            finishPendingBuild();
+        }
+        return shaderProgramId != 0;
+    }
+
+    void Shader::finishPendingBuild() {
+        auto startTime = std::chrono::high_resolution_clock::now();
+        std::vector<std::string> errors;
+        bool success = true;
+        int index = 0;
+        for (auto& source : pendingBuild->preprocessedSources){
+            success = checkCompileShader(pendingBuild->shaders[index], to_id(source.first), errors, source.second, pendingBuild->shaderSources[source.first]) && success;
+            index++;
+        }
+        success = success && checkLinkProgram(pendingBuild->programId, errors);
+        for (auto id : pendingBuild->shaders){
+            glDeleteShader(id);
+        }
+        if (success){
+            auto oldShaderProgramId = shaderProgramId;
+            shaderProgramId = pendingBuild->programId;
+            shaderUniqueId = globalShaderCounter++;          // invalidate vertex array objects created for the old program
+            if (pendingBuild->saveProgramBinary){
+                saveProgramBinary(shaderProgramId, pendingBuild->programBinaryKey);
+            }
+            setupProgram(oldShaderProgramId);
+        } else {
+            LOG_ERROR("Cannot build shader %s", name.c_str());
+            glDeleteProgram(pendingBuild->programId);
+        }
+        pendingBuild.reset();
+        auto endTime = std::chrono::high_resolution_clock::now();
+        Renderer::instance->renderStats.shaderBuildTime += std::chrono::duration<float, std::milli>(endTime - startTime).count();
+    }
+
+    void Shader::cancelPendingBuild() {
+        for (auto id : pendingBuild->shaders){
+            glDeleteShader(id);
+        }
+        glDeleteProgram(pendingBuild->programId);
+        pendingBuild.reset();
+    }
+
+    std::vector<std::shared_ptr<Shader>> Shader::warmup(const std::vector<std::map<std::string,std::string>>& specializations) {
+        if (parent){
+            return parent->warmup(specializations);
+        }
+        std::vector<std::shared_ptr<Shader>> res;
+        for (auto& constants : specializations){
+            if (constants.empty()){
+                res.push_back(shared_from_this());
+            } else {
+                // compile all variants in parallel (when supported by the driver)
+                res.push_back(getSpecialization(constants, true));
+            }
+        }
+        return res;
     }
 
     std::vector<std::string> Shader::getAttributeNames() {
@@ -920,54 +1277,103 @@ namespace sre {
             return parent->createMaterial(std::move(specializationConstants));
         }
         if (!specializationConstants.empty()){
-            for (auto & s : specializations){
-                if (auto ptr = s.lock()){
-                    if (map_compare(specializationConstants, ptr->specializationConstants)){
-                        return std::shared_ptr<Material>(new Material(ptr));
-                    }
-                }
-            }
-            // no specialization shader found
-            auto res =  Shader::ShaderBuilder();
-            res.depthTest = this->depthTest;
-            res.depthWrite = this->depthWrite;
-            res.blend = this->blend;
-            res.name = this->name;
-            res.offset = this->offset;
-            bool isTwoSided = specializationConstants.find("S_TWO_SIDED") != specializationConstants.end();
-            res.cullFace = isTwoSided ? CullFace::None :this->cullFace;
-            res.shaderSources = this->shaderSources;
-            res.specializationConstants = specializationConstants;
-            auto specializedShader = res.build();
+            auto specializedShader = getSpecialization(specializationConstants, asyncCompile);
             if (specializedShader == nullptr){
                 LOG_WARNING("Cannot create specialized shader. Using shader without specialization.");
                 return std::shared_ptr<Material>(new Material(shared_from_this()));
             }
-            specializedShader->parent = shared_from_this();
-            specializations.push_back(std::weak_ptr<Shader>(specializedShader));
             return std::shared_ptr<Material>(new Material(specializedShader));
         }
         return std::shared_ptr<Material>(new Material(shared_from_this()));
     }
 
-    const std::string& Shader::getName() {
-        return name;
+    std::shared_ptr<Shader> Shader::getSpecialization(const std::map<std::string,std::string>& specializationConstants, bool async) {
+        uint64_t key = specializationKey(specializationConstants);
+        auto existing = specializations.find(key);
+        if (existing != specializations.end()){
+            auto ptr = existing->second.lock();
+            if (ptr && map_compare(specializationConstants, ptr->specializationConstants)){
+                cacheSpecialization(ptr);
+                return ptr;
+            }
+        }
+        // no specialization shader found
+        auto res =  Shader::ShaderBuilder();
+        res.depthTest = this->depthTest;
+        res.depthWrite = this->depthWrite;
+        res.blend = this->blend;
+        res.name = this->name;
+        res.offset = this->offset;
+        bool isTwoSided = specializationConstants.find("S_TWO_SIDED") != specializationConstants.end();
+        res.cullFace = isTwoSided ? CullFace::None :this->cullFace;
+        res.shaderSources = this->shaderSources;
+        res.specializationConstants = specializationConstants;
+        res.asyncCompile = async;
+        auto specializedShader = res.build();
+        if (specializedShader == nullptr){
+            return nullptr;
+        }
+        specializedShader->asyncCompile = asyncCompile;
+        specializedShader->parent = shared_from_this();
+        specializations[key] = std::weak_ptr<Shader>(specializedShader);
+        cacheSpecialization(specializedShader);
+        return specializedShader;
     }
 
-    bool Shader::compileShader(std::string& resource, GLenum type, GLuint& shader, std::vector<std::string>& errors){
-        auto source = Resource::loadText(resource);
-        std::string source_ = precompile(source, errors, type);
-        shader = glCreateShader(type);
-        auto stringPtr = source_.c_str();
-        auto length = (GLint)strlen(stringPtr);
-        glShaderSource(shader, 1, &stringPtr, &length);
-        glCompileShader(shader);
-        GLint success = 0;
-        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    void Shader::cacheSpecialization(const std::shared_ptr<Shader>& shader) {
+        if (specializationCacheSize <= 0){
+            return;
+        }
+        if (shader->inSpecializationCache){
+            // move to front (most recently used)
+            specializationCache.splice(specializationCache.begin(), specializationCache, shader->specializationCacheEntry);
+        } else {
+            specializationCache.push_front(shader);
+            shader->specializationCacheEntry = specializationCache.begin();
+            shader->inSpecializationCache = true;
+        }
+        trimSpecializationCache();
+    }
+
+    void Shader::trimSpecializationCache() {
+        while ((int)specializationCache.size() > std::max(specializationCacheSize, 0)){
+            auto shader = specializationCache.back();       // may be the last reference
+            shader->inSpecializationCache = false;
+            specializationCache.pop_back();
+        }
+    }
+
+    void Shader::clearSpecializations() {
+        for (auto& s : specializations){
+            if (auto ptr = s.second.lock()){
+                if (ptr->inSpecializationCache){
+                    ptr->inSpecializationCache = false;
+                    specializationCache.erase(ptr->specializationCacheEntry);
+                }
+            }
+        }
+        specializations.clear();
+    }
+
+    void Shader::clearSpecializationCache() {
+        std::list<std::shared_ptr<Shader>> cache;
+        cache.swap(specializationCache);                    // shaders are released after the cache is emptied
+        for (auto& shader : cache){
+            shader->inSpecializationCache = false;
+        }
+    }
 
-        logCurrentCompileInfo(shader, type, errors, source_, resource, success==1);
+    void Shader::setSpecializationCacheSize(int size) {
+        specializationCacheSize = size;
+        trimSpecializationCache();
+    }
 
-        return success == 1;
+    int Shader::getSpecializationCacheSize() {
+        return specializationCacheSize;
+    }
+
+    const std::string& Shader::getName() {
+        return name;
     }
 
     std::pair<int, int> Shader::getAttibuteType(const std::string &name) {
@@ -980,20 +1386,16 @@ namespace sre {
     }
 
     std::string Shader::precompile(std::string source, std::vector<std::string>& errors, uint32_t shaderType) {
-        // Replace includes with content
-        // for each occurrence of #pragma include replace with substitute
-        source = pragmaInclude(source, errors, shaderType);
-
-        // Insert preprocessor define symbols
-        source = insertPreprocessorDefines(source, specializationConstants, shaderType);
-
+        int esVersion = 0;
         if (renderInfo().graphicsAPIVersionES) {
-            source = Shader::translateToGLSLES(source, shaderType == GL_VERTEX_SHADER, renderInfo().graphicsAPIVersionMajor<=2?100:300);
+            esVersion = renderInfo().graphicsAPIVersionMajor<=2?100:300;
         }
-        return source;
+        // Replace includes with content, insert preprocessor define symbols and translate to GLSL ES (single pass)
+        return ShaderPreprocessor::process(source, getPreprocessorDefines(specializationConstants, shaderType), shaderType, esVersion, errors);
     }
 
     Shader::ShaderBuilder Shader::update() {
+        ShaderPreprocessor::clearIncludeCache();            // reload include files
         auto res =  Shader::ShaderBuilder(this);
         res.depthTest = this->depthTest;
         res.depthWrite = this->depthWrite;
@@ -1001,6 +1403,7 @@ namespace sre {
         res.name = this->name;
         res.offset = this->offset;
         res.shaderSources = this->shaderSources;
+        res.asyncCompile = this->asyncCompile;
         return res;
     }
 
@@ -1012,16 +1415,10 @@ namespace sre {
         if (parent){
             return parent->getAllSpecializationConstants();
         }
-        static std::regex SPECIALIZATION_CONSTANT_PATTERN("(S_[A-Z_0-9]+)");
         std::set<string> res;
         for (auto& source : shaderSources){
-            string s = Resource::loadText(source.second);
-            std::smatch m;
-            while (std::regex_search(s, m, SPECIALIZATION_CONSTANT_PATTERN)) {
-                std::string match = m.str();
-                res.insert(match);
-                s = m.suffix();
-            }
+            auto constants = ShaderPreprocessor::findSpecializationConstants(Resource::loadText(source.second));
+            res.insert(constants.begin(), constants.end());
         }
         return res;
     }
@@ -1054,9 +1451,8 @@ namespace sre {
     {
     }
 
-    std::string Shader::insertPreprocessorDefines(std::string source,
-                                          std::map<std::string, std::string> &specializationConstants,
-                                          uint32_t shaderType){
+    std::string Shader::getPreprocessorDefines(const std::map<std::string, std::string> &specializationConstants,
+                                               uint32_t shaderType){
         stringstream ss;
 
         ss<<"#define SI_LIGHTS "<<Renderer::instance->maxSceneLights<<"\n";
@@ -1097,25 +1493,7 @@ namespace sre {
             ss<<"#define SI_FBO_DEPTH_ATTACHMENT 1\n";
         }
 
-        // If the shader contains any #version or #extension statements, the defines are added after them.
-        auto version = static_cast<int>(source.rfind("#version"));
-        auto extension = static_cast<int>(source.rfind("#extension"));
-        auto last = std::max(version, extension);
-        if (last == -1){
-            ss << "#line 1\n";
-            return ss.str()+source;
-        }
-        auto insertPos = source.find('\n', last);
-        int lines = 0;
-        for (int i=0;i<insertPos;i++){
-            if (source.at(i) == '\n'){
-                lines++;
-            }
-        }
-        ss << "#line "<<(lines+1)<<"\n";
-        return source.substr(0, insertPos+1) +
-               ss.str()+
-               source.substr(insertPos+1);
+        return ss.str();
     }
 
     Stencil Shader::getStencil() {
@@ -0,0 +1,503 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/SpatialIndex.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include "sre/Mesh.hpp"
+#include "sre/Log.hpp"
+
+namespace sre {
+    namespace {
+        const float inf = std::numeric_limits<float>::max();
+
+        float surfaceArea(const glm::vec3& bmin, const glm::vec3& bmax){
+            glm::vec3 e = bmax - bmin;
+            return e.x*e.y + e.y*e.z + e.z*e.x;
+        }
+
+        bool contains(const glm::vec3& outerMin, const glm::vec3& outerMax, const glm::vec3& innerMin, const glm::vec3& innerMax){
+            return glm::all(glm::lessThanEqual(outerMin, innerMin)) && glm::all(glm::lessThanEqual(innerMax, outerMax));
+        }
+
+        bool overlaps(const glm::vec3& aMin, const glm::vec3& aMax, const glm::vec3& bMin, const glm::vec3& bMax){
+            return glm::all(glm::lessThanEqual(aMin, bMax)) && glm::all(glm::lessThanEqual(bMin, aMax));
+        }
+
+        bool intersectsRay(const glm::vec3& bmin, const glm::vec3& bmax, const glm::vec3& origin, const glm::vec3& invDir, float maxDistance){
+            glm::vec3 t0 = (bmin - origin) * invDir;
+            glm::vec3 t1 = (bmax - origin) * invDir;
+            glm::vec3 tmin = glm::min(t0, t1);
+            glm::vec3 tmax = glm::max(t0, t1);
+            float tnear = std::max(std::max(tmin.x, tmin.y), std::max(tmin.z, 0.0f));
+            float tfar = std::min(std::min(tmax.x, tmax.y), std::min(tmax.z, maxDistance));
+            return tnear <= tfar;
+        }
+
+        enum class FrustumTest {
+            Outside,
+            Intersecting,
+            Inside
+        };
+
+        FrustumTest testFrustum(const glm::vec4* planes, const glm::vec3& bmin, const glm::vec3& bmax){
+            FrustumTest res = FrustumTest::Inside;
+            for (int i = 0; i < 6; i++){
+                glm::vec3 n(planes[i]);
+                glm::vec3 positive(n.x >= 0 ? bmax.x : bmin.x, n.y >= 0 ? bmax.y : bmin.y, n.z >= 0 ? bmax.z : bmin.z);
+                if (glm::dot(n, positive) + planes[i].w < 0){
+                    return FrustumTest::Outside;
+                }
+                glm::vec3 negative(n.x >= 0 ? bmin.x : bmax.x, n.y >= 0 ? bmin.y : bmax.y, n.z >= 0 ? bmin.z : bmax.z);
+                if (glm::dot(n, negative) + planes[i].w < 0){
+                    res = FrustumTest::Intersecting;
+                }
+            }
+            return res;
+        }
+    }
+
+    SpatialIndex::SpatialIndex(float margin)
+    :margin(margin)
+    {
+    }
+
+    int SpatialIndex::allocateNode() {
+        if (freeList == -1){
+            nodes.emplace_back();
+            return (int)nodes.size() - 1;
+        }
+        int node = freeList;
+        freeList = nodes[node].parent;
+        nodes[node] = Node();
+        return node;
+    }
+
+    void SpatialIndex::freeNode(int node) {
+        nodes[node].parent = freeList;
+        nodes[node].height = -1;
+        nodes[node].instance = -1;
+        freeList = node;
+    }
+
+    int SpatialIndex::insert(std::shared_ptr<Mesh> mesh, const glm::mat4& transform, std::vector<std::shared_ptr<Material>> materials, void* payload) {
+        int id;
+        if (freeInstances.empty()){
+            id = (int)instances.size();
+            instances.emplace_back();
+        } else {
+            id = freeInstances.back();
+            freeInstances.pop_back();
+        }
+        instances[id].instance = {std::move(mesh), transform, std::move(materials), payload};
+        updateBounds(id);
+
+        int leaf = allocateNode();
+        nodes[leaf].instance = id;
+        instances[id].node = leaf;
+        setFatBounds(leaf, instances[id].boundsMin, instances[id].boundsMax);
+        insertLeaf(leaf);
+        instanceCount++;
+        return id;
+    }
+
+    void SpatialIndex::remove(int id) {
+        if (id < 0 || id >= instances.size() || instances[id].node == -1){
+            LOG_WARNING("SpatialIndex::remove() invalid id %i", id);
+            return;
+        }
+        int leaf = instances[id].node;
+        removeLeaf(leaf);
+        freeNode(leaf);
+        instances[id] = InstanceData();
+        freeInstances.push_back(id);
+        instanceCount--;
+    }
+
+    void SpatialIndex::update(int id, const glm::mat4& transform) {
+        if (id < 0 || id >= instances.size() || instances[id].node == -1){
+            LOG_WARNING("SpatialIndex::update() invalid id %i", id);
+            return;
+        }
+        auto & data = instances[id];
+        data.instance.transform = transform;
+        updateBounds(id);
+        int leaf = data.node;
+        if (contains(nodes[leaf].boundsMin, nodes[leaf].boundsMax, data.boundsMin, data.boundsMax)){
+            return;
+        }
+        removeLeaf(leaf);
+        setFatBounds(leaf, data.boundsMin, data.boundsMax);
+        insertLeaf(leaf);
+    }
+
+    void SpatialIndex::refit() {
+        for (int i = 0; i < instances.size(); i++){
+            if (instances[i].node != -1){
+                updateBounds(i);
+                setFatBounds(instances[i].node, instances[i].boundsMin, instances[i].boundsMax);
+            }
+        }
+        if (root != -1){
+            refitNode(root);
+        }
+    }
+
+    void SpatialIndex::refitNode(int node) {
+        auto & n = nodes[node];
+        if (n.isLeaf()){
+            return;
+        }
+        refitNode(n.child1);
+        refitNode(n.child2);
+        n.boundsMin = glm::min(nodes[n.child1].boundsMin, nodes[n.child2].boundsMin);
+        n.boundsMax = glm::max(nodes[n.child1].boundsMax, nodes[n.child2].boundsMax);
+    }
+
+    void SpatialIndex::clear() {
+        nodes.clear();
+        instances.clear();
+        freeInstances.clear();
+        root = -1;
+        freeList = -1;
+        instanceCount = 0;
+    }
+
+    const SpatialIndex::Instance& SpatialIndex::getInstance(int id) {
+        return instances.at(id).instance;
+    }
+
+    std::array<glm::vec3,2> SpatialIndex::getBoundsMinMax(int id) {
+        return {instances.at(id).boundsMin, instances.at(id).boundsMax};
+    }
+
+    int SpatialIndex::size() {
+        return instanceCount;
+    }
+
+    int SpatialIndex::getHeight() {
+        return root == -1 ? 0 : nodes[root].height + 1;
+    }
+
+    void SpatialIndex::updateBounds(int instanceId) {
+        auto & data = instances[instanceId];
+        auto & transform = data.instance.transform;
+        std::array<glm::vec3,2> local = data.instance.mesh ? data.instance.mesh->getBoundsMinMax() : std::array<glm::vec3,2>{glm::vec3(inf), glm::vec3(-inf)};
+        if (local[0].x > local[1].x){
+            // empty mesh - use the origin of the instance
+            local = {glm::vec3(0.0f), glm::vec3(0.0f)};
+        }
+        glm::vec3 center = (local[0] + local[1]) * 0.5f;
+        glm::vec3 extent = (local[1] - local[0]) * 0.5f;
+        glm::vec3 worldCenter = glm::vec3(transform * glm::vec4(center, 1.0f));
+        glm::vec3 worldExtent = glm::abs(glm::vec3(transform[0])) * extent.x +
+                                glm::abs(glm::vec3(transform[1])) * extent.y +
+                                glm::abs(glm::vec3(transform[2])) * extent.z;
+        data.boundsMin = worldCenter - worldExtent;
+        data.boundsMax = worldCenter + worldExtent;
+    }
+
+    void SpatialIndex::setFatBounds(int leaf, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+        glm::vec3 enlarge = (boundsMax - boundsMin) * margin;
+        nodes[leaf].boundsMin = boundsMin - enlarge;
+        nodes[leaf].boundsMax = boundsMax + enlarge;
+    }
+
+    void SpatialIndex::insertLeaf(int leaf) {
+        if (root == -1){
+            root = leaf;
+            nodes[root].parent = -1;
+            return;
+        }
+
+        // find best sibling (descend using the surface area heuristic)
+        glm::vec3 leafMin = nodes[leaf].boundsMin;
+        glm::vec3 leafMax = nodes[leaf].boundsMax;
+        int index = root;
+        while (!nodes[index].isLeaf()){
+            const Node& node = nodes[index];
+            float area = surfaceArea(node.boundsMin, node.boundsMax);
+            float combinedArea = surfaceArea(glm::min(node.boundsMin, leafMin), glm::max(node.boundsMax, leafMax));
+            float cost = 2.0f * combinedArea;                           // cost of creating a new parent for this node and the leaf
+            float inheritanceCost = 2.0f * (combinedArea - area);       // minimum cost of pushing the leaf further down the tree
+
+            auto childCost = [&](int child){
+                const Node& c = nodes[child];
+                float newArea = surfaceArea(glm::min(c.boundsMin, leafMin), glm::max(c.boundsMax, leafMax));
+                if (c.isLeaf()){
+                    return newArea + inheritanceCost;
+                }
+                return newArea - surfaceArea(c.boundsMin, c.boundsMax) + inheritanceCost;
+            };
+            float cost1 = childCost(node.child1);
+            float cost2 = childCost(node.child2);
+            if (cost < cost1 && cost < cost2){
+                break;
+            }
+            index = cost1 < cost2 ? node.child1 : node.child2;
+        }
+        int sibling = index;
+
+        // create new parent
+        int oldParent = nodes[sibling].parent;
+        int newParent = allocateNode();
+        nodes[newParent].parent = oldParent;
+        nodes[newParent].boundsMin = glm::min(leafMin, nodes[sibling].boundsMin);
+        nodes[newParent].boundsMax = glm::max(leafMax, nodes[sibling].boundsMax);
+        nodes[newParent].height = nodes[sibling].height + 1;
+        nodes[newParent].child1 = sibling;
+        nodes[newParent].child2 = leaf;
+        if (oldParent != -1){
+            if (nodes[oldParent].child1 == sibling){
+                nodes[oldParent].child1 = newParent;
+            } else {
+                nodes[oldParent].child2 = newParent;
+            }
+        } else {
+            root = newParent;
+        }
+        nodes[sibling].parent = newParent;
+        nodes[leaf].parent = newParent;
+
+        // refit and balance ancestors
+        index = nodes[leaf].parent;
+        while (index != -1){
+            index = balance(index);
+            auto & node = nodes[index];
+            node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+            node.boundsMin = glm::min(nodes[node.child1].boundsMin, nodes[node.child2].boundsMin);
+            node.boundsMax = glm::max(nodes[node.child1].boundsMax, nodes[node.child2].boundsMax);
+            index = node.parent;
+        }
+    }
+
+    void SpatialIndex::removeLeaf(int leaf) {
+        if (leaf == root){
+            root = -1;
+            return;
+        }
+        int parent = nodes[leaf].parent;
+        int grandParent = nodes[parent].parent;
+        int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+        if (grandParent == -1){
+            root = sibling;
+            nodes[sibling].parent = -1;
+            freeNode(parent);
+            return;
+        }
+        if (nodes[grandParent].child1 == parent){
+            nodes[grandParent].child1 = sibling;
+        } else {
+            nodes[grandParent].child2 = sibling;
+        }
+        nodes[sibling].parent = grandParent;
+        freeNode(parent);
+
+        int index = grandParent;
+        while (index != -1){
+            index = balance(index);
+            auto & node = nodes[index];
+            node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+            node.boundsMin = glm::min(nodes[node.child1].boundsMin, nodes[node.child2].boundsMin);
+            node.boundsMax = glm::max(nodes[node.child1].boundsMax, nodes[node.child2].boundsMax);
+            index = node.parent;
+        }
+    }
+
+    // Rotate the subtree at iA if it is imbalanced. Returns the new root of the subtree.
+    int SpatialIndex::balance(int iA) {
+        Node& A = nodes[iA];
+        if (A.isLeaf() || A.height < 2){
+            return iA;
+        }
+        int iB = A.child1;
+        int iC = A.child2;
+        Node& B = nodes[iB];
+        Node& C = nodes[iC];
+        int balance = C.height - B.height;
+
+        auto replaceChild = [&](int parent, int oldChild, int newChild){
+            if (parent == -1){
+                root = newChild;
+            } else if (nodes[parent].child1 == oldChild){
+                nodes[parent].child1 = newChild;
+            } else {
+                nodes[parent].child2 = newChild;
+            }
+        };
+
+        if (balance > 1){
+            // rotate C up
+            int iF = C.child1;
+            int iG = C.child2;
+            Node& F = nodes[iF];
+            Node& G = nodes[iG];
+            C.child1 = iA;
+            C.parent = A.parent;
+            A.parent = iC;
+            replaceChild(C.parent, iA, iC);
+            if (F.height > G.height){
+                C.child2 = iF;
+                A.child2 = iG;
+                G.parent = iA;
+                A.boundsMin = glm::min(B.boundsMin, G.boundsMin);
+                A.boundsMax = glm::max(B.boundsMax, G.boundsMax);
+                C.boundsMin = glm::min(A.boundsMin, F.boundsMin);
+                C.boundsMax = glm::max(A.boundsMax, F.boundsMax);
+                A.height = 1 + std::max(B.height, G.height);
+                C.height = 1 + std::max(A.height, F.height);
+            } else {
+                C.child2 = iG;
+                A.child2 = iF;
+                F.parent = iA;
+                A.boundsMin = glm::min(B.boundsMin, F.boundsMin);
+                A.boundsMax = glm::max(B.boundsMax, F.boundsMax);
+                C.boundsMin = glm::min(A.boundsMin, G.boundsMin);
+                C.boundsMax = glm::max(A.boundsMax, G.boundsMax);
+                A.height = 1 + std::max(B.height, F.height);
+                C.height = 1 + std::max(A.height, G.height);
+            }
+            return iC;
+        }
+        if (balance < -1){
+            // rotate B up
+            int iD = B.child1;
+            int iE = B.child2;
+            Node& D = nodes[iD];
+            Node& E = nodes[iE];
+            B.child1 = iA;
+            B.parent = A.parent;
+            A.parent = iB;
+            replaceChild(B.parent, iA, iB);
+            if (D.height > E.height){
+                B.child2 = iD;
+                A.child1 = iE;
+                E.parent = iA;
+                A.boundsMin = glm::min(C.boundsMin, E.boundsMin);
+                A.boundsMax = glm::max(C.boundsMax, E.boundsMax);
+                B.boundsMin = glm::min(A.boundsMin, D.boundsMin);
+                B.boundsMax = glm::max(A.boundsMax, D.boundsMax);
+                A.height = 1 + std::max(C.height, E.height);
+                B.height = 1 + std::max(A.height, D.height);
+            } else {
+                B.child2 = iE;
+                A.child1 = iD;
+                D.parent = iA;
+                A.boundsMin = glm::min(C.boundsMin, D.boundsMin);
+                A.boundsMax = glm::max(C.boundsMax, D.boundsMax);
+                B.boundsMin = glm::min(A.boundsMin, E.boundsMin);
+                B.boundsMax = glm::max(A.boundsMax, E.boundsMax);
+                A.height = 1 + std::max(C.height, D.height);
+                B.height = 1 + std::max(A.height, E.height);
+            }
+            return iB;
+        }
+        return iA;
+    }
+
+    void SpatialIndex::collectLeaves(int node, std::vector<int>& result) {
+        const Node& n = nodes[node];
+        if (n.isLeaf()){
+            result.push_back(n.instance);
+            return;
+        }
+        collectLeaves(n.child1, result);
+        collectLeaves(n.child2, result);
+    }
+
+    void SpatialIndex::queryFrustum(const glm::mat4& viewProjection, std::vector<int>& result) {
+        if (root == -1){
+            return;
+        }
+        // extract frustum planes (Gribb-Hartmann)
+        glm::vec4 rows[4];
+        for (int i = 0; i < 4; i++){
+            rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        }
+        glm::vec4 planes[6] = {
+                rows[3] + rows[0], rows[3] - rows[0],
+                rows[3] + rows[1], rows[3] - rows[1],
+                rows[3] + rows[2], rows[3] - rows[2]
+        };
+
+        stack.clear();
+        stack.push_back(root);
+        while (!stack.empty()){
+            int index = stack.back();
+            stack.pop_back();
+            const Node& node = nodes[index];
+            auto test = testFrustum(planes, node.boundsMin, node.boundsMax);
+            if (test == FrustumTest::Outside){
+                continue;
+            }
+            if (node.isLeaf()){
+                auto & data = instances[node.instance];
+                if (test == FrustumTest::Inside || testFrustum(planes, data.boundsMin, data.boundsMax) != FrustumTest::Outside){
+                    result.push_back(node.instance);
+                }
+            } else if (test == FrustumTest::Inside){
+                collectLeaves(index, result);
+            } else {
+                stack.push_back(node.child1);
+                stack.push_back(node.child2);
+            }
+        }
+    }
+
+    void SpatialIndex::queryAABB(const std::array<glm::vec3,2>& aabbMinMax, std::vector<int>& result) {
+        if (root == -1){
+            return;
+        }
+        stack.clear();
+        stack.push_back(root);
+        while (!stack.empty()){
+            const Node& node = nodes[stack.back()];
+            stack.pop_back();
+            if (!overlaps(node.boundsMin, node.boundsMax, aabbMinMax[0], aabbMinMax[1])){
+                continue;
+            }
+            if (node.isLeaf()){
+                auto & data = instances[node.instance];
+                if (overlaps(data.boundsMin, data.boundsMax, aabbMinMax[0], aabbMinMax[1])){
+                    result.push_back(node.instance);
+                }
+            } else {
+                stack.push_back(node.child1);
+                stack.push_back(node.child2);
+            }
+        }
+    }
+
+    int SpatialIndex::raycast(const std::array<glm::vec3,2>& ray, RaycastHit& hit) {
+        if (root == -1){
+            return -1;
+        }
+        int res = -1;
+        glm::vec3 invDir = 1.0f / ray[1];
+        stack.clear();
+        stack.push_back(root);
+        while (!stack.empty()){
+            const Node& node = nodes[stack.back()];
+            stack.pop_back();
+            if (!intersectsRay(node.boundsMin, node.boundsMax, ray[0], invDir, hit.distance)){
+                continue;
+            }
+            if (node.isLeaf()){
+                auto & data = instances[node.instance];
+                if (data.instance.mesh && data.instance.mesh->raycast(ray, data.instance.transform, hit)){
+                    res = node.instance;
+                }
+            } else {
+                stack.push_back(node.child1);
+                stack.push_back(node.child2);
+            }
+        }
+        return res;
+    }
+}
@@ -10,6 +10,7 @@
 #include "sre/Sprite.hpp"
 #include "sre/Texture.hpp"
 #include "sre/Log.hpp"
+#include "sre/impl/WorkerPool.hpp"
 #include "picojson.h"
 
 #include <fstream>
@@ -18,22 +19,336 @@
 #include <sstream>
 #include <cerrno>
 #include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <climits>
+#include <mutex>
+#include <condition_variable>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/string_cast.hpp>
 
 using namespace std;
 
+namespace {
+    // Worker threads used to decode and composite images of packed sprite atlases
+    sre::WorkerPool& getPackWorkerPool(){
+        static sre::WorkerPool workerPool;
+        return workerPool;
+    }
+
+    // Run task(index) for index in [0, count) on the worker pool and wait for all of them
+    void parallelFor(sre::WorkerPool& workerPool, int count, const std::function<void(int)>& task){
+        std::mutex mutex;
+        std::condition_variable done;
+        int pending = count;
+        for (int i = 0; i < count; i++){
+            workerPool.enqueue([&, i](){
+                task(i);
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--pending == 0){
+                    done.notify_one();
+                }
+            });
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&](){ return pending == 0; });
+    }
+
+    int nextPowerOfTwo(int value){
+        int res = 1;
+        while (res < value){
+            res *= 2;
+        }
+        return res;
+    }
+}
+
 namespace sre {
+
+struct SpriteAtlas::PackedImage {
+    std::string name;
+    glm::vec2 pivot;
+    std::vector<char> rgba;                                     // trimmed RGBA data (bottom row first)
+    glm::ivec2 size = {0,0};                                    // trimmed size
+    glm::ivec2 sourcePos = {0,0};                               // offset of trimmed data in source image
+    glm::ivec2 sourceSize = {0,0};
+    int page = -1;
+    RectanglePacker::Rect rect;                                 // location in page (including extrusion and padding)
+};
+
+SpriteAtlas::PackImage::PackImage(std::string filename)
+        :name(filename), filename(filename)
+{
+}
+
+SpriteAtlas::PackImage::PackImage(std::string name, std::string filename)
+        :name(name), filename(filename)
+{
+}
+
+SpriteAtlas::PackImage::PackImage(std::string name, std::shared_ptr<Texture> texture)
+        :name(name), texture(texture)
+{
+}
+
+SpriteAtlas::PackImage::PackImage(std::string name, const char* rgbaData, int width, int height)
+        :name(name), size(width, height)
+{
+    if (rgbaData && width > 0 && height > 0){
+        rgba.assign(rgbaData, rgbaData + width * height * 4);
+    }
+}
+
 SpriteAtlas::SpriteAtlas(std::map<std::string, Sprite>&& sprites, std::shared_ptr<Texture> texture, std::string atlasName)
         :atlasName{atlasName}
 {
     for (auto & s : sprites){
         this->sprites.insert({s.first,s.second});
     }
-    this->texture = texture;
+    if (texture){
+        textures.push_back(texture);
+    }
     sre::Renderer::instance->spriteAtlases.push_back(this);
 }
 
+std::shared_ptr<SpriteAtlas> SpriteAtlas::pack(const std::vector<PackImage>& images, const PackOptions& options, std::string atlasName) {
+    auto atlas = std::shared_ptr<SpriteAtlas>(new SpriteAtlas({}, nullptr, atlasName));
+    atlas->packOptions = options;
+    atlas->packOptions.padding = std::max(0, options.padding);
+    atlas->packOptions.extrude = std::max(0, options.extrude);
+    atlas->add(images);
+    if (atlas->textures.empty()){
+        LOG_ERROR("Cannot create sprite atlas %s. No images packed.", atlasName.c_str());
+        return std::shared_ptr<SpriteAtlas>(nullptr);
+    }
+    return atlas;
+}
+
+bool SpriteAtlas::add(const std::vector<PackImage>& images) {
+    if (!textures.empty() && packedPages.empty()){
+        LOG_ERROR("Cannot add images to sprite atlas %s (not created using SpriteAtlas::pack())", atlasName.c_str());
+        return false;
+    }
+    std::vector<PackedImage> packedImages(images.size());
+    for (size_t i = 0; i < images.size(); i++){
+        auto& image = images[i];
+        auto& packedImage = packedImages[i];
+        packedImage.name = image.name;
+        packedImage.pivot = image.pivot;
+        if (image.texture){                                     // read on the main thread (OpenGL)
+            packedImage.rgba = image.texture->getRawImage();
+            packedImage.size = {image.texture->getWidth(), image.texture->getHeight()};
+        } else if (image.filename.empty()){
+            packedImage.rgba = image.rgba;
+            packedImage.size = image.size;
+        }
+    }
+
+    // decode files and trim images in parallel
+    Texture::initImageLoader();
+    bool trim = packOptions.trim;
+    parallelFor(getPackWorkerPool(), (int)images.size(), [&](int i){
+        auto& image = images[i];
+        auto& packedImage = packedImages[i];
+        if (!image.filename.empty() && !image.texture){
+            std::ifstream in(image.filename, std::ios::binary);
+            std::vector<char> fileData((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            GLenum format;
+            bool alpha;
+            int bytesPerPixel = 0;
+            std::vector<char> data;
+            if (!fileData.empty()){
+                data = Texture::loadFileFromMemory(fileData.data(), (int)fileData.size(), format, alpha, packedImage.size.x, packedImage.size.y, bytesPerPixel);
+            }
+            if (bytesPerPixel == 3){
+                size_t pixels = data.size() / 3;
+                packedImage.rgba.assign(pixels * 4, (char)0xff);
+                for (size_t p = 0; p < pixels; p++){
+                    memcpy(&packedImage.rgba[p * 4], &data[p * 3], 3);
+                }
+            } else if (bytesPerPixel == 4){
+                packedImage.rgba = std::move(data);
+            }
+        }
+        auto size = packedImage.size;
+        if (size.x <= 0 || size.y <= 0 || packedImage.rgba.size() != (size_t)size.x * size.y * 4){
+            LOG_ERROR("Cannot pack image %s in sprite atlas %s", image.name.c_str(), atlasName.c_str());
+            packedImage.size = {0,0};
+            return;
+        }
+        packedImage.sourceSize = size;
+        if (!trim){
+            return;
+        }
+        glm::ivec2 min = size;
+        glm::ivec2 max = {-1,-1};
+        for (int y = 0; y < size.y; y++){
+            for (int x = 0; x < size.x; x++){
+                if (packedImage.rgba[(x + y * size.x) * 4 + 3] != 0){
+                    min = glm::min(min, glm::ivec2(x, y));
+                    max = glm::max(max, glm::ivec2(x, y));
+                }
+            }
+        }
+        if (max.x < 0){                                         // fully transparent
+            min = {0,0};
+            max = {0,0};
+        }
+        if (min == glm::ivec2(0,0) && max == size - 1){
+            return;
+        }
+        packedImage.sourcePos = min;
+        packedImage.size = max - min + 1;
+        std::vector<char> trimmed((size_t)packedImage.size.x * packedImage.size.y * 4);
+        for (int y = 0; y < packedImage.size.y; y++){
+            memcpy(&trimmed[(size_t)y * packedImage.size.x * 4], &packedImage.rgba[((size_t)(y + min.y) * size.x + min.x) * 4], packedImage.size.x * 4);
+        }
+        packedImage.rgba.swap(trimmed);
+    });
+
+    bool res = packImages(packedImages);
+
+    // composite images (with extruded edges) into the pages in parallel
+    int extrude = packOptions.extrude;
+    parallelFor(getPackWorkerPool(), (int)packedImages.size(), [&](int i){
+        auto& packedImage = packedImages[i];
+        if (packedImage.page == -1){
+            return;
+        }
+        auto& page = packedPages[packedImage.page];
+        auto size = packedImage.size;
+        for (int y = -extrude; y < size.y + extrude; y++){
+            const char* srcRow = &packedImage.rgba[(size_t)glm::clamp(y, 0, size.y - 1) * size.x * 4];
+            char* dstRow = &page.pixels[((size_t)(packedImage.rect.y + extrude + y) * page.width + packedImage.rect.x) * 4];
+            for (int x = -extrude; x < size.x + extrude; x++){
+                memcpy(dstRow + (x + extrude) * 4, srcRow + glm::clamp(x, 0, size.x - 1) * 4, 4);
+            }
+        }
+    });
+
+    // upload pages
+    std::vector<glm::ivec2> updatedRows(packedPages.size(), {INT_MAX, -1});
+    for (auto& packedImage : packedImages){
+        if (packedImage.page != -1){
+            auto& rows = updatedRows[packedImage.page];
+            rows.x = std::min(rows.x, packedImage.rect.y);
+            rows.y = std::max(rows.y, packedImage.rect.y + packedImage.rect.height);
+        }
+    }
+    for (int i = 0; i < (int)packedPages.size(); i++){
+        auto& page = packedPages[i];
+        if (i >= (int)textures.size()){
+            textures.push_back(Texture::create()
+                    .withRGBAData(page.pixels.data(), page.width, page.height)
+                    .withGenerateMipmaps(false)
+                    .withFilterSampling(packOptions.filterSampling)
+                    .withWrapUV(Texture::Wrap::ClampToEdge)
+                    .withName(atlasName + " page " + std::to_string(i))
+                    .build());
+        } else if (updatedRows[i].y != -1){
+            int firstRow = updatedRows[i].x;
+            int lastRow = std::min(updatedRows[i].y, page.height);
+            textures[i]->updateRows(firstRow, lastRow - firstRow, &page.pixels[(size_t)firstRow * page.width * 4]);
+        }
+    }
+
+    for (auto& packedImage : packedImages){
+        if (packedImage.page == -1){
+            continue;
+        }
+        glm::ivec2 pos = glm::ivec2(packedImage.rect.x, packedImage.rect.y) + extrude;
+        Sprite sprite(pos, packedImage.size, packedImage.sourcePos, packedImage.sourceSize, packedImage.pivot, textures[packedImage.page].get());
+        if (sprites.find(packedImage.name) != sprites.end()){
+            LOG_WARNING("Sprite %s replaced in sprite atlas %s", packedImage.name.c_str(), atlasName.c_str());
+            sprites.erase(packedImage.name);
+        }
+        sprites.emplace(std::pair<std::string, Sprite>(packedImage.name, std::move(sprite)));
+    }
+    return res;
+}
+
+// Place the images in the free space of the existing pages, then on new pages (using the smallest page size where
+// the remaining images fit). Sets page and rect of the images placed. Returns false if some images were not placed.
+bool SpriteAtlas::packImages(std::vector<PackedImage>& images) {
+    int border = packOptions.extrude * 2 + packOptions.padding;
+    int maxPageSize = packOptions.maxPageSize;
+    bool res = true;
+    std::vector<PackedImage*> remaining;
+    for (auto& image : images){
+        if (image.size.x == 0){
+            res = false;
+        } else if (image.size.x + border > maxPageSize || image.size.y + border > maxPageSize){
+            LOG_ERROR("Cannot pack image %s (%ix%i) in sprite atlas %s. Larger than max page size %i.", image.name.c_str(), image.size.x, image.size.y, atlasName.c_str(), maxPageSize);
+            res = false;
+        } else {
+            remaining.push_back(&image);
+        }
+    }
+    std::stable_sort(remaining.begin(), remaining.end(), [](const PackedImage* a, const PackedImage* b){
+        int maxA = std::max(a->size.x, a->size.y);
+        int maxB = std::max(b->size.x, b->size.y);
+        return maxA > maxB || (maxA == maxB && a->size.x * a->size.y > b->size.x * b->size.y);
+    });
+
+    // insert images in the packer. Returns the images which did not fit
+    auto insert = [&](RectanglePacker& packer, int pageIndex, const std::vector<PackedImage*>& list){
+        std::vector<PackedImage*> notPlaced;
+        for (auto image : list){
+            if (packer.insert(image->size.x + border, image->size.y + border, image->rect)){
+                image->page = pageIndex;
+            } else {
+                image->page = -1;
+                notPlaced.push_back(image);
+            }
+        }
+        return notPlaced;
+    };
+
+    for (int i = 0; i < (int)packedPages.size() && !remaining.empty(); i++){
+        remaining = insert(packedPages[i].packer, i, remaining);
+    }
+
+    while (!remaining.empty()){
+        if (!packOptions.multiplePages && !packedPages.empty()){
+            LOG_ERROR("Cannot pack %i images in sprite atlas %s. Not enough space.", (int)remaining.size(), atlasName.c_str());
+            return false;
+        }
+        int64_t area = 0;
+        glm::ivec2 maxSize = {1,1};
+        for (auto image : remaining){
+            area += (int64_t)(image->size.x + border) * (image->size.y + border);
+            maxSize = glm::max(maxSize, image->size + border);
+        }
+        int pageIndex = (int)packedPages.size();
+        int width = std::min(maxPageSize, nextPowerOfTwo(std::max(maxSize.x, (int)std::sqrt((double)area))));
+        int height = std::min(maxPageSize, nextPowerOfTwo(std::max(maxSize.y, (int)(area / width))));
+        RectanglePacker packer;
+        std::vector<PackedImage*> notPlaced;
+        while (true){
+            packer = RectanglePacker(width, height);
+            notPlaced = insert(packer, pageIndex, remaining);
+            if (notPlaced.empty() || (width >= maxPageSize && height >= maxPageSize)){
+                break;
+            }
+            if ((width <= height && width < maxPageSize) || height >= maxPageSize){
+                width = std::min(maxPageSize, width * 2);
+            } else {
+                height = std::min(maxPageSize, height * 2);
+            }
+        }
+        if (!packOptions.powerOfTwo){
+            width = packer.getUsedWidth();
+            height = packer.getUsedHeight();
+            packer = RectanglePacker();                         // no free space in cropped pages
+        }
+        packedPages.push_back({packer, std::vector<char>((size_t)width * height * 4, 0), width, height});
+        remaining.swap(notPlaced);
+    }
+    return res;
+}
+
 std::shared_ptr<SpriteAtlas> SpriteAtlas::create(std::string jsonFile, std::shared_ptr<Texture> texture, bool flipAnchorY) {
     picojson::value v;
     std::ifstream t(jsonFile);
@@ -148,8 +463,15 @@ Sprite SpriteAtlas::get(std::string name) {
         return atlasName;
     }
 
-    std::shared_ptr<Texture> SpriteAtlas::getTexture(){
-        return texture;
+    std::shared_ptr<Texture> SpriteAtlas::getTexture(int page){
+        if (page < 0 || page >= (int)textures.size()){
+            return nullptr;
+        }
+        return textures[page];
+    }
+
+    int SpriteAtlas::getPageCount() {
+        return (int)textures.size();
     }
 
 
@@ -11,6 +11,7 @@
 #include <sre/Log.hpp>
 #include "sre/Texture.hpp"
 #include "sre/Material.hpp"
+#include "sre/Renderer.hpp"
 
 
 
@@ -20,11 +21,52 @@ namespace sre{
         return {};
     }
 
-    SpriteBatch::SpriteBatch(std::shared_ptr<Shader> shader, std::vector<Sprite>& sprites)
+    // Copies the textures used by the sprites into a texture array. Returns nullptr if less than two textures are used
+    // or if the textures cannot be stored in the same texture array.
+    std::shared_ptr<Texture> SpriteBatch::createTextureArray(std::vector<Sprite>& sprites, std::map<Texture*, int>& layerByTexture) {
+        if (renderInfo().graphicsAPIVersionES && renderInfo().graphicsAPIVersionMajor <= 2){
+            return nullptr;                 // texture arrays not supported
+        }
+        std::vector<Texture*> textures;
+        for (auto & s : sprites){
+            if (layerByTexture.emplace(s.texture, (int)textures.size()).second){
+                textures.push_back(s.texture);
+            }
+        }
+        if (textures.size() < 2){
+            return nullptr;
+        }
+        auto first = textures[0];
+        for (auto t : textures){
+            if (t->getWidth() != first->getWidth() || t->getHeight() != first->getHeight() || t->isCubemap() || t->isArray() ||
+                t->getSamplerColorSpace() != first->getSamplerColorSpace()){
+                LOG_WARNING("SpriteBatch: textures %s and %s cannot share a texture array. Using a draw call per texture.", first->getName().c_str(), t->getName().c_str());
+                return nullptr;
+            }
+        }
+        auto&& builder = Texture::create();
+        builder.withLayers((int)textures.size())
+                .withFilterSampling(first->isFilterSampling())
+                .withWrapUV(first->getWrapUV())
+                .withGenerateMipmaps(first->isMipmapped())
+                .withSamplerColorspace(first->getSamplerColorSpace())
+                .withName("SpriteBatch texture array");
+        for (int i=0;i<textures.size();i++){
+            builder.withLayerTexture(i, textures[i]->shared_from_this());
+        }
+        return builder.build();
+    }
+
+    SpriteBatch::SpriteBatch(std::shared_ptr<Shader> shader, std::vector<Sprite>& sprites, bool textureArray)
     {
         std::sort(sprites.begin(), sprites.end(), [](const Sprite & a,const Sprite & b){
             return a.order.globalOrder < b.order.globalOrder;
         });
+        std::map<Texture*, int> layerByTexture;
+        std::shared_ptr<Texture> arrayTexture;
+        if (textureArray){
+            arrayTexture = createTextureArray(sprites, layerByTexture);
+        }
         std::vector<glm::vec3> vertices;
         std::vector<glm::vec4> colors;
         std::vector<glm::vec4> uvs;
@@ -39,6 +81,12 @@ namespace sre{
                                            .withIndices(indices)
                                            .withAttribute("vertex_color",colors)
                                            .build());
+            if (arrayTexture){
+                auto mat = shader->createMaterial({{"S_TEXTURE_ARRAY", "1"}});
+                mat->setTexture(arrayTexture);
+                materials.push_back(mat);
+                return;
+            }
             auto mat = shader->createMaterial();
             mat->setTexture(lastTexture->shared_from_this());
             materials.push_back(mat);
@@ -46,7 +94,7 @@ namespace sre{
 
         // create meshes
         for (auto & s : sprites){
-            if (lastTexture && lastTexture != s.texture){
+            if (lastTexture && lastTexture != s.texture && !arrayTexture){
                 pushCurrentMesh();
                 vertices.clear();
                 colors.clear();
@@ -57,8 +105,9 @@ namespace sre{
 
             auto corners = s.getTrimmedCorners();
             auto cornerUvs = s.getUVs();
+            float layer = arrayTexture ? (float)layerByTexture[s.texture] : 0.0f;
 
-            uint16_t idx = (uint16_t)vertices.size();
+            uint32_t idx = (uint32_t)vertices.size();
             indices.push_back(idx);
             indices.push_back(idx+1);
             indices.push_back(idx+2);
@@ -68,7 +117,7 @@ namespace sre{
 
             for (int i=0;i<4;i++){
                 vertices.push_back({corners[i],0});
-                uvs.push_back({cornerUvs[i],0,0});
+                uvs.push_back({cornerUvs[i],layer,0});
                 colors.push_back(s.color);
             }
         }
@@ -98,8 +147,13 @@ namespace sre{
         return *this;
     }
 
+    SpriteBatch::SpriteBatchBuilder &SpriteBatch::SpriteBatchBuilder::withTextureArray(bool enabled) {
+        this->textureArray = enabled;
+        return *this;
+    }
+
     std::shared_ptr<SpriteBatch> SpriteBatch::SpriteBatchBuilder::build() {
-        return std::shared_ptr<SpriteBatch>{new SpriteBatch(shader, sprites)};
+        return std::shared_ptr<SpriteBatch>{new SpriteBatch(shader, sprites, textureArray)};
     }
 
 }
\ No newline at end of file
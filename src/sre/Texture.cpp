@@ -41,6 +41,12 @@
 #include <iomanip>
 
 #include "sre/Log.hpp"
+#include "sre/impl/WorkerPool.hpp"
+#include "sre/impl/TextureCompression.hpp"
+#include "sre/impl/MipmapBuilder.hpp"
+#include "sre/impl/SamplerCache.hpp"
+#include "sre/Sampler.hpp"
+#include <mutex>
 
 // anonymous (file local) namespace
 namespace {
@@ -115,15 +121,75 @@ namespace {
         return 0;
     }
 
+    GLint getInternalFormat(sre::Texture::SamplerColorspace samplerColorspace, int bytesPerPixel){
+        if (samplerColorspace == sre::Texture::SamplerColorspace::Linear){
+            return bytesPerPixel==4?GL_SRGB_ALPHA:GL_SRGB;
+        }
+        return bytesPerPixel==4?GL_RGBA:GL_RGB;
+    }
+
+    // Returns false if the block compressed format must be decompressed on the CPU
+    bool isCompressionSupported(sre::CompressedFormat format, bool srgb){
+        auto& info = sre::renderInfo();
+        switch (format){
+            case sre::CompressedFormat::BC1:
+            case sre::CompressedFormat::BC3:
+                return srgb ? info.supportTextureCompressionS3TCSRGB : info.supportTextureCompressionS3TC;
+            case sre::CompressedFormat::BC4:
+            case sre::CompressedFormat::BC5:
+                return info.supportTextureCompressionRGTC;
+            case sre::CompressedFormat::BC7:
+                return info.supportTextureCompressionBPTC;
+            default:
+                return info.supportTextureCompressionETC2;
+        }
+    }
+
+    // Upload a mip level of a block compressed image to the bound texture. Returns the size on the GPU
+    int uploadCompressedLevel(GLenum faceTarget, const sre::CompressedImage& image, int level, bool srgb, bool supported){
+        auto& levelData = image.levels[level];
+        int levelWidth = std::max(1, image.width >> level);
+        int levelHeight = std::max(1, image.height >> level);
+        if (supported){
+            glCompressedTexImage2D(faceTarget, level, sre::TextureCompression::getGLFormat(image.format, srgb), levelWidth, levelHeight, 0, (GLsizei)levelData.size(), levelData.data());
+            return (int)levelData.size();
+        }
+        auto rgba = sre::TextureCompression::decompress(image.format, levelData.data(), levelWidth, levelHeight);
+        glTexImage2D(faceTarget, level, getInternalFormat(srgb ? sre::Texture::SamplerColorspace::Linear : sre::Texture::SamplerColorspace::Gamma, 4),
+                     levelWidth, levelHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+        return (int)rgba.size();
+    }
+
+    // Worker threads used to generate mipmaps of textures built on the main thread
+    sre::WorkerPool& getMipmapWorkerPool(){
+        static sre::WorkerPool workerPool;
+        return workerPool;
+    }
+
+    // Texture arrays are always stored as RGBA
+    std::vector<char> toRGBA(const std::vector<char>& data, int bytesPerPixel){
+        if (bytesPerPixel != 3){
+            return data;
+        }
+        size_t pixels = data.size() / 3;
+        std::vector<char> res(pixels * 4, (char)0xff);
+        for (size_t i = 0; i < pixels; i++){
+            res[i*4  ] = data[i*3  ];
+            res[i*4+1] = data[i*3+1];
+            res[i*4+2] = data[i*3+2];
+        }
+        return res;
+    }
 }
 
 namespace sre {
 	std::shared_ptr<Texture> whiteTexture;
+    std::shared_ptr<Texture> whiteTextureArray;
     std::shared_ptr<Texture> whiteCubemapTexture;
     std::shared_ptr<Texture> sphereTexture;
 
-	Texture::Texture(unsigned int textureId, int width, int height, uint32_t target, std::string name)
-    	: width{ width }, height{ height }, target{ target}, textureId{textureId},name{name} {
+	Texture::Texture(unsigned int textureId, int width, int height, uint32_t target, std::string name, int layers)
+    	: width{ width }, height{ height }, layers{ layers }, target{ target}, textureId{textureId},name{name} {
         if (! Renderer::instance ){
             LOG_FATAL("Cannot instantiate sre::Texture before sre::Renderer is created.");
         }
@@ -148,12 +214,26 @@ namespace sre {
             renderStats.textureBytesDeallocated += datasize;
 
             r->textures.erase(std::remove(r->textures.begin(), r->textures.end(), this));
+            if (streaming){
+                r->textureStreaming.remove(this);
+            }
 
+            r->textureBindings.remove(textureId);
             glDeleteTextures(1, &textureId);
         }
 
     }
 
+    Texture::TextureBuilder &Texture::TextureBuilder::withMipmapFilter(MipmapFilter filter) {
+        mipmapFilter = filter;
+        return *this;
+    }
+
+    Texture::TextureBuilder &Texture::TextureBuilder::withAlphaCoverage(float alphaCutoff) {
+        this->alphaCutoff = alphaCutoff;
+        return *this;
+    }
+
     Texture::TextureBuilder &Texture::TextureBuilder::withGenerateMipmaps(bool enable) {
         generateMipmaps = enable;
         return *this;
@@ -187,56 +267,272 @@ namespace sre {
         return *this;
     }
 
+    Texture::TextureBuilder &Texture::TextureBuilder::withAnisotropy(float maxAnisotropy) {
+        this->anisotropy = maxAnisotropy;
+        return *this;
+    }
+
     Texture::TextureBuilder &Texture::TextureBuilder::withWrapUV(Texture::Wrap wrap) {
         this->wrapUV = wrap;
         return *this;
     }
 
+    // Files are decoded when the texture is built (or on a worker thread, see Texture::loadAsync())
     Texture::TextureBuilder &Texture::TextureBuilder::withFile(std::string filename) {
         if (name.length()==0){
             name = filename;
         }
-        auto fileData = readAllBytes(filename.c_str());
-        GLenum format;
-        int width;
-        int height;
-        int bytesPerPixel;
-        fileData = loadFileFromMemory(fileData.data(), (int) fileData.size(), format, this->transparent, width, height,bytesPerPixel);
-
-        textureTypeData[GL_TEXTURE_2D] = {
-                width,
-                height,
-                transparent,
-                bytesPerPixel,
-                format,
-                filename,
-                fileData
-        };
+        TextureDefinition textureDef;
+        textureDef.resourcename = filename;
+        textureDef.file = filename;
+        textureTypeData[GL_TEXTURE_2D] = textureDef;
 
         return *this;
     }
 
     Texture::TextureBuilder &Texture::TextureBuilder::withFileCubemap(std::string filename, CubemapSide side){
-        auto fileData = readAllBytes(filename.c_str());
-        GLenum format;
-        int bytesPerPixel;
-        int width;
-        int height;
-        fileData = loadFileFromMemory(fileData.data(), (int) fileData.size(), format,this->transparent, width, height,bytesPerPixel, false);
-
-        textureTypeData[GL_TEXTURE_CUBE_MAP_POSITIVE_X+(unsigned int)side] = {
-                width,
-                height,
-                transparent,
-                bytesPerPixel,
-                format,
-                filename,
-                fileData
-        };
+        TextureDefinition textureDef;
+        textureDef.resourcename = filename;
+        textureDef.file = filename;
+        textureDef.invertY = false;
+        textureTypeData[GL_TEXTURE_CUBE_MAP_POSITIVE_X+(unsigned int)side] = textureDef;
 
         return *this;
     }
 
+    // Read and decode file. Safe to call from worker threads. If the file cannot be loaded a white image is used.
+    void Texture::TextureBuilder::TextureDefinition::decodeFile() {
+        auto fileData = readAllBytes(file.c_str());
+        if (TextureCompression::isCompressedFile(fileData)){
+            auto image = std::make_shared<CompressedImage>();
+            std::string error;
+            if (TextureCompression::load(fileData, *image, error)){
+                compressed = image;
+                width = image->width;
+                height = image->height;
+                transparent = TextureCompression::hasAlpha(image->format);
+                bytesPerPixel = 4;
+                format = GL_RGBA;
+                data.clear();
+                file.clear();
+                return;
+            }
+            LOG_ERROR("Cannot load texture %s: %s", file.c_str(), error.c_str());
+            fileData.clear();
+        }
+        GLenum decodedFormat = 0;
+        if (!fileData.empty()){
+            initImageLoader();
+            data = loadFileFromMemory(fileData.data(), (int) fileData.size(), decodedFormat, transparent, width, height, bytesPerPixel, invertY);
+        }
+        format = decodedFormat;
+        file.clear();
+        if (data.empty()){
+            setWhite(2, 2);
+        }
+    }
+
+    void Texture::TextureBuilder::TextureDefinition::setWhite(int width, int height) {
+        this->width = width;
+        this->height = height;
+        transparent = false;
+        bytesPerPixel = 4;
+        format = GL_RGBA;
+        file.clear();
+        compressed.reset();
+        data.assign(width * height * 4, (char)0xff);
+    }
+
+    void Texture::TextureBuilder::TextureDefinition::generateMipLevels(const MipmapSettings& settings, WorkerPool* workerPool) {
+        if (data.empty() || compressed || (bytesPerPixel != 3 && bytesPerPixel != 4)){
+            return;
+        }
+        uint64_t cacheKey = 0;
+        bool useCache = !MipmapBuilder::getCacheDirectory().empty();
+        if (useCache){
+            cacheKey = MipmapBuilder::getCacheKey(data.data(), width, height, bytesPerPixel, settings);
+            if (MipmapBuilder::loadFromCache(cacheKey, mipLevels) && (int)mipLevels.size() == MipmapBuilder::getLevelCount(width, height) - 1){
+                return;
+            }
+        }
+        mipLevels = MipmapBuilder::build(data.data(), width, height, bytesPerPixel, settings, workerPool);
+        if (useCache){
+            MipmapBuilder::saveToCache(cacheKey, mipLevels);
+        }
+    }
+
+    int Texture::TextureBuilder::TextureDefinition::upload(uint32_t faceTarget, SamplerColorspace samplerColorspace, int firstLevel) {
+        if (!compressed){
+            void* dataPtr = data.size()>0?data.data(): nullptr;
+            if (bytesPerPixel == 3){
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 1);                              // rows of RGB data are not 4 byte aligned
+            }
+            auto internalFormat = getInternalFormat(samplerColorspace, bytesPerPixel);
+            glTexImage2D(faceTarget, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, dataPtr);
+            int dataSize = width * height * 4;
+            for (int level = 1; level <= (int)mipLevels.size(); level++){
+                int levelWidth = std::max(1, width >> level);
+                int levelHeight = std::max(1, height >> level);
+                glTexImage2D(faceTarget, level, internalFormat, levelWidth, levelHeight, 0, format, GL_UNSIGNED_BYTE, mipLevels[level-1].data());
+                dataSize += levelWidth * levelHeight * 4;
+            }
+            if (bytesPerPixel == 3){
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            }
+            return dataSize;
+        }
+        bool srgb = compressed->srgb && samplerColorspace == SamplerColorspace::Linear;
+        bool supported = isCompressionSupported(compressed->format, srgb);
+        int dataSize = 0;
+        for (int level = firstLevel; level < (int)compressed->levels.size(); level++){
+            dataSize += uploadCompressedLevel(faceTarget, *compressed, level, srgb, supported);
+        }
+        if (!supported){
+            LOG_WARNING("%s textures not supported. %s decompressed on the CPU.", TextureCompression::getName(compressed->format), resourcename.c_str());
+        }
+        return dataSize;
+    }
+
+    struct Texture::AsyncLoad {
+        std::weak_ptr<Texture> texture;
+        std::map<uint32_t, TextureBuilder::TextureDefinition> files;                // decoded on a worker thread
+        std::function<void(std::shared_ptr<Texture>)> onLoaded;
+        int streamingResidentLevels = 0;
+        bool generateMipmaps = false;
+        MipmapSettings mipmapSettings;
+
+        static std::mutex mutex;
+        static std::vector<std::shared_ptr<AsyncLoad>> completed;                   // decoded, but not uploaded yet
+        static WorkerPool& getWorkerPool(){
+            static WorkerPool workerPool;
+            return workerPool;
+        }
+    };
+
+    std::mutex Texture::AsyncLoad::mutex;
+    std::vector<std::shared_ptr<Texture::AsyncLoad>> Texture::AsyncLoad::completed;
+
+    std::shared_ptr<Texture> Texture::loadAsync(TextureBuilder& builder, std::function<void(std::shared_ptr<Texture>)> onLoaded) {
+        auto asyncLoad = std::make_shared<AsyncLoad>();
+        for (auto& textureDef : builder.textureTypeData){
+            if (!textureDef.second.file.empty()){
+                asyncLoad->files[textureDef.first] = textureDef.second;
+                textureDef.second.setWhite(2, 2);                                   // placeholder until decoded
+            }
+        }
+        asyncLoad->streamingResidentLevels = builder.streamingResidentLevels;
+        asyncLoad->generateMipmaps = builder.generateMipmaps && builder.layers == 0;
+        asyncLoad->mipmapSettings = builder.getMipmapSettings();
+        if (!asyncLoad->files.empty()){
+            builder.streamingResidentLevels = 0;                                    // streaming starts when the files are uploaded
+        }
+        auto texture = builder.build();
+        if (!texture || asyncLoad->files.empty()){
+            if (onLoaded){
+                onLoaded(texture);
+            }
+            return texture;
+        }
+        texture->loading = true;
+        asyncLoad->texture = texture;
+        asyncLoad->onLoaded = std::move(onLoaded);
+        initImageLoader();
+        AsyncLoad::getWorkerPool().enqueue([asyncLoad](){
+            for (auto& file : asyncLoad->files){
+                file.second.decodeFile();
+                if (asyncLoad->generateMipmaps){
+                    file.second.generateMipLevels(asyncLoad->mipmapSettings, nullptr);
+                }
+            }
+            std::lock_guard<std::mutex> lock(AsyncLoad::mutex);
+            AsyncLoad::completed.push_back(asyncLoad);
+        });
+        return texture;
+    }
+
+    void Texture::updateAsyncLoads() {
+        std::vector<std::shared_ptr<AsyncLoad>> completed;
+        {
+            std::lock_guard<std::mutex> lock(AsyncLoad::mutex);
+            completed.swap(AsyncLoad::completed);
+        }
+        for (auto& asyncLoad : completed){
+            auto texture = asyncLoad->texture.lock();
+            if (!texture){
+                continue;                                                           // texture deleted while loading
+            }
+            texture->uploadAsyncLoad(*asyncLoad);
+            if (asyncLoad->onLoaded){
+                asyncLoad->onLoaded(texture);
+            }
+        }
+    }
+
+    // Replace the placeholder with the decoded data (using the same texture id, so materials are not affected)
+    void Texture::uploadAsyncLoad(AsyncLoad& asyncLoad) {
+        RenderStats& renderStats = Renderer::instance->renderStats;
+        auto oldDataSize = getDataSize();
+        Renderer::instance->textureBindings.bindForUpdate(target, textureId);
+        int fileMipLevels = 0;
+        int fileDataSize = 0;
+        bool generatedMipLevels = false;
+        TextureBuilder::TextureDefinition* streamed = nullptr;
+        int streamedBaseLevel = 0;
+        for (auto& file : asyncLoad.files){
+            auto& textureDef = file.second;
+            int firstLevel = 0;
+            if (file.first == GL_TEXTURE_2D){
+                firstLevel = TextureBuilder::getStreamingBaseLevel(textureDef, asyncLoad.streamingResidentLevels);
+                streamed = firstLevel > 0 ? &textureDef : nullptr;
+                streamedBaseLevel = firstLevel;
+            }
+            int dataSize = textureDef.upload(file.first, samplerColorspace, firstLevel);
+            if (textureDef.compressed){
+                fileMipLevels = (int)textureDef.compressed->levels.size();
+                fileDataSize += dataSize;
+            }
+            generatedMipLevels = !textureDef.mipLevels.empty();
+            width = textureDef.width;
+            height = textureDef.height;
+            transparent = textureDef.transparent;
+        }
+        if (generateMipmap && fileMipLevels == 0 && !generatedMipLevels){
+            invokeGenerateMipmap();
+        }
+        auto dataSize = getDataSize();
+        renderStats.textureBytes += dataSize - oldDataSize;
+        renderStats.textureBytesAllocated += dataSize;
+        renderStats.textureBytesDeallocated += oldDataSize;
+        if (fileMipLevels > 0){
+            setFileMipLevels(fileMipLevels, fileDataSize);
+        }
+        if (streamed){
+            startStreaming(streamed->resourcename, *streamed->compressed, streamedBaseLevel);
+        }
+        loading = false;
+    }
+
+    bool Texture::isLoading() {
+        return loading;
+    }
+
+    MipmapSettings Texture::TextureBuilder::getMipmapSettings() {
+        MipmapSettings settings;
+        settings.filter = mipmapFilter == MipmapFilter::Kaiser ? MipmapSettings::Filter::Kaiser : MipmapSettings::Filter::Box;
+        settings.srgb = samplerColorspace == SamplerColorspace::Linear;
+        settings.alphaCutoff = alphaCutoff;
+        return settings;
+    }
+
+    void Texture::TextureBuilder::decodeFiles() {
+        for (auto& textureDef : textureTypeData){
+            if (!textureDef.second.file.empty()){
+                textureDef.second.decodeFile();
+                transparent = textureDef.second.transparent;
+            }
+        }
+    }
+
     Texture::TextureBuilder &Texture::TextureBuilder::withRGBData(const char *data, int width, int height) {
 
         int bytesPerPixel = 3;
@@ -289,16 +585,162 @@ namespace sre {
         return *this;
     }
 
+    Texture::TextureBuilder &Texture::TextureBuilder::withLayers(int layers, int width, int height) {
+        this->layers = layers;
+        layerWidth = width;
+        layerHeight = height;
+        return *this;
+    }
+
+    Texture::TextureBuilder &Texture::TextureBuilder::withLayerFile(int layer, std::string filename) {
+        if (name.length()==0){
+            name = filename;
+        }
+        auto fileData = readAllBytes(filename.c_str());
+        GLenum format;
+        bool alpha;
+        int width;
+        int height;
+        int bytesPerPixel;
+        fileData = loadFileFromMemory(fileData.data(), (int) fileData.size(), format, alpha, width, height, bytesPerPixel);
+        if (fileData.empty()){
+            return *this;
+        }
+        layerData[layer] = {
+                width,
+                height,
+                alpha,
+                4,
+                GL_RGBA,
+                filename,
+                toRGBA(fileData, bytesPerPixel)
+        };
+        return *this;
+    }
+
+    Texture::TextureBuilder &Texture::TextureBuilder::withLayerRGBAData(int layer, const char *data, int width, int height) {
+        layerData[layer] = {
+                width,
+                height,
+                true,
+                4,
+                GL_RGBA,
+                "memory"
+        };
+        if (data != nullptr){
+            layerData[layer].data.assign(data, data + width * height * 4);
+        }
+        return *this;
+    }
+
+    Texture::TextureBuilder &Texture::TextureBuilder::withLayerTexture(int layer, std::shared_ptr<Texture> texture) {
+        layerTextures[layer] = texture;
+        return *this;
+    }
+
+    // Allocates the texture array and uploads the layers. Returns false if the size of the array is unknown.
+    bool Texture::TextureBuilder::buildTextureArray(TextureDefinition& arrayDef) {
+        arrayDef = {layerWidth, layerHeight, false, 4, GL_RGBA, "TextureArray"};
+        for (auto& l : layerData){
+            if (arrayDef.width <= 0){
+                arrayDef.width = l.second.width;
+                arrayDef.height = l.second.height;
+            }
+            arrayDef.transparent |= l.second.transparent;
+        }
+        for (auto& l : layerTextures){
+            if (arrayDef.width <= 0){
+                arrayDef.width = l.second->getWidth();
+                arrayDef.height = l.second->getHeight();
+            }
+            arrayDef.transparent |= l.second->isTransparent();
+        }
+        if (arrayDef.width <= 0 || arrayDef.height <= 0){
+            LOG_ERROR("Texture array %s has no size. Use withLayers(layers, width, height) or add layer data.", name.c_str());
+            return false;
+        }
+        auto validLayer = [&](int layer, int width, int height){
+            if (layer < 0 || layer >= layers){
+                LOG_ERROR("Texture array %s: invalid layer %i (layers %i)", name.c_str(), layer, layers);
+                return false;
+            }
+            if (width != arrayDef.width || height != arrayDef.height){
+                LOG_ERROR("Texture array %s: layer %i size %ix%i differs from %ix%i", name.c_str(), layer, width, height, arrayDef.width, arrayDef.height);
+                return false;
+            }
+            return true;
+        };
+
+        GLint internalFormat = samplerColorspace == SamplerColorspace::Linear ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+        Renderer::instance->textureBindings.bindForUpdate(target, textureId);
+        glTexImage3D(target, 0, internalFormat, arrayDef.width, arrayDef.height, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        for (auto& l : layerData){
+            auto& layerDef = l.second;
+            if (layerDef.data.empty() || !validLayer(l.first, layerDef.width, layerDef.height)){
+                continue;
+            }
+            if (this->dumpDebug){
+                layerDef.dumpDebug();
+            }
+            glTexSubImage3D(target, 0, 0, 0, l.first, layerDef.width, layerDef.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, layerDef.data.data());
+        }
+        if (!layerTextures.empty()){
+            // copy on the GPU by attaching the source texture to a read framebuffer
+            GLint previousReadFramebuffer;
+            glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousReadFramebuffer);
+            GLuint framebuffer;
+            glGenFramebuffers(1, &framebuffer);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+            for (auto& l : layerTextures){
+                auto& texture = l.second;
+                if (texture->target != GL_TEXTURE_2D || texture->isDepthTexture()){
+                    LOG_ERROR("Texture array %s: layer %i must be copied from a 2D color texture", name.c_str(), l.first);
+                    continue;
+                }
+                if (!validLayer(l.first, texture->getWidth(), texture->getHeight())){
+                    continue;
+                }
+                glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture->textureId, 0);
+                glCopyTexSubImage3D(target, 0, 0, 0, l.first, 0, 0, arrayDef.width, arrayDef.height);
+            }
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)previousReadFramebuffer);
+            glDeleteFramebuffers(1, &framebuffer);
+        }
+        return true;
+    }
+
     std::shared_ptr<Texture> Texture::TextureBuilder::build() {
         if (textureId == 0){
             LOG_FATAL("Texture is already build");
         }
+        decodeFiles();
+        if (generateMipmaps && layers == 0 && depthPrecision == DepthPrecision::None){
+            auto settings = getMipmapSettings();
+            for (auto& textureDef : textureTypeData){
+                if (textureDef.second.mipLevels.empty()){
+                    textureDef.second.generateMipLevels(settings, &getMipmapWorkerPool());
+                }
+            }
+        }
         if (name.length() == 0){
             name = "Unnamed Texture";
         }
         std::map<uint32_t, TextureDefinition>::iterator val;
         TextureDefinition* textureDefPtr;
-        if (depthPrecision != DepthPrecision::None){
+        int fileMipLevelsDataSize = 0;
+        int streamingBaseLevel = 0;
+        TextureDefinition arrayDef;
+        if (layers > 0){
+            if (renderInfo().graphicsAPIVersionES && renderInfo().graphicsAPIVersionMajor <= 2){
+                LOG_FATAL("Texture arrays not supported");
+            }
+            this->target = GL_TEXTURE_2D_ARRAY;
+            if (!buildTextureArray(arrayDef)){
+                return {};
+            }
+            this->transparent = arrayDef.transparent;
+            textureDefPtr = &arrayDef;
+        } else if (depthPrecision != DepthPrecision::None){
             if (renderInfo().graphicsAPIVersionES && renderInfo().graphicsAPIVersionMajor <= 2){
                 LOG_FATAL("Depth texture not supported");
             } else {
@@ -339,64 +781,42 @@ namespace sre {
                 }
                 GLint border = 0;
 
-                glBindTexture(target, textureId);
+                Renderer::instance->textureBindings.bindForUpdate(target, textureId);
                 auto td = textureTypeData.find(GL_TEXTURE_2D);
                 textureDefPtr = &td->second;
                 glTexImage2D(target, 0, internalFormat, textureDefPtr->width,
                              textureDefPtr->height, border, format, type, nullptr);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+                if (!renderInfo().supportSamplerObjects){               // otherwise depth compare is sampler state (see getSampler())
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
 #ifndef GL_ES_VERSION_2_0
-                glm::vec4 ones(1.0, 1.0, 1.0, 1.0);
-                glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, &ones.x);
+                    glm::vec4 ones(1.0, 1.0, 1.0, 1.0);
+                    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, &ones.x);
 #endif
+                }
             }
         } else if ((val = textureTypeData.find(GL_TEXTURE_2D)) != textureTypeData.end()){
             auto& textureDef = val->second;
             textureDefPtr = &textureDef;
             this->target = GL_TEXTURE_2D;
             // create texture
-            GLint mipmapLevel = 0;
-
-            GLint internalFormat;
-            if (samplerColorspace == SamplerColorspace::Linear){
-                internalFormat = textureDef.bytesPerPixel==4?GL_SRGB_ALPHA:GL_SRGB;
-            } else {
-                internalFormat = textureDef.bytesPerPixel==4?GL_RGBA:GL_RGB;
-            }
-
-            GLint border = 0;
-            GLenum type = GL_UNSIGNED_BYTE;
-            glBindTexture(target, textureId);
-            void* dataPtr = textureDef.data.size()>0?textureDef.data.data(): nullptr;
+            Renderer::instance->textureBindings.bindForUpdate(target, textureId);
             if (this->dumpDebug){
                 textureDef.dumpDebug();
             }
-            glTexImage2D(target, mipmapLevel, internalFormat, textureDef.width, textureDef.height, border, textureDef.format, type, dataPtr);
+            streamingBaseLevel = getStreamingBaseLevel(textureDef, streamingResidentLevels);
+            fileMipLevelsDataSize = textureDef.upload(target, samplerColorspace, streamingBaseLevel);
         } else {
             for (int i=0;i<6;i++){
                 if ((val = textureTypeData.find(GL_TEXTURE_CUBE_MAP_POSITIVE_X+i)) != textureTypeData.end()) {
                     auto &textureDef = val->second;
                     textureDefPtr = &textureDef;
                     this->target = GL_TEXTURE_CUBE_MAP;
-                    GLint mipmapLevel = 0;
-
-                    GLint internalFormat;
-                    if (samplerColorspace == SamplerColorspace::Linear){
-                        internalFormat = textureDef.bytesPerPixel==4?GL_SRGB_ALPHA:GL_SRGB;
-                    } else {
-                        internalFormat = textureDef.bytesPerPixel==4?GL_RGBA:GL_RGB;
-                    }
-
-                    GLint border = 0;
-                    GLenum type = GL_UNSIGNED_BYTE;
-                    glBindTexture(target, textureId);
-                    void* dataPtr = textureDef.data.size()>0?textureDef.data.data() : nullptr;
+                    Renderer::instance->textureBindings.bindForUpdate(target, textureId);
                     if (this->dumpDebug){
                         textureDef.dumpDebug();
                     }
-                    glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + (unsigned int) i, mipmapLevel, internalFormat,
-                                 textureDef.width, textureDef.height, border, textureDef.format, type, dataPtr);
+                    fileMipLevelsDataSize += textureDef.upload(GL_TEXTURE_CUBE_MAP_POSITIVE_X + (unsigned int) i, samplerColorspace);
                 }
             }
         }
@@ -404,14 +824,23 @@ namespace sre {
             LOG_FATAL("Texture contain no data");
             return {};
         }
+        if (streamingResidentLevels > 0 && target != GL_TEXTURE_2D){
+            LOG_WARNING("Cannot stream %s. Streaming is only supported for 2D textures.", name.c_str());
+        }
         // build texture
-        Texture * res = new Texture(textureId, textureDefPtr->width, textureDefPtr->height, target, name);
+        Texture * res = new Texture(textureId, textureDefPtr->width, textureDefPtr->height, target, name, std::max(layers, 1));
         res->generateMipmap = this->generateMipmaps;
 		res->transparent = this->transparent;
 		res->samplerColorspace = this->samplerColorspace;
 		res->depthPrecision = this->depthPrecision;
 		res->wrapUV = this->wrapUV;
-        if (this->generateMipmaps){
+        res->anisotropy = this->anisotropy;
+        if (textureDefPtr->compressed){
+            res->setFileMipLevels((int)textureDefPtr->compressed->levels.size(), fileMipLevelsDataSize);
+            if (streamingBaseLevel > 0){
+                res->startStreaming(textureDefPtr->resourcename, *textureDefPtr->compressed, streamingBaseLevel);
+            }
+        } else if (this->generateMipmaps && textureDefPtr->mipLevels.empty()){
             res->invokeGenerateMipmap();
         }
         res->updateTextureSampler(filterSampling, wrapUV);
@@ -466,6 +895,7 @@ namespace sre {
     Texture::TextureBuilder::~TextureBuilder() {
 	    if (Renderer::instance){
             if (textureId != 0){
+                Renderer::instance->textureBindings.remove(textureId);
                 glDeleteTextures(1, &textureId);
             }
         }
@@ -476,6 +906,28 @@ namespace sre {
         return *this;
     }
 
+    Texture::TextureBuilder &Texture::TextureBuilder::withStreaming(int residentLevels) {
+        this->streamingResidentLevels = residentLevels;
+        return *this;
+    }
+
+    // Most detailed mip level uploaded when the texture is built (the levels above are streamed). Returns 0 if the
+    // texture is not streamed.
+    int Texture::TextureBuilder::getStreamingBaseLevel(const TextureDefinition& textureDef, int residentLevels) {
+        if (residentLevels <= 0){
+            return 0;
+        }
+        if (!textureDef.compressed){
+            LOG_WARNING("Cannot stream %s. Streaming requires a KTX2 or DDS file with mip levels.", textureDef.resourcename.c_str());
+            return 0;
+        }
+        if (renderInfo().graphicsAPIVersionES && renderInfo().graphicsAPIVersionMajor <= 2){
+            LOG_WARNING("Cannot stream %s. Texture streaming is not supported on OpenGL ES 2.", textureDef.resourcename.c_str());
+            return 0;
+        }
+        return std::max(0, (int)textureDef.compressed->levels.size() - residentLevels);
+    }
+
     Texture::TextureBuilder &Texture::TextureBuilder::withDumpDebug() {
         this->dumpDebug = true;
         return *this;
@@ -498,7 +950,7 @@ namespace sre {
 	void Texture::updateTextureSampler(bool filterSampling, Wrap wrapTextureCoordinates) {
         this->filterSampling = filterSampling;
         this->wrapUV = wrapTextureCoordinates;
-		glBindTexture(target, textureId);
+		Renderer::instance->textureBindings.bindForUpdate(target, textureId);
 		auto wrapParam = wrapTextureCoordinates == Wrap::Repeat?GL_REPEAT:
                          (wrapTextureCoordinates == Wrap::Mirror ? GL_MIRRORED_REPEAT:
 #ifndef GL_ES_VERSION_2_0
@@ -525,8 +977,21 @@ namespace sre {
 		}
 		glTexParameteri(target, GL_TEXTURE_MAG_FILTER, magnification);
 		glTexParameteri(target, GL_TEXTURE_MIN_FILTER, minification);
+        if (renderInfo().maxAnisotropy > 1){
+            float maxAnisotropy = filterSampling ? glm::clamp(anisotropy, 1.0f, renderInfo().maxAnisotropy) : 1.0f;
+            glTexParameterf(target, GL_TEXTURE_MAX_ANISOTROPY_EXT, maxAnisotropy);
+        }
 	}
 
+    Sampler Texture::getSampler() {
+        Sampler sampler;
+        sampler.filter = !filterSampling ? Sampler::Filter::Point : (generateMipmap ? Sampler::Filter::Trilinear : Sampler::Filter::Bilinear);
+        sampler.wrap = wrapUV;
+        sampler.anisotropy = anisotropy;
+        sampler.depthCompare = isDepthTexture();
+        return sampler;
+    }
+
     std::shared_ptr<Texture> Texture::getWhiteTexture() {
 		if (whiteTexture != nullptr) {
 			return whiteTexture;
@@ -572,7 +1037,101 @@ namespace sre {
         glGenerateMipmap(target);
     }
 
+    // Use the mip levels of a KTX2/DDS file (mipmaps cannot be generated for compressed formats)
+    void Texture::setFileMipLevels(int levels, int dataSize) {
+        RenderStats& renderStats = Renderer::instance->renderStats;
+        auto oldDataSize = getDataSize();
+        generateMipmap = levels > 1;
+        fileMipLevelsDataSize = dataSize;
+        Renderer::instance->textureBindings.bindForUpdate(target, textureId);
+#ifdef GL_TEXTURE_MAX_LEVEL
+        glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+#endif
+        updateTextureSampler(filterSampling, wrapUV);
+        auto dataSizeDelta = getDataSize() - oldDataSize;
+        renderStats.textureBytes += dataSizeDelta;
+        renderStats.textureBytesAllocated += dataSizeDelta;
+    }
+
+    // Clamp sampling to the mip levels from level (the more detailed levels are not resident)
+    void Texture::setBaseLevel(int level) {
+        baseLevel = level;
+        Renderer::instance->textureBindings.bindForUpdate(target, textureId);
+#ifdef GL_TEXTURE_BASE_LEVEL
+        glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, level);
+#endif
+    }
+
+    // Register the texture (built with the levels from baseLevel) for streaming of the more detailed levels
+    void Texture::startStreaming(const std::string& file, const CompressedImage& image, int baseLevel) {
+        bool srgb = image.srgb && samplerColorspace == SamplerColorspace::Linear;
+        bool supported = isCompressionSupported(image.format, srgb);
+        std::vector<int> levelBytes;
+        for (int level = 0; level < (int)image.levels.size(); level++){
+            int levelSize = std::max(1, width >> level) * std::max(1, height >> level) * 4;
+            levelBytes.push_back(supported ? (int)image.levels[level].size() : levelSize);
+        }
+        streaming = true;
+        setBaseLevel(baseLevel);
+        Renderer::instance->textureStreaming.add(this, file, levelBytes);
+    }
+
+    int Texture::uploadStreamedLevels(const CompressedImage& image, int firstLevel, int lastLevel) {
+        RenderStats& renderStats = Renderer::instance->renderStats;
+        bool srgb = image.srgb && samplerColorspace == SamplerColorspace::Linear;
+        bool supported = isCompressionSupported(image.format, srgb);
+        Renderer::instance->textureBindings.bindForUpdate(target, textureId);
+        int dataSize = 0;
+        for (int level = firstLevel; level < lastLevel; level++){
+            dataSize += uploadCompressedLevel(target, image, level, srgb, supported);
+        }
+        setBaseLevel(firstLevel);
+        fileMipLevelsDataSize += dataSize;
+        renderStats.textureBytes += dataSize;
+        renderStats.textureBytesAllocated += dataSize;
+        return dataSize;
+    }
+
+    void Texture::evictStreamedLevel(int dataSize) {
+        RenderStats& renderStats = Renderer::instance->renderStats;
+        int level = baseLevel;
+        setBaseLevel(level + 1);
+        // redefine the level without storage, so the driver can free the memory (levels below the base level do not
+        // affect texture completeness)
+        glTexImage2D(target, level, GL_RGBA, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        fileMipLevelsDataSize -= dataSize;
+        renderStats.textureBytes -= dataSize;
+        renderStats.textureBytesDeallocated += dataSize;
+    }
+
+    bool Texture::isStreaming() {
+        return streaming;
+    }
+
+    int Texture::getBaseMipLevel() {
+        return baseLevel;
+    }
+
+    void Texture::setMipmapCacheDirectory(const std::string& directory) {
+        MipmapBuilder::setCacheDirectory(directory);
+    }
+
+    const std::string& Texture::getMipmapCacheDirectory() {
+        return MipmapBuilder::getCacheDirectory();
+    }
+
+    void Texture::setStreamingBudget(int bytes) {
+        Renderer::instance->textureStreaming.setBudget(bytes);
+    }
+
+    int Texture::getStreamingBudget() {
+        return Renderer::instance->textureStreaming.getBudget();
+    }
+
 	int Texture::getDataSize() {
+        if (fileMipLevelsDataSize > 0){
+            return fileMipLevelsDataSize;
+        }
 		int res = width * height * 4;
 		if (generateMipmap){
 			res += (int)((1.0f/3.0f) * res);
@@ -581,6 +1140,9 @@ namespace sre {
 		if (target == GL_TEXTURE_CUBE_MAP){
 			res *= 6;
 		}
+		if (target == GL_TEXTURE_2D_ARRAY){
+			res *= layers;
+		}
 		return res;
 	}
 
@@ -588,10 +1150,22 @@ namespace sre {
         return target == GL_TEXTURE_CUBE_MAP;
     }
 
+    bool Texture::isArray() {
+        return target == GL_TEXTURE_2D_ARRAY;
+    }
+
+    int Texture::getLayers() {
+        return layers;
+    }
+
     sre::Texture::Wrap Texture::getWrapUV() {
         return wrapUV;
     }
 
+    float Texture::getAnisotropy() {
+        return anisotropy;
+    }
+
     std::shared_ptr<Texture> Texture::getDefaultCubemapTexture() {
         if (whiteCubemapTexture != nullptr) {
             return whiteCubemapTexture;
@@ -605,6 +1179,21 @@ namespace sre {
     }
 
 
+    std::shared_ptr<Texture> Texture::getWhiteTextureArray() {
+        if (whiteTextureArray != nullptr) {
+            return whiteTextureArray;
+        }
+        int size = 2;
+        std::vector<char> data(size * size * 4, (char)0xff);
+        whiteTextureArray = create()
+                .withLayers(1)
+                .withLayerRGBAData(0, data.data(), size, size)
+                .withFilterSampling(false)
+                .withName("SRE Default White Array")
+                .build();
+        return whiteTextureArray;
+    }
+
     const std::string &Texture::getName() {
         return name;
     }
@@ -618,7 +1207,8 @@ namespace sre {
         return generateMipmap;
     }
 
-    std::vector<char> Texture::loadFileFromMemory(const char* data, int dataSize, GLenum& format, bool & alpha,int& width, int& height, int& bytesPerPixel, bool invertY){
+    // Must be called on the main thread before files are decoded on worker threads
+    void Texture::initImageLoader() {
 #ifndef EMSCRIPTEN
         static bool initialized = false;
         if (!initialized) {
@@ -631,6 +1221,9 @@ namespace sre {
             }
         }
 #endif
+    }
+
+    std::vector<char> Texture::loadFileFromMemory(const char* data, int dataSize, GLenum& format, bool & alpha,int& width, int& height, int& bytesPerPixel, bool invertY){
 
         SDL_RWops *source = SDL_RWFromConstMem(data, dataSize);
         SDL_Surface *res_texture = IMG_Load_RW(source, 1);
@@ -648,11 +1241,15 @@ namespace sre {
 
         bytesPerPixel = format == GL_RGB ? 3 : 4;
         auto pixels = static_cast<char *>(formattedSurf->pixels);
+        // copy the rows without the padding of the surface pitch (textures are uploaded with tightly packed rows)
+        int rowSize = width*bytesPerPixel;
+        std::vector<char> res(rowSize*height);
+        for (int y=0;y<height;y++){
+            memcpy(res.data() + y*rowSize, pixels + y*formattedSurf->pitch, rowSize);
+        }
         if (invertY){
-            invert_image(width*bytesPerPixel, height, pixels);
+            invert_image(rowSize, height, res.data());
         }
-
-        std::vector<char> res(pixels, pixels+width*bytesPerPixel*height);
         SDL_FreeSurface(formattedSurf);
         SDL_FreeSurface(res_texture);
 
@@ -707,11 +1304,12 @@ namespace sre {
 #else
         assert(!isDepthTexture());
         assert(!isCubemap());
+        assert(!isArray());
         int bytesPerPixel = 4;
         std::vector<char> data(static_cast<unsigned long>(getWidth() * getHeight() * bytesPerPixel), 0);
         glPixelStorei(GL_UNPACK_ROW_LENGTH, getWidth());
         glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        glBindTexture(GL_TEXTURE_2D, textureId);
+        Renderer::instance->textureBindings.bindForUpdate(GL_TEXTURE_2D, textureId);
         glGetTexImage( GL_TEXTURE_2D, 0,  GL_RGBA, GL_UNSIGNED_BYTE, data.data());
         glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
         return data;
@@ -722,8 +1320,26 @@ namespace sre {
 	    return textureId;
 	}
 
+    void Texture::updateLayer(int layer, const char* rgbaData) {
+        if (target != GL_TEXTURE_2D_ARRAY || layer < 0 || layer >= layers){
+            LOG_ERROR("Cannot update layer %i of texture %s (layers %i)", layer, name.c_str(), isArray() ? layers : 0);
+            return;
+        }
+        Renderer::instance->textureBindings.bindForUpdate(target, textureId);
+        glTexSubImage3D(target, 0, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgbaData);
+    }
+
+    void Texture::updateRows(int firstRow, int rowCount, const char* rgbaData) {
+        if (target != GL_TEXTURE_2D || isDepthTexture() || firstRow < 0 || rowCount <= 0 || firstRow + rowCount > height){
+            LOG_ERROR("Cannot update rows %i-%i of texture %s", firstRow, firstRow + rowCount - 1, name.c_str());
+            return;
+        }
+        Renderer::instance->textureBindings.bindForUpdate(target, textureId);
+        glTexSubImage2D(target, 0, 0, firstRow, width, rowCount, GL_RGBA, GL_UNSIGNED_BYTE, rgbaData);
+    }
+
     void Texture::ReGenerateMipmaps() {
-        glBindTexture(target, textureId);
+        Renderer::instance->textureBindings.bindForUpdate(target, textureId);
         invokeGenerateMipmap();
     }
 
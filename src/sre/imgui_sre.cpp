@@ -134,6 +134,9 @@ if (renderInfo().graphicsAPIVersionMajor >= 3) {
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 #endif
     glActiveTexture(GL_TEXTURE0);
+    if (renderInfo().graphicsAPIVersionMajor >= 3) {
+        glBindSampler(0, 0);        // sample using the texture parameters
+    }
 
     // Setup viewport, orthographic projection matrix
     glViewport(0, 0, (GLsizei)fb_width, (GLsizei)fb_height);
@@ -198,8 +201,7 @@ if (renderInfo().graphicsAPIVersionMajor >= 3) {
 
     // Restore modified GL state
     glUseProgram(last_program);
-    glActiveTexture(last_active_texture);
-    glBindTexture(GL_TEXTURE_2D, last_texture);
+    glBindTexture(GL_TEXTURE_2D, last_texture);                 // unit 0 is still active (last_texture is the binding of unit 0)
     if (renderInfo().graphicsAPIVersionMajor >= 3) {
 
         glBindSampler(0, last_sampler);
@@ -0,0 +1,91 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/DynamicResolutionController.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace sre {
+    namespace {
+        const float integralLimit = 2.0f;                       // avoids windup while the scale is clamped
+        const float integralDecay = 0.9f;                       // applied while inside the hysteresis band
+    }
+
+    DynamicResolutionController::DynamicResolutionController()
+    :DynamicResolutionController(Settings())
+    {
+    }
+
+    DynamicResolutionController::DynamicResolutionController(const Settings& settings)
+    :settings(settings)
+    {
+        scale = clampScale(settings.maxScale);
+    }
+
+    float DynamicResolutionController::update(float time) {
+        if (time <= 0){
+            return scale;
+        }
+        float measuredCost = time / (scale * scale);
+        bool first = cost == 0;
+        cost = first ? measuredCost : cost + (measuredCost - cost) * settings.smoothing;
+
+        float error = (settings.budget - getPredictedTime()) / settings.budget;   // positive when below budget
+        if (first){
+            lastError = error;
+        }
+        bool overBudget = error < 0;
+        bool headroom = error > settings.headroom;
+        if (overBudget || headroom){
+            integral = std::max(-integralLimit, std::min(integral + error, integralLimit));
+        } else {
+            integral *= integralDecay;
+        }
+        float derivative = error - lastError;
+        lastError = error;
+        float output = settings.proportionalGain * error + settings.integralGain * integral + settings.derivativeGain * derivative;
+
+        float pixels = std::max(scale * scale * (1 + output), 0.01f);
+        float desired = clampScale(std::round(std::sqrt(pixels) / settings.step) * settings.step);
+        if (overBudget && desired < scale){
+            scale = desired;
+        } else if (headroom && desired > scale){
+            float fitsBudget = std::floor(std::sqrt(settings.budget / cost) / settings.step + 0.001f) * settings.step;
+            scale = std::max(scale, clampScale(std::min(desired, fitsBudget)));   // must not exceed the budget after increasing
+        }
+        return scale;
+    }
+
+    void DynamicResolutionController::reset(float scale) {
+        this->scale = clampScale(scale);
+        cost = 0;
+        integral = 0;
+        lastError = 0;
+    }
+
+    float DynamicResolutionController::getScale() const {
+        return scale;
+    }
+
+    float DynamicResolutionController::getPredictedTime() const {
+        return cost * scale * scale;
+    }
+
+    const DynamicResolutionController::Settings& DynamicResolutionController::getSettings() const {
+        return settings;
+    }
+
+    void DynamicResolutionController::setSettings(const Settings& settings) {
+        this->settings = settings;
+        scale = clampScale(scale);
+    }
+
+    float DynamicResolutionController::clampScale(float scale) const {
+        return std::max(settings.minScale, std::min(scale, settings.maxScale));
+    }
+}
@@ -0,0 +1,247 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/MeshFile.hpp"
+
+#include <cstring>
+
+namespace sre {
+    namespace {
+        const char meshFileMagic[4] = {'S','R','E','M'};
+        const uint32_t meshFileVersion = 1;
+        const uint32_t indexTypeUnsignedShort = 0x1403;         // GL_UNSIGNED_SHORT
+        const uint32_t indexTypeUnsignedInt = 0x1405;           // GL_UNSIGNED_INT
+
+        // number of elements of the attribute types supported by Mesh (0 if not supported)
+        int getElementCount(int32_t attributeType){
+            switch (attributeType){
+                case 0x1406:                                    // GL_FLOAT
+                    return 1;
+                case 0x8B50:                                    // GL_FLOAT_VEC2
+                    return 2;
+                case 0x8B51:                                    // GL_FLOAT_VEC3
+                    return 3;
+                case 0x8B52:                                    // GL_FLOAT_VEC4
+                case 0x8B55:                                    // GL_INT_VEC4
+                    return 4;
+                default:
+                    return 0;
+            }
+        }
+
+        bool isValidTopology(uint32_t topology){
+            // Points, Lines, LineStrip, Triangles, TriangleStrip and TriangleFan (see MeshTopology)
+            return topology <= 6 && topology != 2;
+        }
+
+        // bounds check which cannot overflow
+        bool isInside(uint64_t offset, uint64_t size, uint64_t totalSize){
+            return offset <= totalSize && size <= totalSize - offset;
+        }
+
+        uint64_t alignTo16(uint64_t offset){
+            return (offset + 15) & ~((uint64_t)15);
+        }
+
+        class MeshFileWriter {
+        public:
+            template<typename T>
+            void write(T value){
+                const char* ptr = reinterpret_cast<const char*>(&value);
+                data.insert(data.end(), ptr, ptr+sizeof(T));
+            }
+            void writeString(const std::string& s){
+                write((uint32_t)s.size());
+                data.insert(data.end(), s.begin(), s.end());
+            }
+            std::vector<char> data;
+        };
+
+        class MeshFileReader {
+        public:
+            MeshFileReader(const char* data, size_t size)
+            :data(data), size(size)
+            {}
+            template<typename T>
+            T read(){
+                T value{};
+                if (pos + sizeof(T) > size){
+                    valid = false;
+                    return value;
+                }
+                memcpy(&value, data+pos, sizeof(T));
+                pos += sizeof(T);
+                return value;
+            }
+            std::string readString(){
+                auto length = read<uint32_t>();
+                if (!valid || pos + length > size){
+                    valid = false;
+                    return "";
+                }
+                std::string res(data+pos, data+pos+length);
+                pos += length;
+                return res;
+            }
+            bool valid = true;
+        private:
+            const char* data;
+            size_t size;
+            size_t pos = 0;
+        };
+    }
+
+    bool MeshFile::write(std::ostream& out) const {
+        MeshFileWriter header;
+        for (auto c : meshFileMagic){
+            header.write(c);
+        }
+        header.write(meshFileVersion);
+        header.write(vertexCount);
+        header.write(bytesPerVertex);
+        for (int i=0;i<2;i++){
+            for (int j=0;j<3;j++){
+                header.write(bounds[i][j]);
+            }
+        }
+        header.write(lineWidth);
+        header.writeString(name);
+        header.write((uint32_t)attributes.size());
+        for (auto & a : attributes){
+            header.writeString(a.name);
+            header.write(a.offset);
+            header.write(a.elementCount);
+            header.write(a.dataType);
+            header.write(a.attributeType);
+        }
+        header.write((uint32_t)topologies.size());
+        for (auto t : topologies){
+            header.write(t);
+        }
+        header.write((uint32_t)indexSets.size());
+        for (auto & e : indexSets){
+            header.write(e.offset);
+            header.write(e.size);
+            header.write(e.type);
+        }
+        uint64_t headerSize = header.data.size() + sizeof(uint64_t)*4;
+        uint64_t vertexDataOffset = alignTo16(headerSize);
+        uint64_t indexDataOffset = alignTo16(vertexDataOffset + vertexDataSize);
+        header.write(vertexDataOffset);
+        header.write(vertexDataSize);
+        header.write(indexDataOffset);
+        header.write(indexDataSize);
+
+        const char padding[16] = {0};
+        out.write(header.data.data(), header.data.size());
+        out.write(padding, vertexDataOffset - headerSize);
+        out.write(vertexData, vertexDataSize);
+        out.write(padding, indexDataOffset - (vertexDataOffset + vertexDataSize));
+        out.write(indexData, indexDataSize);
+        return (bool)out;
+    }
+
+    bool MeshFile::read(const char* data, size_t size, std::string& error) {
+        MeshFileReader in(data, size);
+        char magic[4];
+        for (auto & c : magic){
+            c = in.read<char>();
+        }
+        if (!in.valid || memcmp(magic, meshFileMagic, sizeof(magic)) != 0){
+            error = "not a mesh file";
+            return false;
+        }
+        auto version = in.read<uint32_t>();
+        if (version != meshFileVersion){
+            error = "version " + std::to_string(version) + " is not supported (only version " + std::to_string(meshFileVersion) + ")";
+            return false;
+        }
+        vertexCount = in.read<uint32_t>();
+        bytesPerVertex = in.read<uint32_t>();
+        for (int i=0;i<2;i++){
+            for (int j=0;j<3;j++){
+                bounds[i][j] = in.read<float>();
+            }
+        }
+        lineWidth = in.read<float>();
+        name = in.readString();
+
+        bool valid = true;
+        attributes.clear();
+        auto attributeCount = in.read<uint32_t>();
+        for (uint32_t i=0;i<attributeCount && in.valid;i++){
+            Attribute attribute;
+            attribute.name = in.readString();
+            attribute.offset = in.read<int32_t>();
+            attribute.elementCount = in.read<int32_t>();
+            attribute.dataType = in.read<int32_t>();
+            attribute.attributeType = in.read<int32_t>();
+            valid &= attribute.offset >= 0 && attribute.elementCount == getElementCount(attribute.attributeType) &&
+                     attribute.offset + (int64_t)attribute.elementCount*4 <= (int64_t)bytesPerVertex;
+            attributes.push_back(attribute);
+        }
+        topologies.clear();
+        auto topologyCount = in.read<uint32_t>();
+        for (uint32_t i=0;i<topologyCount && in.valid;i++){
+            topologies.push_back(in.read<uint32_t>());
+            valid &= isValidTopology(topologies.back());
+        }
+        indexSets.clear();
+        auto indexSetCount = in.read<uint32_t>();
+        for (uint32_t i=0;i<indexSetCount && in.valid;i++){
+            IndexSet e;
+            e.offset = in.read<uint32_t>();
+            e.size = in.read<uint32_t>();
+            e.type = in.read<uint32_t>();
+            indexSets.push_back(e);
+        }
+        auto vertexDataOffset = in.read<uint64_t>();
+        vertexDataSize = in.read<uint64_t>();
+        auto indexDataOffset = in.read<uint64_t>();
+        indexDataSize = in.read<uint64_t>();
+
+        // a mesh has a topology per index set (or a single topology if not indexed)
+        valid &= in.valid && !topologies.empty() && (indexSets.empty() || topologies.size() == indexSets.size());
+        valid &= vertexDataSize == (uint64_t)vertexCount * bytesPerVertex && isInside(vertexDataOffset, vertexDataSize, size);
+        valid &= isInside(indexDataOffset, indexDataSize, size);
+        for (auto & e : indexSets){
+            valid &= e.type == indexTypeUnsignedInt || e.type == indexTypeUnsignedShort;
+            valid &= isInside(e.offset, (uint64_t)e.size * (e.type == indexTypeUnsignedInt ? sizeof(uint32_t) : sizeof(uint16_t)), indexDataSize);
+        }
+        if (!valid){
+            error = "corrupt";
+            return false;
+        }
+        vertexData = data + vertexDataOffset;
+        indexData = data + indexDataOffset;
+        return true;
+    }
+
+    bool MeshFile::validateIndices(std::string& error) const {
+        for (size_t i = 0; i < indexSets.size(); i++){
+            auto & e = indexSets[i];
+            const char* src = indexData + e.offset;
+            for (uint32_t j = 0; j < e.size; j++){
+                uint32_t index;
+                if (e.type == indexTypeUnsignedInt){
+                    uint32_t value;
+                    memcpy(&value, src + j*sizeof(uint32_t), sizeof(uint32_t));
+                    index = value;
+                } else {
+                    uint16_t value;
+                    memcpy(&value, src + j*sizeof(uint16_t), sizeof(uint16_t));
+                    index = value;
+                }
+                if (index >= vertexCount){
+                    error = "index set " + std::to_string(i) + " has index " + std::to_string(index) + " outside the " + std::to_string(vertexCount) + " vertices";
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,447 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/MipmapBuilder.hpp"
+#include "sre/impl/WorkerPool.hpp"
+#include "sre/Log.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SRE_MIPMAP_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SRE_MIPMAP_NEON
+#endif
+
+namespace sre {
+    // anonymous (file local) namespace
+    namespace {
+        // A pixel (RGBA in linear space)
+#if defined(SRE_MIPMAP_SSE2)
+        typedef __m128 Vec4;
+        inline Vec4 load(const float* p){ return _mm_loadu_ps(p); }
+        inline void store(float* p, Vec4 v){ _mm_storeu_ps(p, v); }
+        inline Vec4 add(Vec4 a, Vec4 b){ return _mm_add_ps(a, b); }
+        inline Vec4 mul(Vec4 a, float s){ return _mm_mul_ps(a, _mm_set1_ps(s)); }
+        inline Vec4 zero(){ return _mm_setzero_ps(); }
+#elif defined(SRE_MIPMAP_NEON)
+        typedef float32x4_t Vec4;
+        inline Vec4 load(const float* p){ return vld1q_f32(p); }
+        inline void store(float* p, Vec4 v){ vst1q_f32(p, v); }
+        inline Vec4 add(Vec4 a, Vec4 b){ return vaddq_f32(a, b); }
+        inline Vec4 mul(Vec4 a, float s){ return vmulq_n_f32(a, s); }
+        inline Vec4 zero(){ return vdupq_n_f32(0); }
+#else
+        struct Vec4 { float v[4]; };
+        inline Vec4 load(const float* p){ return {{p[0], p[1], p[2], p[3]}}; }
+        inline void store(float* p, Vec4 v){ memcpy(p, v.v, sizeof(v.v)); }
+        inline Vec4 add(Vec4 a, Vec4 b){ return {{a.v[0]+b.v[0], a.v[1]+b.v[1], a.v[2]+b.v[2], a.v[3]+b.v[3]}}; }
+        inline Vec4 mul(Vec4 a, float s){ return {{a.v[0]*s, a.v[1]*s, a.v[2]*s, a.v[3]*s}}; }
+        inline Vec4 zero(){ return {{0, 0, 0, 0}}; }
+#endif
+
+        struct Level {
+            int width;
+            int height;
+            std::vector<float> pixels;                                  // RGBA
+        };
+
+        // Kaiser windowed sinc filter taps for one axis. Each destination pixel uses tapCount source pixels.
+        struct Taps {
+            int tapCount;
+            std::vector<int> index;                                     // source pixel of each tap (clamped to the edge)
+            std::vector<float> weight;
+        };
+
+        std::string cacheDirectory;
+
+        const float kaiserRadius = 2.0f;                                // in destination pixels
+        const float kaiserAlpha = 4.0f;
+
+        float srgbToLinear(float v){
+            return v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+        }
+
+        struct SRGBTables {
+            float toLinear[256];
+            float thresholds[255];                                      // linear value between code i and i+1
+            SRGBTables(){
+                for (int i = 0; i < 256; i++){
+                    toLinear[i] = srgbToLinear(i / 255.0f);
+                }
+                for (int i = 0; i < 255; i++){
+                    thresholds[i] = srgbToLinear((i + 0.5f) / 255.0f);
+                }
+            }
+        };
+
+        const SRGBTables& srgbTables(){
+            static SRGBTables tables;
+            return tables;
+        }
+
+        uint8_t quantize(float v){
+            return (uint8_t)std::min(255.0f, std::max(0.0f, v * 255.0f + 0.5f));
+        }
+
+        uint8_t quantizeSRGB(float v){
+            auto& t = srgbTables().thresholds;
+            return (uint8_t)(std::upper_bound(t, t + 255, v) - t);     // exact rounding in sRGB space
+        }
+
+        // Run task(firstRow, rowCount) for ranges of rows on the worker pool and wait for all of them
+        void forRows(WorkerPool* workerPool, int rows, const std::function<void(int, int)>& task){
+            const int rowsPerTask = 16;
+            if (workerPool == nullptr || rows <= rowsPerTask){
+                task(0, rows);
+                return;
+            }
+            std::mutex mutex;
+            std::condition_variable done;
+            int pending = 0;
+            for (int first = 0; first < rows; first += rowsPerTask){
+                int count = std::min(rowsPerTask, rows - first);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    pending++;
+                }
+                workerPool->enqueue([&, first, count](){
+                    task(first, count);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (--pending == 0){
+                        done.notify_one();
+                    }
+                });
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [&](){ return pending == 0; });
+        }
+
+        void boxFilter(const Level& src, Level& dst, WorkerPool* workerPool){
+            forRows(workerPool, dst.height, [&](int firstRow, int rowCount){
+                for (int y = firstRow; y < firstRow + rowCount; y++){
+                    const float* row0 = &src.pixels[(size_t)std::min(y * 2, src.height - 1) * src.width * 4];
+                    const float* row1 = &src.pixels[(size_t)std::min(y * 2 + 1, src.height - 1) * src.width * 4];
+                    float* out = &dst.pixels[(size_t)y * dst.width * 4];
+                    for (int x = 0; x < dst.width; x++){
+                        int x0 = std::min(x * 2, src.width - 1) * 4;
+                        int x1 = std::min(x * 2 + 1, src.width - 1) * 4;
+                        Vec4 sum = add(add(load(row0 + x0), load(row0 + x1)), add(load(row1 + x0), load(row1 + x1)));
+                        store(out + x * 4, mul(sum, 0.25f));
+                    }
+                }
+            });
+        }
+
+        float besselI0(float x){
+            float sum = 1, term = 1;
+            for (int k = 1; k < 20; k++){
+                term *= (x / (2 * k)) * (x / (2 * k));
+                sum += term;
+            }
+            return sum;
+        }
+
+        Taps createTaps(int srcSize, int dstSize){
+            Taps taps;
+            float scale = srcSize / (float)dstSize;
+            taps.tapCount = (int)std::ceil(2 * kaiserRadius * scale) + 1;
+            for (int x = 0; x < dstSize; x++){
+                float center = (x + 0.5f) * scale;
+                int first = (int)std::floor(center - kaiserRadius * scale);
+                float sum = 0;
+                size_t offset = taps.weight.size();
+                for (int i = 0; i < taps.tapCount; i++){
+                    float d = (first + i + 0.5f - center) / scale;
+                    float w = 0;
+                    if (std::abs(d) < kaiserRadius){
+                        float t = d / kaiserRadius;
+                        float sinc = d == 0 ? 1.0f : std::sin(3.14159265f * d) / (3.14159265f * d);
+                        w = sinc * besselI0(kaiserAlpha * std::sqrt(1 - t * t)) / besselI0(kaiserAlpha);
+                    }
+                    taps.index.push_back(std::min(std::max(first + i, 0), srcSize - 1));
+                    taps.weight.push_back(w);
+                    sum += w;
+                }
+                for (size_t i = offset; i < taps.weight.size(); i++){
+                    taps.weight[i] /= sum;
+                }
+            }
+            return taps;
+        }
+
+        // Separable filter: horizontal pass to a temporary level, then vertical pass
+        void kaiserFilter(const Level& src, Level& dst, WorkerPool* workerPool){
+            Taps tapsX = createTaps(src.width, dst.width);
+            Taps tapsY = createTaps(src.height, dst.height);
+            Level tmp{dst.width, src.height, std::vector<float>((size_t)dst.width * src.height * 4)};
+            forRows(workerPool, src.height, [&](int firstRow, int rowCount){
+                for (int y = firstRow; y < firstRow + rowCount; y++){
+                    const float* in = &src.pixels[(size_t)y * src.width * 4];
+                    float* out = &tmp.pixels[(size_t)y * tmp.width * 4];
+                    for (int x = 0; x < dst.width; x++){
+                        Vec4 sum = zero();
+                        for (int i = 0; i < tapsX.tapCount; i++){
+                            int tap = x * tapsX.tapCount + i;
+                            sum = add(sum, mul(load(in + tapsX.index[tap] * 4), tapsX.weight[tap]));
+                        }
+                        store(out + x * 4, sum);
+                    }
+                }
+            });
+            forRows(workerPool, dst.height, [&](int firstRow, int rowCount){
+                for (int y = firstRow; y < firstRow + rowCount; y++){
+                    float* out = &dst.pixels[(size_t)y * dst.width * 4];
+                    for (int x = 0; x < dst.width; x++){
+                        Vec4 sum = zero();
+                        for (int i = 0; i < tapsY.tapCount; i++){
+                            int tap = y * tapsY.tapCount + i;
+                            sum = add(sum, mul(load(&tmp.pixels[((size_t)tapsY.index[tap] * tmp.width + x) * 4]), tapsY.weight[tap]));
+                        }
+                        store(out + x * 4, sum);
+                    }
+                }
+            });
+        }
+
+        float getCoverage(const Level& level, float alphaCutoff, float alphaScale){
+            size_t count = 0;
+            size_t pixels = level.pixels.size() / 4;
+            for (size_t i = 0; i < pixels; i++){
+                if (std::min(1.0f, level.pixels[i * 4 + 3] * alphaScale) > alphaCutoff){
+                    count++;
+                }
+            }
+            return count / (float)pixels;
+        }
+
+        // Find the alpha scale giving the coverage (coverage increases with the scale)
+        float findAlphaScale(const Level& level, float alphaCutoff, float coverage){
+            float low = 0, high = 4;
+            for (int i = 0; i < 16; i++){
+                float mid = (low + high) * 0.5f;
+                if (getCoverage(level, alphaCutoff, mid) < coverage){
+                    low = mid;
+                } else {
+                    high = mid;
+                }
+            }
+            return high;
+        }
+
+        std::vector<char> toBytes(const Level& level, int channels, bool srgb, float alphaScale){
+            std::vector<char> res((size_t)level.width * level.height * channels);
+            size_t pixels = (size_t)level.width * level.height;
+            for (size_t i = 0; i < pixels; i++){
+                const float* p = &level.pixels[i * 4];
+                for (int c = 0; c < 3; c++){
+                    res[i * channels + c] = (char)(srgb ? quantizeSRGB(p[c]) : quantize(p[c]));
+                }
+                if (channels == 4){
+                    res[i * channels + 3] = (char)quantize(p[3] * alphaScale);
+                }
+            }
+            return res;
+        }
+
+        // 64 bit FNV-1a variant processing 8 bytes at a time
+        uint64_t hashBytes(const char* data, size_t size, uint64_t hash){
+            size_t i = 0;
+            for (; i + 8 <= size; i += 8){
+                uint64_t v;
+                memcpy(&v, data + i, sizeof(v));
+                hash ^= v;
+                hash *= 1099511628211ULL;
+            }
+            for (; i < size; i++){
+                hash ^= (uint8_t)data[i];
+                hash *= 1099511628211ULL;
+            }
+            return hash;
+        }
+
+        const char cacheMagic[4] = {'S','R','E','M'};
+        const uint32_t cacheVersion = 1;
+
+        std::string cachePath(uint64_t key){
+            char name[32];
+            snprintf(name, sizeof(name), "%016llx.mip", (unsigned long long)key);
+            return cacheDirectory + "/" + name;
+        }
+    }
+
+    std::vector<std::vector<char>> MipmapBuilder::build(const char* data, int width, int height, int channels,
+                                                        const MipmapSettings& settings, WorkerPool* workerPool) {
+        std::vector<std::vector<char>> res;
+        if (width <= 0 || height <= 0 || (channels != 3 && channels != 4)){
+            return res;
+        }
+        auto& toLinear = srgbTables().toLinear;
+        Level level{width, height, std::vector<float>((size_t)width * height * 4)};
+        forRows(workerPool, height, [&](int firstRow, int rowCount){
+            for (size_t i = (size_t)firstRow * width; i < (size_t)(firstRow + rowCount) * width; i++){
+                const uint8_t* p = (const uint8_t*)data + i * channels;
+                for (int c = 0; c < 3; c++){
+                    level.pixels[i * 4 + c] = settings.srgb ? toLinear[p[c]] : p[c] / 255.0f;
+                }
+                level.pixels[i * 4 + 3] = channels == 4 ? p[3] / 255.0f : 1.0f;
+            }
+        });
+        bool preserveCoverage = settings.alphaCutoff >= 0 && channels == 4;
+        float coverage = preserveCoverage ? getCoverage(level, settings.alphaCutoff, 1.0f) : 0.0f;
+        while (level.width > 1 || level.height > 1){
+            Level next{std::max(1, level.width / 2), std::max(1, level.height / 2), {}};
+            next.pixels.resize((size_t)next.width * next.height * 4);
+            if (settings.filter == MipmapSettings::Filter::Kaiser){
+                kaiserFilter(level, next, workerPool);
+            } else {
+                boxFilter(level, next, workerPool);
+            }
+            float alphaScale = preserveCoverage ? findAlphaScale(next, settings.alphaCutoff, coverage) : 1.0f;
+            res.push_back(toBytes(next, channels, settings.srgb, alphaScale));
+            level = std::move(next);                                    // the next level is filtered from the unscaled alpha
+        }
+        return res;
+    }
+
+    int MipmapBuilder::getLevelCount(int width, int height) {
+        int levels = 1;
+        while (width > 1 || height > 1){
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+            levels++;
+        }
+        return levels;
+    }
+
+    float MipmapBuilder::getAlphaCoverage(const char* data, int width, int height, int channels, float alphaCutoff) {
+        if (channels != 4 || width <= 0 || height <= 0){
+            return 1;
+        }
+        size_t count = 0;
+        size_t pixels = (size_t)width * height;
+        for (size_t i = 0; i < pixels; i++){
+            if ((uint8_t)data[i * 4 + 3] / 255.0f > alphaCutoff){
+                count++;
+            }
+        }
+        return count / (float)pixels;
+    }
+
+    void MipmapBuilder::setCacheDirectory(const std::string& directory) {
+        cacheDirectory = directory;
+        if (!directory.empty()){
+            // create directory if missing (parent directory must exist)
+#ifdef _WIN32
+            _mkdir(directory.c_str());
+#else
+            mkdir(directory.c_str(), 0755);
+#endif
+        }
+    }
+
+    const std::string& MipmapBuilder::getCacheDirectory() {
+        return cacheDirectory;
+    }
+
+    // Key of a mip chain. Based on the level 0 data and the settings
+    uint64_t MipmapBuilder::getCacheKey(const char* data, int width, int height, int channels, const MipmapSettings& settings) {
+        int32_t header[5] = {width, height, channels, (int32_t)settings.filter, settings.srgb ? 1 : 0};
+        uint64_t hash = hashBytes((const char*)header, sizeof(header), 14695981039346656037ULL);
+        hash = hashBytes((const char*)&settings.alphaCutoff, sizeof(float), hash);
+        return hashBytes(data, (size_t)width * height * channels, hash);
+    }
+
+    // File layout: magic, version, key, level count, checksum of the levels, (size, data) of each level
+    bool MipmapBuilder::loadFromCache(uint64_t key, std::vector<std::vector<char>>& levels) {
+        if (cacheDirectory.empty()){
+            return false;
+        }
+        std::ifstream file(cachePath(key), std::ios::binary);
+        if (!file){
+            return false;
+        }
+        char magic[4];
+        uint32_t version = 0, levelCount = 0;
+        uint64_t fileKey = 0, checksum = 0;
+        file.read(magic, sizeof(magic));
+        file.read((char*)&version, sizeof(version));
+        file.read((char*)&fileKey, sizeof(fileKey));
+        file.read((char*)&levelCount, sizeof(levelCount));
+        file.read((char*)&checksum, sizeof(checksum));
+        if (!file || memcmp(magic, cacheMagic, sizeof(magic)) != 0 || version != cacheVersion || fileKey != key || levelCount > 32){
+            return false;
+        }
+        std::vector<std::vector<char>> res(levelCount);
+        uint64_t hash = 14695981039346656037ULL;
+        for (auto& level : res){
+            uint32_t size = 0;
+            file.read((char*)&size, sizeof(size));
+            if (!file){
+                break;
+            }
+            level.resize(size);
+            file.read(level.data(), size);
+            hash = hashBytes(level.data(), level.size(), hash);
+        }
+        if (!file || hash != checksum){
+            LOG_WARNING("Ignoring corrupt mipmap cache file %s", cachePath(key).c_str());
+            return false;
+        }
+        levels = std::move(res);
+        return true;
+    }
+
+    void MipmapBuilder::saveToCache(uint64_t key, const std::vector<std::vector<char>>& levels) {
+        if (cacheDirectory.empty()){
+            return;
+        }
+        uint32_t levelCount = (uint32_t)levels.size();
+        uint64_t checksum = 14695981039346656037ULL;
+        for (auto& level : levels){
+            checksum = hashBytes(level.data(), level.size(), checksum);
+        }
+        // write to temporary file first, to avoid leaving partially written files in the cache
+        auto path = cachePath(key);
+        auto tmpPath = path + ".tmp";
+        {
+            std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+            file.write(cacheMagic, sizeof(cacheMagic));
+            file.write((const char*)&cacheVersion, sizeof(cacheVersion));
+            file.write((const char*)&key, sizeof(key));
+            file.write((const char*)&levelCount, sizeof(levelCount));
+            file.write((const char*)&checksum, sizeof(checksum));
+            for (auto& level : levels){
+                uint32_t size = (uint32_t)level.size();
+                file.write((const char*)&size, sizeof(size));
+                file.write(level.data(), level.size());
+            }
+            if (!file){
+                LOG_WARNING("Cannot write mipmap cache file %s", tmpPath.c_str());
+                return;
+            }
+        }
+        std::remove(path.c_str());
+        if (std::rename(tmpPath.c_str(), path.c_str()) != 0){
+            std::remove(tmpPath.c_str());
+        }
+    }
+}
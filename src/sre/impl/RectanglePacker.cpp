@@ -0,0 +1,141 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/RectanglePacker.hpp"
+
+#include <algorithm>
+#include <climits>
+
+namespace sre {
+
+    namespace {
+        bool contains(const RectanglePacker::Rect& a, const RectanglePacker::Rect& b){
+            return b.x >= a.x && b.y >= a.y && b.x + b.width <= a.x + a.width && b.y + b.height <= a.y + a.height;
+        }
+
+        bool intersects(const RectanglePacker::Rect& a, const RectanglePacker::Rect& b){
+            return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+        }
+    }
+
+    RectanglePacker::RectanglePacker(int width, int height)
+            :width(width), height(height)
+    {
+        if (width > 0 && height > 0){
+            freeRects.push_back({0, 0, width, height});
+        }
+    }
+
+    bool RectanglePacker::insert(int width, int height, Rect& res) {
+        if (width <= 0 || height <= 0){
+            return false;
+        }
+        int bestShortSide = INT_MAX;
+        int bestLongSide = INT_MAX;
+        const Rect* best = nullptr;
+        for (auto& freeRect : freeRects){
+            if (freeRect.width < width || freeRect.height < height){
+                continue;
+            }
+            int leftoverX = freeRect.width - width;
+            int leftoverY = freeRect.height - height;
+            int shortSide = std::min(leftoverX, leftoverY);
+            int longSide = std::max(leftoverX, leftoverY);
+            if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide)){
+                best = &freeRect;
+                bestShortSide = shortSide;
+                bestLongSide = longSide;
+            }
+        }
+        if (best == nullptr){
+            return false;
+        }
+        res = {best->x, best->y, width, height};
+        splitFreeRects(res);
+        pruneFreeRects();
+        usedWidth = std::max(usedWidth, res.x + width);
+        usedHeight = std::max(usedHeight, res.y + height);
+        usedArea += (int64_t)width * height;
+        return true;
+    }
+
+    // Replace the free rectangles intersecting used with the (up to four) maximal rectangles around it
+    void RectanglePacker::splitFreeRects(const Rect& used) {
+        std::vector<Rect> res;
+        res.reserve(freeRects.size() + 4);
+        for (auto& freeRect : freeRects){
+            if (!intersects(freeRect, used)){
+                res.push_back(freeRect);
+                continue;
+            }
+            if (used.x > freeRect.x){
+                res.push_back({freeRect.x, freeRect.y, used.x - freeRect.x, freeRect.height});
+            }
+            if (used.x + used.width < freeRect.x + freeRect.width){
+                res.push_back({used.x + used.width, freeRect.y, freeRect.x + freeRect.width - used.x - used.width, freeRect.height});
+            }
+            if (used.y > freeRect.y){
+                res.push_back({freeRect.x, freeRect.y, freeRect.width, used.y - freeRect.y});
+            }
+            if (used.y + used.height < freeRect.y + freeRect.height){
+                res.push_back({freeRect.x, used.y + used.height, freeRect.width, freeRect.y + freeRect.height - used.y - used.height});
+            }
+        }
+        freeRects.swap(res);
+    }
+
+    // Remove free rectangles contained in other free rectangles
+    void RectanglePacker::pruneFreeRects() {
+        std::vector<bool> removed(freeRects.size(), false);
+        for (size_t i = 0; i < freeRects.size(); i++){
+            if (removed[i]){
+                continue;
+            }
+            for (size_t j = i + 1; j < freeRects.size(); j++){
+                if (removed[j]){
+                    continue;
+                }
+                if (contains(freeRects[i], freeRects[j])){
+                    removed[j] = true;
+                } else if (contains(freeRects[j], freeRects[i])){
+                    removed[i] = true;
+                    break;
+                }
+            }
+        }
+        size_t count = 0;
+        for (size_t i = 0; i < freeRects.size(); i++){
+            if (!removed[i]){
+                freeRects[count++] = freeRects[i];
+            }
+        }
+        freeRects.resize(count);
+    }
+
+    int RectanglePacker::getWidth() {
+        return width;
+    }
+
+    int RectanglePacker::getHeight() {
+        return height;
+    }
+
+    int RectanglePacker::getUsedWidth() {
+        return usedWidth;
+    }
+
+    int RectanglePacker::getUsedHeight() {
+        return usedHeight;
+    }
+
+    float RectanglePacker::getOccupancy() {
+        if (width <= 0 || height <= 0){
+            return 0;
+        }
+        return (float)((double)usedArea / ((double)width * height));
+    }
+}
@@ -0,0 +1,196 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/RenderGraphCompiler.hpp"
+
+#include <algorithm>
+#include <set>
+
+namespace sre {
+
+    namespace {
+        bool validate(const std::vector<RenderGraphCompiler::Pass>& passes, int resourceCount, std::string& error){
+            for (int p = 0; p < (int)passes.size(); p++){
+                auto& pass = passes[p];
+                for (auto list : {&pass.reads, &pass.writes}){
+                    for (int r : *list){
+                        if (r < 0 || r >= resourceCount){
+                            error = "Pass " + std::to_string(p) + " uses invalid resource " + std::to_string(r);
+                            return false;
+                        }
+                    }
+                }
+                for (int r : pass.reads){
+                    if (std::find(pass.writes.begin(), pass.writes.end(), r) != pass.writes.end()){
+                        error = "Pass " + std::to_string(p) + " reads and writes resource " + std::to_string(r);
+                        return false;
+                    }
+                }
+                if (pass.writesScreen && !pass.writes.empty()){
+                    error = "Pass " + std::to_string(p) + " writes both the screen and resources";
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    RenderGraphCompiler::Result RenderGraphCompiler::compile(const std::vector<Pass>& passes, const std::vector<Resource>& resources) {
+        Result res;
+        int passCount = (int)passes.size();
+        int resourceCount = (int)resources.size();
+        res.culled.assign(passCount, true);
+        res.firstUse.assign(resourceCount, -1);
+        res.lastUse.assign(resourceCount, -1);
+        res.generateMipmaps.resize(passCount);
+        if (!validate(passes, resourceCount, res.error)){
+            return res;
+        }
+
+        std::vector<std::vector<int>> writers(resourceCount);
+        std::vector<std::vector<int>> readers(resourceCount);
+        for (int p = 0; p < passCount; p++){
+            for (int r : passes[p].writes){
+                writers[r].push_back(p);
+            }
+            for (int r : passes[p].reads){
+                readers[r].push_back(p);
+            }
+        }
+
+        // passes writing the screen or an output are kept. Keep the writers of resources read by kept passes.
+        std::vector<bool> resourceNeeded(resourceCount, false);
+        std::vector<int> stack;
+        for (int p = 0; p < passCount; p++){
+            bool output = passes[p].writesScreen;
+            for (int r : passes[p].writes){
+                output |= resources[r].output;
+            }
+            if (output){
+                res.culled[p] = false;
+                stack.push_back(p);
+            }
+        }
+        while (!stack.empty()){
+            int p = stack.back();
+            stack.pop_back();
+            for (int r : passes[p].reads){
+                if (resourceNeeded[r]){
+                    continue;
+                }
+                resourceNeeded[r] = true;
+                for (int writer : writers[r]){
+                    if (res.culled[writer]){
+                        res.culled[writer] = false;
+                        stack.push_back(writer);
+                    }
+                }
+            }
+        }
+
+        // dependency edges between kept passes
+        std::vector<std::vector<int>> edges(passCount);
+        std::vector<int> inDegree(passCount, 0);
+        auto addEdge = [&](int from, int to){
+            if (from != to && !res.culled[from] && !res.culled[to]){
+                edges[from].push_back(to);
+                inDegree[to]++;
+            }
+        };
+        for (int r = 0; r < resourceCount; r++){
+            for (int i = 1; i < (int)writers[r].size(); i++){
+                addEdge(writers[r][i - 1], writers[r][i]);
+            }
+            for (int writer : writers[r]){
+                for (int reader : readers[r]){
+                    addEdge(writer, reader);
+                }
+            }
+        }
+        int lastScreenWriter = -1;
+        for (int p = 0; p < passCount; p++){
+            if (passes[p].writesScreen && !res.culled[p]){
+                if (lastScreenWriter != -1){
+                    addEdge(lastScreenWriter, p);
+                }
+                lastScreenWriter = p;
+            }
+        }
+
+        // topological sort (the first ready pass in declaration order is executed first)
+        std::set<int> ready;
+        int keptCount = 0;
+        for (int p = 0; p < passCount; p++){
+            if (!res.culled[p]){
+                keptCount++;
+                if (inDegree[p] == 0){
+                    ready.insert(p);
+                }
+            }
+        }
+        while (!ready.empty()){
+            int p = *ready.begin();
+            ready.erase(ready.begin());
+            res.order.push_back(p);
+            for (int next : edges[p]){
+                if (--inDegree[next] == 0){
+                    ready.insert(next);
+                }
+            }
+        }
+        if ((int)res.order.size() != keptCount){
+            res.error = "Cyclic dependency between passes";
+            res.order.clear();
+            return res;
+        }
+
+        // lifetimes
+        for (int i = 0; i < (int)res.order.size(); i++){
+            auto& pass = passes[res.order[i]];
+            for (auto list : {&pass.reads, &pass.writes}){
+                for (int r : *list){
+                    if (res.firstUse[r] == -1){
+                        res.firstUse[r] = i;
+                    }
+                    res.lastUse[r] = i;
+                }
+            }
+        }
+        for (int r = 0; r < resourceCount; r++){
+            if (resources[r].output && res.firstUse[r] != -1){
+                res.lastUse[r] = (int)res.order.size();
+            }
+        }
+
+        // mipmaps are generated after the last write, if the resource is read later
+        std::vector<int> position(passCount, -1);
+        for (int i = 0; i < (int)res.order.size(); i++){
+            position[res.order[i]] = i;
+        }
+        for (int r = 0; r < resourceCount; r++){
+            if (!resources[r].mipmapped){
+                continue;
+            }
+            int lastWrite = -1;
+            for (int writer : writers[r]){
+                lastWrite = std::max(lastWrite, position[writer]);
+            }
+            if (lastWrite == -1){
+                continue;
+            }
+            bool readLater = resources[r].output;
+            for (int reader : readers[r]){
+                readLater |= position[reader] > lastWrite;
+            }
+            if (readLater){
+                res.generateMipmaps[res.order[lastWrite]].push_back(r);
+            }
+        }
+        res.valid = true;
+        return res;
+    }
+}
@@ -0,0 +1,89 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/SamplerCache.hpp"
+
+#include "sre/Renderer.hpp"
+#include "sre/Texture.hpp"
+
+#include <algorithm>
+#include <tuple>
+
+namespace sre {
+
+    bool Sampler::operator==(const Sampler& other) const {
+        return filter == other.filter && wrap == other.wrap && anisotropy == other.anisotropy && depthCompare == other.depthCompare;
+    }
+
+    bool Sampler::operator!=(const Sampler& other) const {
+        return !(*this == other);
+    }
+
+    bool Sampler::operator<(const Sampler& other) const {
+        return std::tie(filter, wrap, anisotropy, depthCompare) < std::tie(other.filter, other.wrap, other.anisotropy, other.depthCompare);
+    }
+
+    Sampler SamplerCache::resolve(Sampler sampler, Texture& texture) {
+        if (sampler.filter == Sampler::Filter::Trilinear && !texture.isMipmapped()){
+            sampler.filter = Sampler::Filter::Bilinear;
+        }
+        if (sampler.filter == Sampler::Filter::Point){
+            sampler.anisotropy = 1;
+        }
+        sampler.anisotropy = glm::clamp(sampler.anisotropy, 1.0f, renderInfo().maxAnisotropy);
+        sampler.depthCompare = sampler.depthCompare && texture.isDepthTexture();
+#ifdef GL_ES_VERSION_2_0
+        if (sampler.wrap == Texture::Wrap::ClampToBorder){
+            sampler.wrap = Texture::Wrap::ClampToEdge;
+        }
+#endif
+        return sampler;
+    }
+
+    GLuint SamplerCache::get(const Sampler& sampler, Texture& texture) {
+        auto key = resolve(sampler, texture);
+        auto it = samplers.find(key);
+        if (it != samplers.end()){
+            return it->second;
+        }
+        GLuint samplerId = 0;
+        glGenSamplers(1, &samplerId);
+        GLint wrap = key.wrap == Texture::Wrap::Repeat ? GL_REPEAT :
+                     key.wrap == Texture::Wrap::Mirror ? GL_MIRRORED_REPEAT :
+#ifndef GL_ES_VERSION_2_0
+                     key.wrap == Texture::Wrap::ClampToBorder ? GL_CLAMP_TO_BORDER :
+#endif
+                     GL_CLAMP_TO_EDGE;
+        glSamplerParameteri(samplerId, GL_TEXTURE_WRAP_S, wrap);
+        glSamplerParameteri(samplerId, GL_TEXTURE_WRAP_T, wrap);
+        glSamplerParameteri(samplerId, GL_TEXTURE_WRAP_R, wrap);
+        GLint minification = key.filter == Sampler::Filter::Point ? GL_NEAREST :
+                             key.filter == Sampler::Filter::Bilinear ? GL_LINEAR : GL_LINEAR_MIPMAP_LINEAR;
+        glSamplerParameteri(samplerId, GL_TEXTURE_MIN_FILTER, minification);
+        glSamplerParameteri(samplerId, GL_TEXTURE_MAG_FILTER, key.filter == Sampler::Filter::Point ? GL_NEAREST : GL_LINEAR);
+        if (key.anisotropy > 1){
+            glSamplerParameterf(samplerId, GL_TEXTURE_MAX_ANISOTROPY_EXT, key.anisotropy);
+        }
+        if (key.depthCompare){
+            glSamplerParameteri(samplerId, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+            glSamplerParameteri(samplerId, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+#ifndef GL_ES_VERSION_2_0
+            const float ones[] = {1, 1, 1, 1};                  // outside the shadow map is lit
+            glSamplerParameterfv(samplerId, GL_TEXTURE_BORDER_COLOR, ones);
+#endif
+        }
+        samplers[key] = samplerId;
+        return samplerId;
+    }
+
+    void SamplerCache::clear() {
+        for (auto& sampler : samplers){
+            glDeleteSamplers(1, &sampler.second);
+        }
+        samplers.clear();
+    }
+}
@@ -0,0 +1,289 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/ShaderPreprocessor.hpp"
+#include "sre/impl/GL.hpp"
+#include "sre/Resource.hpp"
+#include "sre/Log.hpp"
+
+#include <unordered_map>
+#include <cstring>
+
+namespace sre {
+    // anonymous (file local) namespace
+    namespace {
+        std::unordered_map<std::string, std::string> includeCache;
+
+        const int maxIncludeDepth = 16;
+
+        const char* precisionBlock =
+                "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+                "   precision highp float;\n"
+                "   precision highp int;\n"
+                "#else\n"
+                "   precision mediump float;\n"
+                "   precision mediump int;\n"
+                "#endif\n";
+
+        bool isIdentifierStart(char c){
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+        }
+
+        bool isIdentifierChar(char c){
+            return isIdentifierStart(c) || (c >= '0' && c <= '9');
+        }
+
+        bool isSpace(char c){
+            return c == ' ' || c == '\t' || c == '\r';
+        }
+
+        size_t skipSpaces(const std::string& source, size_t pos, size_t end){
+            while (pos < end && isSpace(source[pos])){
+                pos++;
+            }
+            return pos;
+        }
+
+        size_t skipIdentifier(const std::string& source, size_t pos, size_t end){
+            while (pos < end && isIdentifierChar(source[pos])){
+                pos++;
+            }
+            return pos;
+        }
+
+        bool matches(const std::string& source, size_t begin, size_t end, const char* token){
+            size_t length = strlen(token);
+            return end - begin == length && source.compare(begin, length, token) == 0;
+        }
+
+        // returns nullptr if resource is not found
+        const std::string* loadInclude(const std::string& name){
+            auto res = includeCache.find(name);
+            if (res != includeCache.end()){
+                return &res->second;
+            }
+            auto text = Resource::loadText(name);
+            if (text.empty()){
+                return nullptr;
+            }
+            return &includeCache.emplace(name, std::move(text)).first->second;
+        }
+    }
+
+    ShaderPreprocessor::ShaderPreprocessor(uint32_t shaderType, int esVersion, std::vector<std::string>& errors)
+    :shaderType(shaderType), vertexShader(shaderType == GL_VERTEX_SHADER), esVersion(esVersion), errors(errors)
+    {
+    }
+
+    std::string ShaderPreprocessor::process(const std::string& source, const std::string& defines, uint32_t shaderType, int esVersion, std::vector<std::string>& errors) {
+        ShaderPreprocessor preprocessor(shaderType, esVersion, errors);
+        preprocessor.out.reserve(source.size() + defines.size() + 1024);
+        preprocessor.processSource(source, 0, 0);
+
+        std::string insert;
+        if (esVersion > 0 && !preprocessor.vertexShader){
+            insert += precisionBlock;
+        }
+        insert += defines;
+        if (!insert.empty()){
+            auto& out = preprocessor.out;
+            if (preprocessor.insertPos > 0 && out[preprocessor.insertPos-1] != '\n'){
+                insert = "\n" + insert;
+            }
+            insert += "#line " + std::to_string(preprocessor.insertLine) + "\n";
+            out.insert(preprocessor.insertPos, insert);
+        }
+        return std::move(preprocessor.out);
+    }
+
+    void ShaderPreprocessor::processSource(const std::string& source, int lineBase, int depth) {
+        size_t pos = 0;
+        int lineNumber = 0;
+        while (pos < source.size()){
+            size_t end = source.find('\n', pos);
+            bool newline = end != std::string::npos;
+            if (!newline){
+                end = source.size();
+            }
+            lineNumber++;
+            size_t first = skipSpaces(source, pos, end);
+            bool insertPoint = false;
+            if (!inBlockComment && first < end && source[first] == '#'){
+                out.append(source, pos, first - pos);
+                insertPoint = processDirective(source, first, end, lineBase, lineNumber, depth);
+            } else if (esVersion == 100){
+                processTokens(source, pos, end);
+            } else {
+                out.append(source, pos, end - pos);
+            }
+            if (newline){
+                out += '\n';
+            }
+            if (insertPoint && depth == 0){
+                insertPos = out.size();
+                insertLine = lineNumber;
+            }
+            pos = end + 1;
+        }
+    }
+
+    bool ShaderPreprocessor::processDirective(const std::string& source, size_t begin, size_t end, int lineBase, int lineNumber, int depth) {
+        size_t nameBegin = skipSpaces(source, begin + 1, end);
+        size_t nameEnd = skipIdentifier(source, nameBegin, end);
+        if (matches(source, nameBegin, nameEnd, "pragma")){
+            size_t includeBegin = skipSpaces(source, nameEnd, end);
+            size_t includeEnd = skipIdentifier(source, includeBegin, end);
+            size_t quoteBegin = skipSpaces(source, includeEnd, end);
+            size_t quoteEnd = quoteBegin < end ? source.find('"', quoteBegin + 1) : std::string::npos;
+            if (matches(source, includeBegin, includeEnd, "include") && source[quoteBegin] == '"' && quoteEnd < end){
+                std::string name = source.substr(quoteBegin + 1, quoteEnd - quoteBegin - 1);
+                auto include = loadInclude(name);
+                if (include == nullptr || depth >= maxIncludeDepth){
+                    if (include == nullptr){
+                        errors.push_back(std::string("0:")+std::to_string(lineBase+lineNumber)+" cannot find include file "+name+"##"+std::to_string(shaderType));
+                    } else {
+                        errors.push_back(std::string("0:")+std::to_string(lineBase+lineNumber)+" include depth exceeded for "+name+"##"+std::to_string(shaderType));
+                    }
+                    out.append(source, begin, end - begin);
+                    return false;
+                }
+                includes++;
+                int includeLineBase = includes * 10000;
+                out += "#line " + std::to_string(includeLineBase + 1) + "\n";
+                processSource(*include, includeLineBase, depth + 1);
+                out += "\n#line " + std::to_string(lineBase + lineNumber);
+                return false;
+            }
+        } else if (matches(source, nameBegin, nameEnd, "version")){
+            size_t versionBegin = skipSpaces(source, nameEnd, end);
+            if (esVersion > 0 && source.compare(versionBegin, 3, "330") == 0){
+                out += esVersion == 100 ? "#version 100" : ("#version " + std::to_string(esVersion) + " es");
+                out.append(source, versionBegin + 3, end - versionBegin - 3);
+            } else {
+                out.append(source, begin, end - begin);
+            }
+            return true;
+        } else if (matches(source, nameBegin, nameEnd, "extension")){
+            out.append(source, begin, end - begin);
+            return true;
+        }
+        if (esVersion == 100){
+            processTokens(source, begin, end);    // e.g. texture lookups in #define
+        } else {
+            out.append(source, begin, end - begin);
+        }
+        return false;
+    }
+
+    void ShaderPreprocessor::processTokens(const std::string& source, size_t begin, size_t end) {
+        size_t pos = begin;
+        bool firstToken = true;
+        while (pos < end){
+            char c = source[pos];
+            if (inBlockComment){
+                size_t commentEnd = source.find("*/", pos);
+                if (commentEnd == std::string::npos || commentEnd >= end){
+                    out.append(source, pos, end - pos);
+                    return;
+                }
+                out.append(source, pos, commentEnd + 2 - pos);
+                pos = commentEnd + 2;
+                inBlockComment = false;
+            } else if (c == '/' && pos + 1 < end && source[pos+1] == '/'){
+                out.append(source, pos, end - pos);
+                return;
+            } else if (c == '/' && pos + 1 < end && source[pos+1] == '*'){
+                out += "/*";
+                pos += 2;
+                inBlockComment = true;
+            } else if (isIdentifierStart(c)){
+                size_t identifierEnd = skipIdentifier(source, pos, end);
+                pos = translateIdentifier(source, pos, identifierEnd, end, firstToken);
+                firstToken = false;
+            } else if (c >= '0' && c <= '9'){
+                // numbers (including suffixes and exponents) are copied as is
+                size_t numberEnd = skipIdentifier(source, pos, end);
+                out.append(source, pos, numberEnd - pos);
+                pos = numberEnd;
+                firstToken = false;
+            } else {
+                if (!isSpace(c)){
+                    firstToken = false;
+                }
+                out += c;
+                pos++;
+            }
+        }
+    }
+
+    // Translate a GLSL 330 identifier to GLSL ES 1.00. Returns the position after the consumed input.
+    size_t ShaderPreprocessor::translateIdentifier(const std::string& source, size_t begin, size_t end, size_t lineEnd, bool firstToken) {
+        if (firstToken && matches(source, begin, end, "out")){
+            out += vertexShader ? "varying" : "// out";
+        } else if (firstToken && matches(source, begin, end, "in")){
+            out += vertexShader ? "attribute" : "varying";
+        } else if (!vertexShader && matches(source, begin, end, "fragColor")){
+            out += "gl_FragColor";
+        } else if (matches(source, begin, end, "texture")){
+            // texture(sampler, ...) to texture2D(sampler, ...) or textureCube(sampler, ...)
+            size_t pos = skipSpaces(source, end, lineEnd);
+            if (pos < lineEnd && source[pos] == '('){
+                size_t nameBegin = skipSpaces(source, pos + 1, lineEnd);
+                size_t nameEnd = skipIdentifier(source, nameBegin, lineEnd);
+                size_t comma = skipSpaces(source, nameEnd, lineEnd);
+                auto sampler = samplers.find(source.substr(nameBegin, nameEnd - nameBegin));
+                if (sampler != samplers.end() && comma < lineEnd && source[comma] == ','){
+                    out += "texture";
+                    out += sampler->second;
+                    out += '(';
+                    out.append(source, nameBegin, nameEnd - nameBegin);
+                    out += ',';
+                    return comma + 1;
+                }
+            }
+            out.append(source, begin, end - begin);
+        } else {
+            if (firstToken && matches(source, begin, end, "uniform")){
+                // uniform samplerXX name;
+                size_t typeBegin = skipSpaces(source, end, lineEnd);
+                size_t typeEnd = skipIdentifier(source, typeBegin, lineEnd);
+                size_t nameBegin = skipSpaces(source, typeEnd, lineEnd);
+                size_t nameEnd = skipIdentifier(source, nameBegin, lineEnd);
+                if (source.compare(typeBegin, 7, "sampler") == 0 && typeEnd - typeBegin >= 7 && nameEnd > nameBegin){
+                    samplers[source.substr(nameBegin, nameEnd - nameBegin)] = source.substr(typeBegin + 7, typeEnd - typeBegin - 7);
+                }
+            }
+            out.append(source, begin, end - begin);
+        }
+        return end;
+    }
+
+    std::set<std::string> ShaderPreprocessor::findSpecializationConstants(const std::string& source) {
+        std::set<std::string> res;
+        size_t pos = 0;
+        while (pos < source.size()){
+            if (isIdentifierStart(source[pos])){
+                size_t end = skipIdentifier(source, pos, source.size());
+                bool upperCase = end - pos > 2 && source[pos] == 'S' && source[pos+1] == '_';
+                for (size_t i = pos + 2; i < end && upperCase; i++){
+                    upperCase = (source[i] >= 'A' && source[i] <= 'Z') || (source[i] >= '0' && source[i] <= '9') || source[i] == '_';
+                }
+                if (upperCase){
+                    res.insert(source.substr(pos, end - pos));
+                }
+                pos = end;
+            } else {
+                pos++;
+            }
+        }
+        return res;
+    }
+
+    void ShaderPreprocessor::clearIncludeCache() {
+        includeCache.clear();
+    }
+}
@@ -0,0 +1,76 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/TextureBindingCache.hpp"
+#include <algorithm>
+
+namespace sre {
+
+    int TextureBindingCache::getTargetIndex(GLenum target) {
+        switch (target){
+            case GL_TEXTURE_CUBE_MAP:
+                return TextureCube;
+            case GL_TEXTURE_2D_ARRAY:
+                return Texture2DArray;
+            default:
+                return Texture2D;
+        }
+    }
+
+    GLuint& TextureBindingCache::getBinding(int unit, GLenum target) {
+        size_t index = unit * TargetCount + getTargetIndex(target);
+        if (index >= bindings.size()){
+            bindings.resize((unit + 1) * TargetCount, 0);
+        }
+        return bindings[index];
+    }
+
+    bool TextureBindingCache::bind(int unit, GLenum target, GLuint textureId) {
+        auto& binding = getBinding(unit, target);
+        if (binding == textureId){
+            return false;
+        }
+        if (activeUnit != unit){
+            glActiveTexture(GL_TEXTURE0 + unit);
+            activeUnit = unit;
+        }
+        glBindTexture(target, textureId);
+        binding = textureId;
+        return true;
+    }
+
+    void TextureBindingCache::bindForUpdate(GLenum target, GLuint textureId) {
+        auto& binding = getBinding(activeUnit, target);
+        if (binding != textureId){
+            glBindTexture(target, textureId);
+            binding = textureId;
+        }
+    }
+
+    bool TextureBindingCache::bindSampler(int unit, GLuint samplerId) {
+        if (unit >= (int)samplerBindings.size()){
+            samplerBindings.resize(unit + 1, 0);
+        }
+        if (samplerBindings[unit] == samplerId){
+            return false;
+        }
+        glBindSampler(unit, samplerId);
+        samplerBindings[unit] = samplerId;
+        return true;
+    }
+
+    void TextureBindingCache::remove(GLuint textureId) {
+        std::replace(bindings.begin(), bindings.end(), textureId, 0u);
+    }
+
+    void TextureBindingCache::reset() {
+        bindings.clear();
+        samplerBindings.clear();
+        glActiveTexture(GL_TEXTURE0);
+        activeUnit = 0;
+    }
+}
@@ -0,0 +1,1155 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/TextureCompression.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace sre {
+    namespace {
+        const uint8_t ktx2Identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+        uint32_t fourCC(const char* s){
+            return (uint32_t)(uint8_t)s[0] | (uint32_t)(uint8_t)s[1] << 8 | (uint32_t)(uint8_t)s[2] << 16 | (uint32_t)(uint8_t)s[3] << 24;
+        }
+
+        uint32_t readU32(const std::vector<char>& data, size_t offset){
+            uint32_t res = 0;
+            for (int i=0;i<4;i++){
+                res |= (uint32_t)(uint8_t)data[offset+i] << (8*i);
+            }
+            return res;
+        }
+
+        uint64_t readU64(const std::vector<char>& data, size_t offset){
+            return (uint64_t)readU32(data, offset) | (uint64_t)readU32(data, offset+4) << 32;
+        }
+
+        void writeU32(std::vector<char>& data, size_t offset, uint32_t value){
+            for (int i=0;i<4;i++){
+                data[offset+i] = (char)((value >> (8*i)) & 0xFF);
+            }
+        }
+
+        void writeU64(std::vector<char>& data, size_t offset, uint64_t value){
+            writeU32(data, offset, (uint32_t)value);
+            writeU32(data, offset+4, (uint32_t)(value >> 32));
+        }
+
+        int clamp255(int v){
+            return v < 0 ? 0 : (v > 255 ? 255 : v);
+        }
+
+        typedef uint8_t Block[16][4];                                   // 4x4 RGBA pixels, row major
+
+        // Vulkan format ids used by KTX2
+        struct FormatInfo {
+            CompressedFormat format;
+            uint32_t vkFormat;
+            uint32_t vkFormatSRGB;
+            uint32_t glFormat;
+            uint32_t glFormatSRGB;
+            uint32_t dxgiFormat;
+            uint32_t dxgiFormatSRGB;
+            const char* fourCC;                                         // legacy DDS header (nullptr if DX10 header is needed)
+            const char* name;
+        };
+
+        const FormatInfo formatInfos[] = {
+            {CompressedFormat::BC1,       133, 134, 0x83F1, 0x8C4D, 71, 72, "DXT1", "BC1"},
+            {CompressedFormat::BC3,       137, 138, 0x83F3, 0x8C4F, 77, 78, "DXT5", "BC3"},
+            {CompressedFormat::BC4,       139,   0, 0x8DBB,      0, 80,  0, "ATI1", "BC4"},
+            {CompressedFormat::BC5,       141,   0, 0x8DBD,      0, 83,  0, "ATI2", "BC5"},
+            {CompressedFormat::BC7,       145, 146, 0x8E8C, 0x8E8D, 98, 99, nullptr, "BC7"},
+            {CompressedFormat::ETC2_RGB,  147, 148, 0x9274, 0x9275,  0,  0, nullptr, "ETC2 RGB"},
+            {CompressedFormat::ETC2_RGBA, 151, 152, 0x9278, 0x9279,  0,  0, nullptr, "ETC2 RGBA"},
+        };
+
+        const FormatInfo& getInfo(CompressedFormat format){
+            return formatInfos[(int)format];
+        }
+
+        // BC1 - BC5
+
+        void decodeRGB565(uint16_t c, uint8_t* out){
+            int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+            out[0] = (uint8_t)((r << 3) | (r >> 2));
+            out[1] = (uint8_t)((g << 2) | (g >> 4));
+            out[2] = (uint8_t)((b << 3) | (b >> 2));
+            out[3] = 255;
+        }
+
+        uint16_t encodeRGB565(const int* c){
+            return (uint16_t)(((clamp255(c[0]) * 31 + 127) / 255) << 11 | ((clamp255(c[1]) * 63 + 127) / 255) << 5 | ((clamp255(c[2]) * 31 + 127) / 255));
+        }
+
+        void getBC1Palette(uint16_t c0, uint16_t c1, bool allowTransparent, uint8_t palette[4][4]){
+            decodeRGB565(c0, palette[0]);
+            decodeRGB565(c1, palette[1]);
+            for (int c=0;c<3;c++){
+                if (c0 > c1 || !allowTransparent){
+                    palette[2][c] = (uint8_t)((2 * palette[0][c] + palette[1][c] + 1) / 3);
+                    palette[3][c] = (uint8_t)((palette[0][c] + 2 * palette[1][c] + 1) / 3);
+                } else {
+                    palette[2][c] = (uint8_t)((palette[0][c] + palette[1][c]) / 2);
+                    palette[3][c] = 0;
+                }
+            }
+            palette[2][3] = 255;
+            palette[3][3] = (c0 > c1 || !allowTransparent) ? 255 : 0;
+        }
+
+        void decodeBC1(const uint8_t* data, Block& out, bool allowTransparent){
+            uint8_t palette[4][4];
+            getBC1Palette((uint16_t)(data[0] | data[1] << 8), (uint16_t)(data[2] | data[3] << 8), allowTransparent, palette);
+            uint32_t indices = (uint32_t)data[4] | (uint32_t)data[5] << 8 | (uint32_t)data[6] << 16 | (uint32_t)data[7] << 24;
+            for (int i=0;i<16;i++){
+                memcpy(out[i], palette[(indices >> (2*i)) & 3], 4);
+            }
+        }
+
+        void decodeBC4(const uint8_t* data, uint8_t* out, int stride){
+            int palette[8] = {data[0], data[1]};
+            if (palette[0] > palette[1]){
+                for (int i=1;i<7;i++){
+                    palette[i+1] = ((7-i) * palette[0] + i * palette[1] + 3) / 7;
+                }
+            } else {
+                for (int i=1;i<5;i++){
+                    palette[i+1] = ((5-i) * palette[0] + i * palette[1] + 2) / 5;
+                }
+                palette[6] = 0;
+                palette[7] = 255;
+            }
+            uint64_t indices = 0;
+            for (int i=0;i<6;i++){
+                indices |= (uint64_t)data[2+i] << (8*i);
+            }
+            for (int i=0;i<16;i++){
+                out[i*stride] = (uint8_t)palette[(indices >> (3*i)) & 7];
+            }
+        }
+
+        int colorDistance(const uint8_t* a, const uint8_t* b, int channels){
+            int res = 0;
+            for (int c=0;c<channels;c++){
+                int d = (int)a[c] - (int)b[c];
+                res += d*d;
+            }
+            return res;
+        }
+
+        // Finds the end points of a line through the colors: the bounding box where the diagonal follows the
+        // correlation with the channel with the largest range.
+        void findEndpoints(const Block& block, int channels, int minColor[4], int maxColor[4]){
+            int mean[4] = {0,0,0,0};
+            for (int c=0;c<channels;c++){
+                minColor[c] = 255;
+                maxColor[c] = 0;
+                for (int i=0;i<16;i++){
+                    minColor[c] = std::min(minColor[c], (int)block[i][c]);
+                    maxColor[c] = std::max(maxColor[c], (int)block[i][c]);
+                    mean[c] += block[i][c];
+                }
+            }
+            int ref = 0;
+            for (int c=1;c<channels;c++){
+                if (maxColor[c]-minColor[c] > maxColor[ref]-minColor[ref]) ref = c;
+            }
+            for (int c=0;c<channels;c++){
+                if (c == ref) continue;
+                int covariance = 0;
+                for (int i=0;i<16;i++){
+                    covariance += (block[i][ref]*16 - mean[ref]) * (block[i][c]*16 - mean[c]);
+                }
+                if (covariance < 0){
+                    std::swap(minColor[c], maxColor[c]);
+                }
+            }
+        }
+
+        void encodeBC1(const Block& block, uint8_t* out){
+            int minColor[4], maxColor[4];
+            findEndpoints(block, 3, minColor, maxColor);
+            for (int c=0;c<3;c++){                                      // inset to reduce the error at the ends
+                int inset = (maxColor[c] - minColor[c]) / 16;
+                maxColor[c] -= inset;
+                minColor[c] += inset;
+            }
+            uint16_t c0 = encodeRGB565(maxColor);
+            uint16_t c1 = encodeRGB565(minColor);
+            if (c0 < c1) std::swap(c0, c1);
+            uint32_t indices = 0;
+            if (c0 != c1){
+                uint8_t palette[4][4];
+                getBC1Palette(c0, c1, true, palette);
+                for (int i=0;i<16;i++){
+                    int best = 0;
+                    int bestDist = colorDistance(block[i], palette[0], 3);
+                    for (int p=1;p<4;p++){
+                        int dist = colorDistance(block[i], palette[p], 3);
+                        if (dist < bestDist){
+                            bestDist = dist;
+                            best = p;
+                        }
+                    }
+                    indices |= (uint32_t)best << (2*i);
+                }
+            }
+            out[0] = (uint8_t)(c0 & 0xFF); out[1] = (uint8_t)(c0 >> 8);
+            out[2] = (uint8_t)(c1 & 0xFF); out[3] = (uint8_t)(c1 >> 8);
+            for (int i=0;i<4;i++){
+                out[4+i] = (uint8_t)((indices >> (8*i)) & 0xFF);
+            }
+        }
+
+        void encodeBC4(const Block& block, int channel, uint8_t* out){
+            int minValue = 255, maxValue = 0;
+            for (int i=0;i<16;i++){
+                minValue = std::min(minValue, (int)block[i][channel]);
+                maxValue = std::max(maxValue, (int)block[i][channel]);
+            }
+            out[0] = (uint8_t)maxValue;
+            out[1] = (uint8_t)minValue;
+            int palette[8] = {maxValue, minValue};
+            for (int i=1;i<7;i++){
+                palette[i+1] = ((7-i) * maxValue + i * minValue + 3) / 7;
+            }
+            uint64_t indices = 0;
+            if (maxValue != minValue){
+                for (int i=0;i<16;i++){
+                    int best = 0;
+                    for (int p=1;p<8;p++){
+                        if (std::abs(palette[p] - block[i][channel]) < std::abs(palette[best] - block[i][channel])) best = p;
+                    }
+                    indices |= (uint64_t)best << (3*i);
+                }
+            }
+            for (int i=0;i<6;i++){
+                out[2+i] = (uint8_t)((indices >> (8*i)) & 0xFF);
+            }
+        }
+
+        // BC7
+
+        struct BitReader {
+            const uint8_t* data;
+            int pos;
+            uint32_t read(int bits){
+                uint32_t res = 0;
+                for (int i=0;i<bits;i++, pos++){
+                    res |= (uint32_t)((data[pos >> 3] >> (pos & 7)) & 1) << i;
+                }
+                return res;
+            }
+        };
+
+        struct BitWriter {
+            uint8_t* data;
+            int pos;
+            void write(uint32_t value, int bits){
+                for (int i=0;i<bits;i++, pos++){
+                    data[pos >> 3] |= (uint8_t)(((value >> i) & 1) << (pos & 7));
+                }
+            }
+        };
+
+        struct BC7Mode {
+            int subsets, partitionBits, rotationBits, indexSelectionBits, colorBits, alphaBits, endpointPBits, sharedPBits, indexBits, index2Bits;
+        };
+
+        const BC7Mode bc7Modes[8] = {
+            {3, 4, 0, 0, 4, 0, 1, 0, 3, 0},
+            {2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+            {3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+            {2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+            {1, 0, 2, 1, 5, 6, 0, 0, 2, 3},
+            {1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+            {1, 0, 0, 0, 7, 7, 1, 0, 4, 0},
+            {2, 6, 0, 0, 5, 5, 1, 0, 2, 0},
+        };
+
+        const uint8_t bc7Weights2[4] = {0, 21, 43, 64};
+        const uint8_t bc7Weights3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+        const uint8_t bc7Weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+        const uint8_t bc7Partitions2[64][16] = {
+            {0,0,1,1,0,0,1,1,0,0,1,1,0,0,1,1}, {0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1}, {0,1,1,1,0,1,1,1,0,1,1,1,0,1,1,1}, {0,0,0,1,0,0,1,1,0,0,1,1,0,1,1,1},
+            {0,0,0,0,0,0,0,1,0,0,0,1,0,0,1,1}, {0,0,1,1,0,1,1,1,0,1,1,1,1,1,1,1}, {0,0,0,1,0,0,1,1,0,1,1,1,1,1,1,1}, {0,0,0,0,0,0,0,1,0,0,1,1,0,1,1,1},
+            {0,0,0,0,0,0,0,0,0,0,0,1,0,0,1,1}, {0,0,1,1,0,1,1,1,1,1,1,1,1,1,1,1}, {0,0,0,0,0,0,0,1,0,1,1,1,1,1,1,1}, {0,0,0,0,0,0,0,0,0,0,0,1,0,1,1,1},
+            {0,0,0,1,0,1,1,1,1,1,1,1,1,1,1,1}, {0,0,0,0,0,0,0,0,1,1,1,1,1,1,1,1}, {0,0,0,0,1,1,1,1,1,1,1,1,1,1,1,1}, {0,0,0,0,0,0,0,0,0,0,0,0,1,1,1,1},
+            {0,0,0,0,1,0,0,0,1,1,1,0,1,1,1,1}, {0,1,1,1,0,0,0,1,0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,0,1,0,0,0,1,1,1,0}, {0,1,1,1,0,0,1,1,0,0,0,1,0,0,0,0},
+            {0,0,1,1,0,0,0,1,0,0,0,0,0,0,0,0}, {0,0,0,0,1,0,0,0,1,1,0,0,1,1,1,0}, {0,0,0,0,0,0,0,0,1,0,0,0,1,1,0,0}, {0,1,1,1,0,0,1,1,0,0,1,1,0,0,0,1},
+            {0,0,1,1,0,0,0,1,0,0,0,1,0,0,0,0}, {0,0,0,0,1,0,0,0,1,0,0,0,1,1,0,0}, {0,1,1,0,0,1,1,0,0,1,1,0,0,1,1,0}, {0,0,1,1,0,1,1,0,0,1,1,0,1,1,0,0},
+            {0,0,0,1,0,1,1,1,1,1,1,0,1,0,0,0}, {0,0,0,0,1,1,1,1,1,1,1,1,0,0,0,0}, {0,1,1,1,0,0,0,1,1,0,0,0,1,1,1,0}, {0,0,1,1,1,0,0,1,1,0,0,1,1,1,0,0},
+            {0,1,0,1,0,1,0,1,0,1,0,1,0,1,0,1}, {0,0,0,0,1,1,1,1,0,0,0,0,1,1,1,1}, {0,1,0,1,1,0,1,0,0,1,0,1,1,0,1,0}, {0,0,1,1,0,0,1,1,1,1,0,0,1,1,0,0},
+            {0,0,1,1,1,1,0,0,0,0,1,1,1,1,0,0}, {0,1,0,1,0,1,0,1,1,0,1,0,1,0,1,0}, {0,1,1,0,1,0,0,1,0,1,1,0,1,0,0,1}, {0,1,0,1,1,0,1,0,1,0,1,0,0,1,0,1},
+            {0,1,1,1,0,0,1,1,1,1,0,0,1,1,1,0}, {0,0,0,1,0,0,1,1,1,1,0,0,1,0,0,0}, {0,0,1,1,0,0,1,0,0,1,0,0,1,1,0,0}, {0,0,1,1,1,0,1,1,1,1,0,1,1,1,0,0},
+            {0,1,1,0,1,0,0,1,1,0,0,1,0,1,1,0}, {0,0,1,1,1,1,0,0,1,1,0,0,0,0,1,1}, {0,1,1,0,0,1,1,0,1,0,0,1,1,0,0,1}, {0,0,0,0,0,1,1,0,0,1,1,0,0,0,0,0},
+            {0,1,0,0,1,1,1,0,0,1,0,0,0,0,0,0}, {0,0,1,0,0,1,1,1,0,0,1,0,0,0,0,0}, {0,0,0,0,0,0,1,0,0,1,1,1,0,0,1,0}, {0,0,0,0,0,1,0,0,1,1,1,0,0,1,0,0},
+            {0,1,1,0,1,1,0,0,1,0,0,1,0,0,1,1}, {0,0,1,1,0,1,1,0,1,1,0,0,1,0,0,1}, {0,1,1,0,0,0,1,1,1,0,0,1,1,1,0,0}, {0,0,1,1,1,0,0,1,1,1,0,0,0,1,1,0},
+            {0,1,1,0,1,1,0,0,1,1,0,0,1,0,0,1}, {0,1,1,0,0,0,1,1,0,0,1,1,1,0,0,1}, {0,1,1,1,1,1,1,0,1,0,0,0,0,0,0,1}, {0,0,0,1,1,0,0,0,1,1,1,0,0,1,1,1},
+            {0,0,0,0,1,1,1,1,0,0,1,1,0,0,1,1}, {0,0,1,1,0,0,1,1,1,1,1,1,0,0,0,0}, {0,0,1,0,0,0,1,0,1,1,1,0,1,1,1,0}, {0,1,0,0,0,1,0,0,0,1,1,1,0,1,1,1},
+        };
+
+        const uint8_t bc7Partitions3[64][16] = {
+            {0,0,1,1,0,0,1,1,0,2,2,1,2,2,2,2}, {0,0,0,1,0,0,1,1,2,2,1,1,2,2,2,1}, {0,0,0,0,2,0,0,1,2,2,1,1,2,2,1,1}, {0,2,2,2,0,0,2,2,0,0,1,1,0,1,1,1},
+            {0,0,0,0,0,0,0,0,1,1,2,2,1,1,2,2}, {0,0,1,1,0,0,1,1,0,0,2,2,0,0,2,2}, {0,0,2,2,0,0,2,2,1,1,1,1,1,1,1,1}, {0,0,1,1,0,0,1,1,2,2,1,1,2,2,1,1},
+            {0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2}, {0,0,0,0,1,1,1,1,1,1,1,1,2,2,2,2}, {0,0,0,0,1,1,1,1,2,2,2,2,2,2,2,2}, {0,0,1,2,0,0,1,2,0,0,1,2,0,0,1,2},
+            {0,1,1,2,0,1,1,2,0,1,1,2,0,1,1,2}, {0,1,2,2,0,1,2,2,0,1,2,2,0,1,2,2}, {0,0,1,1,0,1,1,2,1,1,2,2,1,2,2,2}, {0,0,1,1,2,0,0,1,2,2,0,0,2,2,2,0},
+            {0,0,0,1,0,0,1,1,0,1,1,2,1,1,2,2}, {0,1,1,1,0,0,1,1,2,0,0,1,2,2,0,0}, {0,0,0,0,1,1,2,2,1,1,2,2,1,1,2,2}, {0,0,2,2,0,0,2,2,0,0,2,2,1,1,1,1},
+            {0,1,1,1,0,1,1,1,0,2,2,2,0,2,2,2}, {0,0,0,1,0,0,0,1,2,2,2,1,2,2,2,1}, {0,0,0,0,0,0,1,1,0,1,2,2,0,1,2,2}, {0,0,0,0,1,1,0,0,2,2,1,0,2,2,1,0},
+            {0,1,2,2,0,1,2,2,0,0,1,1,0,0,0,0}, {0,0,1,2,0,0,1,2,1,1,2,2,2,2,2,2}, {0,1,1,0,1,2,2,1,1,2,2,1,0,1,1,0}, {0,0,0,0,0,1,1,0,1,2,2,1,1,2,2,1},
+            {0,0,2,2,1,1,0,2,1,1,0,2,0,0,2,2}, {0,1,1,0,0,1,1,0,2,0,0,2,2,2,2,2}, {0,0,1,1,0,1,2,2,0,1,2,2,0,0,1,1}, {0,0,0,0,2,0,0,0,2,2,1,1,2,2,2,1},
+            {0,0,0,0,0,0,0,2,1,1,2,2,1,2,2,2}, {0,2,2,2,0,0,2,2,0,0,1,2,0,0,1,1}, {0,0,1,1,0,0,1,2,0,0,2,2,0,2,2,2}, {0,1,2,0,0,1,2,0,0,1,2,0,0,1,2,0},
+            {0,0,0,0,1,1,1,1,2,2,2,2,0,0,0,0}, {0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0}, {0,1,2,0,2,0,1,2,1,2,0,1,0,1,2,0}, {0,0,1,1,2,2,0,0,1,1,2,2,0,0,1,1},
+            {0,0,1,1,1,1,2,2,2,2,0,0,0,0,1,1}, {0,1,0,1,0,1,0,1,2,2,2,2,2,2,2,2}, {0,0,0,0,0,0,0,0,2,1,2,1,2,1,2,1}, {0,0,2,2,1,1,2,2,0,0,2,2,1,1,2,2},
+            {0,0,2,2,0,0,1,1,0,0,2,2,0,0,1,1}, {0,2,2,0,1,2,2,1,0,2,2,0,1,2,2,1}, {0,1,0,1,2,2,2,2,2,2,2,2,0,1,0,1}, {0,0,0,0,2,1,2,1,2,1,2,1,2,1,2,1},
+            {0,1,0,1,0,1,0,1,0,1,0,1,2,2,2,2}, {0,2,2,2,0,1,1,1,0,2,2,2,0,1,1,1}, {0,0,0,2,1,1,1,2,0,0,0,2,1,1,1,2}, {0,0,0,0,2,1,1,2,2,1,1,2,2,1,1,2},
+            {0,2,2,2,0,1,1,1,0,1,1,1,0,2,2,2}, {0,0,0,2,1,1,1,2,1,1,1,2,0,0,0,2}, {0,1,1,0,0,1,1,0,0,1,1,0,2,2,2,2}, {0,0,0,0,0,0,0,0,2,1,1,2,2,1,1,2},
+            {0,1,1,0,0,1,1,0,2,2,2,2,2,2,2,2}, {0,0,2,2,0,0,1,1,0,0,1,1,0,0,2,2}, {0,0,2,2,1,1,2,2,1,1,2,2,0,0,2,2}, {0,0,0,0,0,0,0,0,0,0,0,0,2,1,1,2},
+            {0,0,0,2,0,0,0,1,0,0,0,2,0,0,0,1}, {0,2,2,2,1,2,2,2,0,2,2,2,1,2,2,2}, {0,1,0,1,2,2,2,2,2,2,2,2,2,2,2,2}, {0,1,1,1,2,0,1,1,2,2,0,1,2,2,2,0},
+        };
+
+        const uint8_t bc7Anchors2[64] = {
+            15,15,15,15,15,15,15,15, 15,15,15,15,15,15,15,15, 15, 2, 8, 2, 2, 8, 8,15,  2, 8, 2, 2, 8, 8, 2, 2,
+            15,15, 6, 8, 2, 8,15,15,  2, 8, 2, 2, 2,15,15, 6,  6, 2, 6, 8,15,15, 2, 2, 15,15,15,15,15, 2, 2,15,
+        };
+
+        const uint8_t bc7Anchors3a[64] = {
+             3, 3,15,15, 8, 3,15,15,  8, 8, 6, 6, 6, 5, 3, 3,  3, 3, 8,15, 3, 3, 6,10,  5, 8, 8, 6, 8, 5,15,15,
+             8,15, 3, 5, 6,10, 8,15, 15, 3,15, 5,15,15,15,15,  3,15, 5, 5, 5, 8, 5,10,  5,10, 8,13,15,12, 3, 3,
+        };
+
+        const uint8_t bc7Anchors3b[64] = {
+            15, 8, 8, 3,15,15, 3, 8, 15,15,15,15,15,15,15, 8, 15, 8,15, 3,15, 8,15, 8,  3,15, 6,10,15,15,10, 8,
+            15, 3,15,10,10, 8, 9,10,  6,15, 8,15, 3, 6, 6, 8, 15, 3,15,15,15,15,15,15, 15,15,15,15, 3,15,15, 8,
+        };
+
+        int bc7Interpolate(int e0, int e1, int index, int indexBits){
+            const uint8_t* weights = indexBits == 2 ? bc7Weights2 : (indexBits == 3 ? bc7Weights3 : bc7Weights4);
+            int w = weights[index];
+            return ((64 - w) * e0 + w * e1 + 32) >> 6;
+        }
+
+        void decodeBC7(const uint8_t* data, Block& out){
+            int modeIndex = 0;
+            while (modeIndex < 8 && !(data[0] & (1 << modeIndex))) modeIndex++;
+            if (modeIndex == 8){                                        // reserved mode
+                memset(out, 0, sizeof(Block));
+                return;
+            }
+            const BC7Mode& mode = bc7Modes[modeIndex];
+            BitReader reader{data, modeIndex + 1};
+            int partition = reader.read(mode.partitionBits);
+            int rotation = reader.read(mode.rotationBits);
+            int indexSelection = reader.read(mode.indexSelectionBits);
+
+            int endpoints[3][2][4];
+            for (int c=0;c<3;c++){
+                for (int s=0;s<mode.subsets;s++){
+                    for (int e=0;e<2;e++){
+                        endpoints[s][e][c] = reader.read(mode.colorBits);
+                    }
+                }
+            }
+            for (int s=0;s<mode.subsets;s++){
+                for (int e=0;e<2;e++){
+                    endpoints[s][e][3] = reader.read(mode.alphaBits);
+                }
+            }
+            int colorBits = mode.colorBits;
+            int alphaBits = mode.alphaBits;
+            if (mode.endpointPBits || mode.sharedPBits){
+                for (int s=0;s<mode.subsets;s++){
+                    int p = 0;
+                    for (int e=0;e<2;e++){
+                        if (mode.endpointPBits || e == 0) p = reader.read(1);
+                        for (int c=0;c<4;c++){
+                            endpoints[s][e][c] = endpoints[s][e][c] << 1 | p;
+                        }
+                    }
+                }
+                colorBits++;
+                if (alphaBits) alphaBits++;
+            }
+            for (int s=0;s<mode.subsets;s++){
+                for (int e=0;e<2;e++){
+                    for (int c=0;c<4;c++){
+                        int bits = c < 3 ? colorBits : alphaBits;
+                        int& v = endpoints[s][e][c];
+                        v = bits == 0 ? 255 : ((v << (8 - bits)) | (v >> (2 * bits - 8)));
+                    }
+                }
+            }
+
+            int subsetOfPixel[16];
+            bool anchor[16];
+            for (int i=0;i<16;i++){
+                subsetOfPixel[i] = mode.subsets == 1 ? 0 : (mode.subsets == 2 ? bc7Partitions2[partition][i] : bc7Partitions3[partition][i]);
+                anchor[i] = i == 0 ||
+                        (mode.subsets == 2 && i == bc7Anchors2[partition]) ||
+                        (mode.subsets == 3 && (i == bc7Anchors3a[partition] || i == bc7Anchors3b[partition]));
+            }
+            int indices[16], indices2[16];
+            for (int i=0;i<16;i++){
+                indices[i] = reader.read(mode.indexBits - (anchor[i] ? 1 : 0));
+            }
+            if (mode.index2Bits){
+                for (int i=0;i<16;i++){
+                    indices2[i] = reader.read(mode.index2Bits - (i == 0 ? 1 : 0));
+                }
+            }
+
+            for (int i=0;i<16;i++){
+                int (&e)[2][4] = endpoints[subsetOfPixel[i]];
+                int colorIndex = indices[i], colorIndexBits = mode.indexBits;
+                int alphaIndex = indices[i], alphaIndexBits = mode.indexBits;
+                if (mode.index2Bits){
+                    if (indexSelection){
+                        colorIndex = indices2[i];
+                        colorIndexBits = mode.index2Bits;
+                    } else {
+                        alphaIndex = indices2[i];
+                        alphaIndexBits = mode.index2Bits;
+                    }
+                }
+                for (int c=0;c<3;c++){
+                    out[i][c] = (uint8_t)bc7Interpolate(e[0][c], e[1][c], colorIndex, colorIndexBits);
+                }
+                out[i][3] = (uint8_t)bc7Interpolate(e[0][3], e[1][3], alphaIndex, alphaIndexBits);
+                if (rotation){
+                    std::swap(out[i][3], out[i][rotation - 1]);
+                }
+            }
+        }
+
+        // Encodes using mode 6 only (single subset RGBA with 4 bit indices)
+        void encodeBC7(const Block& block, uint8_t* out){
+            int minColor[4], maxColor[4];
+            findEndpoints(block, 4, minColor, maxColor);
+            int quantized[2][4];
+            int pBits[2];
+            int endpoints[2][4];
+            for (int e=0;e<2;e++){
+                const int* color = e == 0 ? minColor : maxColor;
+                int bestError = -1;
+                for (int p=0;p<2;p++){
+                    int error = 0;
+                    int q[4];
+                    for (int c=0;c<4;c++){
+                        q[c] = std::min(127, std::max(0, (color[c] - p + 1) / 2));
+                        int d = ((q[c] << 1) | p) - color[c];
+                        error += d*d;
+                    }
+                    if (bestError < 0 || error < bestError){
+                        bestError = error;
+                        pBits[e] = p;
+                        memcpy(quantized[e], q, sizeof(q));
+                    }
+                }
+                for (int c=0;c<4;c++){
+                    endpoints[e][c] = (quantized[e][c] << 1) | pBits[e];
+                }
+            }
+            uint8_t palette[16][4];
+            for (int i=0;i<16;i++){
+                for (int c=0;c<4;c++){
+                    palette[i][c] = (uint8_t)bc7Interpolate(endpoints[0][c], endpoints[1][c], i, 4);
+                }
+            }
+            int indices[16];
+            for (int i=0;i<16;i++){
+                int best = 0;
+                int bestDist = colorDistance(block[i], palette[0], 4);
+                for (int p=1;p<16;p++){
+                    int dist = colorDistance(block[i], palette[p], 4);
+                    if (dist < bestDist){
+                        bestDist = dist;
+                        best = p;
+                    }
+                }
+                indices[i] = best;
+            }
+            if (indices[0] & 8){                                        // the anchor index must have its top bit clear
+                std::swap(quantized[0], quantized[1]);
+                std::swap(pBits[0], pBits[1]);
+                for (int i=0;i<16;i++){
+                    indices[i] = 15 - indices[i];
+                }
+            }
+            memset(out, 0, 16);
+            BitWriter writer{out, 0};
+            writer.write(1 << 6, 7);
+            for (int c=0;c<4;c++){
+                writer.write(quantized[0][c], 7);
+                writer.write(quantized[1][c], 7);
+            }
+            writer.write(pBits[0], 1);
+            writer.write(pBits[1], 1);
+            for (int i=0;i<16;i++){
+                writer.write(indices[i], i == 0 ? 3 : 4);
+            }
+        }
+
+        // ETC2
+
+        const int etc1Modifiers[8][2] = {{2,8}, {5,17}, {9,29}, {13,42}, {18,60}, {24,80}, {33,106}, {47,183}};
+        const int etc2Distances[8] = {3, 6, 11, 16, 23, 32, 41, 64};
+        const int eacModifiers[16][8] = {
+            {-3,-6,-9,-15,2,5,8,14}, {-3,-7,-10,-13,2,6,9,12}, {-2,-5,-8,-13,1,4,7,12}, {-2,-4,-6,-13,1,3,5,12},
+            {-3,-6,-8,-12,2,5,7,11}, {-3,-7,-9,-11,2,6,8,10}, {-4,-7,-8,-11,3,6,7,10}, {-3,-5,-8,-11,2,4,7,10},
+            {-2,-6,-8,-10,1,5,7,9}, {-2,-5,-8,-10,1,4,7,9}, {-2,-4,-8,-10,1,3,7,9}, {-2,-5,-7,-10,1,4,6,9},
+            {-3,-4,-7,-10,2,3,6,9}, {-1,-2,-3,-10,0,1,2,9}, {-4,-6,-8,-9,3,5,7,8}, {-3,-5,-7,-9,2,4,6,8},
+        };
+
+        uint64_t readBigEndian64(const uint8_t* data){
+            uint64_t res = 0;
+            for (int i=0;i<8;i++){
+                res = res << 8 | data[i];
+            }
+            return res;
+        }
+
+        void writeBigEndian64(uint64_t value, uint8_t* out){
+            for (int i=0;i<8;i++){
+                out[i] = (uint8_t)(value >> (56 - 8*i));
+            }
+        }
+
+        int extend4(int v){ return v << 4 | v; }
+        int extend5(int v){ return v << 3 | v >> 2; }
+        int extend6(int v){ return v << 2 | v >> 4; }
+        int extend7(int v){ return v << 1 | v >> 6; }
+        int signExtend3(int v){ return v >= 4 ? v - 8 : v; }
+
+        // Pixel indices are stored column major: bit 16+i holds the msb and bit i the lsb
+        int etcPixelIndex(uint64_t bits, int x, int y){
+            int i = x*4 + y;
+            return (int)(((bits >> (16 + i)) & 1) << 1 | ((bits >> i) & 1));
+        }
+
+        void decodeETC2(const uint8_t* data, Block& out){
+            uint64_t bits = readBigEndian64(data);
+            bool differential = (bits >> 33) & 1;
+            int base[2][3];
+            if (differential){
+                int r = (bits >> 59) & 31, dr = signExtend3((bits >> 56) & 7);
+                int g = (bits >> 51) & 31, dg = signExtend3((bits >> 48) & 7);
+                int b = (bits >> 43) & 31, db = signExtend3((bits >> 40) & 7);
+                if (r + dr < 0 || r + dr > 31){                         // T mode
+                    int color[2][3] = {
+                        {extend4((int)(((bits >> 59) & 3) << 2 | ((bits >> 56) & 3))), extend4((bits >> 52) & 15), extend4((bits >> 48) & 15)},
+                        {extend4((bits >> 44) & 15), extend4((bits >> 40) & 15), extend4((bits >> 36) & 15)}
+                    };
+                    int distance = etc2Distances[((bits >> 33) & 6) | ((bits >> 32) & 1)];
+                    int paint[4][3];
+                    for (int c=0;c<3;c++){
+                        paint[0][c] = color[0][c];
+                        paint[1][c] = clamp255(color[1][c] + distance);
+                        paint[2][c] = color[1][c];
+                        paint[3][c] = clamp255(color[1][c] - distance);
+                    }
+                    for (int y=0;y<4;y++) for (int x=0;x<4;x++){
+                        int idx = etcPixelIndex(bits, x, y);
+                        for (int c=0;c<3;c++) out[x+y*4][c] = (uint8_t)paint[idx][c];
+                        out[x+y*4][3] = 255;
+                    }
+                    return;
+                }
+                if (g + dg < 0 || g + dg > 31){                         // H mode
+                    int color[2][3] = {
+                        {extend4((bits >> 59) & 15), extend4((int)(((bits >> 56) & 7) << 1 | ((bits >> 52) & 1))), extend4((int)(((bits >> 51) & 1) << 3 | ((bits >> 47) & 7)))},
+                        {extend4((bits >> 43) & 15), extend4((bits >> 39) & 15), extend4((bits >> 35) & 15)}
+                    };
+                    int value0 = color[0][0] << 16 | color[0][1] << 8 | color[0][2];
+                    int value1 = color[1][0] << 16 | color[1][1] << 8 | color[1][2];
+                    int distance = etc2Distances[((bits >> 32) & 4) | ((bits >> 31) & 2) | (value0 >= value1 ? 1 : 0)];
+                    int paint[4][3];
+                    for (int c=0;c<3;c++){
+                        paint[0][c] = clamp255(color[0][c] + distance);
+                        paint[1][c] = clamp255(color[0][c] - distance);
+                        paint[2][c] = clamp255(color[1][c] + distance);
+                        paint[3][c] = clamp255(color[1][c] - distance);
+                    }
+                    for (int y=0;y<4;y++) for (int x=0;x<4;x++){
+                        int idx = etcPixelIndex(bits, x, y);
+                        for (int c=0;c<3;c++) out[x+y*4][c] = (uint8_t)paint[idx][c];
+                        out[x+y*4][3] = 255;
+                    }
+                    return;
+                }
+                if (b + db < 0 || b + db > 31){                         // planar mode
+                    int o[3] = {extend6((bits >> 57) & 63),
+                                extend7((int)(((bits >> 56) & 1) << 6 | ((bits >> 49) & 63))),
+                                extend6((int)(((bits >> 48) & 1) << 5 | ((bits >> 43) & 3) << 3 | ((bits >> 39) & 7)))};
+                    int h[3] = {extend6((int)(((bits >> 34) & 31) << 1 | ((bits >> 32) & 1))), extend7((bits >> 25) & 127), extend6((bits >> 19) & 63)};
+                    int v[3] = {extend6((bits >> 13) & 63), extend7((bits >> 6) & 127), extend6(bits & 63)};
+                    for (int y=0;y<4;y++) for (int x=0;x<4;x++){
+                        for (int c=0;c<3;c++){
+                            out[x+y*4][c] = (uint8_t)clamp255((x * (h[c] - o[c]) + y * (v[c] - o[c]) + 4 * o[c] + 2) >> 2);
+                        }
+                        out[x+y*4][3] = 255;
+                    }
+                    return;
+                }
+                int base5[2][3] = {{r, g, b}, {r + dr, g + dg, b + db}};
+                for (int s=0;s<2;s++) for (int c=0;c<3;c++) base[s][c] = extend5(base5[s][c]);
+            } else {
+                for (int c=0;c<3;c++){
+                    base[0][c] = extend4((bits >> (60 - 8*c)) & 15);
+                    base[1][c] = extend4((bits >> (56 - 8*c)) & 15);
+                }
+            }
+            int codewords[2] = {(int)((bits >> 37) & 7), (int)((bits >> 34) & 7)};
+            bool flip = (bits >> 32) & 1;
+            for (int y=0;y<4;y++) for (int x=0;x<4;x++){
+                int subblock = flip ? (y >= 2) : (x >= 2);
+                int idx = etcPixelIndex(bits, x, y);
+                int modifier = etc1Modifiers[codewords[subblock]][idx & 1] * ((idx & 2) ? -1 : 1);
+                for (int c=0;c<3;c++) out[x+y*4][c] = (uint8_t)clamp255(base[subblock][c] + modifier);
+                out[x+y*4][3] = 255;
+            }
+        }
+
+        // Finds the best codeword and pixel indices for a subblock with a given base color. Returns the error.
+        int fitETCSubblock(const Block& block, bool flip, int subblock, const int* base, int& codeword, int indices[16]){
+            int bestError = -1;
+            int candidateIndices[16];
+            for (int cw=0;cw<8;cw++){
+                int error = 0;
+                for (int y=0;y<4;y++) for (int x=0;x<4;x++){
+                    if ((flip ? (y >= 2) : (x >= 2)) != (subblock == 1)) continue;
+                    int best = 0, bestDist = -1;
+                    for (int idx=0;idx<4;idx++){
+                        int modifier = etc1Modifiers[cw][idx & 1] * ((idx & 2) ? -1 : 1);
+                        int dist = 0;
+                        for (int c=0;c<3;c++){
+                            int d = clamp255(base[c] + modifier) - block[x+y*4][c];
+                            dist += d*d;
+                        }
+                        if (bestDist < 0 || dist < bestDist){
+                            bestDist = dist;
+                            best = idx;
+                        }
+                    }
+                    candidateIndices[x*4+y] = best;
+                    error += bestDist;
+                }
+                if (bestError < 0 || error < bestError){
+                    bestError = error;
+                    codeword = cw;
+                    for (int y=0;y<4;y++) for (int x=0;x<4;x++){
+                        if ((flip ? (y >= 2) : (x >= 2)) == (subblock == 1)) indices[x*4+y] = candidateIndices[x*4+y];
+                    }
+                }
+            }
+            return bestError;
+        }
+
+        // Encodes using the ETC1 compatible individual and differential modes
+        void encodeETC2(const Block& block, uint8_t* out){
+            uint64_t bestBits = 0;
+            int bestError = -1;
+            for (int flip=0;flip<2;flip++){
+                int average[2][3] = {{0,0,0},{0,0,0}};
+                for (int y=0;y<4;y++) for (int x=0;x<4;x++){
+                    int subblock = flip ? (y >= 2) : (x >= 2);
+                    for (int c=0;c<3;c++) average[subblock][c] += block[x+y*4][c];
+                }
+                int base4[2][3], base5[2][3];
+                bool differential = true;
+                for (int s=0;s<2;s++) for (int c=0;c<3;c++){
+                    base4[s][c] = (average[s][c] + 8*17/2) / (8*17);
+                    base5[s][c] = (average[s][c] * 31 + 8*255/2) / (8*255);
+                }
+                for (int c=0;c<3;c++){
+                    int d = base5[1][c] - base5[0][c];
+                    if (d < -4 || d > 3) differential = false;
+                }
+                for (int mode=0;mode<2;mode++){
+                    bool useDifferential = mode == 1;
+                    if (useDifferential && !differential) continue;
+                    int error = 0;
+                    int codewords[2];
+                    int indices[16];
+                    for (int s=0;s<2;s++){
+                        int base[3];
+                        for (int c=0;c<3;c++) base[c] = useDifferential ? extend5(base5[s][c]) : extend4(base4[s][c]);
+                        error += fitETCSubblock(block, flip == 1, s, base, codewords[s], indices);
+                    }
+                    if (bestError >= 0 && error >= bestError) continue;
+                    bestError = error;
+                    uint64_t bits = 0;
+                    for (int c=0;c<3;c++){
+                        if (useDifferential){
+                            bits |= (uint64_t)base5[0][c] << (59 - 8*c);
+                            bits |= (uint64_t)((base5[1][c] - base5[0][c]) & 7) << (56 - 8*c);
+                        } else {
+                            bits |= (uint64_t)base4[0][c] << (60 - 8*c);
+                            bits |= (uint64_t)base4[1][c] << (56 - 8*c);
+                        }
+                    }
+                    bits |= (uint64_t)codewords[0] << 37 | (uint64_t)codewords[1] << 34 | (uint64_t)(useDifferential ? 1 : 0) << 33 | (uint64_t)flip << 32;
+                    for (int i=0;i<16;i++){
+                        bits |= (uint64_t)(indices[i] >> 1) << (16 + i) | (uint64_t)(indices[i] & 1) << i;
+                    }
+                    bestBits = bits;
+                }
+            }
+            writeBigEndian64(bestBits, out);
+        }
+
+        void decodeEAC(const uint8_t* data, uint8_t* out, int stride){
+            uint64_t bits = readBigEndian64(data);
+            int base = (int)(bits >> 56);
+            int multiplier = (int)((bits >> 52) & 15);
+            const int* modifiers = eacModifiers[(bits >> 48) & 15];
+            for (int y=0;y<4;y++) for (int x=0;x<4;x++){
+                int i = x*4 + y;
+                out[(x+y*4)*stride] = (uint8_t)clamp255(base + modifiers[(bits >> (45 - 3*i)) & 7] * multiplier);
+            }
+        }
+
+        void encodeEAC(const Block& block, int channel, uint8_t* out){
+            int minValue = 255, maxValue = 0;
+            for (int i=0;i<16;i++){
+                minValue = std::min(minValue, (int)block[i][channel]);
+                maxValue = std::max(maxValue, (int)block[i][channel]);
+            }
+            uint64_t bestBits = 0;
+            int bestError = -1;
+            for (int table=0;table<16 && bestError != 0;table++){
+                const int* modifiers = eacModifiers[table];
+                int range = modifiers[7] - modifiers[3];
+                for (int multiplier=1;multiplier<16 && bestError != 0;multiplier++){
+                    int base = clamp255((minValue + maxValue - (modifiers[3] + modifiers[7]) * multiplier + 1) / 2);
+                    if (range * multiplier < (maxValue - minValue) / 2 && multiplier < 15) continue;   // cannot span the values
+                    int error = 0;
+                    uint64_t bits = (uint64_t)base << 56 | (uint64_t)multiplier << 52 | (uint64_t)table << 48;
+                    for (int y=0;y<4;y++) for (int x=0;x<4;x++){
+                        int value = block[x+y*4][channel];
+                        int best = 0, bestDist = -1;
+                        for (int idx=0;idx<8;idx++){
+                            int d = std::abs(clamp255(base + modifiers[idx] * multiplier) - value);
+                            if (bestDist < 0 || d < bestDist){
+                                bestDist = d;
+                                best = idx;
+                            }
+                        }
+                        error += bestDist * bestDist;
+                        bits |= (uint64_t)best << (45 - 3*(x*4+y));
+                    }
+                    if (bestError < 0 || error < bestError){
+                        bestError = error;
+                        bestBits = bits;
+                    }
+                }
+            }
+            writeBigEndian64(bestBits, out);
+        }
+
+        void decodeBlock(CompressedFormat format, const uint8_t* data, Block& out){
+            switch (format){
+                case CompressedFormat::BC1:
+                    decodeBC1(data, out, true);
+                    break;
+                case CompressedFormat::BC3:
+                    decodeBC1(data + 8, out, false);
+                    decodeBC4(data, &out[0][3], 4);
+                    break;
+                case CompressedFormat::BC4:
+                case CompressedFormat::BC5:
+                    memset(out, 0, sizeof(Block));
+                    decodeBC4(data, &out[0][0], 4);
+                    if (format == CompressedFormat::BC5){
+                        decodeBC4(data + 8, &out[0][1], 4);
+                    }
+                    for (int i=0;i<16;i++) out[i][3] = 255;
+                    break;
+                case CompressedFormat::BC7:
+                    decodeBC7(data, out);
+                    break;
+                case CompressedFormat::ETC2_RGB:
+                    decodeETC2(data, out);
+                    break;
+                case CompressedFormat::ETC2_RGBA:
+                    decodeETC2(data + 8, out);
+                    decodeEAC(data, &out[0][3], 4);
+                    break;
+            }
+        }
+
+        void encodeBlock(CompressedFormat format, const Block& block, uint8_t* out){
+            switch (format){
+                case CompressedFormat::BC1:
+                    encodeBC1(block, out);
+                    break;
+                case CompressedFormat::BC3:
+                    encodeBC4(block, 3, out);
+                    encodeBC1(block, out + 8);
+                    break;
+                case CompressedFormat::BC4:
+                    encodeBC4(block, 0, out);
+                    break;
+                case CompressedFormat::BC5:
+                    encodeBC4(block, 0, out);
+                    encodeBC4(block, 1, out + 8);
+                    break;
+                case CompressedFormat::BC7:
+                    encodeBC7(block, out);
+                    break;
+                case CompressedFormat::ETC2_RGB:
+                    encodeETC2(block, out);
+                    break;
+                case CompressedFormat::ETC2_RGBA:
+                    encodeEAC(block, 3, out);
+                    encodeETC2(block, out + 8);
+                    break;
+            }
+        }
+
+        bool findFormat(uint32_t id, bool dxgi, CompressedImage& image){
+            for (auto & info : formatInfos){
+                uint32_t linearId = dxgi ? info.dxgiFormat : info.vkFormat;
+                uint32_t srgbId = dxgi ? info.dxgiFormatSRGB : info.vkFormatSRGB;
+                if (linearId != 0 && id == linearId){
+                    image.format = info.format;
+                    image.srgb = false;
+                    return true;
+                }
+                if (srgbId != 0 && id == srgbId){
+                    image.format = info.format;
+                    image.srgb = true;
+                    return true;
+                }
+            }
+            // BC1 without alpha uses the same block layout
+            if (!dxgi && (id == 131 || id == 132)){
+                image.format = CompressedFormat::BC1;
+                image.srgb = id == 132;
+                return true;
+            }
+            return false;
+        }
+
+        const uint32_t maxImageSize = 32768;                        // not smaller than GL_MAX_TEXTURE_SIZE of current GPUs
+
+        uint64_t levelBytes(CompressedFormat format, int width, int height){
+            return (uint64_t)((width + 3) / 4) * (uint64_t)((height + 3) / 4) * (uint64_t)TextureCompression::getBlockBytes(format);
+        }
+
+        // Validate the size read from the header (before any level sizes are computed)
+        bool validateSize(uint32_t width, uint32_t height, uint32_t levelCount, CompressedImage& image, std::string& error){
+            if (width == 0 || height == 0 || width > maxImageSize || height > maxImageSize){
+                error = "Invalid image size "+std::to_string(width)+"x"+std::to_string(height);
+                return false;
+            }
+            int maxLevels = 1;
+            while ((std::max(width, height) >> maxLevels) > 0){
+                maxLevels++;
+            }
+            if (levelCount > (uint32_t)maxLevels){
+                error = "Invalid mip level count "+std::to_string(levelCount);
+                return false;
+            }
+            image.width = (int)width;
+            image.height = (int)height;
+            return true;
+        }
+
+        bool readLevels(const std::vector<char>& fileData, size_t offset, int levelCount, CompressedImage& image, std::string& error){
+            for (int i=0;i<levelCount;i++){
+                uint64_t size = levelBytes(image.format, std::max(1, image.width >> i), std::max(1, image.height >> i));
+                if (offset > fileData.size() || size > fileData.size() - offset){
+                    error = "Truncated file (mip level "+std::to_string(i)+")";
+                    return false;
+                }
+                image.levels.emplace_back(fileData.begin() + offset, fileData.begin() + offset + size);
+                offset += size;
+            }
+            return true;
+        }
+
+        bool loadDDS(const std::vector<char>& fileData, CompressedImage& image, std::string& error){
+            if (fileData.size() < 128 || readU32(fileData, 4) != 124){
+                error = "Invalid DDS header";
+                return false;
+            }
+            uint32_t levelCount = std::max<uint32_t>(1, readU32(fileData, 28));
+            if (!validateSize(readU32(fileData, 16), readU32(fileData, 12), levelCount, image, error)){
+                return false;
+            }
+            uint32_t pixelFormatFlags = readU32(fileData, 80);
+            uint32_t formatId = readU32(fileData, 84);
+            uint32_t caps2 = readU32(fileData, 112);
+            if (caps2 & (0x200 | 0x200000)){
+                error = "DDS cubemaps and volume textures are not supported";
+                return false;
+            }
+            if (!(pixelFormatFlags & 0x4)){
+                error = "DDS file is not block compressed";
+                return false;
+            }
+            size_t offset = 128;
+            bool found = false;
+            if (formatId == fourCC("DX10")){
+                if (fileData.size() < 148){
+                    error = "Invalid DDS header";
+                    return false;
+                }
+                if (readU32(fileData, 132) != 3 || readU32(fileData, 140) > 1){
+                    error = "Only 2D DDS textures are supported";
+                    return false;
+                }
+                found = findFormat(readU32(fileData, 128), true, image);
+                offset = 148;
+            } else {
+                for (auto & info : formatInfos){
+                    if (info.fourCC && formatId == fourCC(info.fourCC)){
+                        image.format = info.format;
+                        found = true;
+                    }
+                }
+                if (formatId == fourCC("BC4U")) { image.format = CompressedFormat::BC4; found = true; }
+                if (formatId == fourCC("BC5U")) { image.format = CompressedFormat::BC5; found = true; }
+            }
+            if (!found){
+                error = "Unsupported DDS format";
+                return false;
+            }
+            return readLevels(fileData, offset, (int)levelCount, image, error);
+        }
+
+        bool loadKTX2(const std::vector<char>& fileData, CompressedImage& image, std::string& error){
+            if (fileData.size() < 80){
+                error = "Invalid KTX2 header";
+                return false;
+            }
+            if (!findFormat(readU32(fileData, 12), false, image)){
+                error = "Unsupported KTX2 format "+std::to_string(readU32(fileData, 12));
+                return false;
+            }
+            if (readU32(fileData, 28) > 0 || readU32(fileData, 32) > 1 || readU32(fileData, 36) != 1){
+                error = "Only 2D KTX2 textures are supported";
+                return false;
+            }
+            uint32_t levelCount = std::max<uint32_t>(1, readU32(fileData, 40));
+            if (!validateSize(readU32(fileData, 20), readU32(fileData, 24), levelCount, image, error)){
+                return false;
+            }
+            if (readU32(fileData, 44) != 0){
+                error = "Supercompressed KTX2 files are not supported";
+                return false;
+            }
+            if (fileData.size() < 80 + 24 * (size_t)levelCount){
+                error = "Invalid KTX2 level index";
+                return false;
+            }
+            for (int i=0;i<(int)levelCount;i++){
+                uint64_t offset = readU64(fileData, 80 + 24*i);
+                uint64_t length = readU64(fileData, 80 + 24*i + 8);
+                CompressedImage levelImage = image;
+                levelImage.levels.clear();
+                levelImage.width = std::max(1, image.width >> i);
+                levelImage.height = std::max(1, image.height >> i);
+                if (length < levelBytes(image.format, levelImage.width, levelImage.height) || offset > fileData.size() ||
+                    !readLevels(fileData, (size_t)offset, 1, levelImage, error)){
+                    error = "Invalid KTX2 mip level "+std::to_string(i);
+                    return false;
+                }
+                image.levels.push_back(std::move(levelImage.levels[0]));
+            }
+            return true;
+        }
+
+        // Data format descriptor (a KTX2 requirement) describing the block layout
+        std::vector<char> createDataFormatDescriptor(const CompressedImage& image){
+            struct Sample { uint32_t channel, offset, length; };
+            uint32_t colorModel = 0;
+            std::vector<Sample> samples;
+            switch (image.format){
+                case CompressedFormat::BC1: colorModel = 128; samples = {{0, 0, 64}}; break;
+                case CompressedFormat::BC3: colorModel = 130; samples = {{15, 0, 64}, {0, 64, 64}}; break;
+                case CompressedFormat::BC4: colorModel = 131; samples = {{0, 0, 64}}; break;
+                case CompressedFormat::BC5: colorModel = 132; samples = {{0, 0, 64}, {1, 64, 64}}; break;
+                case CompressedFormat::BC7: colorModel = 134; samples = {{0, 0, 128}}; break;
+                case CompressedFormat::ETC2_RGB: colorModel = 161; samples = {{2, 0, 64}}; break;
+                case CompressedFormat::ETC2_RGBA: colorModel = 161; samples = {{15, 0, 64}, {2, 64, 64}}; break;
+            }
+            uint32_t blockSize = 24 + 16 * (uint32_t)samples.size();
+            std::vector<char> res(4 + blockSize, 0);
+            writeU32(res, 0, (uint32_t)res.size());
+            writeU32(res, 4, 0);                                        // vendor Khronos, basic descriptor
+            writeU32(res, 8, 2 | blockSize << 16);                      // version 1.3
+            writeU32(res, 12, colorModel | 1 << 8 | (image.srgb ? 2 : 1) << 16);   // BT.709 primaries
+            writeU32(res, 16, 3 | 3 << 8);                              // 4x4 texel block
+            writeU32(res, 20, (uint32_t)TextureCompression::getBlockBytes(image.format));
+            for (size_t i=0;i<samples.size();i++){
+                size_t offset = 28 + 16*i;
+                writeU32(res, offset, samples[i].offset | (samples[i].length - 1) << 16 | samples[i].channel << 24);
+                writeU32(res, offset + 4, 0);
+                writeU32(res, offset + 8, 0);
+                writeU32(res, offset + 12, 0xFFFFFFFF);
+            }
+            return res;
+        }
+    }
+
+    bool TextureCompression::isCompressedFile(const std::vector<char>& fileData) {
+        if (fileData.size() >= 4 && readU32(fileData, 0) == fourCC("DDS ")){
+            return true;
+        }
+        return fileData.size() >= sizeof(ktx2Identifier) && memcmp(fileData.data(), ktx2Identifier, sizeof(ktx2Identifier)) == 0;
+    }
+
+    bool TextureCompression::load(const std::vector<char>& fileData, CompressedImage& image, std::string& error) {
+        image.levels.clear();
+        bool res;
+        if (fileData.size() >= 4 && readU32(fileData, 0) == fourCC("DDS ")){
+            res = loadDDS(fileData, image, error);
+        } else if (isCompressedFile(fileData)){
+            res = loadKTX2(fileData, image, error);
+        } else {
+            error = "Not a KTX2 or DDS file";
+            return false;
+        }
+        if (res && (image.width <= 0 || image.height <= 0)){
+            error = "Invalid image size";
+            res = false;
+        }
+        return res;
+    }
+
+    std::vector<char> TextureCompression::saveKTX2(const CompressedImage& image) {
+        auto levelCount = image.levels.size();
+        auto dfd = createDataFormatDescriptor(image);
+        size_t dfdOffset = 80 + 24 * levelCount;
+        size_t dataOffset = (dfdOffset + dfd.size() + 15) & ~(size_t)15;
+        std::vector<char> res(dataOffset, 0);
+        memcpy(res.data(), ktx2Identifier, sizeof(ktx2Identifier));
+        auto& info = getInfo(image.format);
+        writeU32(res, 12, image.srgb && info.vkFormatSRGB ? info.vkFormatSRGB : info.vkFormat);
+        writeU32(res, 16, 1);                                           // type size
+        writeU32(res, 20, (uint32_t)image.width);
+        writeU32(res, 24, (uint32_t)image.height);
+        writeU32(res, 36, 1);                                           // face count
+        writeU32(res, 40, (uint32_t)levelCount);
+        writeU32(res, 48, (uint32_t)dfdOffset);
+        writeU32(res, 52, (uint32_t)dfd.size());
+        memcpy(res.data() + dfdOffset, dfd.data(), dfd.size());
+        // mip levels are stored from the smallest to the largest
+        for (size_t i = levelCount; i-- > 0;){
+            size_t offset = (res.size() + 15) & ~(size_t)15;
+            res.resize(offset, 0);
+            writeU64(res, 80 + 24*i, offset);
+            writeU64(res, 80 + 24*i + 8, image.levels[i].size());
+            writeU64(res, 80 + 24*i + 16, image.levels[i].size());
+            res.insert(res.end(), image.levels[i].begin(), image.levels[i].end());
+        }
+        return res;
+    }
+
+    std::vector<char> TextureCompression::saveDDS(const CompressedImage& image) {
+        auto& info = getInfo(image.format);
+        if (info.dxgiFormat == 0){
+            return {};
+        }
+        bool dx10 = info.fourCC == nullptr || (image.srgb && info.dxgiFormatSRGB);
+        std::vector<char> res(dx10 ? 148 : 128, 0);
+        auto levelCount = (uint32_t)image.levels.size();
+        writeU32(res, 0, fourCC("DDS "));
+        writeU32(res, 4, 124);
+        writeU32(res, 8, 0x1 | 0x2 | 0x4 | 0x1000 | 0x80000 | (levelCount > 1 ? 0x20000 : 0));
+        writeU32(res, 12, (uint32_t)image.height);
+        writeU32(res, 16, (uint32_t)image.width);
+        writeU32(res, 20, (uint32_t)getLevelBytes(image.format, image.width, image.height));
+        writeU32(res, 28, levelCount);
+        writeU32(res, 76, 32);
+        writeU32(res, 80, 0x4);                                         // DDPF_FOURCC
+        writeU32(res, 84, fourCC(dx10 ? "DX10" : info.fourCC));
+        writeU32(res, 108, 0x1000 | (levelCount > 1 ? 0x8 | 0x400000 : 0));
+        if (dx10){
+            writeU32(res, 128, image.srgb && info.dxgiFormatSRGB ? info.dxgiFormatSRGB : info.dxgiFormat);
+            writeU32(res, 132, 3);                                      // 2D texture
+            writeU32(res, 140, 1);                                      // array size
+        }
+        for (auto & level : image.levels){
+            res.insert(res.end(), level.begin(), level.end());
+        }
+        return res;
+    }
+
+    int TextureCompression::getBlockBytes(CompressedFormat format) {
+        switch (format){
+            case CompressedFormat::BC1:
+            case CompressedFormat::BC4:
+            case CompressedFormat::ETC2_RGB:
+                return 8;
+            default:
+                return 16;
+        }
+    }
+
+    int TextureCompression::getLevelBytes(CompressedFormat format, int width, int height) {
+        return ((width + 3) / 4) * ((height + 3) / 4) * getBlockBytes(format);
+    }
+
+    bool TextureCompression::hasAlpha(CompressedFormat format) {
+        return format == CompressedFormat::BC3 || format == CompressedFormat::BC7 || format == CompressedFormat::ETC2_RGBA;
+    }
+
+    uint32_t TextureCompression::getGLFormat(CompressedFormat format, bool srgb) {
+        auto& info = getInfo(format);
+        return srgb ? info.glFormatSRGB : info.glFormat;
+    }
+
+    const char* TextureCompression::getName(CompressedFormat format) {
+        return getInfo(format).name;
+    }
+
+    std::vector<char> TextureCompression::decompress(CompressedFormat format, const char* data, int width, int height) {
+        std::vector<char> res((size_t)width * height * 4);
+        int blockBytes = getBlockBytes(format);
+        int blocksX = (width + 3) / 4;
+        int blocksY = (height + 3) / 4;
+        Block block;
+        for (int by=0;by<blocksY;by++){
+            for (int bx=0;bx<blocksX;bx++){
+                decodeBlock(format, (const uint8_t*)data + (by * blocksX + bx) * blockBytes, block);
+                for (int y=0;y<4 && by*4+y < height;y++){
+                    int pixels = std::min(4, width - bx*4);
+                    memcpy(&res[((by*4+y) * (size_t)width + bx*4) * 4], block[y*4], (size_t)pixels * 4);
+                }
+            }
+        }
+        return res;
+    }
+
+    std::vector<char> TextureCompression::compress(CompressedFormat format, const char* rgba, int width, int height, int firstBlockRow, int blockRows) {
+        int blockBytes = getBlockBytes(format);
+        int blocksX = (width + 3) / 4;
+        int blocksY = (height + 3) / 4;
+        int lastBlockRow = blockRows < 0 ? blocksY : std::min(blocksY, firstBlockRow + blockRows);
+        std::vector<char> res((size_t)std::max(0, lastBlockRow - firstBlockRow) * blocksX * blockBytes);
+        Block block;
+        for (int by=firstBlockRow;by<lastBlockRow;by++){
+            for (int bx=0;bx<blocksX;bx++){
+                for (int y=0;y<4;y++){
+                    for (int x=0;x<4;x++){                              // edge pixels are repeated in partial blocks
+                        int px = std::min(bx*4+x, width-1);
+                        int py = std::min(by*4+y, height-1);
+                        memcpy(block[y*4+x], rgba + (py * (size_t)width + px) * 4, 4);
+                    }
+                }
+                encodeBlock(format, block, (uint8_t*)res.data() + ((by - firstBlockRow) * blocksX + bx) * blockBytes);
+            }
+        }
+        return res;
+    }
+}
@@ -0,0 +1,206 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/TextureStreaming.hpp"
+
+#include "sre/Texture.hpp"
+#include "sre/RenderStats.hpp"
+#include "sre/Log.hpp"
+#include "sre/impl/WorkerPool.hpp"
+#include "sre/impl/TextureCompression.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+
+namespace sre {
+
+    TextureStreaming::TextureStreaming() = default;
+
+    TextureStreaming::~TextureStreaming() = default;
+
+    void TextureStreaming::add(Texture* texture, const std::string& file, std::vector<int> levelBytes) {
+        Entry entry;
+        entry.id = nextId++;
+        entry.file = file;
+        entry.levelBytes = std::move(levelBytes);
+        entry.permanentLevel = texture->baseLevel;
+        entry.requestedLevel = (int)entry.levelBytes.size();
+        residentBytes += getBytes(entry, texture->baseLevel, (int)entry.levelBytes.size());
+        entries[texture] = std::move(entry);
+    }
+
+    void TextureStreaming::remove(Texture* texture) {
+        auto it = entries.find(texture);
+        if (it == entries.end()){
+            return;
+        }
+        auto& entry = it->second;
+        residentBytes -= getBytes(entry, texture->baseLevel, (int)entry.levelBytes.size());
+        loadingBytes -= entry.loadingBytes;
+        entries.erase(it);                                      // a pending load is ignored, since the id is not found
+    }
+
+    bool TextureStreaming::isActive() {
+        return !entries.empty();
+    }
+
+    void TextureStreaming::requestLevel(Texture* texture, int level) {
+        auto it = entries.find(texture);
+        if (it == entries.end()){
+            return;
+        }
+        auto& entry = it->second;
+        entry.requestedLevel = std::min(entry.requestedLevel, level);
+        entry.lastUsedFrame = frame;
+    }
+
+    void TextureStreaming::update(RenderStats& renderStats) {
+        std::vector<LoadedLevels> loaded;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            loaded.swap(completed);
+        }
+        for (auto& levels : loaded){
+            auto it = entries.find(levels.texture);
+            if (it == entries.end() || it->second.id != levels.id){
+                continue;                                       // texture deleted while loading
+            }
+            auto texture = levels.texture;
+            auto& entry = it->second;
+            loadingBytes -= entry.loadingBytes;
+            entry.loadingBytes = 0;
+            auto& image = levels.image;
+            if (!image || image->width != texture->getWidth() || image->height != texture->getHeight() || image->levels.size() != entry.levelBytes.size()){
+                if (image){
+                    LOG_ERROR("Cannot stream %s. The file has changed.", entry.file.c_str());
+                }
+                entry.failed = true;
+                continue;
+            }
+            int baseLevel = texture->baseLevel;
+            residentBytes += texture->uploadStreamedLevels(*image, levels.firstLevel, baseLevel);
+            renderStats.textureLevelsStreamed += baseLevel - levels.firstLevel;
+        }
+
+        // load requested levels which fit in the budget (after evicting levels which are not used this frame)
+        for (auto& e : entries){
+            auto texture = e.first;
+            auto& entry = e.second;
+            int baseLevel = texture->baseLevel;
+            if (entry.loadingBytes > 0 || entry.failed || entry.requestedLevel >= baseLevel){
+                continue;
+            }
+            int level = entry.requestedLevel;
+            while (level < baseLevel && residentBytes + loadingBytes + getBytes(entry, level, baseLevel) > budget){
+                if (!evictLevel(renderStats, texture, true)){
+                    level++;                                    // use a less detailed level
+                }
+            }
+            if (level < baseLevel){
+                load(texture, entry, level);
+            }
+        }
+
+        // evict until the budget is met (if the budget has been lowered)
+        while (residentBytes > budget && evictLevel(renderStats, nullptr, false)){
+        }
+
+        for (auto& e : entries){
+            e.second.requestedLevel = (int)e.second.levelBytes.size();
+        }
+        renderStats.textureStreamedBytes = residentBytes;
+        frame++;
+    }
+
+    // Evict the most detailed level of the least recently used texture. If onlyUnused is true, only levels not
+    // requested this frame are evicted. Returns false if no level can be evicted.
+    bool TextureStreaming::evictLevel(RenderStats& renderStats, Texture* keep, bool onlyUnused) {
+        Texture* texture = nullptr;
+        Entry* entry = nullptr;
+        for (auto& e : entries){
+            auto& candidate = e.second;
+            int baseLevel = e.first->baseLevel;
+            if (e.first == keep || candidate.loadingBytes > 0 || baseLevel >= candidate.permanentLevel){
+                continue;
+            }
+            if (onlyUnused && baseLevel >= candidate.requestedLevel){
+                continue;
+            }
+            if (entry == nullptr || candidate.lastUsedFrame < entry->lastUsedFrame){
+                texture = e.first;
+                entry = &candidate;
+            }
+        }
+        if (entry == nullptr){
+            return false;
+        }
+        int bytes = entry->levelBytes[texture->baseLevel];
+        texture->evictStreamedLevel(bytes);
+        residentBytes -= bytes;
+        renderStats.textureLevelsEvicted++;
+        return true;
+    }
+
+    // Read the levels [firstLevel, baseLevel) from the file on the loader thread
+    void TextureStreaming::load(Texture* texture, Entry& entry, int firstLevel) {
+        if (!loader){
+            loader.reset(new WorkerPool(1));
+        }
+        int lastLevel = texture->baseLevel;
+        entry.loadingBytes = getBytes(entry, firstLevel, lastLevel);
+        loadingBytes += entry.loadingBytes;
+        LoadedLevels levels{texture, entry.id, firstLevel, nullptr};
+        auto file = entry.file;
+        loader->enqueue([this, levels, file, lastLevel]() mutable {
+            std::ifstream in(file, std::ios::binary);
+            std::vector<char> fileData((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            auto image = std::make_shared<CompressedImage>();
+            std::string error;
+            if (TextureCompression::load(fileData, *image, error)){
+                for (int i = 0; i < (int)image->levels.size(); i++){
+                    if (i < levels.firstLevel || i >= lastLevel){
+                        std::vector<char>().swap(image->levels[i]);   // only keep the levels to upload
+                    }
+                }
+                levels.image = image;
+            } else {
+                LOG_ERROR("Cannot stream %s: %s", file.c_str(), error.c_str());
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            completed.push_back(levels);
+        });
+    }
+
+    int TextureStreaming::getBytes(Entry& entry, int firstLevel, int lastLevel) {
+        int res = 0;
+        for (int i = firstLevel; i < lastLevel; i++){
+            res += entry.levelBytes[i];
+        }
+        return res;
+    }
+
+    void TextureStreaming::setBudget(int bytes) {
+        budget = bytes;
+    }
+
+    int TextureStreaming::getBudget() {
+        return budget;
+    }
+
+    int TextureStreaming::getResidentBytes() {
+        return residentBytes;
+    }
+
+    int TextureStreaming::getDesiredLevel(int textureSize, float screenSize) {
+        if (screenSize <= 0){
+            return 0x7fff;                                      // not visible
+        }
+        return std::max(0, (int)std::floor(std::log2(textureSize / screenSize)));
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/UniformBufferPool.hpp"
+#include "sre/Renderer.hpp"
+#include <algorithm>
+
+namespace sre {
+
+    UniformBufferPool::UniformBufferPool(int blockSize)
+    :blockSize(blockSize)
+    {
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        alignment = std::max(alignment, 1);
+        stride = ((blockSize + alignment - 1) / alignment) * alignment;
+    }
+
+    UniformBufferPool::~UniformBufferPool() {
+        if (Renderer::instance && buffer != 0){
+            glDeleteBuffers(1, &buffer);
+        }
+    }
+
+    int UniformBufferPool::allocate() {
+        if (!freeSlots.empty()){
+            int slot = freeSlots.back();
+            freeSlots.pop_back();
+            return slot;
+        }
+        if (slotCount == capacity){
+            grow();
+        }
+        return slotCount++;
+    }
+
+    void UniformBufferPool::release(int slot) {
+        freeSlots.push_back(slot);
+    }
+
+    void UniformBufferPool::update(int slot, const void *data) {
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, slot * stride, blockSize, data);
+    }
+
+    void UniformBufferPool::bind(int slot, int bindingIndex) {
+        glBindBufferRange(GL_UNIFORM_BUFFER, bindingIndex, buffer, slot * stride, blockSize);
+    }
+
+    int UniformBufferPool::getBlockSize() {
+        return blockSize;
+    }
+
+    void UniformBufferPool::grow() {
+        int newCapacity = std::max(64, capacity * 2);
+        GLuint newBuffer;
+        glGenBuffers(1, &newBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, newBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, newCapacity * stride, nullptr, GL_DYNAMIC_DRAW);
+        if (buffer != 0){
+            // keep the content of the existing slots
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, capacity * stride);
+            glDeleteBuffers(1, &buffer);
+        }
+        buffer = newBuffer;
+        capacity = newCapacity;
+    }
+}
@@ -5,77 +5,204 @@
  *  License: MIT
  */
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
 #include "sre/impl/UniformSet.hpp"
+#include "sre/Texture.hpp"
+#include "sre/Sampler.hpp"
+#include "sre/Renderer.hpp"
+#include "sre/RenderStats.hpp"
 
 namespace sre {
 
-    void UniformSet::bind(){
-        unsigned int textureSlot = 0;
-        for (const auto & t : textureValues) {
+    void UniformShadow::clear() {
+        offsetByLocation.clear();
+        values.clear();
+        textureUnitByLocation.clear();
+    }
 
-            glActiveTexture(GL_TEXTURE0 + textureSlot);
-            glBindTexture(t.second->target, t.second->textureId);
-            glUniform1i(t.first, textureSlot);
-            textureSlot++;
-        }
-        for (auto& t : vectorValues) {
-            glUniform4fv(t.first, 1, glm::value_ptr(t.second));
-        }
-        for (auto& t : mat4Values) {
-            glUniformMatrix4fv(t.first, 1, GL_FALSE, glm::value_ptr(t.second));
+    // Returns nullptr if the values are identical to the shadow copy. Otherwise updates the shadow copy.
+    float* UniformSet::uploadIfChanged(UniformShadow& shadow, int location, const float* data, int count, int& elided){
+        if (location >= (int)shadow.offsetByLocation.size()){
+            shadow.offsetByLocation.resize(location + 1, -1);
         }
-        for (auto& t : floatValues) {
-            glUniform1f(t.first, t.second);
+        int offset = shadow.offsetByLocation[location];
+        if (offset == -1){
+            offset = (int)shadow.values.size();
+            shadow.offsetByLocation[location] = offset;
+            shadow.values.resize(shadow.values.size() + count);
+        } else if (memcmp(&shadow.values[offset], data, sizeof(float) * count) == 0){
+            elided++;
+            return nullptr;
         }
-        for (auto& t : mat3sValues) {
-            if (t.second.get()) {
-                glm::mat3& m3 = (*t.second)[0];
-                glUniformMatrix3fv(t.first, static_cast<GLsizei>(t.second->size()), GL_FALSE, glm::value_ptr(m3));
+        memcpy(&shadow.values[offset], data, sizeof(float) * count);
+        return &shadow.values[offset];
+    }
+
+    // Negative ids are not bound (uniforms in the material uniform block or of a shader still being compiled).
+    // Samplers use the texture unit assigned when the program was linked, so only the texture bind may be needed.
+    // When sampler objects are supported, the sampler (override or the texture's own sampler) is bound to the unit.
+    void UniformSet::bind(UniformShadow& shadow, RenderStats& renderStats){
+        int elided = 0;
+        auto& textureBindings = Renderer::instance->textureBindings;
+        bool samplerObjects = renderInfo().supportSamplerObjects;
+        for (const auto & v : values) {
+            if (v.id < 0) continue;
+            const float* data = floats.data() + v.index;
+            switch (v.type){
+                case ValueType::Texture: {
+                    auto& texture = textureValues[v.index];
+                    int unit = v.id < (int)shadow.textureUnitByLocation.size() ? shadow.textureUnitByLocation[v.id] : -1;
+                    if (!texture || unit < 0) continue;
+                    if (!textureBindings.bind(unit, texture->target, texture->textureId)){
+                        renderStats.textureBindsAvoided++;
+                    }
+                    if (samplerObjects){
+                        auto& sampler = samplerValues[v.index];
+                        textureBindings.bindSampler(unit, Renderer::instance->samplers.get(sampler ? *sampler : texture->getSampler(), *texture));
+                    }
+                }
+                break;
+                case ValueType::Vec4:
+                    if (uploadIfChanged(shadow, v.id, data, 4, elided)){
+                        glUniform4fv(v.id, 1, data);
+                    }
+                break;
+                case ValueType::Mat4:
+                    if (uploadIfChanged(shadow, v.id, data, 16, elided)){
+                        glUniformMatrix4fv(v.id, 1, GL_FALSE, data);
+                    }
+                break;
+                case ValueType::Float:
+                    if (uploadIfChanged(shadow, v.id, data, 1, elided)){
+                        glUniform1f(v.id, *data);
+                    }
+                break;
+                // arrays may be modified through the shared pointer, so they are always uploaded
+                case ValueType::Mat3Array: {
+                    auto& array = mat3sValues[v.index];
+                    if (array.get() && !array->empty()) {
+                        glUniformMatrix3fv(v.id, static_cast<GLsizei>(array->size()), GL_FALSE, glm::value_ptr((*array)[0]));
+                    }
+                }
+                break;
+                case ValueType::Mat4Array: {
+                    auto& array = mat4sValues[v.index];
+                    if (array.get() && !array->empty()) {
+                        glUniformMatrix4fv(v.id, static_cast<GLsizei>(array->size()), GL_FALSE, glm::value_ptr((*array)[0]));
+                    }
+                }
+                break;
             }
         }
-        for (auto& t : mat4sValues) {
-            if (t.second.get()){
-                glm::mat4& m4 = (*t.second)[0];
-                glUniformMatrix4fv(t.first, static_cast<GLsizei>(t.second->size()), GL_FALSE, glm::value_ptr(m4));
-            }
+        renderStats.uniformUploadsElided += elided;
+    }
+
+    UniformSet::Value* UniformSet::find(int id) {
+        auto res = std::lower_bound(values.begin(), values.end(), id, [](const Value& v, int id){
+            return v.id < id;
+        });
+        if (res != values.end() && res->id == id){
+            return &(*res);
         }
+        return nullptr;
+    }
 
+    UniformSet::Value& UniformSet::insert(int id, ValueType type, int floatCount) {
+        auto res = std::lower_bound(values.begin(), values.end(), id, [](const Value& v, int id){
+            return v.id < id;
+        });
+        if (res != values.end() && res->id == id && res->type == type){
+            return *res;
+        }
+        Value value{id, type, 0};
+        switch (type){
+            case ValueType::Texture:
+                value.index = (int)textureValues.size();
+                textureValues.emplace_back();
+                samplerValues.emplace_back();
+                break;
+            case ValueType::Mat3Array:
+                value.index = (int)mat3sValues.size();
+                mat3sValues.emplace_back();
+                break;
+            case ValueType::Mat4Array:
+                value.index = (int)mat4sValues.size();
+                mat4sValues.emplace_back();
+                break;
+            default:
+                value.index = (int)floats.size();
+                floats.resize(floats.size() + floatCount);
+                break;
+        }
+        if (res != values.end() && res->id == id){
+            *res = value;                   // type changed (previous storage is unused until clear())
+            return *res;
+        }
+        return *values.insert(res, value);
     }
 
     void UniformSet::set(int id, glm::vec4 value){
-        vectorValues[id] = value;
+        auto& v = insert(id, ValueType::Vec4, 4);
+        memcpy(&floats[v.index], glm::value_ptr(value), sizeof(glm::vec4));
     }
 
     void UniformSet::set(int id, glm::mat4 value){
-        mat4Values[id] = value;
+        auto& v = insert(id, ValueType::Mat4, 16);
+        memcpy(&floats[v.index], glm::value_ptr(value), sizeof(glm::mat4));
     }
 
     void UniformSet::set(int id, float value){
-        floatValues[id] = value;
+        auto& v = insert(id, ValueType::Float, 1);
+        floats[v.index] = value;
     }
 
     void UniformSet::set(int id, std::shared_ptr<Texture> value){
-        textureValues[id] = value;
+        auto& v = insert(id, ValueType::Texture, 0);
+        textureValues[v.index] = value;
     }
 
     void UniformSet::set(int id, std::shared_ptr<std::vector<glm::mat3>> value){
-        mat3sValues[id] = value;
+        auto& v = insert(id, ValueType::Mat3Array, 0);
+        mat3sValues[v.index] = value;
     }
 
     void UniformSet::set(int id, std::shared_ptr<std::vector<glm::mat4>> value){
-        mat4sValues[id] = value;
+        auto& v = insert(id, ValueType::Mat4Array, 0);
+        mat4sValues[v.index] = value;
     }
 
     void UniformSet::set(int id, Color value){
-        vectorValues[id] = value.toLinear();;
+        set(id, value.toLinear());
+    }
+
+    bool UniformSet::setSampler(int id, std::shared_ptr<const Sampler> sampler) {
+        auto v = find(id);
+        if (!v || v->type != ValueType::Texture){
+            return false;
+        }
+        samplerValues[v->index] = sampler;
+        return true;
+    }
+
+    std::shared_ptr<const Sampler> UniformSet::getSampler(int id) {
+        auto v = find(id);
+        return v && v->type == ValueType::Texture ? samplerValues[v->index] : nullptr;
+    }
+
+    bool UniformSet::contains(int id) {
+        return find(id) != nullptr;
+    }
+
+    const std::vector<std::shared_ptr<sre::Texture>>& UniformSet::getTextures(){
+        return textureValues;
     }
 
     void UniformSet::clear(){
+        values.clear();
+        floats.clear();
         textureValues.clear();
-        vectorValues.clear();
-        mat4Values.clear();
+        samplerValues.clear();
         mat4sValues.clear();
         mat3sValues.clear();
-        floatValues.clear();
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,67 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/WorkerPool.hpp"
+#include <algorithm>
+
+namespace sre {
+
+    WorkerPool::WorkerPool(int threadCount) {
+#ifndef EMSCRIPTEN
+        if (threadCount <= 0){
+            threadCount = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+        }
+        for (int i = 0; i < threadCount; i++){
+            threads.emplace_back(&WorkerPool::run, this);
+        }
+#endif
+    }
+
+    WorkerPool::~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            tasks.clear();
+        }
+        condition.notify_all();
+        for (auto& t : threads){
+            t.join();
+        }
+    }
+
+    void WorkerPool::enqueue(std::function<void()> task) {
+        if (threads.empty()){
+            task();
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        condition.notify_one();
+    }
+
+    int WorkerPool::getThreadCount() {
+        return (int)threads.size();
+    }
+
+    void WorkerPool::run() {
+        while (true){
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [&]{ return stopping || !tasks.empty(); });
+                if (stopping){
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include "sre/impl/DynamicResolutionController.hpp"
+
+using namespace sre;
+
+namespace {
+    // frame time proportional to the number of pixels rendered, with +/- noise (deterministic)
+    float frameTime(float costAtFullResolution, float scale, int frame, float noise = 0){
+        float n = ((frame * 7919) % 101) / 50.0f - 1.0f;
+        return costAtFullResolution * scale * scale * (1 + n * noise);
+    }
+}
+
+TEST(DynamicResolutionController, ConvergesToBudget)
+{
+    DynamicResolutionController::Settings settings;
+    settings.budget = 16;
+    DynamicResolutionController controller(settings);
+    EXPECT_EQ(1.0f, controller.getScale());
+    for (int i = 0; i < 100; i++){
+        controller.update(frameTime(30, controller.getScale(), i));
+    }
+    float scale = controller.getScale();
+    EXPECT_LE(frameTime(30, scale, 0), 16 * 1.05f);
+    EXPECT_GE(frameTime(30, scale, 0), 16 * (1 - settings.headroom - settings.step * 2));
+
+    int changes = 0;
+    for (int i = 0; i < 100; i++){
+        float last = controller.getScale();
+        controller.update(frameTime(30, last, i));
+        changes += controller.getScale() != last;
+    }
+    EXPECT_EQ(0, changes);
+}
+
+TEST(DynamicResolutionController, StableWithNoise)
+{
+    DynamicResolutionController::Settings settings;
+    settings.budget = 16;
+    DynamicResolutionController controller(settings);
+    for (int i = 0; i < 100; i++){
+        controller.update(frameTime(30, controller.getScale(), i, 0.2f));
+    }
+    int changes = 0;
+    for (int i = 0; i < 200; i++){
+        float last = controller.getScale();
+        controller.update(frameTime(30, last, i, 0.2f));
+        changes += controller.getScale() != last;
+    }
+    EXPECT_LE(changes, 4);
+}
+
+TEST(DynamicResolutionController, IncreasesWhenLoadDrops)
+{
+    DynamicResolutionController::Settings settings;
+    settings.budget = 16;
+    DynamicResolutionController controller(settings);
+    for (int i = 0; i < 100; i++){
+        controller.update(frameTime(30, controller.getScale(), i));
+    }
+    EXPECT_LT(controller.getScale(), 1.0f);
+    float last = controller.getScale();
+    for (int i = 0; i < 100; i++){
+        controller.update(frameTime(8, controller.getScale(), i));
+        EXPECT_GE(controller.getScale(), last);                 // never oscillates down
+        last = controller.getScale();
+    }
+    EXPECT_EQ(1.0f, controller.getScale());
+}
+
+TEST(DynamicResolutionController, ClampsScale)
+{
+    DynamicResolutionController::Settings settings;
+    settings.budget = 16;
+    settings.minScale = 0.6f;
+    DynamicResolutionController controller(settings);
+    for (int i = 0; i < 100; i++){
+        controller.update(frameTime(200, controller.getScale(), i));
+    }
+    EXPECT_FLOAT_EQ(0.6f, controller.getScale());
+
+    settings.minScale = 0.7f;
+    controller.setSettings(settings);
+    EXPECT_FLOAT_EQ(0.7f, controller.getScale());
+
+    controller.update(0);                                       // invalid measurements are ignored
+    EXPECT_FLOAT_EQ(0.7f, controller.getScale());
+}
+
+// Within the hysteresis band (below budget, but less than headroom unused) the scale is kept
+TEST(DynamicResolutionController, Hysteresis)
+{
+    DynamicResolutionController::Settings settings;
+    settings.budget = 16;
+    DynamicResolutionController controller(settings);
+    controller.reset(0.8f);
+    for (int i = 0; i < 200; i++){
+        controller.update(15.0f);
+    }
+    EXPECT_FLOAT_EQ(0.8f, controller.getScale());
+
+    for (int i = 0; i < 3; i++){
+        controller.update(20.0f);
+    }
+    EXPECT_LT(controller.getScale(), 0.8f);                     // decreased soon after the budget is exceeded
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "sre/MeshBVH.hpp"
+
+using namespace sre;
+
+namespace {
+    // grid of size x size quads in the xy plane (z = 0) from (0,0) to (size,size)
+    void createGrid(int size, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices){
+        for (int y = 0; y <= size; y++){
+            for (int x = 0; x <= size; x++){
+                positions.emplace_back(x, y, 0);
+            }
+        }
+        for (int y = 0; y < size; y++){
+            for (int x = 0; x < size; x++){
+                uint32_t i = y * (size + 1) + x;
+                indices.insert(indices.end(), {i, i + 1, i + size + 1});
+                indices.insert(indices.end(), {i + 1, i + size + 2, i + size + 1});
+            }
+        }
+    }
+}
+
+TEST(MeshBVH, ClosestHit)
+{
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    createGrid(64, positions, indices);
+    auto bvh = MeshBVH::create(positions, {indices}, {MeshTopology::Triangles});
+    EXPECT_EQ(64 * 64 * 2, bvh->getTriangleCount());
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> dist(0.0f, 64.0f);
+    for (int i = 0; i < 1000; i++){
+        glm::vec3 target(dist(rng), dist(rng), 0.0f);
+        RaycastHit hit;
+        ASSERT_TRUE(bvh->raycast({target + glm::vec3(0, 0, 10), glm::vec3(0, 0, -1)}, hit));
+        EXPECT_NEAR(10.0f, hit.distance, 1e-4f);
+        EXPECT_NEAR(target.x, hit.point.x, 1e-3f);
+        EXPECT_NEAR(target.y, hit.point.y, 1e-3f);
+        EXPECT_EQ(0, hit.indexSet);
+        glm::vec3 p = positions[hit.vertices[0]] * hit.barycentric.x +
+                      positions[hit.vertices[1]] * hit.barycentric.y +
+                      positions[hit.vertices[2]] * hit.barycentric.z;
+        EXPECT_NEAR(target.x, p.x, 1e-3f);
+        EXPECT_NEAR(target.y, p.y, 1e-3f);
+        EXPECT_EQ(indices[hit.triangle * 3], hit.vertices[0]);
+    }
+}
+
+TEST(MeshBVH, Miss)
+{
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    createGrid(16, positions, indices);
+    auto bvh = MeshBVH::create(positions, {indices}, {MeshTopology::Triangles});
+    RaycastHit hit;
+    EXPECT_FALSE(bvh->raycast({glm::vec3(-1, -1, 10), glm::vec3(0, 0, -1)}, hit));
+    EXPECT_FALSE(bvh->raycast({glm::vec3(8, 8, 10), glm::vec3(0, 0, 1)}, hit));
+    EXPECT_FALSE(bvh->raycastAny({glm::vec3(8, 8, 10), glm::vec3(0, 0, -1)}, 5.0f));
+    EXPECT_TRUE(bvh->raycastAny({glm::vec3(8, 8, 10), glm::vec3(0, 0, -1)}, 15.0f));
+}
+
+TEST(MeshBVH, Overlap)
+{
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    createGrid(16, positions, indices);
+    auto bvh = MeshBVH::create(positions, {indices}, {MeshTopology::Triangles});
+    std::vector<MeshBVH::TriangleId> result;
+    // box strictly inside one grid cell overlaps both triangles of the cell
+    bvh->overlap({glm::vec3(2.4f, 3.4f, -1), glm::vec3(2.6f, 3.6f, 1)}, result);
+    EXPECT_EQ(2u, result.size());
+    result.clear();
+    bvh->overlap({glm::vec3(2.4f, 3.4f, 0.5f), glm::vec3(2.6f, 3.6f, 1)}, result);
+    EXPECT_EQ(0u, result.size());
+}
@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <sstream>
+#include "sre/impl/MeshFile.hpp"
+
+using namespace sre;
+
+namespace {
+    const uint32_t unsignedShort = 0x1403;                      // GL_UNSIGNED_SHORT
+    const uint32_t unsignedInt = 0x1405;                        // GL_UNSIGNED_INT
+
+    // two vertices with position (vec3) and uv (vec4), a 16 bit and a 32 bit index set (as written by Mesh::save())
+    struct TestMesh {
+        std::vector<float> vertices = {0, 1, 2, 0.5f, 0.25f, 0, 1,
+                                       3, 4, 5, 1, 1, 0, 1};
+        std::vector<char> indices;
+        MeshFile meshFile;
+
+        TestMesh(){
+            uint16_t indices16[] = {0, 1, 1};
+            uint32_t indices32[] = {1, 0};
+            indices.resize(sizeof(indices16) + 2 + sizeof(indices32));  // 32 bit indices are 4 byte aligned
+            memcpy(indices.data(), indices16, sizeof(indices16));
+            memcpy(indices.data() + 8, indices32, sizeof(indices32));
+
+            meshFile.vertexCount = 2;
+            meshFile.bytesPerVertex = 7 * sizeof(float);
+            meshFile.bounds = {glm::vec3(0, 1, 2), glm::vec3(3, 4, 5)};
+            meshFile.lineWidth = 2;
+            meshFile.name = "Test mesh";
+            meshFile.attributes.push_back({"position", 0, 3, 0x1406, 0x8B51});
+            meshFile.attributes.push_back({"uv", 12, 4, 0x1406, 0x8B52});
+            meshFile.topologies = {0, 1};
+            meshFile.indexSets.push_back({0, 3, unsignedShort});
+            meshFile.indexSets.push_back({8, 2, unsignedInt});
+            meshFile.vertexData = reinterpret_cast<const char*>(vertices.data());
+            meshFile.vertexDataSize = vertices.size() * sizeof(float);
+            meshFile.indexData = indices.data();
+            meshFile.indexDataSize = indices.size();
+        }
+
+        std::string write(){
+            std::stringstream ss;
+            EXPECT_TRUE(meshFile.write(ss));
+            return ss.str();
+        }
+    };
+}
+
+TEST(MeshFile, RoundTrip)
+{
+    TestMesh testMesh;
+    auto data = testMesh.write();
+
+    MeshFile res;
+    std::string error;
+    ASSERT_TRUE(res.read(data.data(), data.size(), error)) << error;
+    auto& src = testMesh.meshFile;
+    EXPECT_EQ(src.vertexCount, res.vertexCount);
+    EXPECT_EQ(src.bytesPerVertex, res.bytesPerVertex);
+    for (int i = 0; i < 2; i++){
+        for (int j = 0; j < 3; j++){
+            EXPECT_EQ(src.bounds[i][j], res.bounds[i][j]);
+        }
+    }
+    EXPECT_EQ(src.lineWidth, res.lineWidth);
+    EXPECT_EQ(src.name, res.name);
+    ASSERT_EQ(src.attributes.size(), res.attributes.size());
+    for (size_t i = 0; i < src.attributes.size(); i++){
+        EXPECT_EQ(src.attributes[i].name, res.attributes[i].name);
+        EXPECT_EQ(src.attributes[i].offset, res.attributes[i].offset);
+        EXPECT_EQ(src.attributes[i].elementCount, res.attributes[i].elementCount);
+        EXPECT_EQ(src.attributes[i].dataType, res.attributes[i].dataType);
+        EXPECT_EQ(src.attributes[i].attributeType, res.attributes[i].attributeType);
+    }
+    EXPECT_EQ(src.topologies, res.topologies);
+    ASSERT_EQ(src.indexSets.size(), res.indexSets.size());
+    for (size_t i = 0; i < src.indexSets.size(); i++){
+        EXPECT_EQ(src.indexSets[i].offset, res.indexSets[i].offset);
+        EXPECT_EQ(src.indexSets[i].size, res.indexSets[i].size);
+        EXPECT_EQ(src.indexSets[i].type, res.indexSets[i].type);
+    }
+    ASSERT_EQ(src.vertexDataSize, res.vertexDataSize);
+    EXPECT_EQ(0, memcmp(src.vertexData, res.vertexData, res.vertexDataSize));
+    EXPECT_EQ(0, (res.vertexData - data.data()) % 16);          // aligned for memory mapped upload
+    ASSERT_EQ(src.indexDataSize, res.indexDataSize);
+    EXPECT_EQ(0, memcmp(src.indexData, res.indexData, res.indexDataSize));
+    EXPECT_EQ(0, (res.indexData - data.data()) % 16);
+}
+
+// The mesh has a topology for each index set
+TEST(MeshFile, RejectTopologyMismatch)
+{
+    TestMesh testMesh;
+    testMesh.meshFile.topologies = {0};
+    auto data = testMesh.write();
+    MeshFile res;
+    std::string error;
+    EXPECT_FALSE(res.read(data.data(), data.size(), error));
+
+    testMesh.meshFile.topologies = {0, 1, 2};
+    data = testMesh.write();
+    EXPECT_FALSE(res.read(data.data(), data.size(), error));
+
+    // without index sets a single topology is used
+    testMesh.meshFile.topologies = {0};
+    testMesh.meshFile.indexSets.clear();
+    testMesh.meshFile.indexDataSize = 0;
+    data = testMesh.write();
+    EXPECT_TRUE(res.read(data.data(), data.size(), error)) << error;
+}
+
+TEST(MeshFile, RejectCorrupt)
+{
+    TestMesh testMesh;
+    auto data = testMesh.write();
+    MeshFile res;
+    std::string error;
+
+    EXPECT_FALSE(res.read(data.data(), data.size() - 1, error));    // truncated index data
+
+    auto badMagic = data;
+    badMagic[0] = 'X';
+    EXPECT_FALSE(res.read(badMagic.data(), badMagic.size(), error));
+
+    testMesh.meshFile.indexSets[1].size = 3;                        // index set outside index data
+    data = testMesh.write();
+    EXPECT_FALSE(res.read(data.data(), data.size(), error));
+
+    testMesh.meshFile.indexSets[1].size = 2;
+    testMesh.meshFile.attributes[1].offset = 16;                    // attribute outside vertex
+    data = testMesh.write();
+    EXPECT_FALSE(res.read(data.data(), data.size(), error));
+
+    testMesh.meshFile.attributes[1].offset = 12;
+    testMesh.meshFile.attributes[1].elementCount = 1;               // vec4 attribute with a single element
+    data = testMesh.write();
+    EXPECT_FALSE(res.read(data.data(), data.size(), error));
+
+    testMesh.meshFile.attributes[1].elementCount = 4;
+    testMesh.meshFile.topologies[1] = 42;                           // not a MeshTopology
+    data = testMesh.write();
+    EXPECT_FALSE(res.read(data.data(), data.size(), error));
+}
+
+// the data offsets are stored after the index set table: vertex data offset, vertex data size, index data offset, index data size
+TEST(MeshFile, RejectOffsetOverflow)
+{
+    TestMesh testMesh;
+    auto data = testMesh.write();
+    MeshFile res;
+    std::string error;
+    ASSERT_TRUE(res.read(data.data(), data.size(), error)) << error;
+    uint64_t offsets[2] = {(uint64_t)(res.vertexData - data.data()), res.vertexDataSize};
+    auto pos = data.find(std::string(reinterpret_cast<const char*>(offsets), sizeof(offsets)));
+    ASSERT_NE(std::string::npos, pos);
+
+    auto corrupt = data;
+    uint64_t wrappingOffset = ~(uint64_t)0 - 7;                     // offset + size wraps around
+    memcpy(&corrupt[pos + 16], &wrappingOffset, sizeof(wrappingOffset));
+    EXPECT_FALSE(res.read(corrupt.data(), corrupt.size(), error));
+
+    corrupt = data;
+    memcpy(&corrupt[pos], &wrappingOffset, sizeof(wrappingOffset));
+    EXPECT_FALSE(res.read(corrupt.data(), corrupt.size(), error));
+}
+
+TEST(MeshFile, ValidateIndices)
+{
+    TestMesh testMesh;
+    auto data = testMesh.write();
+    MeshFile res;
+    std::string error;
+    ASSERT_TRUE(res.read(data.data(), data.size(), error)) << error;
+    EXPECT_TRUE(res.validateIndices(error)) << error;
+
+    uint16_t outside = 2;                                           // the mesh has two vertices
+    memcpy(&testMesh.indices[2], &outside, sizeof(outside));
+    data = testMesh.write();
+    ASSERT_TRUE(res.read(data.data(), data.size(), error)) << error;
+    EXPECT_FALSE(res.validateIndices(error));
+
+    memcpy(&testMesh.indices[2], &testMesh.indices[0], sizeof(outside));
+    uint32_t outside32 = 0xFFFFFFFF;
+    memcpy(&testMesh.indices[12], &outside32, sizeof(outside32));
+    data = testMesh.write();
+    ASSERT_TRUE(res.read(data.data(), data.size(), error)) << error;
+    EXPECT_FALSE(res.validateIndices(error));
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include "sre/impl/MipmapBuilder.hpp"
+#include "sre/impl/WorkerPool.hpp"
+
+using namespace sre;
+
+namespace {
+    std::vector<char> createCheckerboard(int width, int height, int channels, uint8_t a, uint8_t b){
+        std::vector<char> res(width * height * channels);
+        for (int y = 0; y < height; y++){
+            for (int x = 0; x < width; x++){
+                for (int c = 0; c < channels; c++){
+                    res[(x + y * width) * channels + c] = (char)((x + y) % 2 == 0 ? a : b);
+                }
+            }
+        }
+        return res;
+    }
+}
+
+TEST(MipmapBuilder, LevelSizes)
+{
+    auto data = createCheckerboard(13, 4, 4, 0, 255);
+    auto levels = MipmapBuilder::build(data.data(), 13, 4, 4, MipmapSettings());
+    ASSERT_EQ(MipmapBuilder::getLevelCount(13, 4) - 1, (int)levels.size());
+    int expectedSizes[] = {6*2, 3*1, 1*1};
+    ASSERT_EQ(3u, levels.size());
+    for (int i = 0; i < 3; i++){
+        EXPECT_EQ(expectedSizes[i] * 4, (int)levels[i].size());
+    }
+    auto rgbLevels = MipmapBuilder::build(data.data(), 8, 8, 3, MipmapSettings());
+    ASSERT_EQ(3u, rgbLevels.size());
+    EXPECT_EQ(4 * 4 * 3, (int)rgbLevels[0].size());
+}
+
+TEST(MipmapBuilder, SolidColor)
+{
+    for (auto filter : {MipmapSettings::Filter::Box, MipmapSettings::Filter::Kaiser}){
+        for (bool srgb : {false, true}){
+            MipmapSettings settings;
+            settings.filter = filter;
+            settings.srgb = srgb;
+            auto data = createCheckerboard(32, 16, 4, 77, 77);
+            for (auto& level : MipmapBuilder::build(data.data(), 32, 16, 4, settings)){
+                for (auto c : level){
+                    EXPECT_EQ(77, (uint8_t)c);
+                }
+            }
+        }
+    }
+}
+
+TEST(MipmapBuilder, GammaCorrect)
+{
+    // black and white pixels average to 50% intensity, which is 188 in sRGB
+    auto data = createCheckerboard(16, 16, 3, 0, 255);
+    MipmapSettings settings;
+    settings.srgb = true;
+    auto levels = MipmapBuilder::build(data.data(), 16, 16, 3, settings);
+    EXPECT_EQ(188, (uint8_t)levels[0][0]);
+    EXPECT_EQ(188, (uint8_t)levels.back()[0]);
+
+    settings.srgb = false;
+    levels = MipmapBuilder::build(data.data(), 16, 16, 3, settings);
+    EXPECT_EQ(128, (uint8_t)levels[0][0]);
+}
+
+TEST(MipmapBuilder, AlphaCoverage)
+{
+    // alpha of 200 in 40% of the pixels (in 2x2 blocks) and 0 elsewhere
+    int size = 64;
+    std::vector<char> data(size * size * 4, (char)255);
+    for (int y = 0; y < size; y++){
+        for (int x = 0; x < size; x++){
+            data[(x + y * size) * 4 + 3] = (char)(((x / 2) * 7 + (y / 2) * 3) % 10 < 4 ? 200 : 0);
+        }
+    }
+    float cutoff = 0.5f;
+    float coverage = MipmapBuilder::getAlphaCoverage(data.data(), size, size, 4, cutoff);
+    EXPECT_NEAR(0.4f, coverage, 0.01f);
+
+    MipmapSettings settings;
+    auto levels = MipmapBuilder::build(data.data(), size, size, 4, settings);
+    EXPECT_LT(MipmapBuilder::getAlphaCoverage(levels[2].data(), size / 8, size / 8, 4, cutoff), 0.2f);
+
+    settings.alphaCutoff = cutoff;
+    levels = MipmapBuilder::build(data.data(), size, size, 4, settings);
+    for (int i = 0; i < 3; i++){
+        int levelSize = size >> (i + 1);
+        EXPECT_NEAR(coverage, MipmapBuilder::getAlphaCoverage(levels[i].data(), levelSize, levelSize, 4, cutoff), 0.1f) << "level " << (i + 1);
+    }
+}
+
+TEST(MipmapBuilder, WorkerPool)
+{
+    std::vector<char> data(300 * 200 * 4);
+    for (size_t i = 0; i < data.size(); i++){
+        data[i] = (char)((i * 2654435761u) >> 13);
+    }
+    WorkerPool workerPool(4);
+    for (auto filter : {MipmapSettings::Filter::Box, MipmapSettings::Filter::Kaiser}){
+        MipmapSettings settings;
+        settings.filter = filter;
+        settings.srgb = true;
+        EXPECT_EQ(MipmapBuilder::build(data.data(), 300, 200, 4, settings),
+                  MipmapBuilder::build(data.data(), 300, 200, 4, settings, &workerPool));
+    }
+}
+
+TEST(MipmapBuilder, Cache)
+{
+    auto data = createCheckerboard(16, 16, 4, 10, 200);
+    MipmapSettings settings;
+    settings.srgb = true;
+    auto levels = MipmapBuilder::build(data.data(), 16, 16, 4, settings);
+    auto key = MipmapBuilder::getCacheKey(data.data(), 16, 16, 4, settings);
+    settings.srgb = false;
+    EXPECT_NE(key, MipmapBuilder::getCacheKey(data.data(), 16, 16, 4, settings));
+
+    std::vector<std::vector<char>> loaded;
+    EXPECT_FALSE(MipmapBuilder::loadFromCache(key, loaded));        // cache disabled
+    MipmapBuilder::setCacheDirectory("mipmap-cache");
+    MipmapBuilder::saveToCache(key, levels);
+    ASSERT_TRUE(MipmapBuilder::loadFromCache(key, loaded));
+    EXPECT_EQ(levels, loaded);
+    EXPECT_FALSE(MipmapBuilder::loadFromCache(key + 1, loaded));
+    MipmapBuilder::setCacheDirectory("");
+}
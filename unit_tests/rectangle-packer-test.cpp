@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include "sre/impl/RectanglePacker.hpp"
+
+using namespace sre;
+
+namespace {
+    bool overlaps(const RectanglePacker::Rect& a, const RectanglePacker::Rect& b){
+        return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+    }
+}
+
+TEST(RectanglePacker, FillExactly)
+{
+    RectanglePacker packer(32, 32);
+    for (int i = 0; i < 16; i++){
+        RectanglePacker::Rect rect;
+        ASSERT_TRUE(packer.insert(8, 8, rect)) << "rect " << i;
+    }
+    RectanglePacker::Rect rect;
+    EXPECT_FALSE(packer.insert(1, 1, rect));
+    EXPECT_FLOAT_EQ(1.0f, packer.getOccupancy());
+    EXPECT_EQ(32, packer.getUsedWidth());
+    EXPECT_EQ(32, packer.getUsedHeight());
+}
+
+TEST(RectanglePacker, TooLarge)
+{
+    RectanglePacker packer(64, 32);
+    RectanglePacker::Rect rect;
+    EXPECT_FALSE(packer.insert(65, 1, rect));
+    EXPECT_FALSE(packer.insert(1, 33, rect));
+    EXPECT_FALSE(packer.insert(0, 10, rect));
+    EXPECT_TRUE(packer.insert(64, 32, rect));
+    EXPECT_EQ(0, rect.x);
+    EXPECT_EQ(0, rect.y);
+    EXPECT_FALSE(RectanglePacker().insert(1, 1, rect));
+}
+
+TEST(RectanglePacker, NoOverlap)
+{
+    RectanglePacker packer(256, 256);
+    std::vector<RectanglePacker::Rect> rects;
+    unsigned int seed = 1;
+    for (int i = 0; i < 500; i++){
+        seed = seed * 1103515245u + 12345u;
+        int width = 2 + (seed >> 16) % 30;
+        seed = seed * 1103515245u + 12345u;
+        int height = 2 + (seed >> 16) % 30;
+        RectanglePacker::Rect rect;
+        if (!packer.insert(width, height, rect)){
+            continue;
+        }
+        EXPECT_EQ(width, rect.width);
+        EXPECT_EQ(height, rect.height);
+        EXPECT_GE(rect.x, 0);
+        EXPECT_GE(rect.y, 0);
+        EXPECT_LE(rect.x + rect.width, 256);
+        EXPECT_LE(rect.y + rect.height, 256);
+        for (auto& other : rects){
+            ASSERT_FALSE(overlaps(rect, other));
+        }
+        rects.push_back(rect);
+    }
+    EXPECT_GT(packer.getOccupancy(), 0.8f);
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include "sre/impl/RenderGraphCompiler.hpp"
+
+using namespace sre;
+
+namespace {
+    RenderGraphCompiler::Pass pass(std::vector<int> reads, std::vector<int> writes, bool writesScreen = false){
+        RenderGraphCompiler::Pass res;
+        res.reads = std::move(reads);
+        res.writes = std::move(writes);
+        res.writesScreen = writesScreen;
+        return res;
+    }
+}
+
+// shadow map (0) -> scene color (1) -> screen, with an unused debug pass writing 2
+TEST(RenderGraphCompiler, CullUnusedPasses)
+{
+    std::vector<RenderGraphCompiler::Resource> resources(3);
+    std::vector<RenderGraphCompiler::Pass> passes = {
+            pass({}, {0}),
+            pass({0}, {1}),
+            pass({1}, {2}),
+            pass({1}, {}, true),
+    };
+    auto res = RenderGraphCompiler::compile(passes, resources);
+    ASSERT_TRUE(res.valid) << res.error;
+    EXPECT_EQ(std::vector<int>({0, 1, 3}), res.order);
+    EXPECT_TRUE(res.culled[2]);
+    EXPECT_EQ(-1, res.firstUse[2]);
+    EXPECT_EQ(0, res.firstUse[0]);
+    EXPECT_EQ(1, res.lastUse[0]);
+    EXPECT_EQ(1, res.firstUse[1]);
+    EXPECT_EQ(2, res.lastUse[1]);
+
+    resources[2].output = true;
+    res = RenderGraphCompiler::compile(passes, resources);
+    ASSERT_TRUE(res.valid) << res.error;
+    EXPECT_EQ(std::vector<int>({0, 1, 2, 3}), res.order);
+}
+
+// passes declared before the passes producing their inputs are executed after them
+TEST(RenderGraphCompiler, DependencyOrder)
+{
+    std::vector<RenderGraphCompiler::Resource> resources(2);
+    std::vector<RenderGraphCompiler::Pass> passes = {
+            pass({1}, {}, true),
+            pass({0}, {1}),
+            pass({}, {0}),
+            pass({}, {}, true),
+    };
+    auto res = RenderGraphCompiler::compile(passes, resources);
+    ASSERT_TRUE(res.valid) << res.error;
+    EXPECT_EQ(std::vector<int>({2, 1, 0, 3}), res.order);
+}
+
+TEST(RenderGraphCompiler, Invalid)
+{
+    std::vector<RenderGraphCompiler::Resource> resources(2);
+    EXPECT_FALSE(RenderGraphCompiler::compile({pass({0}, {0}, false)}, resources).valid);
+    EXPECT_FALSE(RenderGraphCompiler::compile({pass({}, {2}, true)}, resources).valid);
+    EXPECT_FALSE(RenderGraphCompiler::compile({pass({0}, {1}, true), pass({1}, {0}, true)}, resources).valid);
+}
+
+TEST(RenderGraphCompiler, Mipmaps)
+{
+    std::vector<RenderGraphCompiler::Resource> resources(3);
+    for (auto& resource : resources){
+        resource.mipmapped = true;
+    }
+    resources[2].output = true;
+    std::vector<RenderGraphCompiler::Pass> passes = {
+            pass({}, {0}),
+            pass({}, {1}),
+            pass({0}, {1}),
+            pass({}, {2}),
+            pass({1}, {}, true),
+    };
+    auto res = RenderGraphCompiler::compile(passes, resources);
+    ASSERT_TRUE(res.valid) << res.error;
+    EXPECT_EQ(std::vector<int>({0}), res.generateMipmaps[0]);   // read by pass 2
+    EXPECT_TRUE(res.generateMipmaps[1].empty());                // written again by pass 2
+    EXPECT_EQ(std::vector<int>({1}), res.generateMipmaps[2]);
+    EXPECT_EQ(std::vector<int>({2}), res.generateMipmaps[3]);   // output
+    EXPECT_TRUE(res.generateMipmaps[4].empty());
+}
+
+// outputs are used after the graph, so they are alive after the last pass
+TEST(RenderGraphCompiler, OutputLifetime)
+{
+    std::vector<RenderGraphCompiler::Resource> resources(3);
+    resources[1].output = true;
+    resources[2].output = true;                                 // never written or read
+    std::vector<RenderGraphCompiler::Pass> passes = {
+            pass({}, {0}),
+            pass({0}, {1}),
+            pass({0}, {}, true),
+    };
+    auto res = RenderGraphCompiler::compile(passes, resources);
+    ASSERT_TRUE(res.valid) << res.error;
+    EXPECT_EQ(std::vector<int>({0, 1, 2}), res.order);
+    EXPECT_EQ(2, res.lastUse[0]);
+    EXPECT_EQ(1, res.firstUse[1]);
+    EXPECT_EQ((int)res.order.size(), res.lastUse[1]);
+    EXPECT_EQ(-1, res.firstUse[2]);
+    EXPECT_EQ(-1, res.lastUse[2]);
+}
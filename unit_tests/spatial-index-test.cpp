@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include "sre/SpatialIndex.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+using namespace sre;
+
+// Instances are inserted without a mesh (bounds are the instance origin), so the tree can be tested without an
+// OpenGL context. Query results are compared against a brute force test of all instances.
+namespace {
+    bool overlaps(const std::array<glm::vec3,2>& a, const std::array<glm::vec3,2>& b){
+        return glm::all(glm::lessThanEqual(a[0], b[1])) && glm::all(glm::lessThanEqual(b[0], a[1]));
+    }
+
+    class SpatialIndexTest {
+    public:
+        SpatialIndexTest()
+        :rng(1), dist(-100.0f, 100.0f)
+        {}
+
+        glm::vec3 randomPosition(){
+            return {dist(rng), dist(rng), dist(rng)};
+        }
+
+        void insert(){
+            glm::vec3 position = randomPosition();
+            int id = spatialIndex.insert(nullptr, glm::translate(glm::mat4(1), position), {});
+            ASSERT_EQ(0u, positions.count(id));
+            positions[id] = position;
+        }
+
+        void move(int id, float distance){
+            glm::vec3 position = positions[id] + glm::vec3(dist(rng), dist(rng), dist(rng)) * (distance / 100.0f);
+            spatialIndex.update(id, glm::translate(glm::mat4(1), position));
+            positions[id] = position;
+        }
+
+        void remove(int id){
+            spatialIndex.remove(id);
+            positions.erase(id);
+        }
+
+        int randomId(){
+            auto iter = positions.begin();
+            std::advance(iter, std::uniform_int_distribution<int>(0, (int)positions.size() - 1)(rng));
+            return iter->first;
+        }
+
+        void verify(){
+            ASSERT_EQ((int)positions.size(), spatialIndex.size());
+            // balanced tree (the height of an AVL tree is below 1.45*log2(n+2))
+            EXPECT_LE(spatialIndex.getHeight(), (int)std::ceil(1.45f * std::log2(positions.size() + 2.0f)) + 1);
+            for (auto & p : positions){
+                auto bounds = spatialIndex.getBoundsMinMax(p.first);
+                EXPECT_EQ(p.second, bounds[0]);
+                EXPECT_EQ(p.second, bounds[1]);
+            }
+            for (int i = 0; i < 20; i++){
+                glm::vec3 center = randomPosition();
+                glm::vec3 extent = glm::abs(randomPosition()) * 0.3f;
+                std::array<glm::vec3,2> box = {center - extent, center + extent};
+
+                std::vector<int> result;
+                spatialIndex.queryAABB(box, result);
+                std::sort(result.begin(), result.end());
+                EXPECT_EQ(bruteForce(box), result);
+            }
+        }
+
+        std::vector<int> bruteForce(const std::array<glm::vec3,2>& box){
+            std::vector<int> res;
+            for (auto & p : positions){
+                if (overlaps({p.second, p.second}, box)){
+                    res.push_back(p.first);
+                }
+            }
+            return res;                                             // std::map is sorted by id
+        }
+
+        SpatialIndex spatialIndex;
+        std::map<int, glm::vec3> positions;
+        std::mt19937 rng;
+        std::uniform_real_distribution<float> dist;
+    };
+}
+
+TEST(SpatialIndex, InsertQuery)
+{
+    SpatialIndexTest test;
+    EXPECT_EQ(0, test.spatialIndex.getHeight());
+    for (int i = 0; i < 500; i++){
+        test.insert();
+        if (i % 50 == 0){
+            test.verify();
+        }
+    }
+    test.verify();
+}
+
+TEST(SpatialIndex, MoveRemove)
+{
+    SpatialIndexTest test;
+    for (int i = 0; i < 300; i++){
+        test.insert();
+    }
+    for (int round = 0; round < 20; round++){
+        for (int i = 0; i < 50; i++){
+            test.move(test.randomId(), round % 2 == 0 ? 1.0f : 100.0f);    // small and large moves
+        }
+        for (int i = 0; i < 10; i++){
+            test.remove(test.randomId());
+        }
+        for (int i = 0; i < 5; i++){
+            test.insert();                                          // reuses the removed ids and nodes
+        }
+        test.verify();
+    }
+    while (!test.positions.empty()){
+        test.remove(test.randomId());
+    }
+    test.verify();
+    EXPECT_EQ(0, test.spatialIndex.getHeight());
+}
+
+TEST(SpatialIndex, Frustum)
+{
+    SpatialIndexTest test;
+    for (int i = 0; i < 300; i++){
+        test.insert();
+    }
+    for (int i = 0; i < 100; i++){
+        test.move(test.randomId(), 100.0f);
+    }
+    glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 150.0f) *
+                               glm::lookAt(glm::vec3(0, 0, 0), glm::vec3(1, 0.5f, -1), glm::vec3(0, 1, 0));
+    std::vector<int> result;
+    test.spatialIndex.queryFrustum(viewProjection, result);
+    std::sort(result.begin(), result.end());
+
+    std::vector<int> expected;
+    for (auto & p : test.positions){
+        glm::vec4 clip = viewProjection * glm::vec4(p.second, 1.0f);
+        float distance = clip.w - std::max(std::max(std::abs(clip.x), std::abs(clip.y)), std::abs(clip.z));
+        if (std::abs(distance) < 1e-3f){
+            // on the frustum boundary - skip point, since the result depends on rounding
+            result.erase(std::remove(result.begin(), result.end(), p.first), result.end());
+        } else if (distance > 0){
+            expected.push_back(p.first);
+        }
+    }
+    EXPECT_FALSE(expected.empty());
+    EXPECT_EQ(expected, result);
+}
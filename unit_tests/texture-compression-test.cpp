@@ -0,0 +1,238 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <cstdlib>
+#include <cstring>
+#include "sre/impl/TextureCompression.hpp"
+
+using namespace sre;
+
+namespace {
+    const CompressedFormat allFormats[] = {CompressedFormat::BC1, CompressedFormat::BC3, CompressedFormat::BC4, CompressedFormat::BC5,
+                                           CompressedFormat::BC7, CompressedFormat::ETC2_RGB, CompressedFormat::ETC2_RGBA};
+
+    // smooth gradient with a varying alpha
+    std::vector<char> createGradient(int width, int height){
+        std::vector<char> res(width * height * 4);
+        for (int y = 0; y < height; y++){
+            for (int x = 0; x < width; x++){
+                char* p = &res[(x + y * width) * 4];
+                p[0] = (char)(x * 255 / (width - 1));
+                p[1] = (char)(y * 255 / (height - 1));
+                p[2] = (char)(128 + (x - y) / 4);
+                p[3] = (char)((x + y) * 255 / (width + height - 2));
+            }
+        }
+        return res;
+    }
+
+    // returns the largest per channel difference of the channels stored by the format
+    int maxError(CompressedFormat format, const std::vector<char>& a, const std::vector<char>& b){
+        int channels = format == CompressedFormat::BC4 ? 1 : (format == CompressedFormat::BC5 ? 2 : 3);
+        if (TextureCompression::hasAlpha(format)) channels = 4;
+        int res = 0;
+        for (size_t i = 0; i < a.size(); i += 4){
+            for (int c = 0; c < channels; c++){
+                res = std::max(res, std::abs((int)(uint8_t)a[i+c] - (int)(uint8_t)b[i+c]));
+            }
+        }
+        return res;
+    }
+
+    CompressedImage createImage(CompressedFormat format, int width, int height){
+        CompressedImage image;
+        image.format = format;
+        image.width = width;
+        image.height = height;
+        for (int w = width, h = height; ; w = std::max(1, w/2), h = std::max(1, h/2)){
+            auto rgba = createGradient(std::max(2, w), std::max(2, h));
+            auto level = TextureCompression::compress(format, rgba.data(), w, h);
+            EXPECT_EQ(TextureCompression::getLevelBytes(format, w, h), (int)level.size());
+            image.levels.push_back(level);
+            if (w == 1 && h == 1) break;
+        }
+        return image;
+    }
+}
+
+TEST(TextureCompression, Roundtrip)
+{
+    int width = 64, height = 32;
+    auto rgba = createGradient(width, height);
+    for (auto format : allFormats){
+        auto compressed = TextureCompression::compress(format, rgba.data(), width, height);
+        ASSERT_EQ(TextureCompression::getLevelBytes(format, width, height), (int)compressed.size());
+        auto decompressed = TextureCompression::decompress(format, compressed.data(), width, height);
+        ASSERT_EQ(rgba.size(), decompressed.size());
+        EXPECT_LE(maxError(format, rgba, decompressed), 24) << TextureCompression::getName(format);
+    }
+}
+
+TEST(TextureCompression, SolidColor)
+{
+    std::mt19937 rng(1);
+    for (int i = 0; i < 20; i++){
+        std::vector<char> rgba(8*8*4);
+        char color[4] = {(char)rng(), (char)rng(), (char)rng(), (char)rng()};
+        for (size_t p = 0; p < rgba.size(); p++){
+            rgba[p] = color[p % 4];
+        }
+        for (auto format : allFormats){
+            auto compressed = TextureCompression::compress(format, rgba.data(), 8, 8);
+            auto decompressed = TextureCompression::decompress(format, compressed.data(), 8, 8);
+            EXPECT_LE(maxError(format, rgba, decompressed), 8) << TextureCompression::getName(format);
+        }
+    }
+}
+
+TEST(TextureCompression, PartialBlocks)
+{
+    // sizes which are not a multiple of the block size are encoded as if the edge pixels were repeated
+    auto rgba = createGradient(7, 5);
+    std::vector<char> padded(8 * 8 * 4);
+    for (int y = 0; y < 8; y++){
+        for (int x = 0; x < 8; x++){
+            memcpy(&padded[(x + y * 8) * 4], &rgba[(std::min(x, 6) + std::min(y, 4) * 7) * 4], 4);
+        }
+    }
+    for (auto format : allFormats){
+        auto compressed = TextureCompression::compress(format, rgba.data(), 7, 5);
+        EXPECT_EQ(2 * 2 * TextureCompression::getBlockBytes(format), (int)compressed.size());
+        EXPECT_EQ(TextureCompression::compress(format, padded.data(), 8, 8), compressed);
+        auto decompressed = TextureCompression::decompress(format, compressed.data(), 7, 5);
+        auto decompressedPadded = TextureCompression::decompress(format, compressed.data(), 8, 8);
+        ASSERT_EQ(rgba.size(), decompressed.size());
+        for (int y = 0; y < 5; y++){
+            EXPECT_EQ(0, memcmp(&decompressed[y * 7 * 4], &decompressedPadded[y * 8 * 4], 7 * 4));
+        }
+    }
+}
+
+TEST(TextureCompression, CompressRows)
+{
+    // compressing ranges of block rows (as done by the multithreaded encoder) gives the same result
+    auto rgba = createGradient(16, 16);
+    for (auto format : allFormats){
+        auto all = TextureCompression::compress(format, rgba.data(), 16, 16);
+        std::vector<char> rows;
+        for (int row = 0; row < 4; row++){
+            auto part = TextureCompression::compress(format, rgba.data(), 16, 16, row, 1);
+            rows.insert(rows.end(), part.begin(), part.end());
+        }
+        EXPECT_EQ(all, rows);
+    }
+}
+
+TEST(TextureCompression, KnownBlocks)
+{
+    // BC1: red and blue endpoints, index 0, 1, 2 and 3 in each row
+    const char bc1[8] = {(char)0x00, (char)0xF8, (char)0x1F, (char)0x00, (char)0xE4, (char)0xE4, (char)0xE4, (char)0xE4};
+    auto res = TextureCompression::decompress(CompressedFormat::BC1, bc1, 4, 4);
+    EXPECT_EQ(255, (uint8_t)res[0]);
+    EXPECT_EQ(0, (uint8_t)res[2]);
+    EXPECT_EQ(255, (uint8_t)res[4+2]);
+    EXPECT_EQ(170, (uint8_t)res[8]);
+    EXPECT_EQ(85, (uint8_t)res[8+2]);
+    EXPECT_EQ(85, (uint8_t)res[12]);
+
+    // ETC1 individual mode: base colors (255,0,0) and (0,0,255), codeword 0, flipped, all pixel index 0 (+2)
+    const char etc[8] = {(char)0xF0, (char)0x00, (char)0x0F, (char)0x01, 0, 0, 0, 0};
+    res = TextureCompression::decompress(CompressedFormat::ETC2_RGB, etc, 4, 4);
+    EXPECT_EQ(255, (uint8_t)res[0]);
+    EXPECT_EQ(2, (uint8_t)res[2]);
+    EXPECT_EQ(2, (uint8_t)res[(3*4)*4]);
+    EXPECT_EQ(255, (uint8_t)res[(3*4)*4+2]);
+
+    // BC7 reserved mode decodes to transparent black
+    const char bc7[16] = {0};
+    res = TextureCompression::decompress(CompressedFormat::BC7, bc7, 4, 4);
+    EXPECT_EQ(std::vector<char>(64, 0), res);
+}
+
+TEST(TextureCompression, KTX2)
+{
+    for (auto format : allFormats){
+        auto image = createImage(format, 32, 16);
+        image.srgb = TextureCompression::getGLFormat(format, true) != 0;
+        auto file = TextureCompression::saveKTX2(image);
+        EXPECT_TRUE(TextureCompression::isCompressedFile(file));
+        CompressedImage loaded;
+        std::string error;
+        ASSERT_TRUE(TextureCompression::load(file, loaded, error)) << error;
+        EXPECT_EQ(image.format, loaded.format);
+        EXPECT_EQ(image.srgb, loaded.srgb);
+        EXPECT_EQ(32, loaded.width);
+        EXPECT_EQ(16, loaded.height);
+        EXPECT_EQ(6u, loaded.levels.size());
+        EXPECT_EQ(image.levels, loaded.levels);
+    }
+}
+
+TEST(TextureCompression, DDS)
+{
+    for (auto format : allFormats){
+        auto image = createImage(format, 16, 16);
+        auto file = TextureCompression::saveDDS(image);
+        if (format == CompressedFormat::ETC2_RGB || format == CompressedFormat::ETC2_RGBA){
+            EXPECT_TRUE(file.empty());
+            continue;
+        }
+        CompressedImage loaded;
+        std::string error;
+        ASSERT_TRUE(TextureCompression::load(file, loaded, error)) << error;
+        EXPECT_EQ(image.format, loaded.format);
+        EXPECT_EQ(image.levels, loaded.levels);
+    }
+}
+
+TEST(TextureCompression, InvalidFiles)
+{
+    CompressedImage image;
+    std::string error;
+    std::vector<char> png = {(char)0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    EXPECT_FALSE(TextureCompression::isCompressedFile(png));
+    EXPECT_FALSE(TextureCompression::load(png, image, error));
+
+    // truncated mip chain
+    auto file = TextureCompression::saveKTX2(createImage(CompressedFormat::BC7, 16, 16));
+    file.resize(file.size() - 16);
+    EXPECT_FALSE(TextureCompression::load(file, image, error));
+    EXPECT_FALSE(error.empty());
+}
+
+TEST(TextureCompression, CorruptHeaders)
+{
+    CompressedImage image;
+    std::string error;
+    auto setU32 = [](std::vector<char>& data, size_t offset, uint32_t value){
+        for (int i = 0; i < 4; i++){
+            data[offset + i] = (char)(value >> (8 * i));
+        }
+    };
+    auto ktx2 = TextureCompression::saveKTX2(createImage(CompressedFormat::BC1, 16, 16));
+
+    auto file = ktx2;
+    setU32(file, 20, 0x80000000u);                              // width overflows int
+    EXPECT_FALSE(TextureCompression::load(file, image, error));
+
+    file = ktx2;
+    setU32(file, 24, 0);                                        // height 0
+    EXPECT_FALSE(TextureCompression::load(file, image, error));
+
+    file = ktx2;
+    setU32(file, 40, 40);                                       // more mip levels than the size allows
+    EXPECT_FALSE(TextureCompression::load(file, image, error));
+
+    file = ktx2;
+    setU32(file, 80, 0xFFFFFFF0u);                              // level offset wraps around
+    setU32(file, 84, 0xFFFFFFFFu);
+    EXPECT_FALSE(TextureCompression::load(file, image, error));
+
+    auto dds = TextureCompression::saveDDS(createImage(CompressedFormat::BC1, 16, 16));
+    file = dds;
+    setU32(file, 12, 0xFFFFFFFFu);                              // height
+    EXPECT_FALSE(TextureCompression::load(file, image, error));
+
+    file = dds;
+    setU32(file, 28, 0x7FFFFFFF);                               // mip level count
+    EXPECT_FALSE(TextureCompression::load(file, image, error));
+}
@@ -0,0 +1,183 @@
+// Converts PNG/JPEG images to block compressed KTX2 or DDS files (with mip levels) loadable using
+// Texture::create().withFile(). Mip levels are generated and blocks are compressed on all hardware threads.
+//
+// The image rows are stored bottom-up, so compressed textures have the same orientation as PNG textures.
+
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <SDL_image.h>
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+
+#include "sre/impl/TextureCompression.hpp"
+#include "sre/impl/WorkerPool.hpp"
+#include "sre/impl/MipmapBuilder.hpp"
+
+using namespace std;
+using namespace sre;
+
+struct Level {
+    int width;
+    int height;
+    vector<char> rgba;
+};
+
+bool loadImage(const char* filename, Level& level){
+    SDL_Surface* image = IMG_Load(filename);
+    if (image == nullptr){
+        cout << "Cannot load "<<filename<<": "<<IMG_GetError()<<endl;
+        return false;
+    }
+    SDL_Surface* rgba = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_ABGR8888, 0);   // RGBA byte order on little endian
+    level.width = rgba->w;
+    level.height = rgba->h;
+    level.rgba.resize((size_t)level.width * level.height * 4);
+    for (int y = 0; y < level.height; y++){
+        auto src = (const char*)rgba->pixels + (level.height - 1 - y) * rgba->pitch;     // bottom-up
+        memcpy(&level.rgba[(size_t)y * level.width * 4], src, (size_t)level.width * 4);
+    }
+    SDL_FreeSurface(rgba);
+    SDL_FreeSurface(image);
+    return true;
+}
+
+bool parseFormat(const string& name, CompressedFormat& format){
+    const pair<const char*, CompressedFormat> formats[] = {
+        {"bc1", CompressedFormat::BC1}, {"bc3", CompressedFormat::BC3}, {"bc4", CompressedFormat::BC4},
+        {"bc5", CompressedFormat::BC5}, {"bc7", CompressedFormat::BC7}, {"etc2", CompressedFormat::ETC2_RGB},
+        {"etc2a", CompressedFormat::ETC2_RGBA}
+    };
+    for (auto& f : formats){
+        if (name == f.first){
+            format = f.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool endsWith(const string& s, const string& suffix){
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int main(int argc, char * argv[]){
+    CompressedFormat format = CompressedFormat::BC7;
+    bool srgb = false;
+    bool mipmaps = true;
+    MipmapSettings mipmapSettings;
+    int threads = 0;
+    vector<string> files;
+    for (int i = 1; i < argc; i++){
+        string arg = argv[i];
+        if (arg == "-f" && i + 1 < argc){
+            if (!parseFormat(argv[++i], format)){
+                cout << "Unknown format "<<argv[i]<<endl;
+                return -1;
+            }
+        } else if (arg == "-j" && i + 1 < argc){
+            threads = atoi(argv[++i]);
+        } else if (arg == "--srgb"){
+            srgb = true;
+        } else if (arg == "--no-mipmaps"){
+            mipmaps = false;
+        } else if (arg == "--kaiser"){
+            mipmapSettings.filter = MipmapSettings::Filter::Kaiser;
+        } else if (arg == "--alpha-coverage" && i + 1 < argc){
+            mipmapSettings.alphaCutoff = (float)atof(argv[++i]);
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.size() != 2){
+        cout << "Usage:"<<endl;
+        cout << "texture-compressor [-f bc1|bc3|bc4|bc5|bc7|etc2|etc2a] [--srgb] [--no-mipmaps] [--kaiser] [--alpha-coverage cutoff] [-j threads] input.png output.ktx2|output.dds"<<endl;
+        cout << "Default format is bc7. DDS does not support ETC2."<<endl;
+        cout << "Mipmaps use a box filter (in linear space if --srgb) unless --kaiser is given. --alpha-coverage keeps the fraction of"<<endl;
+        cout << "pixels with alpha > cutoff (0.0-1.0) in each mip level."<<endl;
+        return -1;
+    }
+    bool dds = endsWith(files[1], ".dds");
+    if (dds && (format == CompressedFormat::ETC2_RGB || format == CompressedFormat::ETC2_RGBA)){
+        cout << "ETC2 requires a KTX2 file"<<endl;
+        return -1;
+    }
+
+    IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG);
+    vector<Level> levels(1);
+    if (!loadImage(files[0].c_str(), levels[0])){
+        return -1;
+    }
+
+    auto start = chrono::high_resolution_clock::now();
+    WorkerPool workerPool(threads);
+    if (mipmaps){
+        mipmapSettings.srgb = srgb;
+        auto mipLevels = MipmapBuilder::build(levels[0].rgba.data(), levels[0].width, levels[0].height, 4, mipmapSettings, &workerPool);
+        for (auto& mipLevel : mipLevels){
+            auto& previous = levels.back();
+            levels.push_back({max(1, previous.width / 2), max(1, previous.height / 2), move(mipLevel)});
+        }
+    }
+    CompressedImage image;
+    image.format = format;
+    image.srgb = srgb;
+    image.width = levels[0].width;
+    image.height = levels[0].height;
+    image.levels.resize(levels.size());
+
+    // each task compresses a range of block rows of a level
+    const int rowsPerTask = 4;
+    vector<vector<vector<char>>> rows(levels.size());
+    int pending = 0;
+    mutex mutex;
+    condition_variable done;
+    {
+        for (size_t l = 0; l < levels.size(); l++){
+            int blockRows = (levels[l].height + 3) / 4;
+            rows[l].resize((size_t)(blockRows + rowsPerTask - 1) / rowsPerTask);
+            for (int r = 0; r < blockRows; r += rowsPerTask){
+                {
+                    lock_guard<std::mutex> lock(mutex);
+                    pending++;
+                }
+                workerPool.enqueue([&, l, r](){
+                    auto& level = levels[l];
+                    auto res = TextureCompression::compress(format, level.rgba.data(), level.width, level.height, r, rowsPerTask);
+                    lock_guard<std::mutex> lock(mutex);
+                    rows[l][r / rowsPerTask] = move(res);
+                    if (--pending == 0){
+                        done.notify_one();
+                    }
+                });
+            }
+        }
+        unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&](){ return pending == 0; });
+        cout << "Compressed "<<levels.size()<<" levels using "<<workerPool.getThreadCount()<<" threads"<<endl;
+    }
+    for (size_t l = 0; l < levels.size(); l++){
+        for (auto& r : rows[l]){
+            image.levels[l].insert(image.levels[l].end(), r.begin(), r.end());
+        }
+    }
+    auto end = chrono::high_resolution_clock::now();
+
+    auto fileData = dds ? TextureCompression::saveDDS(image) : TextureCompression::saveKTX2(image);
+    ofstream out(files[1], ios::binary | ios::trunc);
+    out.write(fileData.data(), fileData.size());
+    if (!out){
+        cout << "Cannot write "<<files[1]<<endl;
+        return -1;
+    }
+    cout << files[0]<<" ("<<image.width<<"x"<<image.height<<") -> "<<files[1]<<" "<<TextureCompression::getName(format)
+         <<(srgb?" sRGB":"")<<" "<<fileData.size()<<" bytes in "<<chrono::duration<double, milli>(end - start).count()<<" ms"<<endl;
+    IMG_Quit();
+    return 0;
+}